@@ -0,0 +1,795 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * flare_bench
+ *
+ * Benchmark suite for the engine hot paths: map loading and rendering,
+ * pathfinding, hazard collision/combat resolution and data file parsing.
+ *
+ * The engine is set up the same way as the game, but all maps are generated
+ * from --seed into a "flare_bench" mod in the user data folder, so results only
+ * depend on the engine code. Results are written as JSON (or CSV).
+ */
+
+#include "CommonIncludes.h"
+#include "CompiledMap.h"
+#include "CursorManager.h"
+#include "Enemy.h"
+#include "EnemyManager.h"
+#include "FileParser.h"
+#include "GameStatePlay.h"
+#include "Hazard.h"
+#include "HazardManager.h"
+#include "MapRenderer.h"
+#include "SharedGameResources.h"
+#include "SharedResources.h"
+#include "Settings.h"
+#include "Stats.h"
+#include "UtilsFileSystem.h"
+
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+#define BENCH_MOD "flare_bench"
+
+const int BENCH_MAP_SIZE = 256;
+
+class BenchResult {
+public:
+	std::string name;
+	std::vector<float> samples; // microseconds per iteration
+	std::vector<std::pair<std::string, float> > counters;
+
+	float total() const {
+		float sum = 0;
+		for (unsigned i=0; i<samples.size(); ++i)
+			sum += samples[i];
+		return sum;
+	}
+
+	float percentile(float p) const {
+		if (samples.empty()) return 0;
+		std::vector<float> sorted = samples;
+		std::sort(sorted.begin(), sorted.end());
+		unsigned index = (unsigned)(p * (sorted.size() - 1) + 0.5f);
+		return sorted[index];
+	}
+};
+
+static std::vector<BenchResult> results;
+static std::string bench_filter = "";
+static std::string render_device_name = "null";
+static unsigned int bench_seed = 1;
+static float iteration_scale = 1.0f;
+static Uint64 timer_frequency = 1000;
+
+/**
+ * Returns a timestamp in units of 1/timer_frequency seconds
+ */
+static Uint64 timerNow() {
+#if SDL_VERSION_ATLEAST(2,0,0)
+	return SDL_GetPerformanceCounter();
+#else
+	return SDL_GetTicks();
+#endif
+}
+
+static float elapsedMicroseconds(Uint64 start, Uint64 end) {
+	return (float)(end - start) * 1000000.f / (float)timer_frequency;
+}
+
+static int iterations(int base) {
+	return std::max(1, (int)(base * iteration_scale));
+}
+
+/**
+ * A benchmark only runs if its name contains the --filter string
+ */
+static bool enabled(const std::string& name) {
+	return bench_filter.empty() || name.find(bench_filter) != std::string::npos;
+}
+
+static BenchResult& addResult(const std::string& name) {
+	results.push_back(BenchResult());
+	results.back().name = name;
+	fprintf(stderr, "Running %s...\n", name.c_str());
+	return results.back();
+}
+
+/**
+ * Switch tile metrics the same way loadTilesetSettings() would for the given orientation
+ */
+static void setTileOrientation(unsigned short orientation) {
+	TILESET_ORIENTATION = orientation;
+	TILE_W = 64;
+	TILE_H = (orientation == TILESET_ISOMETRIC) ? 32 : 64;
+	TILE_W_HALF = TILE_W / 2;
+	TILE_H_HALF = TILE_H / 2;
+	float units = (orientation == TILESET_ISOMETRIC) ? 2.0f : 1.0f;
+	UNITS_PER_PIXEL_X = units / TILE_W;
+	UNITS_PER_PIXEL_Y = units / TILE_H;
+}
+
+/**
+ * Tiles are cut from an image of the default mod, so the real renderer has
+ * something to blit. Tiles 1-10 are ground tiles, 11-15 tall objects.
+ * Tile 1 is animated, so the tile set logic has work to do.
+ */
+static bool writeTileset(const std::string& path, bool iso) {
+	ofstream outfile(path.c_str(), ios::out);
+	if (!outfile.is_open()) return false;
+
+	const int ground_h = iso ? 32 : 64;
+	const int object_offset_y = iso ? 112 : 96;
+
+	outfile << "img=images/menus/config.png\n";
+	for (int i=0; i<10; i++)
+		outfile << "tile=" << i+1 << "," << i*64 << ",0,64," << ground_h << ",32," << ground_h/2 << "\n";
+	for (int i=0; i<5; i++)
+		outfile << "tile=" << i+11 << "," << i*64 << ",64,64,128,32," << object_offset_y << "\n";
+	outfile << "animation=1,0,0,200ms,64,0,200ms,128,0,200ms\n";
+
+	outfile.close();
+	return true;
+}
+
+static void writeLayer(ofstream &outfile, const std::string& type, const std::vector<unsigned short>& data) {
+	outfile << "\n[layer]\ntype=" << type << "\nformat=dec\ndata=\n";
+	for (int y=0; y<BENCH_MAP_SIZE; y++) {
+		for (int x=0; x<BENCH_MAP_SIZE; x++) {
+			outfile << data[x + y*BENCH_MAP_SIZE];
+			if (x < BENCH_MAP_SIZE-1 || y < BENCH_MAP_SIZE-1) outfile << ",";
+		}
+		outfile << "\n";
+	}
+}
+
+/**
+ * Generate a map with random ground tiles, scattered walls and water.
+ * Every wall also gets an object tile, so the object layer is populated.
+ */
+static bool writeMap(const std::string& path, const std::string& tileset) {
+	ofstream outfile(path.c_str(), ios::out);
+	if (!outfile.is_open()) return false;
+
+	srand(bench_seed);
+
+	const int size = BENCH_MAP_SIZE * BENCH_MAP_SIZE;
+	std::vector<unsigned short> background(size);
+	std::vector<unsigned short> object(size, 0);
+	std::vector<unsigned short> collision(size, BLOCKS_NONE);
+
+	for (int x=0; x<BENCH_MAP_SIZE; x++) {
+		for (int y=0; y<BENCH_MAP_SIZE; y++) {
+			const int i = x + y*BENCH_MAP_SIZE;
+			background[i] = (unsigned short)(1 + rand() % 10);
+
+			int roll = rand() % 100;
+			if (x == 0 || y == 0 || x == BENCH_MAP_SIZE-1 || y == BENCH_MAP_SIZE-1 || roll < 12) {
+				collision[i] = BLOCKS_ALL;
+				object[i] = (unsigned short)(11 + rand() % 5);
+			}
+			else if (roll < 17) {
+				collision[i] = BLOCKS_MOVEMENT;
+			}
+		}
+	}
+
+	outfile << "[header]\n";
+	outfile << "width=" << BENCH_MAP_SIZE << "\n";
+	outfile << "height=" << BENCH_MAP_SIZE << "\n";
+	outfile << "tileset=" << tileset << "\n";
+	outfile << "title=Benchmark\n";
+	outfile << "location=" << BENCH_MAP_SIZE/2 << "," << BENCH_MAP_SIZE/2 << ",3\n";
+
+	writeLayer(outfile, "background", background);
+	writeLayer(outfile, "object", object);
+	writeLayer(outfile, "collision", collision);
+
+	outfile.close();
+	return true;
+}
+
+/**
+ * Write the synthetic maps and tilesets and make them visible to the ModManager
+ */
+static bool createBenchMod() {
+	const std::string mod_path = PATH_USER + "mods/" + BENCH_MOD;
+	createDir(PATH_USER + "mods");
+	createDir(mod_path);
+	createDir(mod_path + "/maps");
+	createDir(mod_path + "/tilesetdefs");
+
+	if (!writeTileset(mod_path + "/tilesetdefs/bench_iso.txt", true) ||
+			!writeTileset(mod_path + "/tilesetdefs/bench_ortho.txt", false) ||
+			!writeMap(mod_path + "/maps/bench_iso.txt", "tilesetdefs/bench_iso.txt") ||
+			!writeMap(mod_path + "/maps/bench_ortho.txt", "tilesetdefs/bench_ortho.txt") ||
+			!writeMap(mod_path + "/maps/bench_compiled.txt", "tilesetdefs/bench_iso.txt") ||
+			!CompiledMap::compile(mod_path + "/maps/bench_compiled.txt", mod_path + "/maps/bench_compiled.txt" + COMPILED_MAP_EXTENSION)) {
+		fprintf(stderr, "Could not write benchmark data to %s\n", mod_path.c_str());
+		return false;
+	}
+
+	// the bench mod is never added to mods.txt, so it doesn't affect the game
+	if (find(mods->mod_dirs.begin(), mods->mod_dirs.end(), BENCH_MOD) == mods->mod_dirs.end())
+		mods->mod_dirs.push_back(BENCH_MOD);
+	mods->mod_list.push_back(mods->loadMod(BENCH_MOD));
+	mods->buildIndex();
+	return true;
+}
+
+/**
+ * Map parsing: FileParser or CompiledMap, Map::load and the MapRenderer post-processing
+ */
+static void benchMapLoad(const std::string& name, const std::string& mapname) {
+	if (!enabled(name)) return;
+	BenchResult &result = addResult(name);
+
+	int n = iterations(10);
+	for (int i=0; i<n; i++) {
+		Uint64 start = timerNow();
+		mapr->load(mapname);
+		result.samples.push_back(elapsedMicroseconds(start, timerNow()));
+	}
+}
+
+/**
+ * One MapRenderer::render() call per frame, while the camera walks slowly across the map
+ */
+static void benchMapRender(const std::string& name, const std::string& mapname, unsigned short orientation) {
+	if (!enabled(name)) return;
+
+	setTileOrientation(orientation);
+	mapr->load(mapname);
+
+	BenchResult &result = addResult(name);
+	std::vector<Renderable> r;
+	std::vector<Renderable> r_dead;
+
+	int n = iterations(1000);
+	for (int i=0; i<n; i++) {
+		mapr->cam.x = 64 + fmod(i * 0.1f, 128.f);
+		mapr->cam.y = 64 + fmod(i * 0.05f, 128.f);
+		mapr->logic();
+
+		render_device->blankScreen();
+		r.clear();
+		r_dead.clear();
+
+		Uint64 start = timerNow();
+		mapr->render(r, r_dead);
+		result.samples.push_back(elapsedMicroseconds(start, timerNow()));
+
+		render_device->commitFrame();
+	}
+}
+
+static FPoint randomOpenTile(int x0, int y0, int range) {
+	FPoint p;
+	for (int tries=0; tries<1000; tries++) {
+		if (range > 0) {
+			p.x = (float)(x0 - range + rand() % (range*2 + 1)) + 0.5f;
+			p.y = (float)(y0 - range + rand() % (range*2 + 1)) + 0.5f;
+		}
+		else {
+			p.x = (float)(rand() % mapr->collider.map_size.x) + 0.5f;
+			p.y = (float)(rand() % mapr->collider.map_size.y) + 0.5f;
+		}
+		if (mapr->collider.is_valid_position(p.x, p.y, MOVEMENT_NORMAL, false))
+			return p;
+	}
+	return p;
+}
+
+/**
+ * The result of an earlier benchmark, or NULL if it didn't run
+ */
+static const BenchResult *findResult(const std::string& name) {
+	for (unsigned i=0; i<results.size(); i++)
+		if (results[i].name == name) return &results[i];
+	return NULL;
+}
+
+/**
+ * MapCollision::compute_path() between random open tiles.
+ * A max_distance of 0 picks the end point anywhere on the map.
+ * A limit of 0 lets long paths go through the cluster graph.
+ * With jump_point_search, the tile searches use JPS instead of A*. The
+ * result is named after the A* one with a "_jps" suffix and gets its speedup.
+ */
+static void benchPathfinding(const std::string& base_name, int max_distance, unsigned int limit, bool jump_point_search = false) {
+	const std::string name = jump_point_search ? base_name + "_jps" : base_name;
+	if (!enabled(name)) return;
+
+	srand(bench_seed);
+	int n = iterations(2000);
+
+	std::vector<FPoint> starts;
+	std::vector<FPoint> ends;
+	for (int i=0; i<n; i++) {
+		starts.push_back(randomOpenTile(0, 0, 0));
+		ends.push_back(randomOpenTile((int)starts.back().x, (int)starts.back().y, max_distance));
+	}
+
+	BenchResult &result = addResult(name);
+	std::vector<FPoint> path;
+	int found = 0;
+	int waypoints = 0;
+
+	JUMP_POINT_SEARCH = jump_point_search;
+	for (int i=0; i<n; i++) {
+		Uint64 start = timerNow();
+		bool success = mapr->collider.compute_path(starts[i], ends[i], path, MOVEMENT_NORMAL, limit);
+		result.samples.push_back(elapsedMicroseconds(start, timerNow()));
+
+		if (success && !path.empty() && calcDist(path.front(), ends[i]) < 1) found++;
+		waypoints += path.size();
+	}
+	JUMP_POINT_SEARCH = false;
+
+	result.counters.push_back(std::pair<std::string, float>("reached_ratio", (float)found / n));
+	result.counters.push_back(std::pair<std::string, float>("avg_waypoints", (float)waypoints / n));
+
+	const BenchResult *base = jump_point_search ? findResult(base_name) : NULL;
+	if (base && result.total() > 0)
+		result.counters.push_back(std::pair<std::string, float>("speedup", base->total() / result.total()));
+}
+
+/**
+ * The pathfinding of a crowd of enemies chasing the hero, one sample per tick.
+ * The hero walks to another tile every tick, and each pursuer either searches
+ * its own path to the hero or reads its next step from the shared flow field.
+ */
+static void benchPursuit(int pursuer_count, bool flow_field) {
+	std::stringstream ss;
+	ss << (flow_field ? "pursuit_flow_" : "pursuit_paths_") << pursuer_count;
+	if (!enabled(ss.str())) return;
+
+	srand(bench_seed);
+	int ticks = iterations(200);
+
+	FPoint hero = randomOpenTile(0, 0, 0);
+	std::vector<FPoint> pursuers;
+	for (int i=0; i<pursuer_count; i++)
+		pursuers.push_back(randomOpenTile((int)hero.x, (int)hero.y, 16));
+
+	BenchResult &result = addResult(ss.str());
+	std::vector<FPoint> path;
+	int steps = 0;
+
+	for (int t=0; t<ticks; t++) {
+		hero = randomOpenTile((int)hero.x, (int)hero.y, 1);
+
+		Uint64 start = timerNow();
+		if (flow_field)
+			mapr->collider.set_flow_target(hero);
+
+		for (int i=0; i<pursuer_count; i++) {
+			FPoint next;
+			if (flow_field && mapr->collider.get_flow_step(pursuers[i], next, MOVEMENT_NORMAL)) {
+				steps++;
+			}
+			else if (mapr->collider.compute_path(pursuers[i], hero, path, MOVEMENT_NORMAL) && !path.empty()) {
+				next = path.back();
+				steps++;
+			}
+		}
+		result.samples.push_back(elapsedMicroseconds(start, timerNow()));
+	}
+
+	result.counters.push_back(std::pair<std::string, float>("step_ratio", (float)steps / (ticks * pursuer_count)));
+}
+
+/**
+ * A burst of path searches in one tick, as in a big fight. One sample is the time the
+ * main thread spends on the burst: searching every path itself, or only requesting
+ * them from the path service and collecting the answers on the following ticks.
+ */
+static void benchPathBurst(int burst_size, bool async) {
+	std::stringstream ss;
+	ss << (async ? "path_burst_async_" : "path_burst_sync_") << burst_size;
+	if (!enabled(ss.str())) return;
+
+	srand(bench_seed);
+	int bursts = iterations(20);
+
+	std::vector<FPoint> starts;
+	std::vector<FPoint> ends;
+	for (int i=0; i<burst_size; i++) {
+		starts.push_back(randomOpenTile(0, 0, 0));
+		ends.push_back(randomOpenTile((int)starts.back().x, (int)starts.back().y, 24));
+	}
+
+	BenchResult &result = addResult(ss.str());
+	std::vector<FPoint> path;
+	std::vector<unsigned int> tickets(burst_size, 0);
+	mapr->path_service.update(mapr->collider);
+
+	for (int b=0; b<bursts; b++) {
+		Uint64 start = timerNow();
+		for (int i=0; i<burst_size; i++) {
+			if (async)
+				tickets[i] = mapr->path_service.request(starts[i], ends[i], MOVEMENT_NORMAL);
+			else
+				mapr->collider.compute_path(starts[i], ends[i], path, MOVEMENT_NORMAL);
+		}
+		Uint64 elapsed = timerNow() - start;
+
+		// the answers are collected after the following ticks, waiting for the ones still searched
+		if (async) {
+			for (unsigned int tick=0; tick<PathService::RESULT_DELAY; tick++) {
+				mapr->path_service.logic(mapr->collider);
+				SDL_Delay(1000 / MAX_FRAMES_PER_SEC);
+			}
+			start = timerNow();
+			for (int i=0; i<burst_size; i++) {
+				bool found;
+				mapr->path_service.collect(tickets[i], path, found);
+			}
+			elapsed += timerNow() - start;
+		}
+		result.samples.push_back(elapsedMicroseconds(0, elapsed));
+	}
+}
+
+/**
+ * HazardManager::logic() with fresh hazards every tick, in a crowd of enemies and allies.
+ * Enemies get no animations here, so they are given enough HP to never die.
+ */
+static void benchHazards(int hazard_count, int enemy_count) {
+	std::stringstream ss;
+	ss << "hazards_" << hazard_count << "x" << enemy_count;
+	if (!enabled(ss.str())) return;
+
+	mapr->load("maps/bench_ortho.txt");
+	srand(bench_seed);
+
+	// power 0 is the empty power; it only exists when game data is loaded
+	if (powers->powers.empty())
+		powers->powers.resize(1);
+
+	// keep the hero out of the collision checks, it has no animations either
+	pc->stats.hp = 0;
+
+	const int center = BENCH_MAP_SIZE / 2;
+	const int area = 16;
+
+	for (int i=0; i<enemy_count; i++) {
+		Enemy *e = new Enemy();
+		e->stats.hp = INT_MAX / 2;
+		e->stats.in_combat = true;
+		e->stats.hero_ally = (i % 4 == 0);
+		e->stats.pos = randomOpenTile(center, center, area);
+		enemies->enemies.push_back(e);
+	}
+
+	BenchResult &result = addResult(ss.str());
+	HazardManager hazard_manager;
+	int hits = 0;
+
+	int n = iterations(500);
+	for (int i=0; i<n; i++) {
+		for (int j=0; j<hazard_count; j++) {
+			Hazard *h = new Hazard(&mapr->collider);
+			h->pos = randomOpenTile(center, center, area);
+			h->speed.x = (rand() % 5 - 2) * 0.1f;
+			h->speed.y = (rand() % 5 - 2) * 0.1f;
+			h->radius = 1.0f;
+			h->lifespan = 1;
+			h->dmg_min = 1;
+			h->dmg_max = 10;
+			h->accuracy = 100;
+			h->src_stats = &pc->stats;
+			h->source_type = (j % 2) ? SOURCE_TYPE_HERO : SOURCE_TYPE_NEUTRAL;
+			h->multitarget = (j % 3 == 0);
+			hazard_manager.h.push_back(h);
+		}
+
+		Uint64 start = timerNow();
+		hazard_manager.logic();
+		result.samples.push_back(elapsedMicroseconds(start, timerNow()));
+
+		for (unsigned j=0; j<hazard_manager.h.size(); j++) {
+			if (!hazard_manager.h[j]->active) hits++;
+		}
+
+		// expire combat text, so it doesn't pile up
+		comb->render();
+	}
+
+	result.counters.push_back(std::pair<std::string, float>("single_target_hits_per_tick", (float)hits / n));
+
+	hazard_manager.handleNewMap();
+	for (unsigned i=0; i<enemies->enemies.size(); i++)
+		delete enemies->enemies[i];
+	enemies->enemies.clear();
+}
+
+static void collectDataFiles(const std::string& dir, std::vector<std::string>& files) {
+	getFileList(dir, "txt", files);
+
+	std::vector<std::string> dirs;
+	getDirList(dir, dirs);
+	for (unsigned i=0; i<dirs.size(); i++)
+		collectDataFiles(dir + "/" + dirs[i], files);
+}
+
+/**
+ * Parse every text file of every active mod (except the generated one) with FileParser
+ */
+static void benchFileParser() {
+	const std::string name = "fileparser_mods";
+	if (!enabled(name)) return;
+
+	std::vector<std::string> paths;
+	paths.push_back(PATH_USER);
+	if (PATH_DATA != PATH_USER) paths.push_back(PATH_DATA);
+
+	std::vector<std::string> files;
+	for (unsigned i=0; i<mods->mod_list.size(); i++) {
+		if (mods->mod_list[i].name == BENCH_MOD) continue;
+		for (unsigned j=0; j<paths.size(); j++) {
+			std::string dir = paths[j] + "mods/" + mods->mod_list[i].name;
+			if (dirExists(dir))
+				collectDataFiles(dir, files);
+		}
+	}
+
+	BenchResult &result = addResult(name);
+	int keys = 0;
+
+	int n = iterations(20);
+	for (int i=0; i<n; i++) {
+		keys = 0;
+		Uint64 start = timerNow();
+		for (unsigned j=0; j<files.size(); j++) {
+			FileParser infile;
+			if (!infile.open(files[j], false, ""))
+				continue;
+			while (infile.next())
+				keys++;
+			infile.close();
+		}
+		result.samples.push_back(elapsedMicroseconds(start, timerNow()));
+	}
+
+	result.counters.push_back(std::pair<std::string, float>("files", (float)files.size()));
+	result.counters.push_back(std::pair<std::string, float>("keys", (float)keys));
+}
+
+static bool writeResults(const std::string& filename) {
+	FILE *f = stdout;
+	if (!filename.empty()) {
+		f = fopen(filename.c_str(), "w");
+		if (!f) {
+			fprintf(stderr, "Unable to write benchmark results to %s\n", filename.c_str());
+			return false;
+		}
+	}
+
+	bool csv = filename.length() > 4 && filename.compare(filename.length()-4, 4, ".csv") == 0;
+	if (csv) {
+		fprintf(f, "name,iterations,total_ms,mean_us,median_us,p95_us,min_us,max_us,counters\n");
+		for (unsigned i=0; i<results.size(); i++) {
+			const BenchResult &r = results[i];
+			fprintf(f, "%s,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,", r.name.c_str(), (unsigned)r.samples.size(),
+					r.total() / 1000.f, r.total() / r.samples.size(), r.percentile(0.5f), r.percentile(0.95f),
+					r.percentile(0), r.percentile(1));
+			for (unsigned j=0; j<r.counters.size(); j++)
+				fprintf(f, "%s%s=%.3f", (j ? ";" : ""), r.counters[j].first.c_str(), r.counters[j].second);
+			fprintf(f, "\n");
+		}
+	}
+	else {
+		fprintf(f, "{\n\t\"version\": \"%s\",\n\t\"renderer\": \"%s\",\n\t\"seed\": %u,\n\t\"view\": [%d, %d],\n\t\"benchmarks\": [\n",
+				getVersionString().c_str(), render_device_name.c_str(), bench_seed, VIEW_W, VIEW_H);
+		for (unsigned i=0; i<results.size(); i++) {
+			const BenchResult &r = results[i];
+			fprintf(f, "\t\t{\"name\": \"%s\", \"iterations\": %u, \"total_ms\": %.3f, \"mean_us\": %.3f, \"median_us\": %.3f, \"p95_us\": %.3f, \"min_us\": %.3f, \"max_us\": %.3f, \"counters\": {",
+					r.name.c_str(), (unsigned)r.samples.size(), r.total() / 1000.f, r.total() / r.samples.size(),
+					r.percentile(0.5f), r.percentile(0.95f), r.percentile(0), r.percentile(1));
+			for (unsigned j=0; j<r.counters.size(); j++)
+				fprintf(f, "%s\"%s\": %.3f", (j ? ", " : ""), r.counters[j].first.c_str(), r.counters[j].second);
+			fprintf(f, "}}%s\n", (i < results.size()-1 ? "," : ""));
+		}
+		fprintf(f, "\t]\n}\n");
+	}
+
+	if (f != stdout) fclose(f);
+	return true;
+}
+
+/**
+ * Engine set-up, mirroring init() of the game without audio, joysticks or a game state
+ */
+static bool init() {
+	setPaths();
+	setStatNames();
+
+	Uint32 sdl_flags = SDL_INIT_TIMER;
+	if (render_device_name != "null") sdl_flags |= SDL_INIT_VIDEO;
+	if (SDL_Init(sdl_flags) < 0) {
+		fprintf(stderr, "Could not initialize SDL: %s\n", SDL_GetError());
+		return false;
+	}
+#if SDL_VERSION_ATLEAST(2,0,0)
+	timer_frequency = SDL_GetPerformanceFrequency();
+#endif
+
+	mods = new ModManager();
+	if (!mods->haveFallbackMod()) {
+		fprintf(stderr, "Could not find the default mod. Use --data-path to point to the game data.\n");
+		return false;
+	}
+
+	if (!loadSettings()) {
+		fprintf(stderr, "Could not load settings file: %s\n", (PATH_CONF + FILE_SETTINGS).c_str());
+		return false;
+	}
+	AUDIO = false;
+
+	msg = new MessageEngine();
+	font = new FontEngine();
+	anim = new AnimationManager();
+	comb = new CombatText();
+	inpt = new InputState();
+	icons = NULL;
+
+	loadTilesetSettings();
+	loadMiscSettings();
+
+	render_device = getRenderDevice(render_device_name);
+	if (render_device->createContext(VIEW_W, VIEW_H) == -1) {
+		fprintf(stderr, "Could not create a rendering context: %s\n", SDL_GetError());
+		return false;
+	}
+
+	SharedResources::loadIcons();
+	snd = new SoundManager();
+	curs = new CursorManager();
+	prof = new Profiler();
+
+	return true;
+}
+
+static void cleanup(GameStatePlay *play) {
+	delete play;
+
+	delete anim;
+	delete comb;
+	delete font;
+	delete inpt;
+	delete mods;
+	delete msg;
+	delete snd;
+	delete curs;
+	delete prof;
+
+	if (render_device)
+		render_device->destroyContext();
+	delete render_device;
+
+	SDL_Quit();
+}
+
+static std::string parseArg(const std::string &arg) {
+	std::string result = "";
+
+	// arguments must start with '--'
+	if (arg.length() > 2 && arg[0] == '-' && arg[1] == '-') {
+		for (unsigned i = 2; i < arg.length(); ++i) {
+			if (arg[i] == '=') break;
+			result += arg[i];
+		}
+	}
+
+	return result;
+}
+
+static std::string parseArgValue(const std::string &arg) {
+	size_t pos = arg.find('=');
+	if (pos == std::string::npos) return "";
+	return arg.substr(pos+1);
+}
+
+int main(int argc, char *argv[]) {
+	std::string output_filename = "";
+
+	for (int i = 1 ; i < argc; i++) {
+		std::string arg = std::string(argv[i]);
+		if (parseArg(arg) == "data-path") {
+			CUSTOM_PATH_DATA = parseArgValue(arg);
+			if (!CUSTOM_PATH_DATA.empty() && CUSTOM_PATH_DATA.at(CUSTOM_PATH_DATA.length()-1) != '/')
+				CUSTOM_PATH_DATA += "/";
+		}
+		else if (parseArg(arg) == "renderer") {
+			render_device_name = parseArgValue(arg);
+		}
+		else if (parseArg(arg) == "seed") {
+			bench_seed = (unsigned int)strtoul(parseArgValue(arg).c_str(), NULL, 10);
+		}
+		else if (parseArg(arg) == "scale") {
+			iteration_scale = (float)atof(parseArgValue(arg).c_str());
+		}
+		else if (parseArg(arg) == "filter") {
+			bench_filter = parseArgValue(arg);
+		}
+		else if (parseArg(arg) == "output") {
+			output_filename = parseArgValue(arg);
+		}
+		else if (parseArg(arg) == "help") {
+			printf("\
+--help           Prints this message.\n\n\
+--data-path      Specifies an exact path to look for mod data.\n\n\
+--renderer       Rendering backend to measure. The default is 'null', which measures no pixel work.\n\n\
+--seed           Seed for the generated maps and random positions. The default is 1.\n\n\
+--scale          Multiplies the number of iterations of each benchmark.\n\n\
+--filter         Only runs benchmarks whose name contains this string.\n\n\
+--output         Writes results to the given file (.json or .csv) instead of JSON on stdout.\n");
+			return 0;
+		}
+	}
+
+	if (!init()) {
+		SDL_Quit();
+		return 1;
+	}
+
+	if (!createBenchMod()) {
+		cleanup(NULL);
+		return 1;
+	}
+
+	// the game state creates the shared game objects (mapr, pc, enemies, powers...)
+	GameStatePlay *play = new GameStatePlay();
+
+	benchMapLoad("map_load", "maps/bench_iso.txt");
+	benchMapLoad("map_load_compiled", "maps/bench_compiled.txt");
+	benchMapRender("render_iso", "maps/bench_iso.txt", TILESET_ISOMETRIC);
+	benchMapRender("render_ortho", "maps/bench_ortho.txt", TILESET_ORTHOGONAL);
+
+	benchPathfinding("path_short", 16, 256);
+	benchPathfinding("path_long", 0, 4096);
+	benchPathfinding("path_long_clusters", 0, 0);
+	benchPathfinding("path_short", 16, 256, true);
+	benchPathfinding("path_long", 0, 4096, true);
+	benchPathfinding("path_long_clusters", 0, 0, true);
+
+	benchPursuit(10, false);
+	benchPursuit(10, true);
+	benchPursuit(100, false);
+	benchPursuit(100, true);
+
+	benchPathBurst(200, false);
+	benchPathBurst(200, true);
+
+	benchHazards(50, 50);
+	benchHazards(200, 200);
+	benchHazards(500, 100);
+
+	benchFileParser();
+
+	bool written = writeResults(output_filename);
+
+	cleanup(play);
+	return written ? 0 : 1;
+}
@@ -16,129 +16,162 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 */
 
 #include "AStarContainer.h"
-#include <cstring>
-#include <cfloat>
 
-AStarContainer::AStarContainer(unsigned int map_width, unsigned int node_limit)
-	: size(0) {
-	nodes = new AStarNode*[node_limit];
-	map_pos = new astar_mapcol[map_width];
-
-	//initialise the map array. A -1 value will mean there is no node at that position
-	for(unsigned i = 0; i < map_width; ++i)
-		std::fill(map_pos[i], map_pos[i] + 256, -1);
+AStarContainer::AStarContainer()
+	: map_width(0)
+	, map_height(0)
+	, node_count(0)
+	, open_count(0)
+	, closed_count(0)
+	, closest(-1)
+	, generation(0) {
 }
 
 AStarContainer::~AStarContainer() {
-	for(unsigned int i=0; i<size; i++)
-		delete nodes[i];
-	delete [] nodes;
-	delete [] map_pos;
 }
 
-void AStarContainer::add(AStarNode* node) {
+void AStarContainer::reset(int _map_width, int _map_height, unsigned int node_limit) {
+	if (_map_width != map_width || _map_height != map_height) {
+		map_width = _map_width;
+		map_height = _map_height;
+		cell_generation.assign(map_width * map_height, 0);
+		cell_node.resize(map_width * map_height);
+		generation = 0;
+	}
 
-	//add the new node at the end and update its index
-	nodes[size] = node;
-	map_pos[node->getX()][node->getY()] = size;
+	// every closed node can add up to 8 neighbours, plus the start node
+	const unsigned int max_nodes = node_limit * 8 + 1;
+	if (nodes.size() < max_nodes) {
+		nodes.resize(max_nodes);
+		heap_index.resize(max_nodes);
+		open.resize(max_nodes);
+	}
 
-	//reorder the heap based on f ordering, staring with thenewly added node and working up the tree from there
-	int m = size;
+	node_count = 0;
+	open_count = 0;
+	closed_count = 0;
+	closest = -1;
 
-	AStarNode* temp = NULL;
-	while(m != 0) {
-		//if the current nodes f value is shorter than its parent, they need to be swapped
-		if(nodes[m]->getFinalCost() <= nodes[m/2]->getFinalCost()) {
-			temp = nodes[m/2];
-			nodes[m/2] = nodes[m];
-			map_pos[nodes[m/2]->getX()][nodes[m/2]->getY()] = m/2;
-			nodes[m] = temp;
-			map_pos[nodes[m]->getX()][nodes[m]->getY()] = m;
-			m=m/2;
-		}
-		else
-			break;
+	generation++;
+	if (generation == 0) {
+		// the counter wrapped around, so old stamps could look current
+		std::fill(cell_generation.begin(), cell_generation.end(), 0);
+		generation = 1;
 	}
-	size++;
 }
 
-AStarNode* AStarContainer::get_shortest_f() {
-	return nodes[0];
+int AStarContainer::findNode(int x, int y) const {
+	const int cell = y * map_width + x;
+	if (cell_generation[cell] != generation)
+		return -1;
+	return cell_node[cell];
 }
 
-void AStarContainer::remove(AStarNode* node) {
+void AStarContainer::swapOpen(unsigned int a, unsigned int b) {
+	const unsigned int temp = open[a];
+	open[a] = open[b];
+	open[b] = temp;
+	heap_index[open[a]] = a;
+	heap_index[open[b]] = b;
+}
 
-	unsigned int heap_indexv = map_pos[node->getX()][node->getY()] + 1;
+void AStarContainer::add(const Point &pos, const Point &parent, float actual_cost, float estimated_cost) {
+	const unsigned int n = node_count++;
+	nodes[n] = AStarNode(pos);
+	nodes[n].setParent(parent);
+	nodes[n].setActualCost(actual_cost);
+	nodes[n].setEstimatedCost(estimated_cost);
 
-	//swap the last node in the list with the node being deleted
-	nodes[heap_indexv-1] = nodes[size-1];
-	map_pos[nodes[heap_indexv-1]->getX()][nodes[heap_indexv-1]->getY()] = heap_indexv-1;
+	const int cell = pos.y * map_width + pos.x;
+	cell_generation[cell] = generation;
+	cell_node[cell] = n;
 
-	size--;
+	//add the new node at the end of the heap
+	open[open_count] = n;
+	heap_index[n] = open_count;
 
-	if(size == 0) {
-		map_pos[node->getX()][node->getY()] = -1;
-		return;
+	//reorder the heap based on f ordering, staring with thenewly added node and working up the tree from there
+	unsigned int m = open_count;
+	while(m != 0) {
+		//if the current nodes f value is shorter than its parent, they need to be swapped
+		if(nodes[open[m]].getFinalCost() <= nodes[open[m/2]].getFinalCost()) {
+			swapOpen(m, m/2);
+			m=m/2;
+		}
+		else
+			break;
 	}
+	open_count++;
+}
+
+AStarNode* AStarContainer::close_shortest_f() {
+	const unsigned int n = open[0];
 
-	// reorder the heap to maintain the f ordering, starting at the node which replaced the deleted node, and working down the tree
+	//swap the last node in the heap with the node being closed
+	unsigned int heap_indexv = 1;
+	open[0] = open[open_count-1];
+	heap_index[open[0]] = 0;
+	open_count--;
 
-	while(true) {
+	// reorder the heap to maintain the f ordering, starting at the node which replaced the closed node, and working down the tree
+	while(open_count > 0) {
 		//start at the node which dropped down the tree on the previous iteration
 		unsigned int heap_indexu = heap_indexv;
-		if(2*heap_indexu+1 <= size) { //if both children exist
+		if(2*heap_indexu+1 <= open_count) { //if both children exist
 			//Select the lowest of the two children.
-			if(nodes[heap_indexu-1]->getFinalCost() >= nodes[2*heap_indexu-1]->getFinalCost()) heap_indexv = 2*heap_indexu;
-			if(nodes[heap_indexv-1]->getFinalCost() >= nodes[2*heap_indexu]->getFinalCost()) heap_indexv = 2*heap_indexu+1;
+			if(nodes[open[heap_indexu-1]].getFinalCost() >= nodes[open[2*heap_indexu-1]].getFinalCost()) heap_indexv = 2*heap_indexu;
+			if(nodes[open[heap_indexv-1]].getFinalCost() >= nodes[open[2*heap_indexu]].getFinalCost()) heap_indexv = 2*heap_indexu+1;
 		}
-		else if (2*heap_indexu <= size) { //if only child #1 exists
+		else if (2*heap_indexu <= open_count) { //if only child #1 exists
 			//Check if the F cost is greater than the child
-			if(nodes[heap_indexu-1]->getFinalCost() >= nodes[2*heap_indexu-1]->getFinalCost()) heap_indexv = 2*heap_indexu;
+			if(nodes[open[heap_indexu-1]].getFinalCost() >= nodes[open[2*heap_indexu-1]].getFinalCost()) heap_indexv = 2*heap_indexu;
 		}
 
 		if(heap_indexu != heap_indexv) { //If parent's F > one or both of its children, swap them
-			AStarNode* temp = nodes[heap_indexu-1];
-			nodes[heap_indexu-1] = nodes[heap_indexv-1];
-			map_pos[nodes[heap_indexu-1]->getX()][nodes[heap_indexu-1]->getY()] = heap_indexu-1;
-			nodes[heap_indexv-1] = temp;
-			map_pos[nodes[heap_indexv-1]->getX()][nodes[heap_indexv-1]->getY()] = heap_indexv-1;
+			swapOpen(heap_indexu-1, heap_indexv-1);
 		}
 		else {
 			break;//if item <= both children, exit loop
 		}
 	}//Repeat forever
 
-	//remove the node from the map pos index
-	map_pos[node->getX()][node->getY()] = -1;
+	heap_index[n] = -1;
+	closed_count++;
+	if (closest == -1 || nodes[n].getH() < nodes[closest].getH())
+		closest = n;
+
+	return &nodes[n];
 }
 
-bool AStarContainer::exists(Point pos) {
-	return map_pos[pos.x][pos.y] != -1;
+bool AStarContainer::isEmpty() const {
+	return open_count == 0;
 }
 
-AStarNode* AStarContainer::get(int x, int y) {
-	return nodes[map_pos[x][y]];
+bool AStarContainer::isOpen(const Point &pos) const {
+	const int n = findNode(pos.x, pos.y);
+	return n != -1 && heap_index[n] != -1;
 }
 
-bool AStarContainer::isEmpty() {
-	return size == 0;
+bool AStarContainer::isClosed(const Point &pos) const {
+	const int n = findNode(pos.x, pos.y);
+	return n != -1 && heap_index[n] == -1;
+}
+
+AStarNode* AStarContainer::get(int x, int y) {
+	return &nodes[findNode(x, y)];
 }
 
 void AStarContainer::updateParent(Point pos, Point parent_pos, float score) {
-	get(pos.x, pos.y)->setParent(parent_pos);
-	get(pos.x, pos.y)->setActualCost(score);
+	const int n = findNode(pos.x, pos.y);
+	nodes[n].setParent(parent_pos);
+	nodes[n].setActualCost(score);
 
 	//reorder the heap based on the new f value of this node. starting at the updated node and working up the tree
-	int m = map_pos[pos.x][pos.y];
-	AStarNode* temp = NULL;
+	unsigned int m = heap_index[n];
 	while(m != 0) {
 		//if the current node has a lower f value than its parent in the heap, swap them
-		if(nodes[m]->getFinalCost() <= nodes[m/2]->getFinalCost()) {
-			temp = nodes[m/2];
-			nodes[m/2] = nodes[m];
-			map_pos[nodes[m/2]->getX()][nodes[m/2]->getY()] = m/2;
-			nodes[m] = temp;
-			map_pos[nodes[m]->getX()][nodes[m]->getY()] = m;
+		if(nodes[open[m]].getFinalCost() <= nodes[open[m/2]].getFinalCost()) {
+			swapOpen(m, m/2);
 			m=m/2;
 		}
 		else
@@ -146,49 +179,22 @@ void AStarContainer::updateParent(Point pos, Point parent_pos, float score) {
 	}
 }
 
-AStarCloseContainer::AStarCloseContainer(unsigned int map_width, unsigned int node_limit)
-	: size(0) {
-	nodes = new AStarNode*[node_limit];
-	map_pos = new astar_mapcol[map_width];
-
-	//initialise the map index array. A -1 value will mean there is no node at that position
-	for (unsigned i = 0; i < map_width; ++i)
-		std::fill(map_pos[i], map_pos[i] + 256, -1);
-}
+/**
+ * Move a closed node back to the open nodes, because a shorter way to it was found
+ */
+void AStarContainer::reopen(const Point &pos, const Point &parent_pos, float score) {
+	const int n = findNode(pos.x, pos.y);
+	open[open_count] = n;
+	heap_index[n] = open_count;
+	open_count++;
 
-AStarCloseContainer::~AStarCloseContainer() {
-	for(unsigned int i=0; i<size; i++)
-		delete nodes[i];
-	delete [] nodes;
-	delete [] map_pos;
+	updateParent(pos, parent_pos, score);
 }
 
-int AStarCloseContainer::getSize() {
-	return size;
+unsigned int AStarContainer::getClosedSize() const {
+	return closed_count;
 }
 
-void AStarCloseContainer::add(AStarNode* node) {
-	nodes[size] = node;
-	map_pos[node->getX()][node->getY()] = size;
-	size++;
-}
-
-bool AStarCloseContainer::exists(Point pos) {
-	return map_pos[pos.x][pos.y] != -1;
-}
-
-AStarNode* AStarCloseContainer::get(int x, int y) {
-	return nodes[map_pos[x][y]];
-}
-
-AStarNode* AStarCloseContainer::get_shortest_h() {
-	AStarNode *current = NULL;
-	float lowest_score = FLT_MAX;
-	for(unsigned int i = 0; i < size; i++) {
-		if(nodes[i]->getH() < lowest_score) {
-			lowest_score = nodes[i]->getH();
-			current = nodes[i];
-		}
-	}
-	return current;
+AStarNode* AStarContainer::get_shortest_h() {
+	return &nodes[closest];
 }
@@ -20,35 +20,60 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include "AStarNode.h"
 
-/* Designed to be used for the Open nodes.
-*  Unsuitable for Closed nodes but a close node conatiner is declared below
+#include <vector>
+
+/* Holds the open and closed nodes of an A* search.
+*
+*  The container is meant to be kept around and reused: reset() starts a new search,
+*  and all of the memory from earlier searches is kept, so once the container has grown
+*  to the size of the map and the node limit, a search doesn't allocate anything.
 *
 *  All code in the class assumes that the nodes and points provided are within the bounds of the map limits
 */
-typedef short astar_mapcol[256];
 class AStarContainer {
 public:
-	AStarContainer(unsigned int _map_width, unsigned int node_limit);
-	AStarContainer(const AStarContainer&); // copy constructor not yet implemented
-
+	AStarContainer();
 	~AStarContainer();
-	//assumes that the node is not already in the collection
-	void add(AStarNode* node);
-	//assumes that there is at least 1 node in the collection
-	AStarNode* get_shortest_f();
-	//assumes that the node exists in the collection
-	void remove(AStarNode* node);
-	bool exists(Point pos);
-	//assumes that the node exists in the collection
+
+	// start a new search, forgetting all of the nodes of the previous one
+	void reset(int _map_width, int _map_height, unsigned int node_limit);
+
+	//assumes that there is no node at this position yet
+	void add(const Point &pos, const Point &parent, float actual_cost, float estimated_cost);
+	//assumes that there is at least 1 open node. moves the open node with the lowest f value to the closed nodes
+	AStarNode* close_shortest_f();
+	bool isEmpty() const;
+	bool isOpen(const Point &pos) const;
+	bool isClosed(const Point &pos) const;
+	//assumes that a node exists at this position
 	AStarNode* get(int x, int y);
-	bool isEmpty();
+	//assumes that the open node exists
 	void updateParent(Point pos, Point parent_pos, float score);
+	//assumes that the node is closed
+	void reopen(const Point &pos, const Point &parent_pos, float score);
+
+	unsigned int getClosedSize() const;
+	//the closed node which is closest to the goal
+	AStarNode* get_shortest_h();
 
 private:
-	unsigned int size;
+	int findNode(int x, int y) const;
+	void swapOpen(unsigned int a, unsigned int b);
 
-	/* This is an array of AStarNode pointers. This is the main data for this collection.
-	*  The size of the array is based on the node limit.
+	int map_width;
+	int map_height;
+
+	/* Storage for every node of the search, open or closed. The vector only ever grows;
+	*  node_count is the number of slots in use by the current search.
+	*/
+	std::vector<AStarNode> nodes;
+	unsigned int node_count;
+
+	/* For each node, its position in the open heap, or -1 once the node is closed */
+	std::vector<int> heap_index;
+
+	/* This is an array of node indexes which makes up the open list.
+	*  open_count is the number of open nodes.
 	*
 	*  The nodes in this array are ordered based on their f value and the node with the lowest f value is always at position 0.
 	*  The ordering is not linear, so after positon 0, we cannot assume that position 1 has the second shortest f value.
@@ -61,46 +86,22 @@ private:
 	*  Node 1 would have children at position 3 and 4 and node 2 would have children at position 5 and 6 and so on
 	*
 	*  A more detailed explanation of the structure can be found at the below web address.
-	*  Please note that there is additional code found in this class which is not mentioned in the article. This is to provide an index based on map position.
 	*  Also note that the code within the article is based on arrays with starting position 1, whereas we use 0 based arrays.
 	*  http://www.policyalmanac.org/games/binaryHeaps.htm
 	*/
-	AStarNode** nodes;
+	std::vector<unsigned int> open;
+	unsigned int open_count;
 
-	/* This is an array of astar_mapcol (short[256]) which acts as an index for the main node array.
-	*  Its essentially a 2d array: short[map_width][256],
-	*  so elements can be accessed using cartesian coordinates e.g. map_pos[x][y]
-	*  To access an AStarNode based on map position use: nodes[map_pos[x][y]]
-	*
-	*  The map height is always set to 256 even if the actual map is smaller.
-	*  This helps with initialisation and potentially allows the compiler to optimise array access.
-	*
-	*  The data in this array is initialised as -1, which indicates hat there is no corresponding node for that position
-	*  This must be maintained when nodes are added, removed and re-ordered in the node array
-	*/
-	astar_mapcol* map_pos;
-};
-
-/* This class is used to store the closed list of a* nodes
-*  The nodes within this class have no ordering but stil have a map position index
-*/
-class AStarCloseContainer {
-public:
-	AStarCloseContainer(unsigned int _map_width, unsigned int node_limit);
-	AStarCloseContainer(const AStarCloseContainer&); // copy constructor not yet implemented
-	~AStarCloseContainer();
-
-	int getSize();
-	void add(AStarNode* node);
-	bool exists(Point pos);
-	AStarNode* get(int x, int y);
-	AStarNode* get_shortest_h();
-
-private:
-	unsigned int size;
-	AStarNode** nodes;
-	astar_mapcol* map_pos;
+	unsigned int closed_count;
+	int closest; // the closed node with the lowest h value, or -1
 
+	/* A grid the size of the map which maps positions to node indexes.
+	*  A cell only belongs to the current search if its generation matches the current one,
+	*  so starting a new search doesn't need to clear the grid.
+	*/
+	std::vector<unsigned int> cell_generation;
+	std::vector<unsigned int> cell_node;
+	unsigned int generation;
 };
 
 #endif // ASTARCONTAINER_H
@@ -71,54 +71,6 @@ void AStarNode::setParent(const Point& p) {
 	this->parent = p;
 }
 
-std::list<Point> AStarNode::getNeighbours(int limitX, int limitY) const {
-	Point toAdd;
-	std::list<Point> res;
-	if (x>node_stride && y>node_stride) {
-		toAdd.x = x-node_stride;
-		toAdd.y = y-node_stride;
-		res.push_back(toAdd);
-	}
-	if (x>node_stride && (limitY==0 || y<limitY-node_stride)) {
-		toAdd.x = x-node_stride;
-		toAdd.y = y+node_stride;
-		res.push_back(toAdd);
-	}
-	if (y>node_stride && (limitX==0 || x<limitX-node_stride)) {
-		toAdd.x = x+node_stride;
-		toAdd.y = y-node_stride;
-		res.push_back(toAdd);
-	}
-	if ((limitX==0 || x<limitX-node_stride) && (limitY==0 || y<limitY-node_stride)) {
-		toAdd.x = x+node_stride;
-		toAdd.y = y+node_stride;
-		res.push_back(toAdd);
-	}
-	if (x>node_stride) {
-		toAdd.x = x-node_stride;
-		toAdd.y = y;
-		res.push_back(toAdd);
-	}
-	if (y>node_stride) {
-		toAdd.x = x;
-		toAdd.y = y-node_stride;
-		res.push_back(toAdd);
-	}
-	if (limitX==0 || x<limitX-node_stride) {
-		toAdd.x = x+node_stride;
-		toAdd.y = y;
-		res.push_back(toAdd);
-	}
-	if (limitY==0 || y<limitY-node_stride) {
-		toAdd.x = x;
-		toAdd.y = y+node_stride;
-		res.push_back(toAdd);
-	}
-
-	return res;
-}
-
-
 float AStarNode::getActualCost() const {
 	return g;
 }
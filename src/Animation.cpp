@@ -33,6 +33,7 @@ using namespace std;
 
 Animation::Animation(const std::string &_name, const std::string &_type, Image *_sprite)
 	: name(_name)
+	, name_id(internString(_name))
 	, type(	_type == "play_once" ? PLAY_ONCE :
 			_type == "back_forth" ? BACK_FORTH :
 			_type == "looped" ? LOOPED :
@@ -56,6 +57,7 @@ Animation::Animation(const std::string &_name, const std::string &_type, Image *
 
 Animation::Animation(const Animation& a)
 	: name(a.name)
+	, name_id(a.name_id)
 	, type(a.type)
 	, sprite(a.sprite)
 	, number_frames(a.number_frames)
@@ -269,10 +271,14 @@ int Animation::getTimesPlayed() {
 	return times_played;
 }
 
-std::string Animation::getName() {
+const std::string &Animation::getName() {
 	return name;
 }
 
+StringID Animation::getNameID() const {
+	return name_id;
+}
+
 bool Animation::isCompleted() {
 	return (type == PLAY_ONCE && times_played > 0);
 }
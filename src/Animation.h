@@ -47,6 +47,7 @@ protected:
 	unsigned short getLastFrameIndex(const short &frame); // given a frame, gets the last index of frames that matches
 
 	const std::string name;
+	const StringID name_id;
 	const animation_type type;
 	Image *sprite;
 
@@ -122,7 +123,8 @@ public:
 	// resets to beginning of the animation
 	void reset();
 
-	std::string getName();
+	const std::string &getName();
+	StringID getNameID() const;
 
 	// a vector of indexes of gfx passed into.
 	// if { -1 } is passed, all frames are set to active.
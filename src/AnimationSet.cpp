@@ -32,10 +32,14 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 using namespace std;
 
 Animation *AnimationSet::getAnimation(const std::string &_name) {
+	return getAnimation(internString(_name));
+}
+
+Animation *AnimationSet::getAnimation(StringID _name) {
 	if (!loaded)
 		load();
 	for (size_t i = 0; i < animations.size(); i++)
-		if (animations[i]->getName() == _name)
+		if (animations[i]->getNameID() == _name)
 			return new Animation(*animations[i]);
 	return new Animation(*defaultAnimation);
 }
@@ -195,6 +199,23 @@ void AnimationSet::load() {
 	}
 }
 
+/**
+ * Queue the sprite sheet of an animation definition, see AssetLoader.
+ * Safe to call on a worker thread.
+ */
+void AnimationSet::preload(AssetLoader &loader, const std::string &filename) {
+	FileParser parser;
+	if (!parser.open(filename, true, ""))
+		return;
+
+	while (parser.next()) {
+		if (parser.key == "image") {
+			loader.addImage(parser.val);
+			return;
+		}
+	}
+}
+
 AnimationSet::~AnimationSet() {
 	if (sprite) sprite->unref();
 	for (unsigned i = 0; i < animations.size(); ++i)
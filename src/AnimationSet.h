@@ -21,8 +21,10 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #define __ANIMATION_SET__
 
 #include "CommonIncludes.h"
+#include "StringID.h"
 
 class Animation;
+class AssetLoader;
 
 /**
  * The animation set contains all animations of one entity, hence it
@@ -55,6 +57,7 @@ public:
 	 * a default animation is returned.
 	 */
 	Animation *getAnimation(const std::string &name);
+	Animation *getAnimation(StringID name);
 
 	/**
 	 * callee is responsible to free the returned animation.
@@ -63,6 +66,8 @@ public:
 	 */
 	Animation *getAnimation();
 
+	static void preload(AssetLoader &loader, const std::string &filename);
+
 	const std::string &getName() {
 		return name;
 	}
@@ -0,0 +1,183 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+
+#include <stdio.h>
+
+#include "AssetLoader.h"
+#include "Settings.h"
+#include "SharedResources.h"
+#include "WorkerPool.h"
+
+AssetLoader::AssetLoader()
+	: workers(NULL)
+	, mutex(SDL_CreateMutex()) {
+}
+
+AssetLoader::~AssetLoader() {
+	clear();
+	delete workers;
+	SDL_DestroyMutex(mutex);
+}
+
+void AssetLoader::addJob(Job job, const std::string &filename) {
+	if (filename.empty())
+		return;
+
+	SDL_LockMutex(mutex);
+	if (queued_jobs.insert(filename).second)
+		jobs.push_back(std::make_pair(job, filename));
+	SDL_UnlockMutex(mutex);
+}
+
+void AssetLoader::addImage(const std::string &filename) {
+	if (filename.empty())
+		return;
+
+	SDL_LockMutex(mutex);
+	if (queued_assets.insert(filename).second) {
+		queued.push_back(Asset());
+		queued.back().filename = filename;
+	}
+	SDL_UnlockMutex(mutex);
+}
+
+void AssetLoader::addSound(const std::string &filename) {
+	if (filename.empty())
+		return;
+
+	SDL_LockMutex(mutex);
+	if (queued_assets.insert(filename).second) {
+		queued.push_back(Asset());
+		queued.back().filename = filename;
+		queued.back().sound = true;
+	}
+	SDL_UnlockMutex(mutex);
+}
+
+/**
+ * Run the queued jobs, then decode the assets they queued. Both stages are
+ * spread over the worker threads, and run() returns once all of it is done.
+ */
+void AssetLoader::run() {
+	if (jobs.empty() && queued.empty())
+		return;
+
+	if (!workers)
+		workers = new WorkerPool(0);
+
+	// jobs may queue more jobs, e.g. an enemy queues its animations
+	while (!jobs.empty()) {
+		running.swap(jobs);
+		workers->run(runJob, this, running.size());
+		running.clear();
+	}
+	queued_jobs.clear();
+
+	// asking the render device and sound manager isn't thread-safe, so that
+	// is done here. Assets which are loaded already don't need to be decoded again.
+	for (unsigned i = 0; i < queued.size(); ++i) {
+		Asset &asset = queued[i];
+		if (asset.sound) {
+			if (!AUDIO || !SOUND_VOLUME || !snd || snd->isLoaded(asset.filename) || sounds.find(asset.filename) != sounds.end())
+				continue;
+		}
+		else {
+			if (!render_device || !render_device->needsImage(asset.filename) || images.find(asset.filename) != images.end())
+				continue;
+		}
+		asset.path = mods->locate(asset.filename);
+		decoding.push_back(asset);
+	}
+	queued.clear();
+	queued_assets.clear();
+
+	workers->run(decodeAsset, this, decoding.size());
+
+	for (unsigned i = 0; i < decoding.size(); ++i) {
+		if (decoding[i].surface)
+			images[decoding[i].filename] = decoding[i].surface;
+		if (decoding[i].chunk)
+			sounds[decoding[i].filename] = decoding[i].chunk;
+	}
+	decoding.clear();
+}
+
+/**
+ * Release the decoded assets nobody took
+ */
+void AssetLoader::clear() {
+	for (std::map<std::string, SDL_Surface*>::iterator it = images.begin(); it != images.end(); ++it)
+		SDL_FreeSurface(it->second);
+	images.clear();
+
+	for (std::map<std::string, Mix_Chunk*>::iterator it = sounds.begin(); it != sounds.end(); ++it)
+		Mix_FreeChunk(it->second);
+	sounds.clear();
+}
+
+/**
+ * Hand over a decoded image, or NULL if it has to be loaded from the file.
+ * The caller owns the surface.
+ */
+SDL_Surface *AssetLoader::takeImage(const std::string &filename) {
+	std::map<std::string, SDL_Surface*>::iterator it = images.find(filename);
+	if (it == images.end())
+		return NULL;
+
+	SDL_Surface *surface = it->second;
+	images.erase(it);
+	return surface;
+}
+
+/**
+ * Hand over a decoded sound, or NULL if it has to be loaded from the file.
+ * The caller owns the chunk.
+ */
+Mix_Chunk *AssetLoader::takeSound(const std::string &filename) {
+	std::map<std::string, Mix_Chunk*>::iterator it = sounds.find(filename);
+	if (it == sounds.end())
+		return NULL;
+
+	Mix_Chunk *chunk = it->second;
+	sounds.erase(it);
+	return chunk;
+}
+
+void AssetLoader::runJob(void *data, int part) {
+	AssetLoader *loader = static_cast<AssetLoader*>(data);
+	loader->running[part].first(*loader, loader->running[part].second);
+}
+
+void AssetLoader::decodeAsset(void *data, int part) {
+	Asset &asset = static_cast<AssetLoader*>(data)->decoding[part];
+
+	if (asset.sound) {
+		asset.chunk = Mix_LoadWAV_RW(mods->openRW(asset.path), 1);
+		return;
+	}
+
+	asset.surface = IMG_Load_RW(mods->openRW(asset.path), 1);
+#if SDL_VERSION_ATLEAST(2,0,0)
+	// the format conversion doesn't need the display, so it's done here too
+	if (asset.surface) {
+		SDL_Surface *converted = SDL_ConvertSurfaceFormat(asset.surface, SDL_PIXELFORMAT_ARGB8888, 0);
+		SDL_FreeSurface(asset.surface);
+		asset.surface = converted;
+	}
+#endif
+}
@@ -0,0 +1,92 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+
+/**
+ * class AssetLoader
+ *
+ * Decodes the images and sounds which are about to be loaded on worker
+ * threads, so a batch of them takes about as long as the largest one. Jobs
+ * read definition files, such as animations or enemies, in parallel and queue
+ * the assets they mention. run() does the work; afterwards loadImage() and
+ * SoundManager::load() take the decoded data and only register it on the main
+ * thread. Anything that wasn't queued is still loaded the usual way.
+ */
+
+#pragma once
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include "CommonIncludes.h"
+
+class WorkerPool;
+
+class AssetLoader {
+public:
+	// a job reads the definition file filename and queues the assets in it
+	typedef void (*Job)(AssetLoader &loader, const std::string &filename);
+
+	AssetLoader();
+	~AssetLoader();
+
+	// these may be called by jobs on worker threads
+	void addJob(Job job, const std::string &filename);
+	void addImage(const std::string &filename);
+	void addSound(const std::string &filename);
+
+	void run();
+	void clear();
+
+	SDL_Surface *takeImage(const std::string &filename);
+	Mix_Chunk *takeSound(const std::string &filename);
+
+private:
+	AssetLoader(const AssetLoader &copy); // not implemented
+
+	class Asset {
+	public:
+		std::string filename;
+		std::string path;
+		bool sound;
+		SDL_Surface *surface;
+		Mix_Chunk *chunk;
+
+		Asset()
+			: sound(false)
+			, surface(NULL)
+			, chunk(NULL) {
+		}
+	};
+
+	static void runJob(void *data, int part);
+	static void decodeAsset(void *data, int part);
+
+	WorkerPool *workers;
+	SDL_mutex *mutex;
+
+	std::vector<std::pair<Job, std::string> > jobs;
+	std::vector<std::pair<Job, std::string> > running;
+	std::set<std::string> queued_jobs;
+	std::vector<Asset> queued;
+	std::vector<Asset> decoding;
+	std::set<std::string> queued_assets;
+
+	std::map<std::string, SDL_Surface*> images;
+	std::map<std::string, Mix_Chunk*> sounds;
+};
+
+#endif
@@ -191,12 +191,21 @@ void Avatar::loadGraphics(std::vector<Layer_gfx> _img_gfx) {
 	animsets.clear();
 	anims.clear();
 
+	// decode the sprite sheets of all layers at once
+	if (assets) {
+		for (unsigned int i=0; i<_img_gfx.size(); i++) {
+			if (_img_gfx[i].gfx != "")
+				assets->addJob(AnimationSet::preload, "animations/avatar/"+stats.gfx_base+"/"+_img_gfx[i].gfx+".txt");
+		}
+		assets->run();
+	}
+
 	for (unsigned int i=0; i<_img_gfx.size(); i++) {
 		if (_img_gfx[i].gfx != "") {
 			string name = "animations/avatar/"+stats.gfx_base+"/"+_img_gfx[i].gfx+".txt";
 			anim->increaseCount(name);
 			animsets.push_back(anim->getAnimationSet(name));
-			anims.push_back(animsets.back()->getAnimation(activeAnimation->getName()));
+			anims.push_back(animsets.back()->getAnimation(activeAnimation->getNameID()));
 			anims.back()->syncTo(activeAnimation);
 		}
 		else {
@@ -469,7 +478,7 @@ void Avatar::logic(int actionbar_power, bool restrictPowerUse) {
 	switch(stats.cur_state) {
 		case AVATAR_STANCE:
 
-			setAnimation("stance");
+			setAnimation(SID_STANCE);
 
 			// allowed to move or use powers?
 			if (MOUSE_MOVE) {
@@ -508,7 +517,7 @@ void Avatar::logic(int actionbar_power, bool restrictPowerUse) {
 
 		case AVATAR_RUN:
 
-			setAnimation("run");
+			setAnimation(SID_RUN);
 
 			if (sound_steps.size() > 0) {
 				stepfx = rand() % sound_steps.size();
@@ -542,7 +551,7 @@ void Avatar::logic(int actionbar_power, bool restrictPowerUse) {
 			if (allowed_to_use_power)
 				handlePower(actionbar_power);
 
-			if (activeAnimation->getName() != "run")
+			if (activeAnimation->getNameID() != SID_RUN)
 				stats.cur_state = AVATAR_STANCE;
 
 			break;
@@ -553,10 +562,10 @@ void Avatar::logic(int actionbar_power, bool restrictPowerUse) {
 
 			if (MOUSE_MOVE) lockAttack = true;
 
-			if (activeAnimation->isFirstFrame() && attack_anim == "swing")
+			if (activeAnimation->isFirstFrame() && attack_anim == SID_SWING)
 				snd->play(sound_melee);
 
-			if (activeAnimation->isFirstFrame() && attack_anim == "cast")
+			if (activeAnimation->isFirstFrame() && attack_anim == SID_CAST)
 				snd->play(sound_mental);
 
 			// do power
@@ -564,7 +573,7 @@ void Avatar::logic(int actionbar_power, bool restrictPowerUse) {
 				powers->activate(current_power, &stats, act_target);
 			}
 
-			if (activeAnimation->getTimesPlayed() >= 1 || activeAnimation->getName() != attack_anim) {
+			if (activeAnimation->getTimesPlayed() >= 1 || activeAnimation->getNameID() != attack_anim) {
 				stats.cur_state = AVATAR_STANCE;
 				stats.cooldown_ticks += stats.cooldown;
 			}
@@ -572,9 +581,9 @@ void Avatar::logic(int actionbar_power, bool restrictPowerUse) {
 
 		case AVATAR_BLOCK:
 
-			setAnimation("block");
+			setAnimation(SID_BLOCK);
 
-			if (powers->powers[actionbar_power].new_state != POWSTATE_BLOCK || activeAnimation->getName() != "block") {
+			if (powers->powers[actionbar_power].new_state != POWSTATE_BLOCK || activeAnimation->getNameID() != SID_BLOCK) {
 				stats.cur_state = AVATAR_STANCE;
 				stats.effects.triggered_block = false;
 				stats.effects.clearTriggerEffects(TRIGGER_BLOCK);
@@ -583,13 +592,13 @@ void Avatar::logic(int actionbar_power, bool restrictPowerUse) {
 
 		case AVATAR_HIT:
 
-			setAnimation("hit");
+			setAnimation(SID_HIT);
 
 			if (activeAnimation->isFirstFrame()) {
 				stats.effects.triggered_hit = true;
 			}
 
-			if (activeAnimation->getTimesPlayed() >= 1 || activeAnimation->getName() != "hit") {
+			if (activeAnimation->getTimesPlayed() >= 1 || activeAnimation->getNameID() != SID_HIT) {
 				stats.cur_state = AVATAR_STANCE;
 			}
 
@@ -603,7 +612,7 @@ void Avatar::logic(int actionbar_power, bool restrictPowerUse) {
 				untransform();
 			}
 
-			setAnimation("die");
+			setAnimation(SID_DIE);
 
 			if (!stats.corpse && activeAnimation->isFirstFrame() && activeAnimation->getTimesPlayed() < 1) {
 				stats.effects.clearEffects();
@@ -630,7 +639,7 @@ void Avatar::logic(int actionbar_power, bool restrictPowerUse) {
 				}
 			}
 
-			if (activeAnimation->getTimesPlayed() >= 1 || activeAnimation->getName() != "die") {
+			if (activeAnimation->getTimesPlayed() >= 1 || activeAnimation->getNameID() != SID_DIE) {
 				stats.corpse = true;
 			}
 
@@ -772,7 +781,7 @@ void Avatar::untransform() {
 
 	// This is a bit of a hack.
 	// In order to switch to the stance animation, we can't already be in a stance animation
-	setAnimation("run");
+	setAnimation(SID_RUN);
 
 	stats.starting[STAT_DMG_MELEE_MIN] = hero_stats->starting[STAT_DMG_MELEE_MIN];
 	stats.starting[STAT_DMG_MELEE_MAX] = hero_stats->starting[STAT_DMG_MELEE_MAX];
@@ -802,8 +811,8 @@ void Avatar::untransform() {
 	stats.applyEffects();
 }
 
-void Avatar::setAnimation(std::string name) {
-	if (name == activeAnimation->getName())
+void Avatar::setAnimation(StringID name) {
+	if (name == activeAnimation->getNameID())
 		return;
 
 	Entity::setAnimation(name);
@@ -75,7 +75,7 @@ private:
 
 	std::vector<SoundManager::SoundID> sound_steps;
 
-	void setAnimation(std::string name);
+	void setAnimation(StringID name);
 	std::vector<AnimationSet*> animsets; // hold the animations for all equipped items in the right order of drawing.
 	std::vector<Animation*> anims; // hold the animations for all equipped items in the right order of drawing.
 
@@ -107,7 +107,7 @@ public:
 	void set_direction();
 	std::string log_msg;
 
-	std::string attack_anim;
+	StringID attack_anim;
 
 	// transformation handling
 	void transform();
@@ -30,15 +30,21 @@ BehaviorStandard::BehaviorStandard(Enemy *_e) : EnemyBehavior(_e)
 	, prev_target()
 	, collided(false)
 	, path_found(false)
-	, chance_calc_path(0) {
+	, chance_calc_path(0)
+	, path_ticket(0) {
 	los = false;
 	hero_dist = 0;
 	target_dist = 0;
 	pursue_pos.x = pursue_pos.y = -1;
+	pursuing_hero = false;
 	fleeing = false;
 	move_to_safe_dist = false;
 }
 
+BehaviorStandard::~BehaviorStandard() {
+	clearPath();
+}
+
 /**
  * One frame of logic for this behavior
  */
@@ -99,7 +105,7 @@ void BehaviorStandard::doUpkeep() {
 		bool source_ally = false;
 		bool source_enemy = false;
 		for (unsigned i=0; i<e->stats.effects.effect_list.size(); i++) {
-			if (e->stats.effects.effect_list[i].type == "damage") {
+			if (e->stats.effects.effect_list[i].type == SID_DAMAGE) {
 				switch(e->stats.effects.effect_list[i].source_type) {
 					case(SOURCE_TYPE_ALLY):
 						source_ally = true;
@@ -190,6 +196,7 @@ void BehaviorStandard::findTarget() {
 	// by default, the enemy pursues the hero directly
 	pursue_pos.x = pc->stats.pos.x;
 	pursue_pos.y = pc->stats.pos.y;
+	pursuing_hero = true;
 	target_dist = hero_dist;
 
 
@@ -202,6 +209,7 @@ void BehaviorStandard::findTarget() {
 				if (ally_dist < target_dist) {
 					pursue_pos.x = enemies->enemies[i]->stats.pos.x;
 					pursue_pos.y = enemies->enemies[i]->stats.pos.y;
+					pursuing_hero = false;
 					target_dist = ally_dist;
 				}
 			}
@@ -220,6 +228,7 @@ void BehaviorStandard::findTarget() {
 		FPoint waypoint = e->stats.waypoints.front();
 		pursue_pos.x = waypoint.x;
 		pursue_pos.y = waypoint.y;
+		pursuing_hero = false;
 	}
 
 	// check line-of-sight
@@ -384,54 +393,65 @@ void BehaviorStandard::checkMove() {
 			// if blocked, face in pathfinder direction instead
 			if (!mapr->collider.line_of_movement(e->stats.pos.x, e->stats.pos.y, pursue_pos.x, pursue_pos.y, e->stats.movement_type)) {
 
-				// if a path is returned, target first waypoint
+				// the hero is chased by following the flow field all enemies share; after
+				// bumping into another entity, a path of our own leads around it
+				if (pursuing_hero && !collided && mapr->collider.get_flow_step(e->stats.pos, pursue_pos, e->stats.movement_type)) {
+					clearPath();
+				}
+				else {
+					// if a path is returned, target first waypoint
 
-				bool recalculate_path = false;
+					bool recalculate_path = false;
 
-				//if theres no path, it needs to be calculated
-				if(path.empty())
-					recalculate_path = true;
+					//if theres no path, it needs to be calculated
+					if(path.empty())
+						recalculate_path = true;
 
-				//if the target moved more than 1 tile away, recalculate
-				if(calcDist(map_to_collision(prev_target), map_to_collision(pursue_pos)) > 1.f)
-					recalculate_path = true;
+					//if the target moved more than 1 tile away, recalculate
+					if(calcDist(map_to_collision(prev_target), map_to_collision(pursue_pos)) > 1.f)
+						recalculate_path = true;
 
-				//if a collision ocurred then recalculate
-				if(collided)
-					recalculate_path = true;
+					//if a collision ocurred then recalculate
+					if(collided)
+						recalculate_path = true;
 
-				//add a 5% chance to recalculate on every frame. This prevents reclaulating lots of entities in the same frame
-				chance_calc_path += 5;
+					//add a 5% chance to recalculate on every frame. This prevents reclaulating lots of entities in the same frame
+					chance_calc_path += 5;
 
-				if(percentChance(chance_calc_path))
-					recalculate_path = true;
+					if(percentChance(chance_calc_path))
+						recalculate_path = true;
 
-				//dont recalculate if we were blocked and no path was found last time
-				//this makes sure that pathfinding calculation is not spammed when the target is unreachable and the entity is as close as its going to get
-				if(!path_found && collided && !percentChance(chance_calc_path))
-					recalculate_path = false;
-				else//reset the collision flag only if we dont want the cooldown in place
-					collided = false;
+					//dont recalculate if we were blocked and no path was found last time
+					//this makes sure that pathfinding calculation is not spammed when the target is unreachable and the entity is as close as its going to get
+					if(!path_found && collided && !percentChance(chance_calc_path))
+						recalculate_path = false;
+					else//reset the collision flag only if we dont want the cooldown in place
+						collided = false;
 
-				prev_target = pursue_pos;
+					prev_target = pursue_pos;
 
-				// target first waypoint
-				if(recalculate_path) {
-					chance_calc_path = -100;
-					path.clear();
-					path_found = mapr->collider.compute_path(e->stats.pos, pursue_pos, path, e->stats.movement_type);
-				}
+					// the path is searched in the background and arrives a fixed number of frames later;
+					// until then, the old one is followed
+					if(recalculate_path && !path_ticket) {
+						chance_calc_path = -100;
+						path_ticket = mapr->path_service.request(e->stats.pos, pursue_pos, e->stats.movement_type);
+					}
+
+					if(path_ticket && mapr->path_service.collect(path_ticket, path, path_found))
+						path_ticket = 0;
 
-				if(!path.empty()) {
-					pursue_pos = path.back();
+					// target first waypoint
+					if(!path.empty()) {
+						pursue_pos = path.back();
 
-					//if distance to node is lower than a tile size, the node is going to be passed and can be removed
-					if(calcDist(e->stats.pos, pursue_pos) <= 1.f)
-						path.pop_back();
+						//if distance to node is lower than a tile size, the node is going to be passed and can be removed
+						if(calcDist(e->stats.pos, pursue_pos) <= 1.f)
+							path.pop_back();
+					}
 				}
 			}
 			else {
-				path.clear();
+				clearPath();
 			}
 
 			if(fleeing)
@@ -539,12 +559,12 @@ void BehaviorStandard::updateState() {
 
 		case ENEMY_STANCE:
 
-			e->setAnimation("stance");
+			e->setAnimation(SID_STANCE);
 			break;
 
 		case ENEMY_MOVE:
 
-			e->setAnimation("run");
+			e->setAnimation(SID_RUN);
 			break;
 
 		case ENEMY_POWER:
@@ -558,42 +578,42 @@ void BehaviorStandard::updateState() {
 
 			// sound effect based on power type
 			if (e->activeAnimation->isFirstFrame()) {
-				if (powers->powers[power_id].attack_anim == "swing" || powers->powers[power_id].attack_anim == "shoot") e->play_sfx_phys = true;
-				else if (powers->powers[power_id].attack_anim == "cast") e->play_sfx_ment = true;
+				if (powers->powers[power_id].attack_anim == SID_SWING || powers->powers[power_id].attack_anim == SID_SHOOT) e->play_sfx_phys = true;
+				else if (powers->powers[power_id].attack_anim == SID_CAST) e->play_sfx_ment = true;
 			}
 
-			if (e->activeAnimation->isLastFrame() || (power_state == POWSTATE_ATTACK && e->activeAnimation->getName() != powers->powers[power_id].attack_anim))
+			if (e->activeAnimation->isLastFrame() || (power_state == POWSTATE_ATTACK && e->activeAnimation->getNameID() != powers->powers[power_id].attack_anim))
 				e->newState(ENEMY_STANCE);
 			break;
 
 		case ENEMY_SPAWN:
 
-			e->setAnimation("spawn");
+			e->setAnimation(SID_SPAWN);
 			//the second check is needed in case the entity does not have a spawn animation
-			if (e->activeAnimation->isLastFrame() || e->activeAnimation->getName() != "spawn") {
+			if (e->activeAnimation->isLastFrame() || e->activeAnimation->getNameID() != SID_SPAWN) {
 				e->newState(ENEMY_STANCE);
 			}
 			break;
 
 		case ENEMY_BLOCK:
 
-			e->setAnimation("block");
+			e->setAnimation(SID_BLOCK);
 			break;
 
 		case ENEMY_HIT:
 
-			e->setAnimation("hit");
+			e->setAnimation(SID_HIT);
 			if (e->activeAnimation->isFirstFrame()) {
 				e->stats.effects.triggered_hit = true;
 			}
-			if (e->activeAnimation->isLastFrame() || e->activeAnimation->getName() != "hit")
+			if (e->activeAnimation->isLastFrame() || e->activeAnimation->getNameID() != SID_HIT)
 				e->newState(ENEMY_STANCE);
 			break;
 
 		case ENEMY_DEAD:
 			if (e->stats.effects.triggered_death) break;
 
-			e->setAnimation("die");
+			e->setAnimation(SID_DIE);
 			if (e->activeAnimation->isFirstFrame()) {
 				e->play_sfx_die = true;
 				e->stats.corpse_ticks = CORPSE_TIMEOUT;
@@ -603,7 +623,7 @@ void BehaviorStandard::updateState() {
 				if (percentChance(e->stats.power_chance[ON_DEATH]))
 					powers->activate(e->stats.power_index[ON_DEATH], &e->stats, e->stats.pos);
 			}
-			if (e->activeAnimation->isLastFrame() || e->activeAnimation->getName() != "die") {
+			if (e->activeAnimation->isLastFrame() || e->activeAnimation->getNameID() != SID_DIE) {
 				// puts renderable under object layer
 				e->stats.corpse = true;
 
@@ -618,7 +638,7 @@ void BehaviorStandard::updateState() {
 
 		case ENEMY_CRITDEAD:
 
-			e->setAnimation("critdie");
+			e->setAnimation(SID_CRITDIE);
 			if (e->activeAnimation->isFirstFrame()) {
 				e->play_sfx_critdie = true;
 				e->stats.corpse_ticks = CORPSE_TIMEOUT;
@@ -628,7 +648,7 @@ void BehaviorStandard::updateState() {
 				if (percentChance(e->stats.power_chance[ON_DEATH]))
 					powers->activate(e->stats.power_index[ON_DEATH], &e->stats, e->stats.pos);
 			}
-			if (e->activeAnimation->isLastFrame() || e->activeAnimation->getName() != "critdie") {
+			if (e->activeAnimation->isLastFrame() || e->activeAnimation->getNameID() != SID_CRITDIE) {
 				// puts renderable under object layer
 				e->stats.corpse = true;
 
@@ -659,3 +679,14 @@ FPoint BehaviorStandard::getWanderPoint() {
 		return e->stats.pos;
 	}
 }
+
+/**
+ * Forget the current path, and the one which is being searched
+ */
+void BehaviorStandard::clearPath() {
+	path.clear();
+	if (path_ticket) {
+		mapr->path_service.cancel(path_ticket);
+		path_ticket = 0;
+	}
+}
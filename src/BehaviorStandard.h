@@ -39,6 +39,7 @@ private:
 	virtual void checkMoveStateMove();
 	void updateState();
 	FPoint getWanderPoint();
+	void clearPath();
 
 protected:
 	//variables for patfinding
@@ -47,10 +48,13 @@ protected:
 	bool collided;
 	bool path_found;
 	int chance_calc_path;
+	unsigned int path_ticket; // the path requested from the path service, or 0
 
 	float hero_dist;
 	float target_dist;
 	FPoint pursue_pos;
+	// pursue_pos is the hero, so the shared flow field can lead the way
+	bool pursuing_hero;
 	// targeting vars
 	bool los;
 	//when fleeing, the enemy moves away from the pursue_pos
@@ -59,6 +63,7 @@ protected:
 
 public:
 	BehaviorStandard(Enemy *_e);
+	~BehaviorStandard();
 	void logic();
 
 };
@@ -0,0 +1,267 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class ChunkedGrid
+ *
+ * A two-dimensional grid of values, such as the tiles of a map layer, which
+ * is stored in square chunks of 32x32 cells. A chunk is only allocated once a
+ * value other than the empty value is stored in it, so memory scales with the
+ * populated parts of the grid rather than with its size. Reading outside the
+ * grid returns the empty value.
+ */
+
+#pragma once
+#ifndef CHUNKED_GRID_H
+#define CHUNKED_GRID_H
+
+#include <algorithm>
+#include <vector>
+
+template <typename T>
+class ChunkedGrid {
+public:
+	static const int CHUNK_SHIFT = 5;
+	static const int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+	static const int CHUNK_MASK = CHUNK_SIZE - 1;
+	static const int CHUNK_CELLS = CHUNK_SIZE * CHUNK_SIZE;
+
+	ChunkedGrid(T _empty_value = T())
+		: empty_value(_empty_value)
+		, width(0)
+		, height(0)
+		, columns(0)
+		, chunks() {
+	}
+
+	ChunkedGrid(int _width, int _height, T _empty_value = T())
+		: empty_value(_empty_value)
+		, width(0)
+		, height(0)
+		, columns(0)
+		, chunks() {
+		resize(_width, _height);
+	}
+
+	ChunkedGrid(const ChunkedGrid &other)
+		: empty_value(other.empty_value)
+		, width(0)
+		, height(0)
+		, columns(0)
+		, chunks() {
+		copy(other);
+	}
+
+	ChunkedGrid& operator=(const ChunkedGrid &other) {
+		if (this != &other) {
+			empty_value = other.empty_value;
+			copy(other);
+		}
+		return *this;
+	}
+
+	~ChunkedGrid() {
+		clear();
+	}
+
+	/**
+	 * Change the size of the grid. All cells are reset to the empty value.
+	 */
+	void resize(int _width, int _height) {
+		clear();
+		width = std::max(0, _width);
+		height = std::max(0, _height);
+		columns = (width + CHUNK_MASK) >> CHUNK_SHIFT;
+		const int rows = (height + CHUNK_MASK) >> CHUNK_SHIFT;
+		chunks.assign(columns * rows, static_cast<T*>(NULL));
+	}
+
+	/**
+	 * Reset all cells to the empty value and release the chunks
+	 */
+	void reset() {
+		for (unsigned i = 0; i < chunks.size(); ++i) {
+			delete[] chunks[i];
+			chunks[i] = NULL;
+		}
+	}
+
+	void clear() {
+		reset();
+		chunks.clear();
+		width = height = columns = 0;
+	}
+
+	/**
+	 * Exchange the contents with another grid without copying the chunks
+	 */
+	void swap(ChunkedGrid &other) {
+		std::swap(empty_value, other.empty_value);
+		std::swap(width, other.width);
+		std::swap(height, other.height);
+		std::swap(columns, other.columns);
+		chunks.swap(other.chunks);
+	}
+
+	int getWidth() const {
+		return width;
+	}
+
+	int getHeight() const {
+		return height;
+	}
+
+	T getEmptyValue() const {
+		return empty_value;
+	}
+
+	bool isInside(int x, int y) const {
+		return x >= 0 && y >= 0 && x < width && y < height;
+	}
+
+	T get(int x, int y) const {
+		if (!isInside(x, y))
+			return empty_value;
+		const T *chunk = chunks[(y >> CHUNK_SHIFT) * columns + (x >> CHUNK_SHIFT)];
+		return chunk ? chunk[((y & CHUNK_MASK) << CHUNK_SHIFT) | (x & CHUNK_MASK)] : empty_value;
+	}
+
+	/**
+	 * Store a value. Writes outside the grid are ignored.
+	 */
+	void set(int x, int y, T value) {
+		if (!isInside(x, y))
+			return;
+		T *&chunk = chunks[(y >> CHUNK_SHIFT) * columns + (x >> CHUNK_SHIFT)];
+		if (!chunk) {
+			if (value == empty_value)
+				return;
+			chunk = new T[CHUNK_CELLS];
+			std::fill(chunk, chunk + CHUNK_CELLS, empty_value);
+		}
+		chunk[((y & CHUNK_MASK) << CHUNK_SHIFT) | (x & CHUNK_MASK)] = value;
+	}
+
+	/**
+	 * Reset the cells inside a rectangle to the empty value. Chunks which end
+	 * up completely empty this way are released.
+	 */
+	void clearRect(int x, int y, int w, int h) {
+		const int x0 = std::max(0, x);
+		const int y0 = std::max(0, y);
+		const int x1 = std::min(width, x + w);
+		const int y1 = std::min(height, y + h);
+		if (x0 >= x1 || y0 >= y1)
+			return;
+
+		for (int cy = y0 >> CHUNK_SHIFT; cy <= (y1 - 1) >> CHUNK_SHIFT; ++cy) {
+			for (int cx = x0 >> CHUNK_SHIFT; cx <= (x1 - 1) >> CHUNK_SHIFT; ++cx) {
+				T *&chunk = chunks[cy * columns + cx];
+				if (!chunk)
+					continue;
+
+				// the part of the chunk inside the rectangle
+				const int left = std::max(x0, cx << CHUNK_SHIFT);
+				const int top = std::max(y0, cy << CHUNK_SHIFT);
+				const int right = std::min(x1, (cx + 1) << CHUNK_SHIFT);
+				const int bottom = std::min(y1, (cy + 1) << CHUNK_SHIFT);
+
+				if (left == (cx << CHUNK_SHIFT) && top == (cy << CHUNK_SHIFT) &&
+						right == std::min(width, (cx + 1) << CHUNK_SHIFT) &&
+						bottom == std::min(height, (cy + 1) << CHUNK_SHIFT)) {
+					delete[] chunk;
+					chunk = NULL;
+					continue;
+				}
+
+				for (int j = top; j < bottom; ++j) {
+					T *row = chunk + ((j & CHUNK_MASK) << CHUNK_SHIFT);
+					std::fill(row + (left & CHUNK_MASK), row + (left & CHUNK_MASK) + (right - left), empty_value);
+				}
+			}
+		}
+	}
+
+	int getColumns() const {
+		return columns;
+	}
+
+	int getRows() const {
+		return columns ? static_cast<int>(chunks.size()) / columns : 0;
+	}
+
+	/**
+	 * The CHUNK_CELLS values of chunk (cx, cy), row by row, or NULL if the chunk is empty
+	 */
+	const T *getChunk(int cx, int cy) const {
+		if (cx < 0 || cy < 0 || cx >= getColumns() || cy >= getRows())
+			return NULL;
+		return chunks[cy * columns + cx];
+	}
+
+	/**
+	 * Replace all values of chunk (cx, cy) at once, e.g. from a compiled map.
+	 * Chunks outside the grid are ignored.
+	 */
+	void setChunk(int cx, int cy, const T *cells) {
+		if (cx < 0 || cy < 0 || cx >= getColumns() || cy >= getRows())
+			return;
+		T *&chunk = chunks[cy * columns + cx];
+		if (!chunk)
+			chunk = new T[CHUNK_CELLS];
+		std::copy(cells, cells + CHUNK_CELLS, chunk);
+	}
+
+	/**
+	 * The number of allocated chunks, for memory statistics
+	 */
+	int getChunkCount() const {
+		int count = 0;
+		for (unsigned i = 0; i < chunks.size(); ++i)
+			if (chunks[i]) ++count;
+		return count;
+	}
+
+	/**
+	 * Check if the chunk holding cell (x, y) is unallocated, so every cell in
+	 * it is empty. Used to skip over large empty areas.
+	 */
+	bool isChunkEmpty(int x, int y) const {
+		if (!isInside(x, y))
+			return true;
+		return chunks[(y >> CHUNK_SHIFT) * columns + (x >> CHUNK_SHIFT)] == NULL;
+	}
+
+private:
+	void copy(const ChunkedGrid &other) {
+		resize(other.width, other.height);
+		for (unsigned i = 0; i < chunks.size(); ++i) {
+			if (other.chunks[i]) {
+				chunks[i] = new T[CHUNK_CELLS];
+				std::copy(other.chunks[i], other.chunks[i] + CHUNK_CELLS, chunks[i]);
+			}
+		}
+	}
+
+	T empty_value;
+	int width;
+	int height;
+	int columns;
+	std::vector<T*> chunks;
+};
+
+#endif
@@ -0,0 +1,302 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "CompiledMap.h"
+#include "FileParser.h"
+#include "Map.h"
+#include "SharedResources.h"
+#include "UtilsFileSystem.h"
+#include "UtilsParsing.h"
+
+CompiledMap::CompiledMap()
+	: entry_count(0)
+	, entries(NULL)
+	, layer_count(0)
+	, layers(NULL)
+	, strings(NULL)
+	, strings_size(0) {
+}
+
+/**
+ * Find the compiled version of a map, or an empty string if the text map has
+ * to be parsed. The compiled file must belong to the same mod as the text
+ * file and must not be older, or it would hide changes to the map.
+ * This only reads the mod list, so it's safe on the map region loader thread.
+ */
+std::string CompiledMap::locate(const std::string &map_name) {
+	std::vector<std::string> paths = mods->list(map_name);
+	if (!paths.empty()) {
+		const std::string path = paths.back() + COMPILED_MAP_EXTENSION;
+		if (mods->getModifiedTime(path) >= mods->getModifiedTime(paths.back()))
+			return path;
+		return "";
+	}
+
+	paths = mods->list(map_name + COMPILED_MAP_EXTENSION);
+	return paths.empty() ? "" : paths.back();
+}
+
+static void writeUint32(std::vector<unsigned char> &buf, uint32_t value) {
+	buf.push_back(static_cast<unsigned char>(value & 0xff));
+	buf.push_back(static_cast<unsigned char>((value >> 8) & 0xff));
+	buf.push_back(static_cast<unsigned char>((value >> 16) & 0xff));
+	buf.push_back(static_cast<unsigned char>((value >> 24) & 0xff));
+}
+
+static uint32_t addString(std::vector<char> &strings, std::map<std::string, uint32_t> &offsets, const std::string &s) {
+	std::map<std::string, uint32_t>::iterator it = offsets.find(s);
+	if (it != offsets.end())
+		return it->second;
+
+	const uint32_t offset = static_cast<uint32_t>(strings.size());
+	strings.insert(strings.end(), s.begin(), s.end());
+	strings.push_back('\0');
+	offsets[s] = offset;
+	return offset;
+}
+
+/**
+ * Convert the text map at src_path into a compiled map at dest_path
+ */
+bool CompiledMap::compile(const std::string &src_path, const std::string &dest_path) {
+	FileParser infile;
+	if (!infile.open(src_path, false, "Could not open map"))
+		return false;
+
+	std::vector<uint32_t> entry_data;
+	std::vector<Map_Layer*> layer_data;
+	std::vector<char> string_data;
+	std::map<std::string, uint32_t> string_offsets;
+	int w = 0;
+	int h = 0;
+	bool ok = true;
+
+	while (infile.next()) {
+		if (infile.section == "header") {
+			if (infile.key == "width")
+				w = toInt(infile.val);
+			else if (infile.key == "height")
+				h = toInt(infile.val);
+		}
+
+		uint32_t flags = infile.new_section ? ENTRY_NEW_SECTION : 0;
+		uint32_t value;
+
+		if (infile.section == "layer" && infile.key == "data") {
+			if (w <= 0 || h <= 0) {
+				fprintf(stderr, "%s: the header must set width and height before the layers.\n", src_path.c_str());
+				ok = false;
+				break;
+			}
+			Map_Layer *layer = new Map_Layer(w, h);
+			Map::readLayerData(infile, *layer);
+			flags |= ENTRY_LAYER_DATA;
+			value = static_cast<uint32_t>(layer_data.size());
+			layer_data.push_back(layer);
+		}
+		else {
+			value = addString(string_data, string_offsets, infile.val);
+		}
+
+		entry_data.push_back(addString(string_data, string_offsets, infile.section));
+		entry_data.push_back(addString(string_data, string_offsets, infile.key));
+		entry_data.push_back(value);
+		entry_data.push_back(flags);
+	}
+	infile.close();
+
+	std::vector<unsigned char> buf;
+	if (ok) {
+		const uint32_t entries_offset = HEADER_SIZE;
+		const uint32_t layers_offset = entries_offset + static_cast<uint32_t>(entry_data.size()) * 4;
+		uint32_t chunks_offset = layers_offset + static_cast<uint32_t>(layer_data.size()) * LAYER_SIZE;
+
+		std::vector<uint32_t> chunk_counts(layer_data.size(), 0);
+		for (unsigned i = 0; i < layer_data.size(); ++i) {
+			for (int cy = 0; cy < layer_data[i]->getRows(); ++cy)
+				for (int cx = 0; cx < layer_data[i]->getColumns(); ++cx)
+					if (layer_data[i]->getChunk(cx, cy))
+						chunk_counts[i]++;
+		}
+
+		uint32_t strings_offset = chunks_offset;
+		for (unsigned i = 0; i < layer_data.size(); ++i)
+			strings_offset += chunk_counts[i] * CHUNK_SIZE;
+
+		buf.insert(buf.end(), "FLAREMAP", "FLAREMAP" + 8);
+		writeUint32(buf, VERSION);
+		writeUint32(buf, static_cast<uint32_t>(entry_data.size() / 4));
+		writeUint32(buf, entries_offset);
+		writeUint32(buf, static_cast<uint32_t>(layer_data.size()));
+		writeUint32(buf, layers_offset);
+		writeUint32(buf, strings_offset);
+		writeUint32(buf, static_cast<uint32_t>(string_data.size()));
+
+		for (unsigned i = 0; i < entry_data.size(); ++i)
+			writeUint32(buf, entry_data[i]);
+
+		for (unsigned i = 0; i < layer_data.size(); ++i) {
+			writeUint32(buf, layer_data[i]->getWidth());
+			writeUint32(buf, layer_data[i]->getHeight());
+			writeUint32(buf, chunk_counts[i]);
+			writeUint32(buf, chunks_offset);
+			chunks_offset += chunk_counts[i] * CHUNK_SIZE;
+		}
+
+		for (unsigned i = 0; i < layer_data.size(); ++i) {
+			for (int cy = 0; cy < layer_data[i]->getRows(); ++cy) {
+				for (int cx = 0; cx < layer_data[i]->getColumns(); ++cx) {
+					const unsigned short *cells = layer_data[i]->getChunk(cx, cy);
+					if (!cells)
+						continue;
+					writeUint32(buf, cx);
+					writeUint32(buf, cy);
+					for (int k = 0; k < Map_Layer::CHUNK_CELLS; ++k) {
+						buf.push_back(static_cast<unsigned char>(cells[k] & 0xff));
+						buf.push_back(static_cast<unsigned char>(cells[k] >> 8));
+					}
+				}
+			}
+		}
+
+		buf.insert(buf.end(), string_data.begin(), string_data.end());
+	}
+
+	for (unsigned i = 0; i < layer_data.size(); ++i)
+		delete layer_data[i];
+
+	if (!ok)
+		return false;
+
+	std::ofstream outfile(dest_path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!outfile.is_open()) {
+		fprintf(stderr, "Could not write compiled map %s\n", dest_path.c_str());
+		return false;
+	}
+	outfile.write(reinterpret_cast<const char*>(&buf[0]), buf.size());
+	outfile.close();
+	return !outfile.fail();
+}
+
+/**
+ * Map a compiled map and check that all tables are inside the file
+ */
+bool CompiledMap::open(const std::string &path) {
+	if (!mods->openFile(path, file))
+		return false;
+
+	const unsigned char *data = file.getData();
+	const size_t size = file.getSize();
+
+	if (size < HEADER_SIZE || memcmp(data, "FLAREMAP", 8) != 0 || readUint32(data + 8) != VERSION) {
+		fprintf(stderr, "%s is not a compiled map of this version, ignoring it.\n", path.c_str());
+		file.close();
+		return false;
+	}
+
+	entry_count = readUint32(data + 12);
+	const uint32_t entries_offset = readUint32(data + 16);
+	layer_count = readUint32(data + 20);
+	const uint32_t layers_offset = readUint32(data + 24);
+	const uint32_t strings_offset = readUint32(data + 28);
+	strings_size = readUint32(data + 32);
+
+	if (entries_offset > size || entry_count > (size - entries_offset) / ENTRY_SIZE ||
+			layers_offset > size || layer_count > (size - layers_offset) / LAYER_SIZE ||
+			strings_offset > size || strings_size == 0 || strings_size > size - strings_offset ||
+			data[strings_offset + strings_size - 1] != '\0') {
+		fprintf(stderr, "Compiled map %s is damaged, ignoring it.\n", path.c_str());
+		file.close();
+		return false;
+	}
+
+	entries = data + entries_offset;
+	layers = data + layers_offset;
+	strings = reinterpret_cast<const char*>(data + strings_offset);
+	return true;
+}
+
+unsigned CompiledMap::getEntryCount() const {
+	return entry_count;
+}
+
+/**
+ * Fill the parser with an entry, as if FileParser::next() had read it.
+ * Layer data entries have an empty value; use getLayerData() for them.
+ */
+void CompiledMap::getEntry(unsigned index, FileParser &infile) const {
+	const unsigned char *entry = entries + index * ENTRY_SIZE;
+	const uint32_t flags = readUint32(entry + 12);
+
+	infile.new_section = (flags & ENTRY_NEW_SECTION) != 0;
+	infile.section = getString(readUint32(entry));
+	infile.setEntry(getString(readUint32(entry + 4)), (flags & ENTRY_LAYER_DATA) ? "" : getString(readUint32(entry + 8)));
+}
+
+/**
+ * Returns the layer an entry holds the data of, or -1 for other entries
+ */
+int CompiledMap::getLayerData(unsigned index) const {
+	const unsigned char *entry = entries + index * ENTRY_SIZE;
+	if (!(readUint32(entry + 12) & ENTRY_LAYER_DATA))
+		return -1;
+	return static_cast<int>(readUint32(entry + 8));
+}
+
+/**
+ * Copy the chunks of a layer into grid. The grid keeps its size; chunks
+ * outside of it are dropped.
+ */
+bool CompiledMap::loadLayer(int layer, ChunkedGrid<unsigned short> &grid) const {
+	if (layer < 0 || static_cast<unsigned>(layer) >= layer_count)
+		return false;
+
+	const unsigned char *info = layers + layer * LAYER_SIZE;
+	const uint32_t chunk_count = readUint32(info + 8);
+	const uint32_t chunks_offset = readUint32(info + 12);
+	if (chunks_offset > file.getSize() || chunk_count > (file.getSize() - chunks_offset) / CHUNK_SIZE)
+		return false;
+
+	const unsigned char *chunk = file.getData() + chunks_offset;
+	for (uint32_t i = 0; i < chunk_count; ++i, chunk += CHUNK_SIZE) {
+		const int cx = static_cast<int>(readUint32(chunk));
+		const int cy = static_cast<int>(readUint32(chunk + 4));
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+		// chunks are 4 byte aligned, so the tile ids can be copied straight from the file
+		grid.setChunk(cx, cy, reinterpret_cast<const unsigned short*>(chunk + 8));
+#else
+		unsigned short cells[Map_Layer::CHUNK_CELLS];
+		for (int k = 0; k < Map_Layer::CHUNK_CELLS; ++k)
+			cells[k] = static_cast<unsigned short>(chunk[8 + k*2] | (chunk[9 + k*2] << 8));
+		grid.setChunk(cx, cy, cells);
+#endif
+	}
+	return true;
+}
+
+uint32_t CompiledMap::readUint32(const unsigned char *p) {
+	return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+		   (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+const char *CompiledMap::getString(uint32_t offset) const {
+	return (offset < strings_size) ? strings + offset : "";
+}
@@ -0,0 +1,86 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+
+/**
+ * class CompiledMap
+ *
+ * Maps converted into a binary file by flare_map_compiler. A compiled map
+ * holds the same entries as the text file, but layer data is stored in the
+ * chunk layout of ChunkedGrid, so it's copied instead of parsed. The file is
+ * memory mapped and read in place.
+ *
+ * Layout, all numbers are little endian unsigned 32 bit integers:
+ *   header:  "FLAREMAP", version, entry count, entry offset, layer count,
+ *            layer offset, string offset, string size
+ *   entries: section, key, value (string offsets), flags
+ *   layers:  width, height, chunk count, chunk offset
+ *   chunks:  column, row, CHUNK_CELLS 16 bit tile ids
+ *   strings: zero terminated
+ * Entries flagged as ENTRY_LAYER_DATA hold a layer index as their value.
+ */
+
+#pragma once
+#ifndef COMPILED_MAP_H
+#define COMPILED_MAP_H
+
+#include "CommonIncludes.h"
+#include "ChunkedGrid.h"
+#include "MappedFile.h"
+
+class FileParser;
+
+// compiled maps are stored next to the text file, with this appended to its name
+const std::string COMPILED_MAP_EXTENSION = ".bin";
+
+class CompiledMap {
+public:
+	CompiledMap();
+
+	static std::string locate(const std::string &map_name);
+	static bool compile(const std::string &src_path, const std::string &dest_path);
+
+	bool open(const std::string &path);
+
+	unsigned getEntryCount() const;
+	void getEntry(unsigned index, FileParser &infile) const;
+	int getLayerData(unsigned index) const;
+	bool loadLayer(int layer, ChunkedGrid<unsigned short> &grid) const;
+
+private:
+	static const unsigned VERSION = 1;
+	static const unsigned HEADER_SIZE = 36;
+	static const unsigned ENTRY_SIZE = 16;
+	static const unsigned LAYER_SIZE = 16;
+	static const unsigned CHUNK_SIZE = 8 + ChunkedGrid<unsigned short>::CHUNK_CELLS * 2;
+
+	static const unsigned ENTRY_NEW_SECTION = 1;
+	static const unsigned ENTRY_LAYER_DATA = 2;
+
+	static uint32_t readUint32(const unsigned char *p);
+	const char *getString(uint32_t offset) const;
+
+	MappedFile file;
+	unsigned entry_count;
+	const unsigned char *entries;
+	unsigned layer_count;
+	const unsigned char *layers;
+	const char *strings;
+	uint32_t strings_size;
+};
+
+#endif
@@ -0,0 +1,261 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "DataCache.h"
+#include "MappedFile.h"
+#include "SharedResources.h"
+
+static void writeUint32(std::vector<unsigned char> &buf, uint32_t value) {
+	buf.push_back(static_cast<unsigned char>(value & 0xff));
+	buf.push_back(static_cast<unsigned char>((value >> 8) & 0xff));
+	buf.push_back(static_cast<unsigned char>((value >> 16) & 0xff));
+	buf.push_back(static_cast<unsigned char>((value >> 24) & 0xff));
+}
+
+static void writeString(std::vector<unsigned char> &buf, const std::string &s) {
+	writeUint32(buf, static_cast<uint32_t>(s.length()));
+	buf.insert(buf.end(), s.begin(), s.end());
+}
+
+/**
+ * Reads the cache file front to back. Reading past the end only sets the
+ * error flag, so the caller checks it once per record.
+ */
+class DataCacheReader {
+public:
+	DataCacheReader(const unsigned char *_data, size_t _size)
+		: data(_data)
+		, size(_size)
+		, pos(0)
+		, error(false) {
+	}
+
+	uint32_t readUint32() {
+		if (size - pos < 4) {
+			error = true;
+			return 0;
+		}
+		const unsigned char *p = data + pos;
+		pos += 4;
+		return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+			   (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+	}
+
+	void readString(std::string &s) {
+		const uint32_t length = readUint32();
+		if (error || size - pos < length) {
+			error = true;
+			s.clear();
+			return;
+		}
+		s.assign(reinterpret_cast<const char*>(data + pos), length);
+		pos += length;
+	}
+
+	const unsigned char *data;
+	size_t size;
+	size_t pos;
+	bool error;
+};
+
+DataCache::DataCache(const std::string &_path)
+	: path(_path)
+	, changed(false)
+	, mutex(SDL_CreateMutex()) {
+}
+
+/**
+ * Read the records of the last launch. A cache file of another version or a
+ * damaged one is ignored and replaced on save().
+ */
+bool DataCache::load() {
+	MappedFile file;
+	if (!file.open(path))
+		return false;
+
+	DataCacheReader in(file.getData(), file.getSize());
+	if (in.size < 16 || memcmp(in.data, "FLAREDAT", 8) != 0) {
+		fprintf(stderr, "Ignoring damaged data cache %s\n", path.c_str());
+		return false;
+	}
+	in.pos = 8;
+	if (in.readUint32() != VERSION)
+		return false;
+
+	std::map<std::string, Record> loaded;
+	const uint32_t record_count = in.readUint32();
+	for (uint32_t i = 0; i < record_count && !in.error; ++i) {
+		std::string name;
+		in.readString(name);
+		Record &record = loaded[name];
+
+		const uint32_t source_count = in.readUint32();
+		for (uint32_t j = 0; j < source_count && !in.error; ++j) {
+			Source source;
+			in.readString(source.path);
+			const uint32_t modified_low = in.readUint32();
+			const uint32_t modified_high = in.readUint32();
+			source.modified = static_cast<time_t>((static_cast<unsigned long long>(modified_high) << 32) | modified_low);
+			source.size = in.readUint32();
+			record.sources.push_back(source);
+		}
+
+		const uint32_t entry_count = in.readUint32();
+		// every entry takes at least 16 bytes, don't trust larger counts
+		if (entry_count > (in.size - in.pos) / 16) {
+			in.error = true;
+			break;
+		}
+		record.entries.resize(entry_count);
+		for (uint32_t j = 0; j < entry_count && !in.error; ++j) {
+			DataCacheEntry &entry = record.entries[j];
+			const uint32_t flags = in.readUint32();
+			entry.new_section = (flags & 1) != 0;
+			entry.file = flags >> 1;
+			in.readString(entry.section);
+			in.readString(entry.key);
+			in.readString(entry.val);
+		}
+	}
+
+	if (in.error) {
+		fprintf(stderr, "Ignoring damaged data cache %s\n", path.c_str());
+		return false;
+	}
+
+	SDL_LockMutex(mutex);
+	records.swap(loaded);
+	changed = false;
+	SDL_UnlockMutex(mutex);
+	return true;
+}
+
+/**
+ * Write the records back if any of them were added or replaced
+ */
+bool DataCache::save() {
+	SDL_LockMutex(mutex);
+	if (!changed) {
+		SDL_UnlockMutex(mutex);
+		return true;
+	}
+
+	std::vector<unsigned char> buf;
+	const char *magic = "FLAREDAT";
+	buf.insert(buf.end(), magic, magic + 8);
+	writeUint32(buf, VERSION);
+	writeUint32(buf, static_cast<uint32_t>(records.size()));
+
+	for (std::map<std::string, Record>::const_iterator it = records.begin(); it != records.end(); ++it) {
+		writeString(buf, it->first);
+
+		const std::vector<Source> &sources = it->second.sources;
+		writeUint32(buf, static_cast<uint32_t>(sources.size()));
+		for (unsigned i = 0; i < sources.size(); ++i) {
+			const unsigned long long modified = static_cast<unsigned long long>(sources[i].modified);
+			writeString(buf, sources[i].path);
+			writeUint32(buf, static_cast<uint32_t>(modified & 0xffffffff));
+			writeUint32(buf, static_cast<uint32_t>(modified >> 32));
+			writeUint32(buf, static_cast<uint32_t>(sources[i].size));
+		}
+
+		const std::vector<DataCacheEntry> &entries = it->second.entries;
+		writeUint32(buf, static_cast<uint32_t>(entries.size()));
+		for (unsigned i = 0; i < entries.size(); ++i) {
+			writeUint32(buf, (entries[i].file << 1) | (entries[i].new_section ? 1 : 0));
+			writeString(buf, entries[i].section);
+			writeString(buf, entries[i].key);
+			writeString(buf, entries[i].val);
+		}
+	}
+	changed = false;
+	SDL_UnlockMutex(mutex);
+
+	std::ofstream outfile(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!outfile.is_open()) {
+		fprintf(stderr, "Could not write data cache %s\n", path.c_str());
+		return false;
+	}
+	outfile.write(reinterpret_cast<const char*>(&buf[0]), buf.size());
+	outfile.close();
+	return !outfile.fail();
+}
+
+/**
+ * Check that a record was made from exactly the files which make up the
+ * data file now, and none of them changed since
+ */
+bool DataCache::isValid(const Record &record, const std::vector<std::string> &files) {
+	if (record.sources.size() != files.size())
+		return false;
+
+	for (unsigned i = 0; i < files.size(); ++i) {
+		const Source &source = record.sources[i];
+		if (source.path != files[i] ||
+				source.modified != mods->getModifiedTime(files[i]) ||
+				source.size != mods->getSize(files[i]))
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Get the cached key pairs of the data file name, which is made up of files.
+ * Returns NULL if they have to be parsed again. The entries stay valid until
+ * the record is stored again.
+ */
+const std::vector<DataCacheEntry> *DataCache::find(const std::string &name, const std::vector<std::string> &files) {
+	const std::vector<DataCacheEntry> *entries = NULL;
+
+	SDL_LockMutex(mutex);
+	std::map<std::string, Record>::const_iterator it = records.find(name);
+	if (it != records.end() && isValid(it->second, files))
+		entries = &it->second.entries;
+	SDL_UnlockMutex(mutex);
+
+	return entries;
+}
+
+/**
+ * Remember the key pairs that were parsed from files for the next launch
+ */
+void DataCache::store(const std::string &name, const std::vector<std::string> &files, const std::vector<DataCacheEntry> &entries) {
+	Record record;
+	for (unsigned i = 0; i < files.size(); ++i) {
+		Source source;
+		source.path = files[i];
+		source.modified = mods->getModifiedTime(files[i]);
+		source.size = mods->getSize(files[i]);
+		record.sources.push_back(source);
+	}
+	record.entries = entries;
+
+	SDL_LockMutex(mutex);
+	Record &stored = records[name];
+	stored.sources.swap(record.sources);
+	stored.entries.swap(record.entries);
+	changed = true;
+	SDL_UnlockMutex(mutex);
+}
+
+DataCache::~DataCache() {
+	SDL_DestroyMutex(mutex);
+}
@@ -0,0 +1,86 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+
+/**
+ * class DataCache
+ *
+ * Keeps the key pairs of parsed data files in a binary file in the user
+ * directory, so the next launch can hand them to the loaders without reading
+ * the text again. Each record remembers the files ModManager::list() returned
+ * for it, with their size and modification time, and is only used while all
+ * of them are unchanged.
+ */
+
+#pragma once
+#ifndef DATA_CACHE_H
+#define DATA_CACHE_H
+
+#include "CommonIncludes.h"
+
+class DataCacheEntry {
+public:
+	bool new_section;
+	unsigned file; // index into the files of the record
+	std::string section;
+	std::string key;
+	std::string val;
+
+	DataCacheEntry()
+		: new_section(false)
+		, file(0) {
+	}
+};
+
+class DataCache {
+public:
+	static const unsigned VERSION = 1;
+
+	DataCache(const std::string &_path);
+	~DataCache();
+
+	bool load();
+	bool save();
+
+	const std::vector<DataCacheEntry> *find(const std::string &name, const std::vector<std::string> &files);
+	void store(const std::string &name, const std::vector<std::string> &files, const std::vector<DataCacheEntry> &entries);
+
+private:
+	DataCache(const DataCache &copy); // not implemented
+
+	class Source {
+	public:
+		std::string path;
+		time_t modified;
+		size_t size;
+	};
+
+	class Record {
+	public:
+		std::vector<Source> sources;
+		std::vector<DataCacheEntry> entries;
+	};
+
+	bool isValid(const Record &record, const std::vector<std::string> &files);
+
+	std::string path;
+	std::map<std::string, Record> records;
+	bool changed;
+	SDL_mutex *mutex;
+};
+
+#endif
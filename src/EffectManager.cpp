@@ -51,6 +51,8 @@ EffectManager& EffectManager::operator= (const EffectManager &emSource) {
 		effect_list[i].ticks = emSource.effect_list[i].ticks;
 		effect_list[i].duration = emSource.effect_list[i].duration;
 		effect_list[i].type = emSource.effect_list[i].type;
+		effect_list[i].bonus_stat = emSource.effect_list[i].bonus_stat;
+		effect_list[i].bonus_resist = emSource.effect_list[i].bonus_resist;
 		effect_list[i].magnitude = emSource.effect_list[i].magnitude;
 		effect_list[i].magnitude_max = emSource.effect_list[i].magnitude_max;
 		effect_list[i].item = emSource.effect_list[i].item;
@@ -127,46 +129,63 @@ void EffectManager::logic() {
 	for (unsigned i=0; i<effect_list.size(); i++) {
 		// expire timed effects and total up magnitudes of active effects
 		if (effect_list[i].duration >= 0) {
-			if (effect_list[i].type == "damage" && effect_list[i].ticks % MAX_FRAMES_PER_SEC == 1) damage += effect_list[i].magnitude;
-			else if (effect_list[i].type == "hpot" && effect_list[i].ticks % MAX_FRAMES_PER_SEC == 1) hpot += effect_list[i].magnitude;
-			else if (effect_list[i].type == "mpot" && effect_list[i].ticks % MAX_FRAMES_PER_SEC == 1) mpot += effect_list[i].magnitude;
-			else if (effect_list[i].type == "speed") speed = (effect_list[i].magnitude * speed) / 100;
-			else if (effect_list[i].type == "immunity") immunity = true;
-			else if (effect_list[i].type == "stun") stun = true;
-			else if (effect_list[i].type == "forced_move") {
-				forced_move = true;
-				forced_speed = (float)effect_list[i].magnitude;
-			}
-			else if (effect_list[i].type == "revive") revive = true;
-			else if (effect_list[i].type == "convert") convert = true;
-			else if (effect_list[i].type == "fear") fear = true;
-			else if (effect_list[i].type == "offense") bonus_offense += effect_list[i].magnitude;
-			else if (effect_list[i].type == "defense") bonus_defense += effect_list[i].magnitude;
-			else if (effect_list[i].type == "physical") bonus_physical += effect_list[i].magnitude;
-			else if (effect_list[i].type == "mental") bonus_mental += effect_list[i].magnitude;
-			else {
-				bool found_key = false;
-
-				for (unsigned j=0; j<STAT_COUNT; j++) {
-					if (effect_list[i].type == STAT_NAME[j]) {
-						bonus[j] += effect_list[i].magnitude;
-						found_key = true;
-					}
-				}
-
-				if (!found_key) {
-					for (unsigned j=0; j<bonus_resist.size(); j++) {
-						if (effect_list[i].type == ELEMENTS[j].name + "_resist")
-							bonus_resist[j] += effect_list[i].magnitude;
-					}
-				}
+			switch (effect_list[i].type) {
+				case SID_DAMAGE:
+					if (effect_list[i].ticks % MAX_FRAMES_PER_SEC == 1) damage += effect_list[i].magnitude;
+					break;
+				case SID_HPOT:
+					if (effect_list[i].ticks % MAX_FRAMES_PER_SEC == 1) hpot += effect_list[i].magnitude;
+					break;
+				case SID_MPOT:
+					if (effect_list[i].ticks % MAX_FRAMES_PER_SEC == 1) mpot += effect_list[i].magnitude;
+					break;
+				case SID_SPEED:
+					speed = (effect_list[i].magnitude * speed) / 100;
+					break;
+				case SID_IMMUNITY:
+					immunity = true;
+					break;
+				case SID_STUN:
+					stun = true;
+					break;
+				case SID_FORCED_MOVE:
+					forced_move = true;
+					forced_speed = (float)effect_list[i].magnitude;
+					break;
+				case SID_REVIVE:
+					revive = true;
+					break;
+				case SID_CONVERT:
+					convert = true;
+					break;
+				case SID_FEAR:
+					fear = true;
+					break;
+				case SID_OFFENSE:
+					bonus_offense += effect_list[i].magnitude;
+					break;
+				case SID_DEFENSE:
+					bonus_defense += effect_list[i].magnitude;
+					break;
+				case SID_PHYSICAL:
+					bonus_physical += effect_list[i].magnitude;
+					break;
+				case SID_MENTAL:
+					bonus_mental += effect_list[i].magnitude;
+					break;
+				default:
+					if (effect_list[i].bonus_stat != -1)
+						bonus[effect_list[i].bonus_stat] += effect_list[i].magnitude;
+					else if (effect_list[i].bonus_resist != -1)
+						bonus_resist[effect_list[i].bonus_resist] += effect_list[i].magnitude;
+					break;
 			}
 
 			if (effect_list[i].duration > 0) {
 				if (effect_list[i].ticks > 0) effect_list[i].ticks--;
 				if (effect_list[i].ticks == 0) {
 					//death sentence is only applied at the end of the timer
-					if (effect_list[i].type == "death_sentence") death_sentence = true;
+					if (effect_list[i].type == SID_DEATH_SENTENCE) death_sentence = true;
 					removeEffect(i);
 					i--;
 					continue;
@@ -175,7 +194,7 @@ void EffectManager::logic() {
 		}
 		// expire shield effects
 		if (effect_list[i].magnitude_max > 0 && effect_list[i].magnitude == 0) {
-			if (effect_list[i].type == "shield") {
+			if (effect_list[i].type == SID_SHIELD) {
 				removeEffect(i);
 				i--;
 				continue;
@@ -183,7 +202,7 @@ void EffectManager::logic() {
 		}
 		// expire effects based on animations
 		if ((effect_list[i].animation && effect_list[i].animation->isLastFrame()) || !effect_list[i].animation) {
-			if (effect_list[i].type == "heal") {
+			if (effect_list[i].type == SID_HEAL) {
 				removeEffect(i);
 				i--;
 				continue;
@@ -199,27 +218,29 @@ void EffectManager::logic() {
 }
 
 void EffectManager::addEffect(std::string id, int icon, int duration, int magnitude, std::string type, std::string animation, bool additive, bool item, int trigger, bool render_above, int passive_id, int source_type) {
+	const StringID type_id = internString(type);
+
 	// if we're already immune, don't add negative effects
 	if (immunity) {
-		if (type == "damage") return;
-		else if (type == "speed" && magnitude < 100) return;
-		else if (type == "stun") return;
+		if (type_id == SID_DAMAGE) return;
+		else if (type_id == SID_SPEED && magnitude < 100) return;
+		else if (type_id == SID_STUN) return;
 	}
 
 	// only allow one forced_move effect
 	// TODO remove this limitation
 	if (forced_move) {
-		if (type == "forced_move") return;
+		if (type_id == SID_FORCED_MOVE) return;
 	}
 
 	for (unsigned i=0; i<effect_list.size(); i++) {
 		if (effect_list[i].id == id) {
 			if (trigger > -1 && effect_list[i].trigger == trigger) return; // trigger effects can only be cast once per trigger
-			if (effect_list[i].duration <= duration && effect_list[i].type != "death_sentence") {
+			if (effect_list[i].duration <= duration && effect_list[i].type != SID_DEATH_SENTENCE) {
 				effect_list[i].ticks = effect_list[i].duration = duration;
 				if (effect_list[i].animation) effect_list[i].animation->reset();
 			}
-			if (effect_list[i].duration > duration && effect_list[i].type == "death_sentence") {
+			if (effect_list[i].duration > duration && effect_list[i].type == SID_DEATH_SENTENCE) {
 				effect_list[i].ticks = effect_list[i].duration = duration;
 				if (effect_list[i].animation) effect_list[i].animation->reset();
 			}
@@ -231,7 +252,7 @@ void EffectManager::addEffect(std::string id, int icon, int duration, int magnit
 			return; // we already have this effect
 		}
 		// if we're adding an immunity effect, remove all negative effects
-		if (type == "immunity") {
+		if (type_id == SID_IMMUNITY) {
 			clearNegativeEffects();
 		}
 	}
@@ -242,13 +263,30 @@ void EffectManager::addEffect(std::string id, int icon, int duration, int magnit
 	e.icon = icon;
 	e.ticks = e.duration = duration;
 	e.magnitude = e.magnitude_max = magnitude;
-	e.type = type;
+	e.type = type_id;
 	e.item = item;
 	e.trigger = trigger;
 	e.render_above = render_above;
 	e.passive_id = passive_id;
 	e.source_type = source_type;
 
+	// stat and resistance bonuses are looked up once here instead of every frame
+	for (unsigned j=0; j<STAT_COUNT; j++) {
+		if (type == STAT_NAME[j]) {
+			e.bonus_stat = j;
+			break;
+		}
+	}
+
+	if (e.bonus_stat == -1) {
+		for (unsigned j=0; j<ELEMENTS.size(); j++) {
+			if (type == ELEMENTS[j].name + "_resist") {
+				e.bonus_resist = j;
+				break;
+			}
+		}
+	}
+
 	if (animation != "") {
 		anim->increaseCount(animation);
 		e.animation = loadAnimation(animation);
@@ -272,7 +310,7 @@ void EffectManager::removeAnimation(int id) {
 	}
 }
 
-void EffectManager::removeEffectType(std::string type) {
+void EffectManager::removeEffectType(StringID type) {
 	for (unsigned i=effect_list.size(); i > 0; i--) {
 		if (effect_list[i-1].type == type) removeEffect(i-1);
 	}
@@ -295,9 +333,9 @@ void EffectManager::clearEffects() {
 
 void EffectManager::clearNegativeEffects() {
 	for (unsigned i=effect_list.size(); i > 0; i--) {
-		if (effect_list[i-1].type == "damage") removeEffect(i-1);
-		else if (effect_list[i-1].type == "speed" && effect_list[i-1].magnitude_max < 100) removeEffect(i-1);
-		else if (effect_list[i-1].type == "stun") removeEffect(i-1);
+		if (effect_list[i-1].type == SID_DAMAGE) removeEffect(i-1);
+		else if (effect_list[i-1].type == SID_SPEED && effect_list[i-1].magnitude_max < 100) removeEffect(i-1);
+		else if (effect_list[i-1].type == SID_STUN) removeEffect(i-1);
 	}
 }
 
@@ -317,7 +355,7 @@ int EffectManager::damageShields(int dmg) {
 	int over_dmg = dmg;
 
 	for (unsigned i=0; i<effect_list.size(); i++) {
-		if (effect_list[i].magnitude_max > 0 && effect_list[i].type == "shield") {
+		if (effect_list[i].magnitude_max > 0 && effect_list[i].type == SID_SHIELD) {
 			effect_list[i].magnitude -= dmg;
 			if (effect_list[i].magnitude < 0) {
 				if (abs(effect_list[i].magnitude) < over_dmg) over_dmg = abs(effect_list[i].magnitude);
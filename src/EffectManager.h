@@ -29,6 +29,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "Hazard.h"
 #include "SharedResources.h"
 #include "Stats.h"
+#include "StringID.h"
 #include "Utils.h"
 
 class Animation;
@@ -40,7 +41,9 @@ public:
 	int icon;
 	int ticks;
 	int duration;
-	std::string type;
+	StringID type;
+	int bonus_stat; // index into STAT_NAME, or -1 if type isn't a stat
+	int bonus_resist; // index into ELEMENTS, or -1 if type isn't a resistance
 	int magnitude;
 	int magnitude_max;
 	std::string animation_name;
@@ -56,7 +59,9 @@ public:
 		, icon(-1)
 		, ticks(0)
 		, duration(-1)
-		, type("")
+		, type(SID_NONE)
+		, bonus_stat(-1)
+		, bonus_resist(-1)
 		, magnitude(0)
 		, magnitude_max(0)
 		, animation_name("")
@@ -86,7 +91,7 @@ public:
 	void clearStatus();
 	void logic();
 	void addEffect(std::string id, int icon, int duration, int magnitude, std::string type, std::string animation, bool additive, bool item, int trigger, bool render_above, int passive_id, int source_type);
-	void removeEffectType(std::string type);
+	void removeEffectType(StringID type);
 	void removeEffectPassive(int id);
 	void clearEffects();
 	void clearNegativeEffects();
@@ -76,7 +76,6 @@ Enemy *EnemyManager::getEnemyPrototype(const string& type_id) {
  */
 void EnemyManager::handleNewMap () {
 
-	Map_Enemy me;
 	std::queue<Enemy *> allies;
 
 	// delete existing enemies
@@ -93,7 +92,35 @@ void EnemyManager::handleNewMap () {
 
 	prototypes.clear();
 
-	// load new enemies
+	addMapEnemies();
+
+	while (!allies.empty()) {
+
+		Enemy *e = allies.front();
+		allies.pop();
+
+		//dont need the result of this. its only called to handle animation and sound
+		getEnemyPrototype(e->type);
+
+		e->stats.pos.x = pc->stats.pos.x;
+		e->stats.pos.y = pc->stats.pos.y;
+		e->stats.direction = pc->stats.direction;
+
+		enemies.push_back(e);
+
+		mapr->collider.block(e->stats.pos.x, e->stats.pos.y, true);
+	}
+
+	anim->cleanUp();
+}
+
+/**
+ * Create the enemies the map has queued, e.g. when a region of a streamed map was loaded
+ */
+void EnemyManager::addMapEnemies() {
+
+	Map_Enemy me;
+
 	while (!mapr->enemies.empty()) {
 		me = mapr->enemies.front();
 		mapr->enemies.pop();
@@ -131,25 +158,6 @@ void EnemyManager::handleNewMap () {
 
 		mapr->collider.block(me.pos.x, me.pos.y, false);
 	}
-
-	while (!allies.empty()) {
-
-		Enemy *e = allies.front();
-		allies.pop();
-
-		//dont need the result of this. its only called to handle animation and sound
-		getEnemyPrototype(e->type);
-
-		e->stats.pos.x = pc->stats.pos.x;
-		e->stats.pos.y = pc->stats.pos.y;
-		e->stats.direction = pc->stats.direction;
-
-		enemies.push_back(e);
-
-		mapr->collider.block(e->stats.pos.x, e->stats.pos.y, true);
-	}
-
-	anim->cleanUp();
 }
 
 /**
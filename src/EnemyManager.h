@@ -50,6 +50,7 @@ public:
 	EnemyManager();
 	~EnemyManager();
 	void handleNewMap();
+	void addMapEnemies();
 	void handleSpawn();
 	void handlePartyBuff();
 	void logic();
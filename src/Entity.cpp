@@ -314,7 +314,7 @@ bool Entity::takeHit(const Hazard &h) {
 				if (MAX_RESIST < 100) dmg = 1;
 			}
 			play_sfx_block = true;
-			if (activeAnimation->getName() == "block")
+			if (activeAnimation->getNameID() == SID_BLOCK)
 				resetActiveAnimation();
 		}
 	}
@@ -358,7 +358,7 @@ bool Entity::takeHit(const Hazard &h) {
 	if (dmg > 0) {
 
 		// damage always breaks stun
-		stats.effects.removeEffectType("stun");
+		stats.effects.removeEffectType(SID_STUN);
 
 		if (stats.hp > 0) {
 			if (h.mod_power > 0) powers->effect(&stats, h.src_stats, h.mod_power,h.source_type);
@@ -439,17 +439,17 @@ void Entity::resetActiveAnimation() {
 /**
  * Set the entity's current animation by name
  */
-bool Entity::setAnimation(const string& animationName) {
+bool Entity::setAnimation(StringID animationName) {
 
 	// if the animation is already the requested one do nothing
-	if (activeAnimation != NULL && activeAnimation->getName() == animationName)
+	if (activeAnimation != NULL && activeAnimation->getNameID() == animationName)
 		return true;
 
 	delete activeAnimation;
 	activeAnimation = animationSet->getAnimation(animationName);
 
 	if (activeAnimation == NULL)
-		fprintf(stderr, "Entity::setAnimation(%s): not found\n", animationName.c_str());
+		fprintf(stderr, "Entity::setAnimation(%s): not found\n", getInternedString(animationName).c_str());
 
 	return activeAnimation == NULL;
 }
@@ -30,6 +30,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "CommonIncludes.h"
 #include "SoundManager.h"
 #include "StatBlock.h"
+#include "StringID.h"
 
 class Animation;
 class AnimationSet;
@@ -73,7 +74,7 @@ public:
 	// Each child of Entity defines its own rendering method
 	virtual Renderable getRender() = 0;
 
-	bool setAnimation(const std::string& animation);
+	bool setAnimation(StringID animation);
 	Animation *activeAnimation;
 	AnimationSet *animationSet;
 
@@ -38,7 +38,7 @@ void EventManager::loadEvent(FileParser &infile, Event* evnt) {
 	if (infile.key == "type") {
 		// @ATTR event.type|[on_trigger:on_mapexit:on_leave:on_load:on_clear]|Type of map event.
 		std::string type = infile.val;
-		evnt->type = type;
+		evnt->type = internString(type);
 
 		if      (type == "on_trigger");
 		else if (type == "on_mapexit"); // no need to set keep_after_trigger to false correctly, it's ignored anyway
@@ -106,7 +106,7 @@ void EventManager::loadEventComponent(FileParser &infile, Event* evnt, Event_Com
 
 	if (!e) return;
 
-	e->type = infile.key;
+	e->type = internString(infile.key);
 
 	if (infile.key == "tooltip") {
 		// @ATTR event.tooltip|string|Tooltip for event
@@ -157,7 +157,7 @@ void EventManager::loadEventComponent(FileParser &infile, Event* evnt, Event_Com
 			while (repeat_val != "") {
 				evnt->components.push_back(Event_Component());
 				e = &evnt->components.back();
-				e->type = infile.key;
+				e->type = internString(infile.key);
 				e->s = repeat_val;
 				e->x = toInt(infile.nextValue());
 				e->y = toInt(infile.nextValue());
@@ -202,7 +202,7 @@ void EventManager::loadEventComponent(FileParser &infile, Event* evnt, Event_Com
 			while (repeat_val != "") {
 				evnt->components.push_back(Event_Component());
 				e = &evnt->components.back();
-				e->type = infile.key;
+				e->type = internString(infile.key);
 				e->s = repeat_val;
 				e->x = toInt(infile.nextValue());
 				e->y = toInt(infile.nextValue());
@@ -238,7 +238,7 @@ void EventManager::loadEventComponent(FileParser &infile, Event* evnt, Event_Com
 			while (repeat_val != "") {
 				evnt->components.push_back(Event_Component());
 				e = &evnt->components.back();
-				e->type = infile.key;
+				e->type = internString(infile.key);
 				e->s = repeat_val;
 
 				repeat_val = infile.nextValue();
@@ -255,7 +255,7 @@ void EventManager::loadEventComponent(FileParser &infile, Event* evnt, Event_Com
 			while (repeat_val != "") {
 				evnt->components.push_back(Event_Component());
 				e = &evnt->components.back();
-				e->type = infile.key;
+				e->type = internString(infile.key);
 				e->s = repeat_val;
 
 				repeat_val = infile.nextValue();
@@ -284,7 +284,7 @@ void EventManager::loadEventComponent(FileParser &infile, Event* evnt, Event_Com
 			while (repeat_val != "") {
 				evnt->components.push_back(Event_Component());
 				e = &evnt->components.back();
-				e->type = infile.key;
+				e->type = internString(infile.key);
 				e->x = toInt(repeat_val);
 
 				repeat_val = infile.nextValue();
@@ -301,7 +301,7 @@ void EventManager::loadEventComponent(FileParser &infile, Event* evnt, Event_Com
 			while (repeat_val != "") {
 				evnt->components.push_back(Event_Component());
 				e = &evnt->components.back();
-				e->type = infile.key;
+				e->type = internString(infile.key);
 				e->s = repeat_val;
 
 				repeat_val = infile.nextValue();
@@ -318,7 +318,7 @@ void EventManager::loadEventComponent(FileParser &infile, Event* evnt, Event_Com
 			while (repeat_val != "") {
 				evnt->components.push_back(Event_Component());
 				e = &evnt->components.back();
-				e->type = infile.key;
+				e->type = internString(infile.key);
 				e->s = repeat_val;
 
 				repeat_val = infile.nextValue();
@@ -340,7 +340,7 @@ void EventManager::loadEventComponent(FileParser &infile, Event* evnt, Event_Com
 			while (repeat_val != "") {
 				evnt->components.push_back(Event_Component());
 				e = &evnt->components.back();
-				e->type = infile.key;
+				e->type = internString(infile.key);
 				e->x = toInt(repeat_val);
 
 				repeat_val = infile.nextValue();
@@ -360,7 +360,7 @@ void EventManager::loadEventComponent(FileParser &infile, Event* evnt, Event_Com
 	else if (infile.key == "reward_item") {
 		// @ATTR event.reward_item|x(integer),y(integer)|Reward hero with y number of item x.
 		e->x = toInt(infile.nextValue());
-		e->y = toInt(infile.val);
+		e->y = toInt(infile.nextValue());
 		clampFloor(e->y, 0);
 	}
 	else if (infile.key == "restore") {
@@ -383,7 +383,7 @@ void EventManager::loadEventComponent(FileParser &infile, Event* evnt, Event_Com
 			while (repeat_val != "") {
 				evnt->components.push_back(Event_Component());
 				e = &evnt->components.back();
-				e->type = infile.key;
+				e->type = internString(infile.key);
 
 				e->s = repeat_val;
 				e->x = toInt(infile.nextValue());
@@ -439,15 +439,15 @@ bool EventManager::executeEvent(Event &ev) {
 	for (unsigned i = 0; i < ev.components.size(); ++i) {
 		ec = &ev.components[i];
 
-		if (ec->type == "set_status") {
+		if (ec->type == SID_SET_STATUS) {
 			camp->setStatus(ec->s);
 		}
-		else if (ec->type == "unset_status") {
+		else if (ec->type == SID_UNSET_STATUS) {
 			camp->unsetStatus(ec->s);
 		}
-		else if (ec->type == "intermap") {
+		else if (ec->type == SID_INTERMAP) {
 
-			if (fileExists(mods->locate(ec->s))) {
+			if (mods->exists(ec->s)) {
 				mapr->teleportation = true;
 				mapr->teleport_mapname = ec->s;
 				mapr->teleport_destination.x = ec->x + 0.5f;
@@ -458,32 +458,29 @@ bool EventManager::executeEvent(Event &ev) {
 				mapr->log_msg = msg->get("Unknown destination");
 			}
 		}
-		else if (ec->type == "intramap") {
+		else if (ec->type == SID_INTRAMAP) {
 			mapr->teleportation = true;
 			mapr->teleport_mapname = "";
 			mapr->teleport_destination.x = ec->x + 0.5f;
 			mapr->teleport_destination.y = ec->y + 0.5f;
 		}
-		else if (ec->type == "mapmod") {
+		else if (ec->type == SID_MAPMOD) {
 			if (ec->s == "collision") {
-				if (ec->x >= 0 && ec->x < 256 && ec->y >= 0 && ec->y < 256)
-					mapr->collider.colmap[ec->x][ec->y] = ec->z;
+				if (mapr->collider.colmap.isInside(ec->x, ec->y))
+					mapr->modifyCollision(ec->x, ec->y, static_cast<unsigned short>(ec->z));
 				else
-					fprintf(stderr, "Error: mapmod at position (%d, %d) is out of bounds 0-255.\n", ec->x, ec->y);
+					fprintf(stderr, "Error: mapmod at position (%d, %d) is outside the map.\n", ec->x, ec->y);
 			}
 			else {
 				int index = distance(mapr->layernames.begin(), find(mapr->layernames.begin(), mapr->layernames.end(), ec->s));
-				if (ec->x >= 0 && ec->x < 256 && ec->y >= 0 && ec->y < 256)
-					mapr->layers[index][ec->x][ec->y] = ec->z;
+				if (ec->x >= 0 && ec->x < mapr->w && ec->y >= 0 && ec->y < mapr->h)
+					mapr->modifyTile(index, ec->x, ec->y, static_cast<unsigned short>(ec->z));
 				else
-					fprintf(stderr, "Error: mapmod at position (%d, %d) is out of bounds 0-255.\n", ec->x, ec->y);
-
-				if (ec->a < (int)(mapr->index_objectlayer))
-					mapr->repaint_background = true;
+					fprintf(stderr, "Error: mapmod at position (%d, %d) is outside the map.\n", ec->x, ec->y);
 			}
 			mapr->map_change = true;
 		}
-		else if (ec->type == "soundfx") {
+		else if (ec->type == SID_SOUNDFX) {
 			FPoint pos(0,0);
 			bool loop = false;
 
@@ -498,7 +495,7 @@ bool EventManager::executeEvent(Event &ev) {
 				pos.y = ev.location.y + 0.5f;
 			}
 
-			if (ev.type == "on_load")
+			if (ev.type == SID_ON_LOAD)
 				loop = true;
 
 			SoundManager::SoundID sid = snd->load(ec->s, "MapRenderer background soundfx");
@@ -506,47 +503,47 @@ bool EventManager::executeEvent(Event &ev) {
 			snd->play(sid, GLOBAL_VIRTUAL_CHANNEL, pos, loop);
 			mapr->sids.push_back(sid);
 		}
-		else if (ec->type == "loot") {
+		else if (ec->type == SID_LOOT) {
 			mapr->loot.push_back(*ec);
 		}
-		else if (ec->type == "msg") {
+		else if (ec->type == SID_MSG) {
 			mapr->log_msg = ec->s;
 		}
-		else if (ec->type == "shakycam") {
+		else if (ec->type == SID_SHAKYCAM) {
 			mapr->shaky_cam_ticks = ec->x;
 		}
-		else if (ec->type == "remove_currency") {
+		else if (ec->type == SID_REMOVE_CURRENCY) {
 			camp->removeCurrency(ec->x);
 		}
-		else if (ec->type == "remove_item") {
+		else if (ec->type == SID_REMOVE_ITEM) {
 			camp->removeItem(ec->x);
 		}
-		else if (ec->type == "reward_xp") {
+		else if (ec->type == SID_REWARD_XP) {
 			camp->rewardXP(ec->x, true);
 		}
-		else if (ec->type == "reward_currency") {
+		else if (ec->type == SID_REWARD_CURRENCY) {
 			camp->rewardCurrency(ec->x);
 		}
-		else if (ec->type == "reward_item") {
+		else if (ec->type == SID_REWARD_ITEM) {
 			ItemStack istack;
 			istack.item = ec->x;
 			istack.quantity = ec->y;
 			camp->rewardItem(istack);
 		}
-		else if (ec->type == "restore") {
+		else if (ec->type == SID_RESTORE) {
 			camp->restoreHPMP(ec->s);
 		}
-		else if (ec->type == "spawn") {
+		else if (ec->type == SID_SPAWN) {
 			Point spawn_pos;
 			spawn_pos.x = ec->x;
 			spawn_pos.y = ec->y;
 			powers->spawn(ec->s, spawn_pos);
 		}
-		else if (ec->type == "power") {
+		else if (ec->type == SID_POWER) {
 
 			int power_index = ec->x;
 
-			Event_Component *ec_path = ev.getComponent("power_path");
+			Event_Component *ec_path = ev.getComponent(SID_POWER_PATH);
 			if (ev.stats == NULL) {
 				ev.stats = new StatBlock();
 
@@ -563,7 +560,7 @@ bool EventManager::executeEvent(Event &ev) {
 					ev.stats->pos.y = ev.location.y + 0.5f;
 				}
 
-				Event_Component *ec_damage = ev.getComponent("power_damage");
+				Event_Component *ec_damage = ev.getComponent(SID_POWER_DAMAGE);
 				if (ec_damage) {
 					ev.stats->current[STAT_DMG_MELEE_MIN] = ev.stats->current[STAT_DMG_RANGED_MIN] = ev.stats->current[STAT_DMG_MENT_MIN] = ec_damage->a;
 					ev.stats->current[STAT_DMG_MELEE_MAX] = ev.stats->current[STAT_DMG_RANGED_MAX] = ev.stats->current[STAT_DMG_MENT_MAX] = ec_damage->b;
@@ -592,23 +589,23 @@ bool EventManager::executeEvent(Event &ev) {
 
 			powers->activate(power_index, ev.stats, target);
 		}
-		else if (ec->type == "stash") {
+		else if (ec->type == SID_STASH) {
 			mapr->stash = true;
 			mapr->stash_pos.x = ev.location.x + 0.5f;
 			mapr->stash_pos.y = ev.location.y + 0.5f;
 		}
-		else if (ec->type == "npc") {
+		else if (ec->type == SID_NPC) {
 			mapr->event_npc = ec->s;
 		}
-		else if (ec->type == "music") {
+		else if (ec->type == SID_MUSIC) {
 			mapr->music_filename = ec->s;
 			mapr->loadMusic();
 		}
-		else if (ec->type == "cutscene") {
+		else if (ec->type == SID_CUTSCENE) {
 			mapr->cutscene = true;
 			mapr->cutscene_file = ec->s;
 		}
-		else if (ec->type == "repeat") {
+		else if (ec->type == SID_REPEAT) {
 			ev.keep_after_trigger = toBool(ec->s);
 		}
 	}
@@ -618,32 +615,32 @@ bool EventManager::executeEvent(Event &ev) {
 
 bool EventManager::isActive(const Event &e) {
 	for (unsigned i=0; i < e.components.size(); i++) {
-		if (e.components[i].type == "requires_not_status") {
+		if (e.components[i].type == SID_REQUIRES_NOT_STATUS) {
 			if (camp->checkStatus(e.components[i].s)) {
 				return false;
 			}
 		}
-		else if (e.components[i].type == "requires_status") {
+		else if (e.components[i].type == SID_REQUIRES_STATUS) {
 			if (!camp->checkStatus(e.components[i].s)) {
 				return false;
 			}
 		}
-		else if (e.components[i].type == "requires_currency") {
+		else if (e.components[i].type == SID_REQUIRES_CURRENCY) {
 			if (!camp->checkCurrency(e.components[i].x)) {
 				return false;
 			}
 		}
-		else if (e.components[i].type == "requires_item") {
+		else if (e.components[i].type == SID_REQUIRES_ITEM) {
 			if (!camp->checkItem(e.components[i].x)) {
 				return false;
 			}
 		}
-		else if (e.components[i].type == "requires_level") {
+		else if (e.components[i].type == SID_REQUIRES_LEVEL) {
 			if (camp->hero->level < e.components[i].x) {
 				return false;
 			}
 		}
-		else if (e.components[i].type == "requires_not_level") {
+		else if (e.components[i].type == SID_REQUIRES_NOT_LEVEL) {
 			if (camp->hero->level >= e.components[i].x) {
 				return false;
 			}
@@ -29,7 +29,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 class Event {
 public:
-	std::string type;
+	StringID type;
 	std::vector<Event_Component> components;
 	Rect location;
 	Rect hotspot;
@@ -41,7 +41,7 @@ public:
 	Rect reachable_from;
 
 	Event()
-		: type("")
+		: type(SID_NONE)
 		, components(std::vector<Event_Component>())
 		, cooldown(0)
 		, cooldown_ticks(0)
@@ -56,7 +56,7 @@ public:
 	// returns a pointer to the event component within the components list
 	// no need to free the pointer by caller
 	// NULL will be returned if no such event is found
-	Event_Component *getComponent(const std::string &_type) {
+	Event_Component *getComponent(StringID _type) {
 		std::vector<Event_Component>::iterator it;
 		for (it = components.begin(); it != components.end(); ++it)
 			if (it->type == _type)
@@ -64,11 +64,14 @@ public:
 		return NULL;
 	}
 
-	void deleteAllComponents(const std::string &_type) {
-		std::vector<Event_Component>::iterator it;
-		for (it = components.begin(); it != components.end(); ++it)
+	void deleteAllComponents(StringID _type) {
+		std::vector<Event_Component>::iterator it = components.begin();
+		while (it != components.end()) {
 			if (it->type == _type)
 				it = components.erase(it);
+			else
+				++it;
+		}
 	}
 
 	~Event() {
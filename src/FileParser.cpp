@@ -28,14 +28,72 @@ std::string val;
 
 FileParser::FileParser()
 	: current_index(0)
+	, cursor(NULL)
+	, file_end(NULL)
 	, line("")
+	, val_pos(0)
+	, cached(NULL)
+	, cached_index(0)
+	, recording(false)
 	, new_section(false)
 	, section("")
 	, key("")
 	, val("") {
 }
 
+static const char *WHITESPACE = " \f\n\r\t\v";
+
+static bool isWhitespace(char c) {
+	return c != '\0' && strchr(WHITESPACE, c) != NULL;
+}
+
+/**
+ * Narrow a view down to its contents without the surrounding whitespace
+ */
+static FileParserView trimView(const char *begin, const char *end) {
+	while (begin < end && isWhitespace(*begin)) ++begin;
+	while (end > begin && isWhitespace(*(end-1))) --end;
+	return FileParserView(begin, end - begin);
+}
+
+/**
+ * Map a file and start reading it from the beginning
+ */
+bool FileParser::openFile(const string& filename) {
+	cursor = file_end = NULL;
+
+	// the settings are read before the mods are set up
+	if (mods ? !mods->openFile(filename, file) : !file.open(filename))
+		return false;
+
+	cursor = reinterpret_cast<const char*>(file.getData());
+	file_end = cursor + file.getSize();
+	return true;
+}
+
+/**
+ * Read the next line of the current file, without the line break
+ *
+ * @return false if the end of the file was reached
+ */
+bool FileParser::readLine(FileParserView& raw_line) {
+	if (cursor == NULL || cursor >= file_end)
+		return false;
+
+	const char *line_end = static_cast<const char*>(memchr(cursor, '\n', file_end - cursor));
+	const char *next_line = line_end ? line_end + 1 : file_end;
+	if (!line_end)
+		line_end = file_end;
+	if (line_end > cursor && *(line_end-1) == '\r')
+		--line_end;
+
+	raw_line = FileParserView(cursor, line_end - cursor);
+	cursor = next_line;
+	return true;
+}
+
 bool FileParser::open(const string& _filename, bool locateFileName, const string &_errormessage) {
+	close();
 	filenames.clear();
 	if (locateFileName) {
 		filenames = mods->list(_filename);
@@ -43,9 +101,49 @@ bool FileParser::open(const string& _filename, bool locateFileName, const string
 	else {
 		filenames.push_back(_filename);
 	}
-	current_index = 0;
 	this->errormessage = _errormessage;
 
+	return openFiles(_filename);
+}
+
+bool FileParser::open(const vector<string>& paths, const string& _filename, const string &_errormessage) {
+	close();
+	filenames = paths;
+	this->errormessage = _errormessage;
+
+	return openFiles(_filename);
+}
+
+bool FileParser::openCached(const string& _filename, const string &_errormessage) {
+	close();
+	filenames = mods->list(_filename);
+	this->errormessage = _errormessage;
+
+	if (data_cache && !filenames.empty()) {
+		cached = data_cache->find(_filename, filenames);
+		if (cached) {
+			current_index = 0;
+			cached_index = 0;
+			return true;
+		}
+	}
+
+	if (!openFiles(_filename))
+		return false;
+
+	if (data_cache) {
+		recording = true;
+		cache_name = _filename;
+	}
+	return true;
+}
+
+/**
+ * Open the first file of filenames which isn't appended to the ones before it
+ */
+bool FileParser::openFiles(const string& _filename) {
+	current_index = 0;
+
 	if (filenames.size() == 0 && !errormessage.empty()) {
 		fprintf(stderr, "%s: %s: No such file or directory!\n", _filename.c_str(), errormessage.c_str());
 		return false;
@@ -55,20 +153,21 @@ bool FileParser::open(const string& _filename, bool locateFileName, const string
 
 	// Cycle through all filenames from the end, stopping when a file is to overwrite all further files.
 	for (unsigned i=filenames.size(); i>0; i--) {
-		infile.open(filenames[i-1].c_str(), ios::in);
-		ret = infile.is_open();
+		ret = openFile(filenames[i-1]);
 
 		if (ret) {
-			// This will be the first file to be parsed. Seek to the start of the file and leave it open.
-			if (infile.good() && trim(getLine(infile)) != "APPEND") {
+			// This will be the first file to be parsed. Rewind to the start of the file and leave it open.
+			const char *file_start = cursor;
+			FileParserView first_line;
+			if (!readLine(first_line) || trimView(first_line.data, first_line.data + first_line.length) != "APPEND") {
 				current_index = i-1;
-				infile.seekg(ios::beg);
+				cursor = file_start;
 				break;
 			}
 
 			// don't close the final file if it's the only one with an "APPEND" line
 			if (i > 1)
-				infile.close();
+				close();
 		}
 		else {
 			if (!errormessage.empty())
@@ -79,9 +178,25 @@ bool FileParser::open(const string& _filename, bool locateFileName, const string
 	return ret;
 }
 
+/**
+ * Use the parser only to hand over entries which are read by other means,
+ * e.g. from a compiled map. filename is reported by getFileName().
+ */
+void FileParser::setSource(const string& filename) {
+	close();
+	filenames.assign(1, filename);
+	current_index = 0;
+	errormessage = "";
+}
+
 void FileParser::close() {
-	if (infile.is_open())
-		infile.close();
+	file.close();
+	cursor = file_end = NULL;
+	key_view = val_view = FileParserView();
+
+	cached = NULL;
+	recording = false;
+	recorded.clear();
 }
 
 /**
@@ -92,48 +207,90 @@ void FileParser::close() {
  */
 bool FileParser::next() {
 
-	string starts_with;
+	FileParserView raw_line;
 	new_section = false;
+	val_pos = 0;
+
+	if (cached) {
+		if (cached_index >= cached->size())
+			return false;
+
+		const DataCacheEntry &entry = (*cached)[cached_index++];
+		new_section = entry.new_section;
+		section = entry.section;
+		current_index = entry.file;
+		key_view = FileParserView(entry.key.data(), entry.key.length());
+		val_view = FileParserView(entry.val.data(), entry.val.length());
+		key = entry.key;
+		val = entry.val;
+		return true;
+	}
 
 	while (current_index < filenames.size()) {
-		while (infile.good()) {
+		while (readLine(raw_line)) {
 
-			line = trim(getLine(infile));
+			const FileParserView trimmed = trimView(raw_line.data, raw_line.data + raw_line.length);
 
 			// skip ahead if this line is empty
-			if (line.length() == 0) continue;
-
-			starts_with = line.at(0);
+			if (trimmed.empty()) continue;
 
 			// skip ahead if this line is a comment
-			if (starts_with == "#") continue;
+			if (trimmed.data[0] == '#') continue;
 
 			// set new section if this line is a section declaration
-			if (starts_with == "[") {
+			if (trimmed.data[0] == '[') {
 				new_section = true;
-				section = parse_section_title(line);
+				const char *bracket = static_cast<const char*>(memchr(trimmed.data, ']', trimmed.length));
+				if (bracket)
+					section.assign(trimmed.data + 1, bracket - trimmed.data - 1);
+				else
+					section.clear();
 
 				// keep searching for a key-pair
 				continue;
 			}
 
 			// skip the string used to combine files
-			if (line == "APPEND") continue;
+			if (trimmed == "APPEND") continue;
 
-			// this is a keypair. Perform basic parsing and return
-			parse_key_pair(line, key, val);
+			// this is a keypair. Split it in place and copy it out only once
+			const char *separator = static_cast<const char*>(memchr(trimmed.data, '=', trimmed.length));
+			if (separator) {
+				key_view = trimView(trimmed.data, separator);
+				val_view = trimView(separator + 1, trimmed.data + trimmed.length);
+			}
+			else {
+				key_view = val_view = FileParserView();
+			}
+			key.assign(key_view.data, key_view.length);
+			val.assign(val_view.data, val_view.length);
+
+			if (recording) {
+				recorded.push_back(DataCacheEntry());
+				DataCacheEntry &entry = recorded.back();
+				entry.new_section = new_section;
+				entry.file = current_index;
+				entry.section = section;
+				entry.key = key;
+				entry.val = val;
+			}
 			return true;
 		}
 
-		infile.close();
+		// all files were read, so the cache gets the complete data file
+		if (recording && current_index + 1 == filenames.size())
+			data_cache->store(cache_name, filenames, recorded);
+
+		file.close();
 
 		current_index++;
-		if (current_index == filenames.size()) return false;
+		if (current_index == filenames.size()) {
+			close();
+			return false;
+		}
 
 		const string current_filename = filenames[current_index];
-		infile.clear();
-		infile.open(current_filename.c_str(), ios::in);
-		if (!infile.is_open()) {
+		if (!openFile(current_filename)) {
 			if (!errormessage.empty())
 				fprintf(stderr, "%s: %s\n", errormessage.c_str(), current_filename.c_str());
 			return false;
@@ -149,36 +306,58 @@ bool FileParser::next() {
 /**
  * Get an unparsed, unfiltered line from the input file
  */
-string FileParser::getRawLine() {
-	line = "";
+FileParserView FileParser::getRawLineView() {
+	FileParserView raw_line;
+	// raw lines aren't cached, so the entries would be incomplete
+	recording = false;
+	readLine(raw_line);
+	return raw_line;
+}
 
-	if (infile.good()) {
-		line = getLine(infile);
-	}
+string FileParser::getRawLine() {
+	line = getRawLineView().str();
 	return line;
 }
 
 string FileParser::nextValue() {
-	if (val == "") {
+	if (val_pos >= val.length()) {
 		return ""; // not found
 	}
 	string s;
-	size_t seppos = val.find_first_of(',');
-	size_t alt_seppos = val.find_first_of(';');
-	if (alt_seppos != string::npos && alt_seppos < seppos)
-		seppos = alt_seppos; // return the first ',' or ';'
+	// return up to the next ',' or ';'
+	size_t seppos = val.find_first_of(",;", val_pos);
 
 	if (seppos == string::npos) {
-		s = val;
-		val = "";
+		s.assign(val, val_pos, string::npos);
+		val_pos = val.length();
 	}
 	else {
-		s = val.substr(0, seppos);
-		val = val.substr(seppos+1);
+		s.assign(val, val_pos, seppos - val_pos);
+		val_pos = seppos + 1;
 	}
 	return s;
 }
 
+/**
+ * Hand over a key pair which was read by other means, see setSource().
+ * Both strings have to outlive the entry.
+ */
+void FileParser::setEntry(const char *_key, const char *_val) {
+	key_view = FileParserView(_key, strlen(_key));
+	val_view = FileParserView(_val, strlen(_val));
+	key.assign(key_view.data, key_view.length);
+	val.assign(val_view.data, val_view.length);
+	val_pos = 0;
+}
+
+const FileParserView& FileParser::getKeyView() const {
+	return key_view;
+}
+
+const FileParserView& FileParser::getValView() const {
+	return val_view;
+}
+
 std::string FileParser::getFileName() {
 	return filenames[current_index];
 }
@@ -26,6 +26,46 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #define FILE_PARSER_H
 
 #include "CommonIncludes.h"
+#include "DataCache.h"
+#include "MappedFile.h"
+
+#include <string.h>
+
+/**
+ * A piece of the file being parsed, which is not copied out of it.
+ * It stays valid until the parser moves on to the next file or is closed.
+ */
+class FileParserView {
+public:
+	const char *data;
+	size_t length;
+
+	FileParserView()
+		: data("")
+		, length(0) {
+	}
+
+	FileParserView(const char *_data, size_t _length)
+		: data(_data)
+		, length(_length) {
+	}
+
+	bool empty() const {
+		return length == 0;
+	}
+
+	bool operator==(const char *s) const {
+		return strlen(s) == length && memcmp(data, s, length) == 0;
+	}
+
+	bool operator!=(const char *s) const {
+		return !(*this == s);
+	}
+
+	std::string str() const {
+		return std::string(data, length);
+	}
+};
 
 class FileParser {
 private:
@@ -33,9 +73,29 @@ private:
 	unsigned current_index;
 	std::string errormessage;
 
-	std::ifstream infile;
+	// the current file is scanned in place; cursor is the start of the next line
+	MappedFile file;
+	const char *cursor;
+	const char *file_end;
 	std::string line;
 
+	FileParserView key_view;
+	FileParserView val_view;
+
+	// where nextValue() continues in val
+	size_t val_pos;
+
+	// entries replayed from the data cache, or recorded for it
+	const std::vector<DataCacheEntry> *cached;
+	unsigned cached_index;
+	bool recording;
+	std::string cache_name;
+	std::vector<DataCacheEntry> recorded;
+
+	bool openFiles(const std::string& filename);
+	bool openFile(const std::string& filename);
+	bool readLine(FileParserView& raw_line);
+
 public:
 	FileParser();
 	~FileParser();
@@ -62,10 +122,27 @@ public:
 	 */
 	bool open(const std::string& filename, bool locateFileName = true, const std::string &errormessage = "Could not open text file");
 
+	/**
+	 * Like open(), but with the files of filename already located by
+	 * ModManager::list(), e.g. on another thread
+	 */
+	bool open(const std::vector<std::string>& paths, const std::string& filename, const std::string &errormessage = "Could not open text file");
+
+	/**
+	 * Like open(), but the entries are taken from the data cache if none of the
+	 * files changed since they were parsed, and stored in it otherwise.
+	 * Only for files which are read with next(); getRawLine() doesn't work on
+	 * cached entries.
+	 */
+	bool openCached(const std::string& filename, const std::string &errormessage = "Could not open text file");
+
+	void setSource(const std::string& filename);
+	void setEntry(const char *_key, const char *_val);
 	void close();
 	bool next();
-	std::string nextValue(); // next value inside one line.
+	std::string nextValue(); // next value inside one line. val itself is left as it is.
 	std::string getRawLine();
+	FileParserView getRawLineView();
 	std::string getFileName();
 
 	/**
@@ -78,6 +155,13 @@ public:
 	std::string section;
 	std::string key;
 	std::string val;
+
+	/**
+	 * The key and value of the current entry, without copying them out of
+	 * the file.
+	 */
+	const FileParserView& getKeyView() const;
+	const FileParserView& getValView() const;
 };
 
 #endif
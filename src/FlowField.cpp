@@ -0,0 +1,158 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+
+#include "FlowField.h"
+#include "MapCollision.h"
+
+#include <algorithm>
+#include <climits>
+
+// step costs, in fifths of a tile, so the queue can be a ring of buckets longer than the biggest step
+static const int STEP = 5;
+static const int DIAGONAL_STEP = 7;
+
+static const unsigned char NO_DIRECTION = 0xff;
+
+static const int NEIGHBOUR_OFFSETS[8][2] = {
+	{-1, -1}, {-1, 1}, {1, -1}, {1, 1},
+	{-1, 0}, {0, -1}, {1, 0}, {0, 1}
+};
+
+const int FlowField::RADIUS;
+
+FlowField::FlowField(int _movement_type)
+	: movement_type(_movement_type)
+	, map_width(0)
+	, map_height(0)
+	, dirty(false)
+	, target(-1, -1) {
+}
+
+FlowField::~FlowField() {
+}
+
+/**
+ * Forget the field of the previous map. It is computed again once a target is set.
+ */
+void FlowField::setmap(int width, int height) {
+	map_width = width;
+	map_height = height;
+	target = Point(-1, -1);
+	area = Rect();
+	dirty = false;
+}
+
+/**
+ * The terrain inside this area has changed
+ */
+void FlowField::invalidate(int x, int y, int w, int h) {
+	if (x < area.x + area.w && y < area.y + area.h && x + w > area.x && y + h > area.y)
+		dirty = true;
+}
+
+/**
+ * The field is only computed again by update() when the target enters another tile
+ */
+void FlowField::setTarget(const Point &_target) {
+	if (_target.x == target.x && _target.y == target.y)
+		return;
+
+	target = _target;
+	dirty = true;
+}
+
+/**
+ * Dijkstra search outwards from the target over the tiles around it
+ */
+void FlowField::update(const MapCollision &collider) {
+	if (!dirty)
+		return;
+	dirty = false;
+
+	if (target.x < 0 || target.y < 0 || target.x >= map_width || target.y >= map_height) {
+		area = Rect();
+		return;
+	}
+
+	area.x = std::max(0, target.x - RADIUS);
+	area.y = std::max(0, target.y - RADIUS);
+	area.w = std::min(map_width, target.x + RADIUS + 1) - area.x;
+	area.h = std::min(map_height, target.y + RADIUS + 1) - area.y;
+
+	cost.assign(area.w * area.h, INT_MAX);
+	direction.assign(area.w * area.h, NO_DIRECTION);
+
+	// passable tiles are marked with INT_MAX, everything else can never be reached
+	for (int y = 0; y < area.h; y++)
+		for (int x = 0; x < area.w; x++)
+			if (!collider.is_open_terrain(area.x + x, area.y + y, static_cast<MOVEMENTTYPE>(movement_type)))
+				cost[y * area.w + x] = -1;
+
+	const int target_index = (target.y - area.y) * area.w + (target.x - area.x);
+	cost[target_index] = 0;
+	buckets[0].push_back(target_index);
+	int queued = 1;
+
+	for (int c = 0; queued > 0; c++) {
+		std::vector<int> &bucket = buckets[c % BUCKETS];
+
+		for (unsigned k = 0; k < bucket.size(); k++) {
+			const int index = bucket[k];
+			queued--;
+
+			// skip tiles which were reached cheaper after they were queued
+			if (cost[index] != c)
+				continue;
+
+			const int x = area.x + index % area.w;
+			const int y = area.y + index / area.w;
+
+			for (int i = 0; i < 8; i++) {
+				const int nx = x + NEIGHBOUR_OFFSETS[i][0];
+				const int ny = y + NEIGHBOUR_OFFSETS[i][1];
+				if (nx < area.x || ny < area.y || nx >= area.x + area.w || ny >= area.y + area.h)
+					continue;
+				const int next = (ny - area.y) * area.w + (nx - area.x);
+
+				const int next_cost = c + (i < 4 ? DIAGONAL_STEP : STEP);
+				if (next_cost < cost[next]) {
+					cost[next] = next_cost;
+					direction[next] = static_cast<unsigned char>(i);
+					buckets[next_cost % BUCKETS].push_back(next);
+					queued++;
+				}
+			}
+		}
+
+		bucket.clear();
+	}
+}
+
+bool FlowField::getStep(const Point &from, Point &next) const {
+	if (from.x < area.x || from.y < area.y || from.x >= area.x + area.w || from.y >= area.y + area.h)
+		return false;
+
+	const int i = direction[(from.y - area.y) * area.w + (from.x - area.x)];
+	if (i == NO_DIRECTION)
+		return false;
+
+	// the direction was stored from the tile closer to the target, so walk it backwards
+	next.x = from.x - NEIGHBOUR_OFFSETS[i][0];
+	next.y = from.y - NEIGHBOUR_OFFSETS[i][1];
+	return true;
+}
@@ -0,0 +1,79 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+
+/**
+ * class FlowField
+ *
+ * The walking distance from every tile around one target to that target,
+ * together with the first step towards it.
+ *
+ * Enemies chasing the hero all go to the same place, so instead of each of
+ * them searching its own path, the field around the hero is computed once
+ * whenever the hero enters a new tile. Any number of entities can then read
+ * their next step from it without searching.
+ *
+ * Only the terrain is considered; tiles occupied by entities count as open.
+ * The field covers a square of RADIUS tiles around the target, entities
+ * further away have to search a path of their own.
+ */
+
+#pragma once
+#ifndef FLOW_FIELD_H
+#define FLOW_FIELD_H
+
+#include "Utils.h"
+
+#include <vector>
+
+class MapCollision;
+
+class FlowField {
+public:
+	static const int RADIUS = 32;
+
+	FlowField(int _movement_type);
+	~FlowField();
+
+	void setmap(int width, int height);
+	void invalidate(int x, int y, int w, int h);
+	void setTarget(const Point &_target);
+	void update(const MapCollision &collider);
+
+	/**
+	 * The neighbour of from which is one step closer to the target.
+	 * Returns false if from is outside of the field, can't reach the target or is the target.
+	 */
+	bool getStep(const Point &from, Point &next) const;
+
+private:
+	const int movement_type;
+	int map_width;
+	int map_height;
+	bool dirty;
+
+	Point target;
+	Rect area; // the tiles covered by the field, clipped to the map
+
+	std::vector<int> cost;
+	std::vector<unsigned char> direction; // index into the neighbour offsets, pointing towards the target
+
+	static const int BUCKETS = 8;
+	std::vector<int> buckets[BUCKETS];
+};
+
+#endif
@@ -61,7 +61,7 @@ FontEngine::FontEngine()
 				style->path = popFirstString(infile.val);
 				style->ptsize = popFirstInt(infile.val);
 				style->blend = toBool(popFirstString(infile.val));
-				style->ttfont = TTF_OpenFont(mods->locate("fonts/" + style->path).c_str(), style->ptsize);
+				style->ttfont = TTF_OpenFontRW(mods->openRW(mods->locate("fonts/" + style->path), true), 1, style->ptsize);
 				if(style->ttfont == NULL) {
 					printf("TTF_OpenFont: %s\n", TTF_GetError());
 				}
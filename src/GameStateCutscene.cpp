@@ -254,7 +254,7 @@ bool GameStateCutscene::load(std::string filename) {
 		else if (infile.key == "caption_margins") {
 			// @ATTR caption_margins|[x,y]|Percentage-based margins for the caption text based on screen size
 			caption_margins.x = toFloat(infile.nextValue())/100.0f;
-			caption_margins.y = toFloat(infile.val)/100.0f;
+			caption_margins.y = toFloat(infile.nextValue())/100.0f;
 		}
 	}
 
@@ -345,7 +345,7 @@ void GameStateLoad::loadPreview(int slot) {
 
 	// fall back to default if it exists
 	for (unsigned int i=0; i<preview_layer.size(); i++) {
-		bool exists = fileExists(mods->locate("animations/avatar/" + stats[slot].gfx_base + "/default_" + preview_layer[i] + ".txt"));
+		bool exists = mods->exists("animations/avatar/" + stats[slot].gfx_base + "/default_" + preview_layer[i] + ".txt");
 		if (exists) {
 			img_gfx.push_back("default_" + preview_layer[i]);
 		}
@@ -522,7 +522,7 @@ void GameStateLoad::updateButtons() {
 	button_action->tooltip = "";
 	if (stats[selected_slot].name == "") {
 		button_action->label = msg->get("New Game");
-		if (!fileExists(mods->locate("maps/spawn.txt"))) {
+		if (!mods->exists("maps/spawn.txt")) {
 			button_action->enabled = false;
 			tablist.remove(button_action);
 			button_action->tooltip = msg->get("Enable a story mod to continue");
@@ -537,7 +537,7 @@ void GameStateLoad::updateButtons() {
 		}
 		button_action->label = msg->get("Load Game");
 		if (current_map[selected_slot] == "") {
-			if (!fileExists(mods->locate("maps/spawn.txt"))) {
+			if (!mods->exists("maps/spawn.txt")) {
 				button_action->enabled = false;
 				tablist.remove(button_action);
 				button_action->tooltip = msg->get("Enable a story mod to continue");
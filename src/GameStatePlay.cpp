@@ -64,12 +64,39 @@ using namespace std;
 
 const int MENU_ENEMY_TIMEOUT = MAX_FRAMES_PER_SEC * 10;
 
+// a map is loaded in stages, one per frame, so the loading screen stays up to date
+const int LOAD_STAGE_NONE = 0;
+const int LOAD_STAGE_MAP = 1;
+const int LOAD_STAGE_ASSETS = 2;
+const int LOAD_STAGE_TILESET = 3;
+const int LOAD_STAGE_COLLISION = 4;
+const int LOAD_STAGE_CHUNKS = 5;
+const int LOAD_STAGE_ENEMIES = 6;
+const int LOAD_STAGE_NPCS = 7;
+const int LOAD_STAGE_MINIMAP = 8;
+const int LOAD_STAGE_COUNT = 8;
+
+static Sprite *createBarSprite(int w, int h, const Color& color) {
+	Image *graphics = render_device->createImage(w, h);
+	if (!graphics)
+		return NULL;
+
+	graphics->fillWithColor(NULL, graphics->MapRGB(color.r, color.g, color.b));
+	Sprite *sprite = graphics->createSprite();
+	graphics->unref();
+	return sprite;
+}
+
 
 GameStatePlay::GameStatePlay()
 	: GameState()
 	, enemy(NULL)
 	, loading(new WidgetLabel())
 	, loading_bg(NULL)
+	, loading_bar(NULL)
+	, loading_bar_fill(NULL)
+	, loading_map("")
+	, loading_stage(LOAD_STAGE_NONE)
 	// Load the loading screen image (we currently use the confirm dialog background):
 	, npc_id(-1)
 	, eventDialogOngoing(false)
@@ -108,6 +135,12 @@ GameStatePlay::GameStatePlay()
 
 	loading->set(VIEW_W_HALF, VIEW_H_HALF, JUSTIFY_CENTER, VALIGN_CENTER, msg->get("Loading..."), color_normal);
 
+	// progress bar below the label
+	if (loading_bg) {
+		loading_bar = createBarSprite(loading_bg->getGraphicsWidth() / 2, 8, Color(32, 32, 32));
+		loading_bar_fill = createBarSprite(loading_bg->getGraphicsWidth() / 2, 8, color_normal);
+	}
+
 	// load the config file for character titles
 	loadTitles();
 }
@@ -268,68 +301,141 @@ void GameStatePlay::checkTeleport() {
 
 		// process intermap teleport
 		if (mapr->teleportation && mapr->teleport_mapname != "") {
-			std::string teleport_mapname = mapr->teleport_mapname;
+			loading_map = mapr->teleport_mapname;
 			mapr->teleport_mapname = "";
 			mapr->executeOnMapExitEvents();
-			showLoading();
-			mapr->load(teleport_mapname);
-			load_counter++;
-			enemies->handleNewMap();
-			hazards->handleNewMap();
-			loot->handleNewMap();
-			powers->handleNewMap(&mapr->collider);
-			menu->enemy->handleNewMap();
-			npcs->handleNewMap();
-			menu->vendor->npc = NULL;
-			menu->vendor->visible = false;
-			menu->talker->visible = false;
-			menu->stash->visible = false;
-			menu->npc->visible = false;
-			menu->mini->prerender(&mapr->collider, mapr->w, mapr->h);
-			npc_id = nearest_npc = -1;
-
-			// store this as the new respawn point
-			mapr->respawn_map = teleport_mapname;
-			mapr->respawn_point.x = pc->stats.pos.x;
-			mapr->respawn_point.y = pc->stats.pos.y;
-
-			// return to title (permadeath) OR auto-save
-			if (pc->stats.permadeath && pc->stats.corpse) {
-				stringstream filename;
-				filename << PATH_USER;
-				if (SAVE_PREFIX.length() > 0)
-					filename << SAVE_PREFIX << "_";
-				filename << "save" << game_slot << ".txt";
-				if (remove(filename.str().c_str()) != 0)
-					perror("Error deleting save from path");
-
-				// Remove stash
-				stringstream ss;
-				ss.str("");
-				ss << PATH_USER;
-				if (SAVE_PREFIX.length() > 0)
-					ss << SAVE_PREFIX << "_";
-				ss << "stash_HC" << game_slot << ".txt";
-				if (remove(ss.str().c_str()) != 0)
-					fprintf(stderr, "Error deleting hardcore stash in slot %d\n", game_slot);
-
-				delete requestedGameState;
-				requestedGameState = new GameStateTitle();
-			}
-			else {
-				saveGame();
-			}
+
+			// the new map is loaded over the next frames, updateLoading() finishes the teleport
+			loading_stage = LOAD_STAGE_MAP;
+			return;
 		}
 
-		mapr->collider.block(pc->stats.pos.x, pc->stats.pos.y, false);
+		finishTeleport();
+	}
+
+	if (mapr->teleport_mapname == "") mapr->teleportation = false;
+}
+
+/**
+ * Do the next stage of loading a map. The game logic waits meanwhile, but
+ * frames are still drawn, so the loading screen shows the progress.
+ */
+void GameStatePlay::updateLoading() {
+	prof->begin(PROF_LOADING);
+
+	if (loading_stage == LOAD_STAGE_MAP) {
+		prof->begin(PROF_LOAD_MAP);
+		mapr->loadMapFile(loading_map);
+		prof->end(PROF_LOAD_MAP);
+	}
+	else if (loading_stage == LOAD_STAGE_ASSETS) {
+		prof->begin(PROF_LOAD_ASSETS);
+		mapr->loadAssets();
+		prof->end(PROF_LOAD_ASSETS);
+	}
+	else if (loading_stage == LOAD_STAGE_TILESET) {
+		prof->begin(PROF_LOAD_TILESET);
+		mapr->loadTileset();
+		prof->end(PROF_LOAD_TILESET);
+	}
+	else if (loading_stage == LOAD_STAGE_COLLISION) {
+		prof->begin(PROF_LOAD_COLLISION);
+		mapr->loadCollision();
+		prof->end(PROF_LOAD_COLLISION);
+	}
+	else if (loading_stage == LOAD_STAGE_CHUNKS) {
+		prof->begin(PROF_LOAD_CHUNKS);
+		mapr->loadChunks();
+		prof->end(PROF_LOAD_CHUNKS);
+	}
+	else if (loading_stage == LOAD_STAGE_ENEMIES) {
+		prof->begin(PROF_LOAD_ENEMIES);
+		enemies->handleNewMap();
+		hazards->handleNewMap();
+		loot->handleNewMap();
+		powers->handleNewMap(&mapr->collider);
+		menu->enemy->handleNewMap();
+		prof->end(PROF_LOAD_ENEMIES);
+	}
+	else if (loading_stage == LOAD_STAGE_NPCS) {
+		prof->begin(PROF_LOAD_NPCS);
+		npcs->handleNewMap();
+		if (assets) assets->clear();
+		menu->vendor->npc = NULL;
+		menu->vendor->visible = false;
+		menu->talker->visible = false;
+		menu->stash->visible = false;
+		menu->npc->visible = false;
+		prof->end(PROF_LOAD_NPCS);
+	}
+	else if (loading_stage == LOAD_STAGE_MINIMAP) {
+		prof->begin(PROF_LOAD_MINIMAP);
+		menu->mini->prerender(&mapr->collider, mapr->w, mapr->h);
+		prof->end(PROF_LOAD_MINIMAP);
+	}
+
+	prof->end(PROF_LOADING);
+
+	// each stage is slow, don't let the main loop try to catch up by running the next one right away
+	load_counter++;
 
-		pc->stats.teleportation = false; // teleport spell
+	if (loading_stage < LOAD_STAGE_COUNT) {
+		loading_stage++;
+		return;
+	}
+	loading_stage = LOAD_STAGE_NONE;
+
+	npc_id = nearest_npc = -1;
+
+	// store this as the new respawn point
+	mapr->respawn_map = loading_map;
+	mapr->respawn_point.x = pc->stats.pos.x;
+	mapr->respawn_point.y = pc->stats.pos.y;
+
+	// return to title (permadeath) OR auto-save
+	if (pc->stats.permadeath && pc->stats.corpse) {
+		stringstream filename;
+		filename << PATH_USER;
+		if (SAVE_PREFIX.length() > 0)
+			filename << SAVE_PREFIX << "_";
+		filename << "save" << game_slot << ".txt";
+		if (remove(filename.str().c_str()) != 0)
+			perror("Error deleting save from path");
+
+		// Remove stash
+		stringstream ss;
+		ss.str("");
+		ss << PATH_USER;
+		if (SAVE_PREFIX.length() > 0)
+			ss << SAVE_PREFIX << "_";
+		ss << "stash_HC" << game_slot << ".txt";
+		if (remove(ss.str().c_str()) != 0)
+			fprintf(stderr, "Error deleting hardcore stash in slot %d\n", game_slot);
 
+		delete requestedGameState;
+		requestedGameState = new GameStateTitle();
 	}
+	else {
+		saveGame();
+	}
+
+	finishTeleport();
 
 	if (mapr->teleport_mapname == "") mapr->teleportation = false;
 }
 
+/**
+ * Put the hero down at the teleport destination
+ */
+void GameStatePlay::finishTeleport() {
+	// the destination may be in a region of a streamed map which isn't loaded yet
+	mapr->streamRegions();
+
+	mapr->collider.block(pc->stats.pos.x, pc->stats.pos.y, false);
+
+	pc->stats.teleportation = false; // teleport spell
+}
+
 /**
  * Check for cancel key to exit menus or exit the game.
  * Also check closing the game window entirely.
@@ -527,7 +633,7 @@ void GameStatePlay::checkEquipmentChange() {
 			}
 			// fall back to default if it exists
 			if (gfx.gfx == "") {
-				bool exists = fileExists(mods->locate("animations/avatar/" + pc->stats.gfx_base + "/default_" + gfx.type + ".txt"));
+				bool exists = mods->exists("animations/avatar/" + pc->stats.gfx_base + "/default_" + gfx.type + ".txt");
 				if (exists) gfx.gfx = "default_" + gfx.type;
 			}
 			img_gfx.push_back(gfx);
@@ -793,10 +899,18 @@ void GameStatePlay::checkCutscene() {
  */
 void GameStatePlay::logic() {
 
+	// while a map is loading, the game waits and the loading screen is shown
+	if (loading_stage != LOAD_STAGE_NONE) {
+		updateLoading();
+		return;
+	}
+
 	checkCutscene();
 
 	// check menus first (top layer gets mouse click priority)
+	prof->begin(PROF_MENU_LOGIC);
 	menu->logic();
+	prof->end(PROF_MENU_LOGIC);
 
 	if (!menu->pause) {
 
@@ -811,7 +925,9 @@ void GameStatePlay::logic() {
 		checkTitle();
 
 		int actionbar_power = menu->act->checkAction();
+		prof->begin(PROF_AVATAR);
 		pc->logic(actionbar_power, restrictPowerUse());
+		prof->end(PROF_AVATAR);
 
 		// Transform powers change the actionbar layout,
 		// so we need to prevent accidental clicks if a new power is placed under the slot we clicked on.
@@ -823,12 +939,27 @@ void GameStatePlay::logic() {
 		// transfer hero data to enemies, for AI use
 		if (pc->stats.get(STAT_STEALTH) > 100) enemies->hero_stealth = 100;
 		else enemies->hero_stealth = pc->stats.get(STAT_STEALTH);
+		mapr->collider.set_flow_target(pc->stats.pos);
 
+		prof->begin(PROF_ENEMIES);
 		enemies->logic();
+		prof->end(PROF_ENEMIES);
+
+		prof->begin(PROF_HAZARDS);
 		hazards->logic();
+		prof->end(PROF_HAZARDS);
+
+		prof->begin(PROF_LOOT);
 		loot->logic();
+		prof->end(PROF_LOOT);
+
+		prof->begin(PROF_ENEMIES);
 		enemies->checkEnemiesforXP();
+		prof->end(PROF_ENEMIES);
+
+		prof->begin(PROF_NPCS);
 		npcs->logic();
+		prof->end(PROF_NPCS);
 
 		snd->logic(pc->stats.pos);
 	}
@@ -841,6 +972,7 @@ void GameStatePlay::logic() {
 
 	// these actions occur whether the game is paused or not.
 	checkTeleport();
+	if (loading_stage != LOAD_STAGE_NONE) return;
 	checkLootDrop();
 	checkLog();
 	checkBook();
@@ -850,8 +982,17 @@ void GameStatePlay::logic() {
 	checkNotifications();
 	checkCancel();
 
+	prof->begin(PROF_MAP_LOGIC);
 	mapr->logic();
-	mapr->enemies_cleared = enemies->isCleared();
+	prof->end(PROF_MAP_LOGIC);
+
+	// enemies and NPCs of regions which were just loaded
+	if (!mapr->enemies.empty())
+		enemies->addMapEnemies();
+	if (!mapr->npcs.empty())
+		npcs->addMapNPCs();
+
+	mapr->enemies_cleared = enemies->isCleared() && mapr->allRegionsVisited();
 	quests->logic();
 
 
@@ -924,11 +1065,17 @@ void GameStatePlay::logic() {
  */
 void GameStatePlay::render() {
 
+	if (loading_stage != LOAD_STAGE_NONE) {
+		showLoading();
+		return;
+	}
+
 	// Create a list of Renderables from all objects not already on the map.
 	// split the list into the beings alive (may move) and dead beings (must not move)
 	vector<Renderable> rens;
 	vector<Renderable> rens_dead;
 
+	prof->begin(PROF_RENDER_ADD);
 	pc->addRenders(rens);
 
 	enemies->addRenders(rens, rens_dead);
@@ -938,22 +1085,30 @@ void GameStatePlay::render() {
 	loot->addRenders(rens, rens_dead);
 
 	hazards->addRenders(rens, rens_dead);
+	prof->end(PROF_RENDER_ADD);
 
 
 	// render the static map layers plus the renderables
+	prof->begin(PROF_MAP_RENDER);
 	mapr->render(rens, rens_dead);
+	prof->end(PROF_MAP_RENDER);
 
 	// mouseover tooltips
 	loot->renderTooltips(mapr->cam);
 	npcs->renderTooltips(mapr->cam, inpt->mouse, nearest_npc);
 
+	prof->begin(PROF_MINIMAP_RENDER);
 	if (mapr->map_change) {
 		menu->mini->prerender(&mapr->collider, mapr->w, mapr->h);
 		mapr->map_change = false;
 	}
 	menu->mini->getMapTitle(mapr->title);
 	menu->mini->render(pc->stats.pos);
+	prof->end(PROF_MINIMAP_RENDER);
+
+	prof->begin(PROF_MENU_RENDER);
 	menu->render();
+	prof->end(PROF_MENU_RENDER);
 
 	// render combat text last - this should make it obvious you're being
 	// attacked, even if you have menus open
@@ -973,7 +1128,19 @@ void GameStatePlay::showLoading() {
 	render_device->render(loading_bg);
 	loading->render();
 
-	render_device->commitFrame();
+	// progress bar, filled by the finished loading stages
+	if (loading_bar && loading_bar_fill) {
+		dest.x = VIEW_W_HALF - loading_bar->getGraphicsWidth()/2;
+		dest.y = VIEW_H_HALF + loading_bg->getGraphicsHeight()/4;
+
+		loading_bar->setDest(dest);
+		render_device->render(loading_bar);
+
+		int done = (loading_stage > LOAD_STAGE_NONE) ? loading_stage - 1 : 0;
+		loading_bar_fill->setClipW(loading_bar_fill->getGraphicsWidth() * done / LOAD_STAGE_COUNT);
+		loading_bar_fill->setDest(dest);
+		render_device->render(loading_bar_fill);
+	}
 }
 
 Avatar *GameStatePlay::getAvatar() const {
@@ -982,6 +1149,8 @@ Avatar *GameStatePlay::getAvatar() const {
 
 GameStatePlay::~GameStatePlay() {
 	if (loading_bg)	delete loading_bg;
+	if (loading_bar) delete loading_bar;
+	if (loading_bar_fill) delete loading_bar_fill;
 	delete quests;
 	delete npcs;
 	delete hazards;
@@ -69,12 +69,20 @@ private:
 
 	WidgetLabel *loading;
 	Sprite *loading_bg;
+	Sprite *loading_bar;
+	Sprite *loading_bar_fill;
+
+	// the map being loaded and the next step of it, see updateLoading()
+	std::string loading_map;
+	int loading_stage;
 
 	bool restrictPowerUse();
 	void checkEnemyFocus();
 	void checkLoot();
 	void checkLootDrop();
 	void checkTeleport();
+	void finishTeleport();
+	void updateLoading();
 	void checkCancel();
 	void checkLog();
 	void checkBook();
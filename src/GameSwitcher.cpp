@@ -34,6 +34,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "GameSwitcher.h"
 #include "GameStateTitle.h"
 #include "GameStateCutscene.h"
+#include "GameStatePlay.h"
 #include "SharedResources.h"
 #include "Settings.h"
 #include "FileParser.h"
@@ -45,15 +46,26 @@ using namespace std;
 
 GameSwitcher::GameSwitcher() {
 
-	// The initial state is the intro cutscene and then title screen
-	GameStateTitle *title=new GameStateTitle();
-	GameStateCutscene *intro = new GameStateCutscene(title);
+	if (LOAD_SLOT > 0) {
+		// Skip straight to the game, as if the slot was picked on the load screen
+		GameStatePlay *play = new GameStatePlay();
+		play->resetGame();
+		play->game_slot = LOAD_SLOT;
+		play->loadGame();
 
-	currentState = intro;
+		currentState = play;
+	}
+	else {
+		// The initial state is the intro cutscene and then title screen
+		GameStateTitle *title=new GameStateTitle();
+		GameStateCutscene *intro = new GameStateCutscene(title);
+
+		currentState = intro;
 
-	if (!intro->load("cutscenes/intro.txt")) {
-		delete intro;
-		currentState = title;
+		if (!intro->load("cutscenes/intro.txt")) {
+			delete intro;
+			currentState = title;
+		}
 	}
 
 	label_fps = new WidgetLabel();
@@ -79,7 +91,7 @@ void GameSwitcher::loadMusic() {
 		}
 
 		if (music_filename != "") {
-			music = Mix_LoadMUS((mods->locate(music_filename)).c_str());
+			music = Mix_LoadMUSType_RW(mods->openRW(mods->locate(music_filename), true), MUS_NONE, 1);
 			if (!music)
 				printf("Mix_LoadMUS: %s\n", Mix_GetError());
 		}
@@ -17,6 +17,8 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 */
 
 #include "GetText.h"
+#include "MappedFile.h"
+#include "SharedResources.h"
 #include "UtilsParsing.h"
 
 
@@ -30,14 +32,21 @@ GetText::GetText()
 	, fuzzy(false) {
 }
 
+/**
+ * Read a whole .po file, which may be in a mod archive
+ */
 bool GetText::open(const string& filename) {
-	infile.open(filename.c_str(), ios::in);
-	return infile.is_open();
+	MappedFile file;
+	if (!mods->openFile(filename, file))
+		return false;
+
+	infile.clear();
+	infile.str(string(reinterpret_cast<const char*>(file.getData()), file.getSize()));
+	return true;
 }
 
 void GetText::close() {
-	if (infile.is_open())
-		infile.close();
+	infile.str("");
 }
 
 // Turns all \" into just "
@@ -31,7 +31,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 class GetText {
 private:
-	std::ifstream infile;
+	std::istringstream infile;
 	std::string line;
 	std::string sanitize(std::string input);
 
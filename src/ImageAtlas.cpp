@@ -0,0 +1,115 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "ImageAtlas.h"
+#include "RenderDevice.h"
+
+// empty space kept around each packed image, so neighbours never bleed into each other
+static const int ATLAS_PADDING = 1;
+
+ImageAtlas::ImageAtlas()
+	: device(NULL)
+	, page_size(0)
+	, pages() {
+}
+
+ImageAtlas::~ImageAtlas() {
+}
+
+void ImageAtlas::init(RenderDevice *_device, int _page_size) {
+	device = _device;
+	page_size = _page_size;
+}
+
+/**
+ * Only images up to half the page size are packed, anything bigger would
+ * leave too much of a page unused
+ */
+bool ImageAtlas::fits(int w, int h) const {
+	if (!device || page_size <= 0 || w <= 0 || h <= 0)
+		return false;
+	return w + ATLAS_PADDING <= page_size / 2 && h + ATLAS_PADDING <= page_size / 2;
+}
+
+Image *ImageAtlas::insert(int w, int h, Point &pos) {
+	if (!fits(w, h))
+		return NULL;
+
+	for (unsigned i = 0; i < pages.size(); ++i) {
+		if (insertIntoPage(pages[i], w, h, pos)) {
+			pages[i].image->ref();
+			return pages[i].image;
+		}
+	}
+
+	// the reference from createImage is the one handed to the packed image
+	ImageAtlasPage page;
+	page.image = device->createImage(page_size, page_size);
+	if (!page.image)
+		return NULL;
+
+	pages.push_back(page);
+	insertIntoPage(pages.back(), w, h, pos);
+	return page.image;
+}
+
+/**
+ * Put the image on the shelf which wastes the least height. If none has room,
+ * a new shelf is opened below the others.
+ */
+bool ImageAtlas::insertIntoPage(ImageAtlasPage &page, int w, int h, Point &pos) {
+	const int padded_w = w + ATLAS_PADDING;
+	const int padded_h = h + ATLAS_PADDING;
+
+	ImageAtlasShelf *best = NULL;
+	for (unsigned i = 0; i < page.shelves.size(); ++i) {
+		ImageAtlasShelf &shelf = page.shelves[i];
+		if (shelf.h < padded_h || shelf.used_w + padded_w > page_size)
+			continue;
+		// don't waste more than a third of a shelf on a short image
+		if (padded_h < shelf.h * 2 / 3)
+			continue;
+		if (!best || shelf.h < best->h)
+			best = &shelf;
+	}
+
+	if (!best) {
+		if (page.used_h + padded_h > page_size)
+			return false;
+		page.shelves.push_back(ImageAtlasShelf(page.used_h, padded_h));
+		page.used_h += padded_h;
+		best = &page.shelves.back();
+	}
+
+	pos.x = best->used_w;
+	pos.y = best->y;
+	best->used_w += padded_w;
+	return true;
+}
+
+void ImageAtlas::removePage(Image *image) {
+	for (unsigned i = 0; i < pages.size(); ++i) {
+		if (pages[i].image == image) {
+			pages.erase(pages.begin() + i);
+			return;
+		}
+	}
+}
+
+int ImageAtlas::getPageCount() const {
+	return static_cast<int>(pages.size());
+}
@@ -0,0 +1,93 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class ImageAtlas
+ *
+ * Packs small images into large shared pages. Each page is divided into
+ * shelves, rows of images with about the same height, which are filled from
+ * left to right. A page is freed when the last image packed into it is freed;
+ * the space of single images is not reused before that.
+ *
+ * The atlas only does the bookkeeping. Copying the pixels into the page is up
+ * to the RenderDevice.
+ */
+
+#pragma once
+#ifndef IMAGE_ATLAS_H
+#define IMAGE_ATLAS_H
+
+#include <vector>
+#include "Utils.h"
+
+class Image;
+class RenderDevice;
+
+class ImageAtlasShelf {
+public:
+	int y;
+	int h;
+	int used_w;
+
+	ImageAtlasShelf(int _y, int _h)
+		: y(_y)
+		, h(_h)
+		, used_w(0) {
+	}
+};
+
+class ImageAtlasPage {
+public:
+	Image *image;
+	int used_h;
+	std::vector<ImageAtlasShelf> shelves;
+
+	ImageAtlasPage()
+		: image(NULL)
+		, used_h(0) {
+	}
+};
+
+class ImageAtlas {
+public:
+	ImageAtlas();
+	~ImageAtlas();
+
+	// page_size 0 disables packing
+	void init(RenderDevice *_device, int _page_size);
+	bool fits(int w, int h) const;
+
+	// find room for a w x h image. Returns the page with a new reference for
+	// the packed image, or NULL if there is no room and no page can be created.
+	Image *insert(int w, int h, Point &pos);
+
+	// to be called when a page is freed
+	void removePage(Image *image);
+
+	int getPageCount() const;
+
+private:
+	ImageAtlas(const ImageAtlas &copy); // not implemented
+
+	bool insertIntoPage(ImageAtlasPage &page, int w, int h, Point &pos);
+
+	RenderDevice *device;
+	int page_size;
+	std::vector<ImageAtlasPage> pages;
+};
+
+#endif
@@ -32,6 +32,32 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 using namespace std;
 
+// Replay files start with this identifier, followed by a format version
+const char REPLAY_MAGIC[4] = {'F', 'L', 'R', 'P'};
+const Uint8 REPLAY_VERSION = 1;
+
+// bits of the per-tick flags byte in replay files
+const Uint8 REPLAY_SCROLL_UP = 0x1;
+const Uint8 REPLAY_SCROLL_DOWN = 0x2;
+const Uint8 REPLAY_DONE = 0x4;
+
+// replay values are stored little-endian, regardless of the platform
+static void writeReplayInt(std::ofstream &out, Uint32 val, int bytes) {
+	for (int i=0; i<bytes; i++) {
+		out.put((char)((val >> (i*8)) & 0xff));
+	}
+}
+
+static bool readReplayInt(std::ifstream &in, Uint32 *val, int bytes) {
+	*val = 0;
+	for (int i=0; i<bytes; i++) {
+		int c = in.get();
+		if (c == EOF) return false;
+		*val |= (Uint32)(c & 0xff) << (i*8);
+	}
+	return true;
+}
+
 InputState::InputState(void)
 	: done(false)
 	, mouse()
@@ -40,7 +66,9 @@ InputState::InputState(void)
 	, last_joybutton(0)
 	, scroll_up(false)
 	, scroll_down(false)
-	, lock_scroll(false) {
+	, lock_scroll(false)
+	, recording(false)
+	, replaying(false) {
 #if SDL_VERSION_ATLEAST(2,0,0)
 	SDL_StartTextInput();
 #else
@@ -243,6 +271,16 @@ void InputState::saveKeyBindings() {
 void InputState::handle(bool dump_event) {
 	SDL_Event event;
 
+	if (replaying) {
+		// drain the event queue, so that the window stays responsive
+		while (SDL_PollEvent (&event)) {
+			if (event.type == SDL_QUIT) done = 1;
+			else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F3) prof->toggleOverlay();
+		}
+		replayTick();
+		return;
+	}
+
 	SDL_GetMouseState(&mouse.x, &mouse.y);
 
 	inkeys = "";
@@ -353,6 +391,8 @@ void InputState::handle(bool dump_event) {
 						un_press[key] = false;
 					}
 				}
+				// F3 is a fixed debug key for the profiler overlay
+				if (event.key.keysym.sym == SDLK_F3) prof->toggleOverlay();
 				break;
 			case SDL_KEYUP:
 				for (int key=0; key<key_count; key++) {
@@ -631,6 +671,8 @@ void InputState::handle(bool dump_event) {
 			joyLastPosY = JOY_POS_CENTER;
 		}
 	}
+
+	if (recording) recordTick();
 }
 
 void InputState::resetScroll() {
@@ -747,5 +789,121 @@ std::string InputState::getKeyName(int key) {
 #endif
 }
 
+/**
+ * Write the result of every following handle() call to a replay file
+ * The random seed is stored in the header, so a replay can restore it.
+ */
+bool InputState::startRecording(const std::string& filename, unsigned int seed) {
+	record_file.open(filename.c_str(), ios::out | ios::binary | ios::trunc);
+	if (!record_file.is_open()) {
+		fprintf(stderr, "Unable to open replay file for recording: %s\n", filename.c_str());
+		return false;
+	}
+
+	record_file.write(REPLAY_MAGIC, 4);
+	writeReplayInt(record_file, REPLAY_VERSION, 1);
+	writeReplayInt(record_file, key_count, 1);
+	writeReplayInt(record_file, seed, 4);
+
+	recording = true;
+	return true;
+}
+
+/**
+ * Replace hardware input with the ticks stored in a replay file
+ * The seed that the replay was recorded with is written to *seed.
+ */
+bool InputState::startReplay(const std::string& filename, unsigned int *seed) {
+	replay_file.open(filename.c_str(), ios::in | ios::binary);
+	if (!replay_file.is_open()) {
+		fprintf(stderr, "Unable to open replay file: %s\n", filename.c_str());
+		return false;
+	}
+
+	char magic[4];
+	Uint32 version, keys, file_seed;
+	replay_file.read(magic, 4);
+	if (!replay_file.good() || memcmp(magic, REPLAY_MAGIC, 4) != 0 ||
+		!readReplayInt(replay_file, &version, 1) || version != REPLAY_VERSION ||
+		!readReplayInt(replay_file, &keys, 1) || keys != (Uint32)key_count ||
+		!readReplayInt(replay_file, &file_seed, 4)) {
+		fprintf(stderr, "Invalid or incompatible replay file: %s\n", filename.c_str());
+		replay_file.close();
+		return false;
+	}
+
+	*seed = file_seed;
+	replaying = true;
+	return true;
+}
+
+/**
+ * Store the input state of a single logic tick
+ * Layout: pressing mask (4), lock mask (4), mouse x (2), mouse y (2), flags (1),
+ * text input length (1), text input
+ */
+void InputState::recordTick() {
+	Uint32 pressing_mask = 0;
+	Uint32 lock_mask = 0;
+	for (int key=0; key<key_count; key++) {
+		if (pressing[key]) pressing_mask |= (1 << key);
+		if (lock[key]) lock_mask |= (1 << key);
+	}
+
+	Uint8 flags = 0;
+	if (scroll_up) flags |= REPLAY_SCROLL_UP;
+	if (scroll_down) flags |= REPLAY_SCROLL_DOWN;
+	if (done) flags |= REPLAY_DONE;
+
+	size_t text_len = inkeys.length() > 255 ? 255 : inkeys.length();
+
+	writeReplayInt(record_file, pressing_mask, 4);
+	writeReplayInt(record_file, lock_mask, 4);
+	writeReplayInt(record_file, (Uint16)mouse.x, 2);
+	writeReplayInt(record_file, (Uint16)mouse.y, 2);
+	writeReplayInt(record_file, flags, 1);
+	writeReplayInt(record_file, (Uint32)text_len, 1);
+	record_file.write(inkeys.c_str(), text_len);
+}
+
+/**
+ * Restore the input state of the next recorded logic tick
+ * When the replay runs out, the game is asked to quit.
+ */
+void InputState::replayTick() {
+	Uint32 pressing_mask, lock_mask, mouse_x, mouse_y, flags, text_len;
+
+	if (!readReplayInt(replay_file, &pressing_mask, 4) ||
+		!readReplayInt(replay_file, &lock_mask, 4) ||
+		!readReplayInt(replay_file, &mouse_x, 2) ||
+		!readReplayInt(replay_file, &mouse_y, 2) ||
+		!readReplayInt(replay_file, &flags, 1) ||
+		!readReplayInt(replay_file, &text_len, 1)) {
+		printf("Replay finished.\n");
+		replay_file.close();
+		replaying = false;
+		done = true;
+		return;
+	}
+
+	for (int key=0; key<key_count; key++) {
+		pressing[key] = (pressing_mask & (1 << key)) != 0;
+		lock[key] = (lock_mask & (1 << key)) != 0;
+		un_press[key] = false;
+	}
+
+	mouse.x = (Sint16)mouse_x;
+	mouse.y = (Sint16)mouse_y;
+	scroll_up = (flags & REPLAY_SCROLL_UP) != 0;
+	scroll_down = (flags & REPLAY_SCROLL_DOWN) != 0;
+	if (flags & REPLAY_DONE) done = true;
+
+	char text[256];
+	replay_file.read(text, text_len);
+	inkeys = std::string(text, replay_file.gcount());
+}
+
 InputState::~InputState() {
+	if (record_file.is_open()) record_file.close();
+	if (replay_file.is_open()) replay_file.close();
 }
@@ -94,6 +94,10 @@ public:
 	std::string getJoystickName(int index);
 	std::string getKeyName(int key);
 
+	// input recording and replay, used for reproducible test runs
+	bool startRecording(const std::string& filename, unsigned int seed);
+	bool startReplay(const std::string& filename, unsigned int *seed);
+
 	bool pressing[key_count];
 	bool lock[key_count];
 
@@ -109,6 +113,14 @@ public:
 
 private:
 	bool un_press[key_count];
+
+	void recordTick();
+	void replayTick();
+
+	std::ofstream record_file;
+	std::ifstream replay_file;
+	bool recording;
+	bool replaying;
 };
 
 #endif
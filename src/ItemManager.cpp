@@ -117,7 +117,7 @@ void ItemManager::loadItems() {
 	FileParser infile;
 
 	// @CLASS ItemManager: Items|Description about the class and it usage, items/items.txt...
-	if (!infile.open("items/items.txt"))
+	if (!infile.openCached("items/items.txt"))
 		return;
 
 	int id = 0;
@@ -181,32 +181,36 @@ void ItemManager::loadItems() {
 		else if (infile.key == "dmg_melee") {
 			// @ATTR dmg_melee|[min (integer), max (integer)]|Defines the item melee damage, if only min is specified the melee damage is fixed.
 			items[id].dmg_melee_min = toInt(infile.nextValue());
-			if (infile.val.length() > 0)
-				items[id].dmg_melee_max = toInt(infile.nextValue());
+			const std::string max_value = infile.nextValue();
+			if (max_value.length() > 0)
+				items[id].dmg_melee_max = toInt(max_value);
 			else
 				items[id].dmg_melee_max = items[id].dmg_melee_min;
 		}
 		else if (infile.key == "dmg_ranged") {
 			// @ATTR dmg_ranged|[min (integer), max (integer)]|Defines the item ranged damage, if only min is specified the ranged damage is fixed.
 			items[id].dmg_ranged_min = toInt(infile.nextValue());
-			if (infile.val.length() > 0)
-				items[id].dmg_ranged_max = toInt(infile.nextValue());
+			const std::string max_value = infile.nextValue();
+			if (max_value.length() > 0)
+				items[id].dmg_ranged_max = toInt(max_value);
 			else
 				items[id].dmg_ranged_max = items[id].dmg_ranged_min;
 		}
 		else if (infile.key == "dmg_ment") {
 			// @ATTR dmg_ment|[min (integer), max (integer)]|Defines the item mental damage, if only min is specified the ranged damage is fixed.
 			items[id].dmg_ment_min = toInt(infile.nextValue());
-			if (infile.val.length() > 0)
-				items[id].dmg_ment_max = toInt(infile.nextValue());
+			const std::string max_value = infile.nextValue();
+			if (max_value.length() > 0)
+				items[id].dmg_ment_max = toInt(max_value);
 			else
 				items[id].dmg_ment_max = items[id].dmg_ment_min;
 		}
 		else if (infile.key == "abs") {
 			// @ATTR abs|[min (integer), max (integer)]|Defines the item absorb value, if only min is specified the absorb value is fixed.
 			items[id].abs_min = toInt(infile.nextValue());
-			if (infile.val.length() > 0)
-				items[id].abs_max = toInt(infile.nextValue());
+			const std::string max_value = infile.nextValue();
+			if (max_value.length() > 0)
+				items[id].abs_max = toInt(max_value);
 			else
 				items[id].abs_max = items[id].abs_min;
 		}
@@ -311,7 +315,7 @@ void ItemManager::loadTypes() {
 	type = description = "";
 
 	// @CLASS ItemManager: Types|Definition of a item types, items/types.txt...
-	if (infile.open("items/types.txt")) {
+	if (infile.openCached("items/types.txt")) {
 		while (infile.next()) {
 			// @ATTR name|string|Item type name.
 			if (infile.key == "name") type = infile.val;
@@ -345,7 +349,7 @@ void ItemManager::loadSets() {
 	FileParser infile;
 
 	// @CLASS ItemManager: Sets|Definition of a item sets, items/sets.txt...
-	if (!infile.open("items/sets.txt"))
+	if (!infile.openCached("items/sets.txt"))
 		return;
 
 	int id = 0;
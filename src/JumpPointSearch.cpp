@@ -0,0 +1,261 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+
+#include "JumpPointSearch.h"
+#include "MapCollision.h"
+
+static const int NEIGHBOUR_OFFSETS[8][2] = {
+	{-1, -1}, {-1, 1}, {1, -1}, {1, 1},
+	{-1, 0}, {0, -1}, {1, 0}, {0, 1}
+};
+
+// the A* search looks at the 8 neighbours of each tile it explores, so a search with the same
+// limit may scan 8 tiles per jump point
+static const unsigned int SCANS_PER_NODE = 8;
+
+static int signum(int value) {
+	return (value > 0) - (value < 0);
+}
+
+JumpPointSearch::JumpPointSearch()
+	: collider(NULL)
+	, movement_type(0)
+	, explored(0)
+	, explore_limit(0)
+	, closest_distance(0) {
+}
+
+JumpPointSearch::~JumpPointSearch() {
+}
+
+bool JumpPointSearch::search(const MapCollision &_collider, AStarContainer &astar, const Point &start, const Point &end, std::vector<FPoint> &path, int _movement_type, unsigned int limit) {
+	collider = &_collider;
+	movement_type = _movement_type;
+	goal = end;
+	current = start;
+	explored = 0;
+	explore_limit = limit * SCANS_PER_NODE;
+	closest = closest_corner = closest_from = start;
+	closest_distance = (start.x - end.x) * (start.x - end.x) + (start.y - end.y) * (start.y - end.y);
+
+	astar.reset(collider->map_size.x, collider->map_size.y, limit);
+	astar.add(start, start, 0, calcDist(start, end));
+
+	bool reached = false;
+
+	while (!astar.isEmpty() && astar.getClosedSize() < limit && explored < explore_limit) {
+		AStarNode *node = astar.close_shortest_f();
+		current = Point(node->getX(), node->getY());
+
+		if (current.x == end.x && current.y == end.y) {
+			reached = true;
+			break;
+		}
+
+		const float actual_cost = node->getActualCost();
+		const int px = signum(current.x - node->getParent().x);
+		const int py = signum(current.y - node->getParent().y);
+
+		// only the directions in which a shortest path can continue are scanned
+		int directions[8][2];
+		int count = 0;
+		if (px == 0 && py == 0) {
+			for (int i = 0; i < 8; i++) {
+				directions[count][0] = NEIGHBOUR_OFFSETS[i][0];
+				directions[count++][1] = NEIGHBOUR_OFFSETS[i][1];
+			}
+		}
+		else if (px != 0 && py != 0) {
+			directions[count][0] = px;
+			directions[count++][1] = py;
+			directions[count][0] = px;
+			directions[count++][1] = 0;
+			directions[count][0] = 0;
+			directions[count++][1] = py;
+			if (!isWalkable(current.x - px, current.y)) {
+				directions[count][0] = -px;
+				directions[count++][1] = py;
+			}
+			if (!isWalkable(current.x, current.y - py)) {
+				directions[count][0] = px;
+				directions[count++][1] = -py;
+			}
+		}
+		else {
+			// the sides of a straight move
+			const int sx = py;
+			const int sy = px;
+			directions[count][0] = px;
+			directions[count++][1] = py;
+			if (!isWalkable(current.x + sx, current.y + sy)) {
+				directions[count][0] = px + sx;
+				directions[count++][1] = py + sy;
+			}
+			if (!isWalkable(current.x - sx, current.y - sy)) {
+				directions[count][0] = px - sx;
+				directions[count++][1] = py - sy;
+			}
+		}
+
+		for (int i = 0; i < count; i++) {
+			Point pos(current.x + directions[i][0], current.y + directions[i][1]);
+			if (!jump(pos, directions[i][0], directions[i][1], NULL))
+				continue;
+
+			const float cost = actual_cost + calcDist(current, pos);
+
+			if (!astar.isOpen(pos) && !astar.isClosed(pos))
+				astar.add(pos, current, cost, calcDist(pos, end));
+			else if (cost >= astar.get(pos.x, pos.y)->getActualCost())
+				continue;
+			else if (astar.isOpen(pos))
+				astar.updateParent(pos, current, cost);
+			else {
+				// the estimate is weighted, so a jump point can be closed before its shortest path
+				// is found. It has to be scanned again, since the directions which are scanned
+				// depend on where it's reached from.
+				astar.reopen(pos, current, cost);
+			}
+		}
+	}
+
+	// the jump points are connected by straight lines, which are filled in tile by tile
+	Point pos;
+	if (reached) {
+		// store path from end to start
+		path.push_back(collision_to_map(end));
+		pos = end;
+	}
+	else {
+		// couldnt find the target so map a path to the closest tile found
+		addLine(path, closest, closest_corner);
+		addLine(path, closest_corner, closest_from);
+		pos = closest_from;
+	}
+
+	while (pos.x != start.x || pos.y != start.y) {
+		const Point parent = astar.get(pos.x, pos.y)->getParent();
+		addLine(path, pos, parent);
+		pos = parent;
+	}
+
+	return reached;
+}
+
+/**
+ * Like the A* search, the first row and column of the map are never entered
+ */
+bool JumpPointSearch::isWalkable(int x, int y) const {
+	if (x < node_stride || y < node_stride || x >= collider->map_size.x || y >= collider->map_size.y)
+		return false;
+	return collider->is_valid_tile(x, y, static_cast<MOVEMENTTYPE>(movement_type), false);
+}
+
+/**
+ * Scan from pos in the direction (dx, dy) until a tile is found where a path may have to turn.
+ * pos is moved to that tile. corner is the diagonal tile a straight scan branched off from, if any.
+ * @return false if the scan runs into a wall first
+ */
+bool JumpPointSearch::jump(Point &pos, int dx, int dy, const Point *corner) {
+	if (dx != 0 && dy != 0) {
+		while (true) {
+			if (!isWalkable(pos.x, pos.y))
+				return false;
+			if (pos.x == goal.x && pos.y == goal.y)
+				return true;
+
+			if (!explore(pos, corner))
+				return false;
+
+			if ((!isWalkable(pos.x - dx, pos.y) && isWalkable(pos.x - dx, pos.y + dy)) ||
+					(!isWalkable(pos.x, pos.y - dy) && isWalkable(pos.x + dx, pos.y - dy)))
+				return true;
+
+			// a diagonal tile is a jump point if a straight scan from it finds one
+			Point straight(pos.x + dx, pos.y);
+			if (jump(straight, dx, 0, &pos))
+				return true;
+			straight = Point(pos.x, pos.y + dy);
+			if (jump(straight, 0, dy, &pos))
+				return true;
+
+			pos.x += dx;
+			pos.y += dy;
+		}
+	}
+
+	// the tiles on both sides of a straight scan; the tiles ahead of one step are beside the next one
+	const int sx = dy;
+	const int sy = dx;
+	bool side_a = isWalkable(pos.x + sx, pos.y + sy);
+	bool side_b = isWalkable(pos.x - sx, pos.y - sy);
+
+	while (true) {
+		if (!isWalkable(pos.x, pos.y))
+			return false;
+		if (pos.x == goal.x && pos.y == goal.y)
+			return true;
+
+		if (!explore(pos, corner))
+			return false;
+
+		const bool ahead_a = isWalkable(pos.x + dx + sx, pos.y + dy + sy);
+		const bool ahead_b = isWalkable(pos.x + dx - sx, pos.y + dy - sy);
+		if ((!side_a && ahead_a) || (!side_b && ahead_b))
+			return true;
+
+		side_a = ahead_a;
+		side_b = ahead_b;
+		pos.x += dx;
+		pos.y += dy;
+	}
+}
+
+/**
+ * Count a scanned tile against the limit, and remember it if it's the closest one to the goal so far.
+ * @return false if the limit is used up and the search has to stop
+ */
+bool JumpPointSearch::explore(const Point &pos, const Point *corner) {
+	if (explored >= explore_limit)
+		return false;
+	explored++;
+
+	const int distance = (pos.x - goal.x) * (pos.x - goal.x) + (pos.y - goal.y) * (pos.y - goal.y);
+	if (distance < closest_distance) {
+		closest = pos;
+		closest_corner = corner ? *corner : pos;
+		closest_from = current;
+		closest_distance = distance;
+	}
+	return true;
+}
+
+/**
+ * Add the tiles of a straight or diagonal line to path, from the first one up to but not including to
+ */
+void JumpPointSearch::addLine(std::vector<FPoint> &path, const Point &from, const Point &to) const {
+	const int dx = signum(to.x - from.x);
+	const int dy = signum(to.y - from.y);
+
+	Point pos = from;
+	while (pos.x != to.x || pos.y != to.y) {
+		path.push_back(collision_to_map(pos));
+		pos.x += dx;
+		pos.y += dy;
+	}
+}
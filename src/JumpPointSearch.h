@@ -0,0 +1,76 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+
+/**
+ * class JumpPointSearch
+ *
+ * An alternative to the A* search of MapCollision for paths on the tile grid.
+ *
+ * Every step on the grid costs the same, so most of the paths between two
+ * tiles are equally good. Jump point search only puts the tiles where a path
+ * may have to turn into the open list, and scans along straight lines over
+ * everything in between. The result has the same form as the A* path: every
+ * tile from the end back to the start, or to the closest tile found when the
+ * end can't be reached.
+ *
+ * Enabled with jump_point_search in engine/misc.txt.
+ */
+
+#pragma once
+#ifndef JUMP_POINT_SEARCH_H
+#define JUMP_POINT_SEARCH_H
+
+#include "AStarContainer.h"
+#include "Utils.h"
+
+#include <vector>
+
+class MapCollision;
+
+class JumpPointSearch {
+public:
+	JumpPointSearch();
+	~JumpPointSearch();
+
+	/**
+	 * Search a path between two tiles, scanning at most limit tiles.
+	 * See MapCollision::find_path() for the meaning of path and the return value.
+	 */
+	bool search(const MapCollision &_collider, AStarContainer &astar, const Point &start, const Point &end, std::vector<FPoint> &path, int _movement_type, unsigned int limit);
+
+private:
+	bool isWalkable(int x, int y) const;
+	bool jump(Point &pos, int dx, int dy, const Point *corner);
+	bool explore(const Point &pos, const Point *corner);
+	void addLine(std::vector<FPoint> &path, const Point &from, const Point &to) const;
+
+	const MapCollision *collider;
+	int movement_type;
+	Point goal;
+	Point current; // the jump point being expanded
+	unsigned int explored; // scanned tiles, like the closed tiles of the A* search
+	unsigned int explore_limit;
+
+	// the explored tile which is closest to the goal, and how it was reached from a jump point
+	Point closest;
+	Point closest_corner;
+	Point closest_from;
+	int closest_distance; // squared
+};
+
+#endif
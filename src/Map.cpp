@@ -20,13 +20,16 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include "Map.h"
 
+#include "CompiledMap.h"
 #include "FileParser.h"
+#include "SharedResources.h"
 #include "UtilsParsing.h"
 #include "Settings.h"
 
 Map::Map()
 	: events()
 	, enemy_groups()
+	, regions()
 	, filename("")
 	, layers()
 	, w(0)
@@ -40,7 +43,7 @@ Map::Map()
 void Map::clearLayers() {
 
 	for (unsigned i = 0; i < layers.size(); ++i)
-		delete[] layers[i];
+		delete layers[i];
 	layers.clear();
 	layernames.clear();
 }
@@ -55,46 +58,80 @@ void Map::clearEvents() {
 }
 
 int Map::load(std::string fname) {
+	return load(fname, CompiledMap::locate(fname), mods->list(fname));
+}
+
+/**
+ * Load a map whose files were already located: compiled_path as returned by
+ * CompiledMap::locate(), and paths as returned by ModManager::list()
+ */
+int Map::load(const std::string& fname, const std::string& compiled_path, const std::vector<std::string>& paths) {
 	FileParser infile;
-	maprow *cur_layer = NULL;
+	Map_Layer *cur_layer = NULL;
 
 	clearEvents();
 	clearLayers();
 	clearQueues();
+	regions.clear();
 
 	// @CLASS Map|Description of maps/
-	if (!infile.open(fname))
+
+	// compiled maps hold the same entries, but the layers don't need parsing
+	CompiledMap compiled;
+	if (!compiled_path.empty() && compiled.open(compiled_path)) {
+		this->filename = fname;
+		infile.setSource(compiled_path);
+
+		for (unsigned i = 0; i < compiled.getEntryCount(); ++i) {
+			compiled.getEntry(i, infile);
+			const int layer = compiled.getLayerData(i);
+			if (layer < 0)
+				loadEntry(infile, &cur_layer);
+			else if (cur_layer)
+				compiled.loadLayer(layer, *cur_layer);
+		}
+		return 0;
+	}
+
+	if (!infile.open(paths, fname))
 		return 0;
 
 	this->filename = fname;
 
-	while (infile.next()) {
-		if (infile.new_section) {
+	while (infile.next())
+		loadEntry(infile, &cur_layer);
 
-			// for sections that are stored in collections, add a new object here
-			if (infile.section == "enemy")
-				enemy_groups.push(Map_Group());
-			else if (infile.section == "npc")
-				npcs.push(Map_NPC());
-			else if (infile.section == "event")
-				events.push_back(Event());
+	infile.close();
 
-		}
-		if (infile.section == "header")
-			loadHeader(infile);
-		else if (infile.section == "layer")
-			loadLayer(infile, &cur_layer);
-		else if (infile.section == "enemy")
-			loadEnemyGroup(infile, &enemy_groups.back());
+	return 0;
+}
+
+void Map::loadEntry(FileParser &infile, Map_Layer **cur_layer) {
+	if (infile.new_section) {
+
+		// for sections that are stored in collections, add a new object here
+		if (infile.section == "enemy")
+			enemy_groups.push(Map_Group());
 		else if (infile.section == "npc")
-			loadNPC(infile);
+			npcs.push(Map_NPC());
 		else if (infile.section == "event")
-			EventManager::loadEvent(infile, &events.back());
-	}
+			events.push_back(Event());
+		else if (infile.section == "region")
+			regions.push_back(Map_Region());
 
-	infile.close();
-
-	return 0;
+	}
+	if (infile.section == "header")
+		loadHeader(infile);
+	else if (infile.section == "layer")
+		loadLayer(infile, cur_layer);
+	else if (infile.section == "enemy")
+		loadEnemyGroup(infile, &enemy_groups.back());
+	else if (infile.section == "npc")
+		loadNPC(infile);
+	else if (infile.section == "event")
+		EventManager::loadEvent(infile, &events.back());
+	else if (infile.section == "region")
+		loadRegion(infile);
 }
 
 void Map::loadHeader(FileParser &infile) {
@@ -126,10 +163,10 @@ void Map::loadHeader(FileParser &infile) {
 	}
 }
 
-void Map::loadLayer(FileParser &infile, maprow **current_layer) {
+void Map::loadLayer(FileParser &infile, Map_Layer **current_layer) {
 	if (infile.key == "type") {
 		// @ATTR layer.type|string|Map layer type.
-		*current_layer = new maprow[w];
+		*current_layer = new Map_Layer(w, h);
 		layers.push_back(*current_layer);
 		layernames.push_back(infile.val);
 	}
@@ -144,12 +181,20 @@ void Map::loadLayer(FileParser &infile, maprow **current_layer) {
 	else if (infile.key == "data") {
 		// @ATTR layer.data|raw|Raw map layer data
 		// layer map data handled as a special case
-		// The next h lines must contain layer data.  TODO: err
-		for (int j=0; j<h; j++) {
-			std::string val = infile.getRawLine() + ',';
-			for (int i=0; i<w; i++)
-				(*current_layer)[i][j] = popFirstInt(val, ',');
-		}
+		readLayerData(infile, **current_layer);
+	}
+}
+
+/**
+ * Read the rows of a layer following its "data=" line
+ */
+void Map::readLayerData(FileParser &infile, Map_Layer &layer) {
+	// The next h lines must contain layer data.  TODO: err
+	for (int j=0; j<layer.getHeight(); j++) {
+		const FileParserView row = infile.getRawLineView();
+		const char *cursor = row.data;
+		for (int i=0; i<layer.getWidth(); i++)
+			layer.set(i, j, static_cast<unsigned short>(popFirstInt(cursor, row.data + row.length, ',')));
 	}
 }
 
@@ -244,4 +289,16 @@ void Map::loadNPC(FileParser &infile) {
 	}
 }
 
-
+void Map::loadRegion(FileParser &infile) {
+	if (infile.key == "file") {
+		// @ATTR region.file|string|Map file holding the layers, enemies, NPCs and events of this region. Layers are relative to the region, everything else uses map coordinates.
+		regions.back().file = infile.val;
+	}
+	else if (infile.key == "location") {
+		// @ATTR region.location|[x(integer), y(integer), w(integer), h(integer)]|Area of the map covered by the region
+		regions.back().area.x = toInt(infile.nextValue());
+		regions.back().area.y = toInt(infile.nextValue());
+		regions.back().area.w = toInt(infile.nextValue());
+		regions.back().area.h = toInt(infile.nextValue());
+	}
+}
@@ -23,12 +23,14 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include <vector>
 #include <queue>
 
+#include "ChunkedGrid.h"
 #include "FileParser.h"
 #include "Utils.h"
 #include "StatBlock.h"
 #include "EventManager.h"
 
-typedef unsigned short maprow[256];
+// tile ids of one map layer, indexed by map position. 0 is an empty tile.
+typedef ChunkedGrid<unsigned short> Map_Layer;
 
 class Map_Group {
 public:
@@ -105,12 +107,29 @@ public:
 	}
 };
 
+/**
+ * A part of the map which is stored in its own file and streamed in by the
+ * MapRenderer when the camera comes close. area is in tiles.
+ */
+class Map_Region {
+public:
+	std::string file;
+	Rect area;
+
+	Map_Region()
+		: file("")
+		, area() {
+	}
+};
+
 class Map {
 protected:
+	void loadEntry(FileParser &infile, Map_Layer **cur_layer);
 	void loadHeader(FileParser &infile);
-	void loadLayer(FileParser &infile, maprow **cur_layer);
+	void loadLayer(FileParser &infile, Map_Layer **cur_layer);
 	void loadEnemyGroup(FileParser &infile, Map_Group *group);
 	void loadNPC(FileParser &infile);
+	void loadRegion(FileParser &infile);
 
 	void clearLayers();
 	void clearQueues();
@@ -118,17 +137,21 @@ protected:
 	// map events
 	std::vector<Event> events;
 	std::queue<Map_Group> enemy_groups;
+	std::vector<Map_Region> regions;
 
 	std::string filename;
 	std::string tileset;
 
 	int load(std::string filename);
+	int load(const std::string& filename, const std::string& compiled_path, const std::vector<std::string>& paths);
 public:
 	Map();
 
+	static void readLayerData(FileParser &infile, Map_Layer &layer);
+
 	std::string music_filename;
 
-	std::vector<maprow*> layers; // visible layers in maprenderer
+	std::vector<Map_Layer*> layers; // visible layers in maprenderer
 	std::vector<std::string> layernames;
 
 	void clearEvents();
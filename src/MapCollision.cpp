@@ -23,10 +23,8 @@ FLARE.  If not, see http://www.gnu.org/licenses/
  * Handle collisions between objects and the map
  */
 
-#include "AStarNode.h"
 #include "MapCollision.h"
 #include "Settings.h"
-#include "AStarContainer.h"
 #include <cfloat>
 #include <math.h>
 #include <cassert>
@@ -35,17 +33,53 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 using namespace std;
 
 MapCollision::MapCollision()
-	: map_size(Point()) {
-	memset(colmap, 0, sizeof(colmap));
+	: path_clusters_normal(MOVEMENT_NORMAL)
+	, path_clusters_flying(MOVEMENT_FLYING)
+	, flow_field_normal(MOVEMENT_NORMAL)
+	, flow_field_flying(MOVEMENT_FLYING)
+	, colmap(BLOCKS_NONE)
+	, map_size(Point())
+	, terrain_revision(0) {
 }
 
-void MapCollision::setmap(const unsigned short _colmap[][256], unsigned short w, unsigned short h) {
-	for (int i=0; i<w; i++)
-		for (int j=0; j<h; j++)
-			colmap[i][j] = _colmap[i][j];
+void MapCollision::setmap(const ChunkedGrid<unsigned short>& _colmap) {
+	colmap = _colmap;
 
-	map_size.x = w;
-	map_size.y = h;
+	map_size.x = colmap.getWidth();
+	map_size.y = colmap.getHeight();
+
+	// the cluster graphs are only built by the first long path search that needs them,
+	// so loading a map doesn't wait for them
+	path_clusters_normal.setmap(map_size.x, map_size.y);
+	path_clusters_flying.setmap(map_size.x, map_size.y);
+	flow_field_normal.setmap(map_size.x, map_size.y);
+	flow_field_flying.setmap(map_size.x, map_size.y);
+	terrain_revision++;
+}
+
+/**
+ * The collision tiles inside this area were changed
+ */
+void MapCollision::invalidate_area(int x, int y, int w, int h) {
+	path_clusters_normal.invalidate(x, y, w, h);
+	path_clusters_flying.invalidate(x, y, w, h);
+	flow_field_normal.invalidate(x, y, w, h);
+	flow_field_flying.invalidate(x, y, w, h);
+	terrain_revision++;
+}
+
+PathClusters *MapCollision::get_path_clusters(MOVEMENTTYPE movement_type) {
+	if (movement_type == MOVEMENT_NORMAL) return &path_clusters_normal;
+	if (movement_type == MOVEMENT_FLYING) return &path_clusters_flying;
+
+	// intangible creatures go straight through everything anyway
+	return NULL;
+}
+
+FlowField *MapCollision::get_flow_field(MOVEMENTTYPE movement_type) {
+	if (movement_type == MOVEMENT_NORMAL) return &flow_field_normal;
+	if (movement_type == MOVEMENT_FLYING) return &flow_field_flying;
+	return NULL;
 }
 
 int sgn(float f) {
@@ -204,7 +238,8 @@ bool MapCollision::is_empty(const float& x, const float& y) const {
 	if (is_outside_map(tile_x, tile_y)) return false;
 
 	// collision type check
-	return (colmap[tile_x][tile_y] == BLOCKS_NONE || colmap[tile_x][tile_y] == MAP_ONLY || colmap[tile_x][tile_y] == MAP_ONLY_ALT);
+	const unsigned short tile = colmap.get(tile_x, tile_y);
+	return (tile == BLOCKS_NONE || tile == MAP_ONLY || tile == MAP_ONLY_ALT);
 }
 
 /**
@@ -219,38 +254,62 @@ bool MapCollision::is_wall(const float& x, const float& y) const {
 	if (is_outside_map(tile_x, tile_y)) return true;
 
 	// collision type check
-	return (colmap[tile_x][tile_y] == BLOCKS_ALL || colmap[tile_x][tile_y] == BLOCKS_ALL_HIDDEN);
+	const unsigned short tile = colmap.get(tile_x, tile_y);
+	return (tile == BLOCKS_ALL || tile == BLOCKS_ALL_HIDDEN);
 }
 
 /**
  * Is this a valid tile for an entity with this movement type?
  */
+static bool is_terrain_valid(unsigned short tile, MOVEMENTTYPE movement_type) {
+
+	// intangible creatures can be everywhere
+	if (movement_type == MOVEMENT_INTANGIBLE) return true;
+
+	// flying creatures can't be in walls
+	if (movement_type == MOVEMENT_FLYING) {
+		return (!(tile == BLOCKS_ALL || tile == BLOCKS_ALL_HIDDEN));
+	}
+
+	if (tile == MAP_ONLY || tile == MAP_ONLY_ALT)
+		return true;
+
+	// normal creatures can only be in empty spaces
+	return (tile == BLOCKS_NONE);
+}
+
 bool MapCollision::is_valid_tile(const int& tile_x, const int& tile_y, MOVEMENTTYPE movement_type, bool is_hero) const {
 
 	// outside the map isn't valid
 	if (is_outside_map(tile_x,tile_y)) return false;
 
+	const unsigned short tile = colmap.get(tile_x, tile_y);
+
 	if(is_hero) {
-		if(colmap[tile_x][tile_y] == BLOCKS_ENEMIES && !ENABLE_ALLY_COLLISION) return true;
+		if(tile == BLOCKS_ENEMIES && !ENABLE_ALLY_COLLISION) return true;
 	}
-	else if(colmap[tile_x][tile_y] == BLOCKS_ENEMIES) return false;
+	else if(tile == BLOCKS_ENEMIES) return false;
 
 	// occupied by an entity isn't valid
-	if (colmap[tile_x][tile_y] == BLOCKS_ENTITIES) return false;
+	if (tile == BLOCKS_ENTITIES) return false;
 
-	// intangible creatures can be everywhere
-	if (movement_type == MOVEMENT_INTANGIBLE) return true;
+	return is_terrain_valid(tile, movement_type);
+}
 
-	// flying creatures can't be in walls
-	if (movement_type == MOVEMENT_FLYING) {
-		return (!(colmap[tile_x][tile_y] == BLOCKS_ALL || colmap[tile_x][tile_y] == BLOCKS_ALL_HIDDEN));
-	}
+/**
+ * Like is_valid_tile(), but entities don't count; only the map itself is checked
+ */
+bool MapCollision::is_open_terrain(const int& tile_x, const int& tile_y, MOVEMENTTYPE movement_type) const {
 
-	if (colmap[tile_x][tile_y] == MAP_ONLY || colmap[tile_x][tile_y] == MAP_ONLY_ALT)
-		return true;
+	// outside the map isn't valid
+	if (is_outside_map(tile_x,tile_y)) return false;
 
-	// normal creatures can only be in empty spaces
-	return (colmap[tile_x][tile_y] == BLOCKS_NONE);
+	const unsigned short tile = colmap.get(tile_x, tile_y);
+
+	// entities only block tiles which are empty otherwise
+	if (tile == BLOCKS_ENTITIES || tile == BLOCKS_ENEMIES) return true;
+
+	return is_terrain_valid(tile, movement_type);
 }
 
 /**
@@ -322,8 +381,8 @@ bool MapCollision::line_of_movement(const float& x1, const float& y1, const floa
 	int tile_x = int(x2);
 	int tile_y = int(y2);
 	bool target_blocks = false;
-	int target_blocks_type = colmap[tile_x][tile_y];
-	if (colmap[tile_x][tile_y] == BLOCKS_ENTITIES || colmap[tile_x][tile_y] == BLOCKS_ENEMIES) {
+	int target_blocks_type = colmap.get(tile_x, tile_y);
+	if (colmap.get(tile_x, tile_y) == BLOCKS_ENTITIES || colmap.get(tile_x, tile_y) == BLOCKS_ENEMIES) {
 		target_blocks = true;
 		unblock(x2,y2);
 	}
@@ -363,19 +422,33 @@ bool MapCollision::is_facing(const float& x1, const float& y1, char direction, c
 	return false;
 }
 
+/**
+ * The neighbours of a tile, diagonals first
+ */
+static const int NEIGHBOUR_OFFSETS[8][2] = {
+	{-node_stride, -node_stride},
+	{-node_stride, node_stride},
+	{node_stride, -node_stride},
+	{node_stride, node_stride},
+	{-node_stride, 0},
+	{0, -node_stride},
+	{node_stride, 0},
+	{0, node_stride}
+};
+
+// the number of tiles of a long path which are filled in, see compute_path()
 /**
 * Compute a path from (x1,y1) to (x2,y2)
 * Store waypoint inside path
 * limit is the maximum number of explored node
+* When no limit is given, paths leading out of the current cluster are found
+* through the cluster graph, so they aren't cut short by the limit.
 * @return true if a path is found
 */
 bool MapCollision::compute_path(FPoint start_pos, FPoint end_pos, vector<FPoint> &path, MOVEMENTTYPE movement_type, unsigned int limit) {
 
 	if (is_outside_map(end_pos.x, end_pos.y)) return false;
 
-	if (limit == 0)
-		limit = 256;
-
 	// path must be empty
 	if (!path.empty())
 		path.clear();
@@ -386,78 +459,129 @@ bool MapCollision::compute_path(FPoint start_pos, FPoint end_pos, vector<FPoint>
 
 	// if the target square has an entity, temporarily clear it to compute the path
 	bool target_blocks = false;
-	int target_blocks_type = colmap[end.x][end.y];
-	if (colmap[end.x][end.y] == BLOCKS_ENTITIES || colmap[end.x][end.y] == BLOCKS_ENEMIES) {
+	int target_blocks_type = colmap.get(end.x, end.y);
+	if (colmap.get(end.x, end.y) == BLOCKS_ENTITIES || colmap.get(end.x, end.y) == BLOCKS_ENEMIES) {
 		target_blocks = true;
 		unblock(end_pos.x, end_pos.y);
 	}
 
-	Point current = start;
-	AStarNode* node = new AStarNode(start);
-	node->setActualCost(0);
-	node->setEstimatedCost((float)calcDist(start,end));
-	node->setParent(current);
+	PathClusters *clusters = get_path_clusters(movement_type);
+
+	if (limit == 0 && clusters && !clusters->isSameCluster(start, end) && clusters->search(*this, start, end, path_waypoints)) {
+		// fill in the path between the portals, one cluster at a time
+		path_forward.clear();
+		FPoint last = collision_to_map(start);
+		Point from = start;
+
+		for (unsigned i = 0; i < path_waypoints.size(); i++) {
+			const Point &to = path_waypoints[i];
+			path_segment.clear();
+
+			// crossing a border is a single step
+			bool reached;
+			if (abs(to.x - from.x) <= 1 && abs(to.y - from.y) <= 1 && is_valid_tile(to.x, to.y, movement_type, false)) {
+				path_segment.push_back(collision_to_map(to));
+				reached = true;
+			}
+			else {
+				reached = find_path(from, to, path_segment, movement_type, PathClusters::CLUSTER_SIZE * PathClusters::CLUSTER_SIZE);
+			}
+
+			// segments are stored from end to start
+			for (unsigned j = path_segment.size(); j > 0; j--) {
+				if (path_segment[j-1].x != last.x || path_segment[j-1].y != last.y) {
+					last = path_segment[j-1];
+					path_forward.push_back(last);
+				}
+			}
 
-	AStarContainer open(map_size.x, limit);
-	AStarCloseContainer close(map_size.x, limit);
+			// blocked by an entity, so go as far as possible for now
+			if (!reached)
+				break;
+
+			from = to;
+		}
+
+		path.assign(path_forward.rbegin(), path_forward.rend());
+	}
+	else {
+		find_path(start, end, path, movement_type, (limit == 0) ? 256 : limit);
+	}
+
+	// reblock target if needed
+	if (target_blocks) block(end_pos.x, end_pos.y, target_blocks_type == BLOCKS_ENEMIES);
+
+	return !path.empty();
+}
+
+/**
+ * A* search between two tiles, exploring at most limit tiles.
+ * The waypoints are added to path from end to start. If end can't be reached,
+ * the path leads to the closest explored tile instead.
+ * @return true if end was reached
+ */
+bool MapCollision::find_path(const Point &start, const Point &end, vector<FPoint> &path, MOVEMENTTYPE movement_type, unsigned int limit) {
+	if (JUMP_POINT_SEARCH)
+		return jump_point_search.search(*this, astar, start, end, path, movement_type, limit);
+
+	Point current = start;
+	AStarNode* node = NULL;
 
-	open.add(node);
+	astar.reset(map_size.x, map_size.y, limit);
+	astar.add(start, current, 0, (float)calcDist(start,end));
 
-	while (!open.isEmpty() && (unsigned)close.getSize() < limit) {
-		node = open.get_shortest_f();
+	while (!astar.isEmpty() && astar.getClosedSize() < limit) {
+		node = astar.close_shortest_f();
 
 		current.x = node->getX();
 		current.y = node->getY();
-		close.add(node);
-		open.remove(node);
 
 		if ( current.x == end.x && current.y == end.y)
 			break; //path found !
 
-		//limit evaluated nodes to the size of the map
-		list<Point> neighbours = node->getNeighbours(map_size.x, map_size.y);
+		const float actual_cost = node->getActualCost();
 
 		// for every neighbour of current node
-		for (list<Point>::iterator it=neighbours.begin(); it != neighbours.end(); ++it)	{
-			Point neighbour = *it;
+		for (int i = 0; i < 8; i++) {
+			Point neighbour(current.x + NEIGHBOUR_OFFSETS[i][0], current.y + NEIGHBOUR_OFFSETS[i][1]);
+
+			//limit evaluated nodes to the size of the map
+			if ((neighbour.x != current.x && (neighbour.x < node_stride || neighbour.x >= map_size.x)) ||
+					(neighbour.y != current.y && (neighbour.y < node_stride || neighbour.y >= map_size.y)))
+				continue;
 
 			// if neighbour is not free of any collision, skip it
 			if (!is_valid_tile(neighbour.x,neighbour.y,movement_type, false))
 				continue;
 			// if nabour is already in close, skip it
-			if(close.exists(neighbour))
+			if(astar.isClosed(neighbour))
 				continue;
 
+			const float cost = actual_cost+(float)calcDist(current,neighbour);
+
 			// if neighbour isn't inside open, add it as a new Node
-			if(!open.exists(neighbour)) {
-				AStarNode* newNode = new AStarNode(neighbour.x,neighbour.y);
-				newNode->setActualCost(node->getActualCost()+(float)calcDist(current,neighbour));
-				newNode->setParent(current);
-				newNode->setEstimatedCost((float)calcDist(neighbour,end));
-				open.add(newNode);
+			if(!astar.isOpen(neighbour)) {
+				astar.add(neighbour, current, cost, (float)calcDist(neighbour,end));
 			}
 			// else, update it's cost if better
-			else {
-				AStarNode* i = open.get(neighbour.x, neighbour.y);
-				if (node->getActualCost()+(float)calcDist(current,neighbour) < i->getActualCost()) {
-					Point pos(i->getX(), i->getY());
-					Point parent_pos(node->getX(), node->getY());
-					open.updateParent(pos, parent_pos, node->getActualCost()+(float)calcDist(current,neighbour));
-				}
+			else if (cost < astar.get(neighbour.x, neighbour.y)->getActualCost()) {
+				astar.updateParent(neighbour, current, cost);
 			}
 		}
 	}
 
-	if (current.x != end.x || current.y != end.y) {
+	const bool reached = (current.x == end.x && current.y == end.y);
+
+	if (!reached) {
 
 		//couldnt find the target so map a path to the closest node found
-		node = close.get_shortest_h();
+		node = astar.get_shortest_h();
 		current.x = node->getX();
 		current.y = node->getY();
 
 		while (current.x != start.x || current.y != start.y) {
 			path.push_back(collision_to_map(current));
-			current = close.get(current.x, current.y)->getParent();
+			current = astar.get(current.x, current.y)->getParent();
 		}
 	}
 	else {
@@ -465,13 +589,41 @@ bool MapCollision::compute_path(FPoint start_pos, FPoint end_pos, vector<FPoint>
 		path.push_back(collision_to_map(end));
 		while (current.x != start.x || current.y != start.y) {
 			path.push_back(collision_to_map(current));
-			current = close.get(current.x, current.y)->getParent();
+			current = astar.get(current.x, current.y)->getParent();
 		}
 	}
-	// reblock target if needed
-	if (target_blocks) block(end_pos.x, end_pos.y, target_blocks_type == BLOCKS_ENEMIES);
 
-	return !path.empty();
+	return reached;
+}
+
+/**
+ * Move the target of the flow fields, usually to the hero once per frame.
+ * The fields are only computed again when the target enters another tile,
+ * and only for the movement types somebody asks for.
+ */
+void MapCollision::set_flow_target(const FPoint& target) {
+	const Point tile = map_to_collision(target);
+	flow_field_normal.setTarget(tile);
+	flow_field_flying.setTarget(tile);
+}
+
+/**
+ * The center of the next tile on the way from pos to the flow target.
+ * Unlike compute_path(), this doesn't search, so any number of entities can follow the same target.
+ * @return false if pos is too far from the target or can't reach it; compute_path() has to be used instead
+ */
+bool MapCollision::get_flow_step(const FPoint& pos, FPoint& next, MOVEMENTTYPE movement_type) {
+	FlowField *field = get_flow_field(movement_type);
+	if (!field) return false;
+
+	field->update(*this);
+
+	Point next_tile;
+	if (!field->getStep(map_to_collision(pos), next_tile))
+		return false;
+
+	next = collision_to_map(next_tile);
+	return true;
 }
 
 void MapCollision::block(const float& map_x, const float& map_y, bool is_ally) {
@@ -479,11 +631,11 @@ void MapCollision::block(const float& map_x, const float& map_y, bool is_ally) {
 	const int tile_x = int(map_x);
 	const int tile_y = int(map_y);
 
-	if (colmap[tile_x][tile_y] == BLOCKS_NONE) {
+	if (colmap.get(tile_x, tile_y) == BLOCKS_NONE) {
 		if(is_ally)
-			colmap[tile_x][tile_y] = BLOCKS_ENEMIES;
+			colmap.set(tile_x, tile_y, BLOCKS_ENEMIES);
 		else
-			colmap[tile_x][tile_y] = BLOCKS_ENTITIES;
+			colmap.set(tile_x, tile_y, BLOCKS_ENTITIES);
 	}
 
 }
@@ -493,8 +645,8 @@ void MapCollision::unblock(const float& map_x, const float& map_y) {
 	const int tile_x = int(map_x);
 	const int tile_y = int(map_y);
 
-	if (colmap[tile_x][tile_y] == BLOCKS_ENTITIES || colmap[tile_x][tile_y] == BLOCKS_ENEMIES) {
-		colmap[tile_x][tile_y] = BLOCKS_NONE;
+	if (colmap.get(tile_x, tile_y) == BLOCKS_ENTITIES || colmap.get(tile_x, tile_y) == BLOCKS_ENEMIES) {
+		colmap.set(tile_x, tile_y, BLOCKS_NONE);
 	}
 
 }
@@ -26,7 +26,12 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #ifndef MAP_COLLISION_H
 #define MAP_COLLISION_H
 
+#include "AStarContainer.h"
+#include "ChunkedGrid.h"
 #include "CommonIncludes.h"
+#include "FlowField.h"
+#include "JumpPointSearch.h"
+#include "PathClusters.h"
 #include "Utils.h"
 
 #include <cstdlib>
@@ -73,11 +78,29 @@ private:
 
 	bool is_valid_tile(const int& x, const int& y, MOVEMENTTYPE movement_type, bool is_hero) const;
 
+	bool find_path(const Point& start, const Point& end, std::vector<FPoint> &path, MOVEMENTTYPE movement_type, unsigned int limit);
+	PathClusters *get_path_clusters(MOVEMENTTYPE movement_type);
+	FlowField *get_flow_field(MOVEMENTTYPE movement_type);
+
+	// reused by every compute_path() call
+	AStarContainer astar;
+	JumpPointSearch jump_point_search;
+	PathClusters path_clusters_normal;
+	PathClusters path_clusters_flying;
+	FlowField flow_field_normal;
+	FlowField flow_field_flying;
+	std::vector<Point> path_waypoints;
+	std::vector<FPoint> path_segment;
+	std::vector<FPoint> path_forward;
+
+	friend class JumpPointSearch;
+
 public:
 	MapCollision();
 	~MapCollision();
 
-	void setmap(const unsigned short _colmap[][256], unsigned short w, unsigned short h);
+	void setmap(const ChunkedGrid<unsigned short>& _colmap);
+	void invalidate_area(int x, int y, int w, int h);
 	bool move(float &x, float &y, float step_x, float step_y, MOVEMENTTYPE movement_type, bool is_hero);
 
 	bool is_outside_map(const int& tile_x, const int& tile_y) const;
@@ -86,19 +109,29 @@ public:
 	bool is_wall(const float& x, const float& y) const;
 
 	bool is_valid_position(const float& x, const float& y, MOVEMENTTYPE movement_type, bool is_hero) const;
+	bool is_open_terrain(const int& x, const int& y, MOVEMENTTYPE movement_type) const;
 
 	bool line_of_sight(const float& x1, const float& y1, const float& x2, const float& y2);
 	bool line_of_movement(const float& x1, const float& y1, const float& x2, const float& y2, MOVEMENTTYPE movement_type);
 
 	bool is_facing(const float& x1, const float& y1, char direction, const float& x2, const float& y2);
 
+	// The path leads from tile to tile, from end to start. With a limit of 0,
+	// paths between clusters are searched on the cluster graph and aren't cut
+	// short; other searches give up after exploring limit tiles (256 for 0).
 	bool compute_path(FPoint start, FPoint end, std::vector<FPoint> &path, MOVEMENTTYPE movement_type, unsigned int limit = 0);
 
+	void set_flow_target(const FPoint& target);
+	bool get_flow_step(const FPoint& pos, FPoint& next, MOVEMENTTYPE movement_type);
+
 	void block(const float& map_x, const float& map_y, bool is_ally);
 	void unblock(const float& map_x, const float& map_y);
 
-	unsigned short colmap[256][256];
+	ChunkedGrid<unsigned short> colmap;
 	Point map_size;
+
+	// counts the changes of the terrain by setmap() and invalidate_area()
+	unsigned int terrain_revision;
 };
 
 #endif
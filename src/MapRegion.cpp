@@ -0,0 +1,204 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+
+#include <stdio.h>
+
+#include "CompiledMap.h"
+#include "MapRegion.h"
+#include "SharedResources.h"
+
+MapRegion::MapRegion(const Map_Region &info)
+	: Map()
+	, file(info.file)
+	, area(info.area)
+	, state(UNLOADED)
+	, visited(false)
+	, modified(false) {
+}
+
+MapRegion::~MapRegion() {
+	release();
+}
+
+/**
+ * Find the files of the region in the mods. This runs on the main thread,
+ * before the region is handed to the loader.
+ */
+void MapRegion::locate() {
+	compiled_path = CompiledMap::locate(file);
+	paths = mods->list(file);
+}
+
+/**
+ * Read the region files found by locate(). This runs on the loader thread,
+ * so it must not touch anything but the region itself and the files.
+ */
+void MapRegion::parse() {
+	// the layers are the size of the region, unless its header says otherwise
+	w = static_cast<short>(area.w);
+	h = static_cast<short>(area.h);
+
+	Map::load(file, compiled_path, paths);
+
+	// regions can't be nested
+	regions.clear();
+}
+
+/**
+ * Free everything that was parsed
+ */
+void MapRegion::release() {
+	clearLayers();
+	clearEvents();
+	clearQueues();
+	enemy_groups = std::queue<Map_Group>();
+}
+
+MapRegionLoader::MapRegionLoader()
+	: thread(NULL)
+	, mutex(SDL_CreateMutex())
+	, work_ready(SDL_CreateCond())
+	, work_done(SDL_CreateCond())
+	, current(NULL)
+	, quit(false) {
+}
+
+MapRegionLoader::~MapRegionLoader() {
+	if (thread) {
+		SDL_LockMutex(mutex);
+		quit = true;
+		pending.clear();
+		SDL_CondSignal(work_ready);
+		SDL_UnlockMutex(mutex);
+		SDL_WaitThread(thread, NULL);
+	}
+
+	if (work_done) SDL_DestroyCond(work_done);
+	if (work_ready) SDL_DestroyCond(work_ready);
+	if (mutex) SDL_DestroyMutex(mutex);
+}
+
+/**
+ * Parse a region in the background. The thread is only started for the
+ * first region, so maps without regions don't need it.
+ * Without threads, the region is parsed right away.
+ */
+void MapRegionLoader::queue(MapRegion *region) {
+	region->locate();
+
+	if (!thread && mutex && work_ready && work_done) {
+#if SDL_VERSION_ATLEAST(2,0,0)
+		thread = SDL_CreateThread(threadMain, "MapRegionLoader", this);
+#else
+		thread = SDL_CreateThread(threadMain, this);
+#endif
+		if (!thread)
+			fprintf(stderr, "Could not create map region loader thread: %s\n", SDL_GetError());
+	}
+
+	if (!thread) {
+		region->parse();
+		finished.push_back(region);
+		return;
+	}
+
+	SDL_LockMutex(mutex);
+	pending.push_back(region);
+	SDL_CondSignal(work_ready);
+	SDL_UnlockMutex(mutex);
+}
+
+/**
+ * Finish parsing a queued region, because it's needed right now.
+ * If the loader hasn't started on it yet, it is parsed on the calling thread.
+ */
+void MapRegionLoader::wait(MapRegion *region) {
+	if (thread) {
+		SDL_LockMutex(mutex);
+		std::deque<MapRegion*>::iterator it = std::find(pending.begin(), pending.end(), region);
+		if (it != pending.end()) {
+			pending.erase(it);
+			SDL_UnlockMutex(mutex);
+			region->parse();
+			return;
+		}
+		while (current == region)
+			SDL_CondWait(work_done, mutex);
+	}
+
+	std::vector<MapRegion*>::iterator it = std::find(finished.begin(), finished.end(), region);
+	if (it != finished.end())
+		finished.erase(it);
+
+	if (thread)
+		SDL_UnlockMutex(mutex);
+}
+
+/**
+ * Hand the regions which were parsed since the last call back to the caller
+ */
+void MapRegionLoader::collect(std::vector<MapRegion*> &parsed) {
+	if (thread) SDL_LockMutex(mutex);
+	parsed.insert(parsed.end(), finished.begin(), finished.end());
+	finished.clear();
+	if (thread) SDL_UnlockMutex(mutex);
+}
+
+/**
+ * Forget all queued regions, e.g. before the map is unloaded.
+ * Waits for the region which is being parsed right now.
+ */
+void MapRegionLoader::cancel() {
+	if (thread) {
+		SDL_LockMutex(mutex);
+		pending.clear();
+		while (current)
+			SDL_CondWait(work_done, mutex);
+	}
+
+	finished.clear();
+
+	if (thread)
+		SDL_UnlockMutex(mutex);
+}
+
+int MapRegionLoader::threadMain(void *arg) {
+	MapRegionLoader *loader = static_cast<MapRegionLoader*>(arg);
+
+	SDL_LockMutex(loader->mutex);
+	while (!loader->quit) {
+		if (loader->pending.empty()) {
+			SDL_CondWait(loader->work_ready, loader->mutex);
+			continue;
+		}
+
+		loader->current = loader->pending.front();
+		loader->pending.pop_front();
+		SDL_UnlockMutex(loader->mutex);
+
+		loader->current->parse();
+
+		SDL_LockMutex(loader->mutex);
+		loader->finished.push_back(loader->current);
+		loader->current = NULL;
+		SDL_CondBroadcast(loader->work_done);
+	}
+	SDL_UnlockMutex(loader->mutex);
+
+	return 0;
+}
@@ -0,0 +1,102 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+
+/**
+ * class MapRegion
+ *
+ * The contents of one region file of a streamed map. A region is a map file
+ * of its own: its layers cover only the region, while enemies, NPCs and
+ * events use the coordinates of the whole map.
+ *
+ * class MapRegionLoader
+ *
+ * A background thread which parses the queued regions one after another.
+ * A queued region belongs to the loader until collect() or wait() hand it
+ * back, so the main thread must not touch it in between. The region files are
+ * located before they are queued, so the loader doesn't search the mods.
+ */
+
+#pragma once
+#ifndef MAP_REGION_H
+#define MAP_REGION_H
+
+#include "CommonIncludes.h"
+#include "Map.h"
+
+class MapRegion : public Map {
+public:
+	enum State {
+		UNLOADED = 0, // nothing is parsed
+		QUEUED = 1,   // waiting for or being parsed by the loader
+		PARSED = 2,   // ready to be merged into the map
+		ACTIVE = 3    // merged into the map
+	};
+
+	MapRegion(const Map_Region &info);
+	~MapRegion();
+
+	void locate();
+	void parse();
+	void release();
+
+	std::string file;
+
+	// the files to parse, located on the main thread
+	std::string compiled_path;
+	std::vector<std::string> paths;
+
+	Rect area;
+	State state;
+
+	// enemies, NPCs and events are only added when the region is merged for the first time
+	bool visited;
+
+	// events changed tiles of the active region, so the tiles have to be
+	// kept when it's unloaded instead of parsing the file again
+	bool modified;
+
+	friend class MapRenderer;
+};
+
+class MapRegionLoader {
+public:
+	MapRegionLoader();
+	~MapRegionLoader();
+
+	void queue(MapRegion *region);
+	void wait(MapRegion *region);
+	void collect(std::vector<MapRegion*> &parsed);
+	void cancel();
+
+private:
+	MapRegionLoader(const MapRegionLoader &copy); // not implemented
+
+	static int threadMain(void *arg);
+
+	SDL_Thread *thread;
+	SDL_mutex *mutex;
+	SDL_cond *work_ready;
+	SDL_cond *work_done;
+
+	std::deque<MapRegion*> pending;
+	std::vector<MapRegion*> finished;
+	MapRegion *current;
+	bool quit;
+};
+
+#endif
@@ -23,6 +23,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "EnemyGroupManager.h"
 #include "FileParser.h"
 #include "MapRenderer.h"
+#include "NPC.h"
 #include "PowerManager.h"
 #include "SharedGameResources.h"
 #include "SharedResources.h"
@@ -45,6 +46,20 @@ MapRenderer::MapRenderer()
 	, tip_pos()
 	, show_tooltip(false)
 	, shakycam()
+	, shakycam_offset()
+	, background(NULL)
+	, background_scroll(NULL)
+	, background_area()
+	, background_valid(false)
+	, background_dirty()
+	, view_area()
+	, chunk_size(0)
+	, chunk_limit(0)
+	, chunk_count(0)
+	, chunk_frame(0)
+	, map_regions()
+	, region_loader()
+	, loading_collision(NULL)
 	, cam()
 	, map_change(false)
 	, teleportation(false)
@@ -148,7 +163,40 @@ void MapRenderer::clearLayers() {
 	index_objectlayer = 0;
 }
 
+/**
+ * Decode the tileset and the graphics and sounds of the map's enemies and
+ * NPCs at the same time. The loads that follow pick them up, see AssetLoader.
+ */
+void MapRenderer::preloadAssets() {
+	if (!assets)
+		return;
+
+	assets->addJob(TileSet::preload, tileset);
+
+	std::queue<Map_Enemy> queued_enemies = enemies;
+	for (; !queued_enemies.empty(); queued_enemies.pop())
+		assets->addJob(StatBlock::preload, queued_enemies.front().type);
+
+	std::queue<Map_NPC> queued_npcs = npcs;
+	for (; !queued_npcs.empty(); queued_npcs.pop())
+		assets->addJob(NPC::preload, queued_npcs.front().id);
+
+	assets->run();
+}
+
 int MapRenderer::load(std::string fname) {
+	loadMapFile(fname);
+	loadAssets();
+	loadTileset();
+	loadCollision();
+	loadChunks();
+	return 0;
+}
+
+/**
+ * Parse the map file. The collision layer is set aside for loadCollision().
+ */
+void MapRenderer::loadMapFile(const std::string& fname) {
 	/* unload sounds */
 	snd->reset();
 	while (!sids.empty()) {
@@ -157,40 +205,65 @@ int MapRenderer::load(std::string fname) {
 	}
 
 	show_tooltip = false;
+	clearChunks();
+	clearRegions();
 
 	Map::load(fname);
 
-	loadMusic();
-
+	delete loading_collision;
+	loading_collision = NULL;
 	for (unsigned i = 0; i < layers.size(); ++i) {
 		if (layernames[i] == "collision") {
-			collider.setmap(layers[i], w, h);
+			delete loading_collision;
+			loading_collision = layers[i];
 			layernames.erase(layernames.begin() + i);
-			delete[] layers[i];
 			layers.erase(layers.begin() + i);
 		}
 	}
+
+	for (unsigned i = 0; i < regions.size(); ++i) {
+		if (regions[i].file.empty() || regions[i].area.w <= 0 || regions[i].area.h <= 0) {
+			fprintf(stderr, "Map %s: region %u needs a file and a location, skipping.\n", filename.c_str(), i);
+			continue;
+		}
+		map_regions.push_back(new MapRegion(regions[i]));
+	}
+
 	for (unsigned i = 0; i < layers.size(); ++i)
 		if (layernames[i] == "object")
 			index_objectlayer = i;
+}
+
+/**
+ * Load the music, and queue the enemies and the assets of the map
+ */
+void MapRenderer::loadAssets() {
+	loadMusic();
 
 	while (!enemy_groups.empty()) {
 		pushEnemyGroup(enemy_groups.front());
 		enemy_groups.pop();
 	}
 
+	preloadAssets();
+}
+
+/**
+ * Load the tileset, and remove the tiles it doesn't define
+ */
+void MapRenderer::loadTileset() {
 	tset.load(this->tileset);
 
 	std::vector<unsigned> corrupted;
 	for (unsigned i = 0; i < layers.size(); ++i) {
 		for (int x = 0; x < w; ++x) {
 			for (int y = 0; y < h; ++y) {
-				const unsigned tile_id = layers[i][x][y];
+				const unsigned tile_id = layers[i]->get(x, y);
 				if (tile_id > 0 && (tile_id >= tset.tiles.size() || tset.tiles[tile_id].tile == NULL)) {
 					if (find(corrupted.begin(), corrupted.end(), tile_id) == corrupted.end()) {
 						corrupted.push_back(tile_id);
 					}
-					layers[i][x][y] = 0;
+					layers[i]->set(x, y, 0);
 				}
 			}
 		}
@@ -203,12 +276,49 @@ int MapRenderer::load(std::string fname) {
 			corrupted.pop_back();
 		}
 	}
+}
+
+/**
+ * Set up the collision map and its pathfinding data
+ */
+void MapRenderer::loadCollision() {
+	if (loading_collision) {
+		collider.setmap(*loading_collision);
+		delete loading_collision;
+		loading_collision = NULL;
+	}
+	else if (!map_regions.empty()) {
+		collider.setmap(Map_Layer(w, h));
+	}
+
+	// nothing can move into a region before it's loaded
+	for (unsigned i = 0; i < map_regions.size(); ++i) {
+		const Rect &area = map_regions[i]->area;
+		for (int y = area.y; y < area.y + area.h; ++y)
+			for (int x = area.x; x < area.x + area.w; ++x)
+				collider.colmap.set(x, y, BLOCKS_ALL);
+		collider.invalidate_area(area.x, area.y, area.w, area.h);
+	}
+}
+
+/**
+ * Run the on_load events, pre-render the chunks and load the regions around the camera
+ */
+void MapRenderer::loadChunks() {
+	repaint_background = true;
 
 	// some events automatically trigger when the map loads
 	// e.g. change map state based on campaign status
 	executeOnLoadEvents();
 
-	return 0;
+	initChunks();
+
+	// the regions around the camera are needed right away, the others are
+	// loaded in the background once the camera comes close
+	streamRegions();
+
+	// paths requested on the first frame of the map already need its terrain
+	path_service.update(collider);
 }
 
 void MapRenderer::loadMusic() {
@@ -225,7 +335,7 @@ void MapRenderer::loadMusic() {
 		music = NULL;
 	}
 	if (AUDIO && MUSIC_VOLUME) {
-		music = Mix_LoadMUS(mods->locate(played_music_filename).c_str());
+		music = Mix_LoadMUSType_RW(mods->openRW(mods->locate(played_music_filename), true), MUS_NONE, 1);
 		if(!music)
 			fprintf(stderr, "Mix_LoadMUS: %s\n", Mix_GetError());
 	}
@@ -239,11 +349,22 @@ void MapRenderer::loadMusic() {
 void MapRenderer::logic() {
 
 	// handle camera shaking timer
-	if (shaky_cam_ticks > 0) shaky_cam_ticks--;
+	// the shake offset is rolled here instead of in render(), so that the
+	// random number sequence only depends on logic ticks
+	if (shaky_cam_ticks > 0) {
+		shaky_cam_ticks--;
+		shakycam_offset.x = (rand() % 16 - 8) * 0.0078125f;
+		shakycam_offset.y = (rand() % 16 - 8) * 0.0078125f;
+	}
 
 	// handle tile set logic e.g. animations
 	tset.logic();
 
+	streamRegions();
+
+	// events and regions may have changed the collision since the last frame
+	path_service.logic(collider);
+
 	// handle event cooldowns
 	vector<Event>::iterator it;
 	for (it = events.begin(); it < events.end(); ++it) {
@@ -286,10 +407,13 @@ void MapRenderer::render(vector<Renderable> &r, vector<Renderable> &r_dead) {
 		shakycam.y = cam.y;
 	}
 	else {
-		shakycam.x = cam.x + (rand() % 16 - 8) * 0.0078125f;
-		shakycam.y = cam.y + (rand() % 16 - 8) * 0.0078125f;
+		shakycam.x = cam.x + shakycam_offset.x;
+		shakycam.y = cam.y + shakycam_offset.y;
 	}
 
+	updateViewArea();
+	chunk_frame++;
+
 	if (TILESET_ORIENTATION == TILESET_ORTHOGONAL) {
 		calculatePriosOrtho(r);
 		calculatePriosOrtho(r_dead);
@@ -316,7 +440,7 @@ void MapRenderer::drawRenderable(vector<Renderable>::iterator r_cursor) {
 	}
 }
 
-void MapRenderer::renderIsoLayer(const unsigned short layerdata[256][256]) {
+void MapRenderer::renderIsoLayer(const Map_Layer &layerdata) {
 	int_fast16_t i; // first index of the map array
 	int_fast16_t j; // second index of the map array
 	Rect dest;
@@ -359,7 +483,7 @@ void MapRenderer::renderIsoLayer(const unsigned short layerdata[256][256]) {
 			++tiles_width;
 			p.x += TILE_W;
 
-			if (const uint_fast16_t current_tile = layerdata[i][j]) {
+			if (const uint_fast16_t current_tile = layerdata.get(i, j)) {
 				dest.x = p.x - tset.tiles[current_tile].offset.x;
 				dest.y = p.y - tset.tiles[current_tile].offset.y;
 				// no need to set w and h in dest, as it is ignored
@@ -404,7 +528,7 @@ void MapRenderer::renderIsoFrontObjects(vector<Renderable> &r) {
 	if (index_objectlayer >= layers.size())
 		return;
 
-	maprow *objectlayer = layers[index_objectlayer];
+	const Map_Layer &objectlayer = *layers[index_objectlayer];
 	for (uint_fast16_t y = max_tiles_height ; y; --y) {
 		int_fast16_t tiles_width = 0;
 
@@ -431,7 +555,7 @@ void MapRenderer::renderIsoFrontObjects(vector<Renderable> &r) {
 			++tiles_width;
 			p.x += TILE_W;
 
-			if (const uint_fast16_t current_tile = objectlayer[i][j]) {
+			if (const uint_fast16_t current_tile = objectlayer.get(i, j)) {
 				dest.x = p.x - tset.tiles[current_tile].offset.x;
 				dest.y = p.y - tset.tiles[current_tile].offset.y;
 				tset.tiles[current_tile].tile->setDest(dest);
@@ -458,20 +582,22 @@ void MapRenderer::renderIsoFrontObjects(vector<Renderable> &r) {
 
 void MapRenderer::renderIso(vector<Renderable> &r, vector<Renderable> &r_dead) {
 	size_t index = 0;
+	if (renderBackground())
+		index = index_objectlayer;
 	while (index < index_objectlayer)
-		renderIsoLayer(layers[index++]);
+		renderLayer(index++);
 
 	renderIsoBackObjects(r_dead);
 	renderIsoFrontObjects(r);
 
 	index++;
 	while (index < layers.size())
-		renderIsoLayer(layers[index++]);
+		renderLayer(index++);
 
 	checkTooltip();
 }
 
-void MapRenderer::renderOrthoLayer(const unsigned short layerdata[256][256]) {
+void MapRenderer::renderOrthoLayer(const Map_Layer &layerdata) {
 
 	const Point upperleft = floor(screen_to_map(0, 0, shakycam.x, shakycam.y));
 
@@ -488,7 +614,7 @@ void MapRenderer::renderOrthoLayer(const unsigned short layerdata[256][256]) {
 		p = center_tile(p);
 		for (i = starti; i < max_tiles_width; i++) {
 
-			if (const unsigned short current_tile = layerdata[i][j]) {
+			if (const unsigned short current_tile = layerdata.get(i, j)) {
 				Rect dest;
 				dest.x = p.x - tset.tiles[current_tile].offset.x;
 				dest.y = p.y - tset.tiles[current_tile].offset.y;
@@ -528,13 +654,13 @@ void MapRenderer::renderOrthoFrontObjects(std::vector<Renderable> &r) {
 	if (index_objectlayer >= layers.size())
 		return;
 
-	maprow *objectlayer = layers[index_objectlayer];
+	const Map_Layer &objectlayer = *layers[index_objectlayer];
 	for (j = startj; j < max_tiles_height; j++) {
 		Point p = map_to_screen(starti, j, shakycam.x, shakycam.y);
 		p = center_tile(p);
 		for (i = starti; i<max_tiles_width; i++) {
 
-			if (const unsigned short current_tile = objectlayer[i][j]) {
+			if (const unsigned short current_tile = objectlayer.get(i, j)) {
 				dest.x = p.x - tset.tiles[current_tile].offset.x;
 				dest.y = p.y - tset.tiles[current_tile].offset.y;
 				tset.tiles[current_tile].tile->setDest(dest);
@@ -556,19 +682,1058 @@ void MapRenderer::renderOrthoFrontObjects(std::vector<Renderable> &r) {
 
 void MapRenderer::renderOrtho(vector<Renderable> &r, vector<Renderable> &r_dead) {
 	unsigned index = 0;
+	if (renderBackground())
+		index = index_objectlayer;
 	while (index < index_objectlayer)
-		renderOrthoLayer(layers[index++]);
+		renderLayer(index++);
 
 	renderOrthoBackObjects(r_dead);
 	renderOrthoFrontObjects(r);
 	index++;
 
 	while (index < layers.size())
-		renderOrthoLayer(layers[index++]);
+		renderLayer(index++);
 
 	checkTooltip();
 }
 
+/**
+ * Draw a layer other than the object layer, from pre-rendered chunks if possible
+ */
+void MapRenderer::renderLayer(unsigned index) {
+	if (renderChunks(index))
+		return;
+
+	if (TILESET_ORIENTATION == TILESET_ORTHOGONAL)
+		renderOrthoLayer(*layers[index]);
+	else
+		renderIsoLayer(*layers[index]);
+}
+
+/**
+ * Returns the position of the center of tile (i,j) in map pixels.
+ * Map pixels are screen pixels relative to the center of tile (0,0), so they
+ * don't depend on the camera.
+ */
+Point MapRenderer::mapPixel(int i, int j) {
+	if (TILESET_ORIENTATION == TILESET_ORTHOGONAL)
+		return Point(i * TILE_W + TILE_W_HALF, j * TILE_H + TILE_H_HALF);
+	else
+		return Point((i - j) * TILE_W_HALF, (i + j) * TILE_H_HALF + TILE_H_HALF);
+}
+
+/**
+ * Returns the area which tiles placed inside a rectangle of tiles can cover,
+ * in map pixels. This includes tiles reaching over the edges of the rectangle.
+ */
+Rect MapRenderer::getAreaRect(const Rect& tiles) {
+	Point corner[4];
+	corner[0] = mapPixel(tiles.x, tiles.y);
+	corner[1] = mapPixel(tiles.x + tiles.w - 1, tiles.y);
+	corner[2] = mapPixel(tiles.x, tiles.y + tiles.h - 1);
+	corner[3] = mapPixel(tiles.x + tiles.w - 1, tiles.y + tiles.h - 1);
+	int left = corner[0].x;
+	int right = corner[0].x;
+	int top = corner[0].y;
+	int bottom = corner[0].y;
+	for (int k = 1; k < 4; ++k) {
+		left = min(left, corner[k].x);
+		right = max(right, corner[k].x);
+		top = min(top, corner[k].y);
+		bottom = max(bottom, corner[k].y);
+	}
+
+	Rect area;
+	area.x = left - tset.max_size_x * TILE_W;
+	area.y = top - tset.max_size_y * TILE_H;
+	area.w = right + tset.max_size_x * TILE_W - area.x;
+	area.h = bottom + tset.max_size_y * TILE_H - area.y;
+	return area;
+}
+
+/**
+ * Returns the area covered by tile_id placed at (i,j), in map pixels
+ */
+Rect MapRenderer::getTileRect(unsigned short tile_id, int i, int j) {
+	const Point center = mapPixel(i, j);
+	const Rect clip = tset.tiles[tile_id].tile->getClip();
+
+	Rect tile_rect;
+	tile_rect.x = center.x - tset.tiles[tile_id].offset.x;
+	tile_rect.y = center.y - tset.tiles[tile_id].offset.y;
+	tile_rect.w = clip.w;
+	tile_rect.h = clip.h;
+	return tile_rect;
+}
+
+static int floorDiv(int a, int b) {
+	return (a >= 0) ? a / b : -((b - 1 - a) / b);
+}
+
+static Rect intersectRect(const Rect& a, const Rect& b) {
+	Rect r;
+	r.x = max(a.x, b.x);
+	r.y = max(a.y, b.y);
+	r.w = max(0, min(a.x + a.w, b.x + b.w) - r.x);
+	r.h = max(0, min(a.y + a.h, b.y + b.h) - r.y);
+	return r;
+}
+
+/**
+ * The smallest rectangle containing both a and b. An empty rectangle adds nothing.
+ */
+static Rect unionRect(const Rect& a, const Rect& b) {
+	if (a.w <= 0 || a.h <= 0) return b;
+	if (b.w <= 0 || b.h <= 0) return a;
+
+	Rect r;
+	r.x = min(a.x, b.x);
+	r.y = min(a.y, b.y);
+	r.w = max(a.x + a.w, b.x + b.w) - r.x;
+	r.h = max(a.y + a.h, b.y + b.h) - r.y;
+	return r;
+}
+
+/**
+ * Returns the rectangle of tiles which can reach into region (in map pixels),
+ * clipped to the map. On isometric maps, this is the bounding box of the tiles.
+ */
+Rect MapRenderer::getTileRange(const Rect& region) {
+	const int left = region.x - tset.max_size_x * TILE_W;
+	const int right = region.x + region.w + tset.max_size_x * TILE_W;
+	const int top = region.y - tset.max_size_y * TILE_H;
+	const int bottom = region.y + region.h + tset.max_size_y * TILE_H;
+
+	int min_i, max_i, min_j, max_j;
+	if (TILESET_ORIENTATION == TILESET_ORTHOGONAL) {
+		min_i = floorDiv(left - TILE_W_HALF, TILE_W);
+		max_i = floorDiv(right - TILE_W_HALF, TILE_W) + 1;
+		min_j = floorDiv(top - TILE_H_HALF, TILE_H);
+		max_j = floorDiv(bottom - TILE_H_HALF, TILE_H) + 1;
+	}
+	else {
+		// see paintLayer: d = i-j and s = i+j
+		const int min_d = floorDiv(left, TILE_W_HALF);
+		const int max_d = floorDiv(right, TILE_W_HALF) + 1;
+		const int min_s = floorDiv(top - TILE_H_HALF, TILE_H_HALF);
+		const int max_s = floorDiv(bottom - TILE_H_HALF, TILE_H_HALF) + 1;
+		min_i = floorDiv(min_s + min_d, 2);
+		max_i = floorDiv(max_s + max_d, 2) + 1;
+		min_j = floorDiv(min_s - max_d, 2);
+		max_j = floorDiv(max_s - min_d, 2) + 1;
+	}
+
+	Rect tiles;
+	tiles.x = max(0, min_i);
+	tiles.y = max(0, min_j);
+	tiles.w = max(0, min(w - 1, max_i) - tiles.x + 1);
+	tiles.h = max(0, min(h - 1, max_j) - tiles.y + 1);
+	return tiles;
+}
+
+/**
+ * Find the visible part of the map, in map pixels.
+ * A tile near the camera is used as reference, to get the same rounding as the tile renderers.
+ */
+void MapRenderer::updateViewArea() {
+	const Point ref((int)shakycam.x, (int)shakycam.y);
+	const Point ref_screen = center_tile(map_to_screen(float(ref.x), float(ref.y), shakycam.x, shakycam.y));
+	const Point ref_pixel = mapPixel(ref.x, ref.y);
+
+	view_area.x = ref_pixel.x - ref_screen.x;
+	view_area.y = ref_pixel.y - ref_screen.y;
+	view_area.w = VIEW_W;
+	view_area.h = VIEW_H;
+}
+
+/**
+ * Draw the layers below the object layer from the background cache.
+ * Returns false if the cache can't be used, so the layers have to be drawn tile by tile.
+ */
+bool MapRenderer::renderBackground() {
+	if (index_objectlayer == 0)
+		return true;
+
+	const int margin_x = movedistance_to_rerender * TILE_W;
+	const int margin_y = movedistance_to_rerender * TILE_H;
+	const int cache_w = VIEW_W + 2 * margin_x;
+	const int cache_h = VIEW_H + 2 * margin_y;
+
+	if (!background || background->getGraphicsWidth() != cache_w || background->getGraphicsHeight() != cache_h) {
+		clearBackground();
+
+		Image *graphics = render_device->createImage(cache_w, cache_h);
+		if (!graphics) return false;
+		background = graphics->createSprite();
+		graphics->unref();
+
+		graphics = render_device->createImage(cache_w, cache_h);
+		if (!graphics) {
+			clearBackground();
+			return false;
+		}
+		background_scroll = graphics->createSprite();
+		graphics->unref();
+	}
+
+	const Rect &view = view_area;
+
+	Rect area;
+	area.x = view.x - margin_x;
+	area.y = view.y - margin_y;
+	area.w = cache_w;
+	area.h = cache_h;
+
+	if (!background_valid || repaint_background) {
+		background_area = area;
+		background_anim_tiles.clear();
+		findAnimatedBackgroundTiles(background_area);
+		paintBackground(background_area);
+		background_anim_frames.resize(tset.anim.size());
+		for (unsigned i = 0; i < tset.anim.size(); ++i)
+			background_anim_frames[i] = tset.anim[i].current_frame;
+		background_valid = true;
+		repaint_background = false;
+	}
+	else {
+		const Rect visible = intersectRect(view, background_area);
+		if (visible.w < view.w || visible.h < view.h)
+			scrollBackground(area);
+
+		const Rect dirty = intersectRect(background_dirty, background_area);
+		if (dirty.w > 0 && dirty.h > 0) {
+			findAnimatedBackgroundTiles(dirty);
+			paintBackground(dirty);
+		}
+		repaintAnimatedBackground();
+	}
+	background_dirty = Rect();
+
+	background->setClip(view.x - background_area.x, view.y - background_area.y, view.w, view.h);
+	background->setDest(0, 0);
+	render_device->render(background);
+	return true;
+}
+
+/**
+ * Move the cache to cover a new area. The part both areas have in common is
+ * copied, so only the newly exposed edges have to be painted.
+ */
+void MapRenderer::scrollBackground(const Rect& area) {
+	const Rect overlap = intersectRect(area, background_area);
+
+	background_anim_tiles.clear();
+	findAnimatedBackgroundTiles(area);
+
+	if (overlap.w == 0 || overlap.h == 0) {
+		background_area = area;
+		paintBackground(background_area);
+		return;
+	}
+
+	Rect src;
+	src.x = overlap.x - background_area.x;
+	src.y = overlap.y - background_area.y;
+	src.w = overlap.w;
+	src.h = overlap.h;
+	Rect dest;
+	dest.x = overlap.x - area.x;
+	dest.y = overlap.y - area.y;
+	dest.w = overlap.w;
+	dest.h = overlap.h;
+	render_device->renderToImage(background->getGraphics(), src, background_scroll->getGraphics(), dest);
+
+	Sprite *swap = background;
+	background = background_scroll;
+	background_scroll = swap;
+	background_area = area;
+
+	// exposed rows above and below the copied part span the full width,
+	// exposed columns only the height of the copied part
+	Rect edge;
+	edge.x = area.x;
+	edge.w = area.w;
+	if (overlap.y > area.y) {
+		edge.y = area.y;
+		edge.h = overlap.y - area.y;
+		paintBackground(edge);
+	}
+	if (overlap.y + overlap.h < area.y + area.h) {
+		edge.y = overlap.y + overlap.h;
+		edge.h = area.y + area.h - edge.y;
+		paintBackground(edge);
+	}
+
+	edge.y = overlap.y;
+	edge.h = overlap.h;
+	if (overlap.x > area.x) {
+		edge.x = area.x;
+		edge.w = overlap.x - area.x;
+		paintBackground(edge);
+	}
+	if (overlap.x + overlap.w < area.x + area.w) {
+		edge.x = overlap.x + overlap.w;
+		edge.w = area.x + area.w - edge.x;
+		paintBackground(edge);
+	}
+}
+
+/**
+ * Repaint the parts of the cache covered by animated tiles that changed their frame
+ */
+void MapRenderer::repaintAnimatedBackground() {
+	bool changed = false;
+	for (unsigned i = 0; i < tset.anim.size() && i < background_anim_frames.size(); ++i) {
+		if (tset.anim[i].frames && tset.anim[i].current_frame != background_anim_frames[i]) {
+			changed = true;
+			break;
+		}
+	}
+	if (!changed)
+		return;
+
+	for (unsigned k = 0; k < background_anim_tiles.size(); ++k) {
+		const Point &pos = background_anim_tiles[k];
+
+		// the dirty region covers all changed tiles at this position
+		Rect dirty;
+		for (unsigned layer = 0; layer < index_objectlayer; ++layer) {
+			const unsigned short id = layers[layer]->get(pos.x, pos.y);
+			if (id == 0 || id >= tset.anim.size() || id >= background_anim_frames.size())
+				continue;
+			if (!tset.anim[id].frames || tset.anim[id].current_frame == background_anim_frames[id])
+				continue;
+
+			dirty = unionRect(dirty, getTileRect(id, pos.x, pos.y));
+		}
+
+		dirty = intersectRect(dirty, background_area);
+		if (dirty.w > 0 && dirty.h > 0)
+			paintBackground(dirty);
+	}
+
+	for (unsigned i = 0; i < tset.anim.size() && i < background_anim_frames.size(); ++i)
+		background_anim_frames[i] = tset.anim[i].current_frame;
+}
+
+/**
+ * Clear a region of the cache and draw all tiles below the object layer into it.
+ * The region is given in map pixels and must be inside background_area.
+ */
+void MapRenderer::paintBackground(const Rect& region) {
+	Image *graphics = background->getGraphics();
+	const Point origin(background_area.x, background_area.y);
+
+	Rect dest = region;
+	dest.x -= origin.x;
+	dest.y -= origin.y;
+	graphics->fillWithColor(&dest, graphics->MapRGB(0, 0, 0));
+
+	for (unsigned layer = 0; layer < index_objectlayer && layer < layers.size(); ++layer) {
+		if (!blitChunks(layer, graphics, origin, region))
+			paintLayer(layer, graphics, origin, region, false);
+	}
+}
+
+/**
+ * Draw the tiles of a layer which are inside region (in map pixels) into target.
+ * target_pos is the map pixel at the top left corner of target.
+ * Returns the number of tiles drawn.
+ */
+int MapRenderer::paintLayer(unsigned index, Image *target, const Point& target_pos, const Rect& region, bool target_is_transparent) {
+	const Map_Layer &layerdata = *layers[index];
+	int painted = 0;
+
+	// tiles can be larger than the grid, so include all tiles which could reach into the region
+	const int left = region.x - tset.max_size_x * TILE_W;
+	const int right = region.x + region.w + tset.max_size_x * TILE_W;
+	const int top = region.y - tset.max_size_y * TILE_H;
+	const int bottom = region.y + region.h + tset.max_size_y * TILE_H;
+
+	if (TILESET_ORIENTATION == TILESET_ORTHOGONAL) {
+		const int min_i = max(0, floorDiv(left - TILE_W_HALF, TILE_W));
+		const int max_i = min(w - 1, floorDiv(right - TILE_W_HALF, TILE_W) + 1);
+		const int min_j = max(0, floorDiv(top - TILE_H_HALF, TILE_H));
+		const int max_j = min(h - 1, floorDiv(bottom - TILE_H_HALF, TILE_H) + 1);
+
+		// same order as renderOrthoLayer
+		for (int j = min_j; j <= max_j; ++j) {
+			for (int i = min_i; i <= max_i; ++i) {
+				if (const unsigned short current_tile = layerdata.get(i, j)) {
+					paintTile(current_tile, i, j, target, target_pos, region, target_is_transparent);
+					painted++;
+				}
+			}
+		}
+	}
+	else {
+		// on isometric maps, the screen x position depends on i-j and y on i+j
+		const int min_d = floorDiv(left, TILE_W_HALF);
+		const int max_d = floorDiv(right, TILE_W_HALF) + 1;
+		const int min_s = max(0, floorDiv(top - TILE_H_HALF, TILE_H_HALF));
+		const int max_s = min(w + h - 2, floorDiv(bottom - TILE_H_HALF, TILE_H_HALF) + 1);
+
+		// same order as renderIsoLayer: line by line, from left to right
+		for (int s = min_s; s <= max_s; ++s) {
+			const int min_i = max(max(0, s - (h - 1)), -floorDiv(-(s + min_d), 2));
+			const int max_i = min(min(w - 1, s), floorDiv(s + max_d, 2));
+			for (int i = min_i; i <= max_i; ++i) {
+				if (const unsigned short current_tile = layerdata.get(i, s - i)) {
+					paintTile(current_tile, i, s - i, target, target_pos, region, target_is_transparent);
+					painted++;
+				}
+			}
+		}
+	}
+
+	return painted;
+}
+
+/**
+ * Draw the part of a single tile which is inside region (in map pixels) into target
+ */
+void MapRenderer::paintTile(unsigned short tile_id, int i, int j, Image *target, const Point& target_pos, const Rect& region, bool target_is_transparent) {
+	Sprite *tile = tset.tiles[tile_id].tile;
+	const Rect clip = tile->getClip();
+	const Rect tile_rect = getTileRect(tile_id, i, j);
+
+	const Rect visible = intersectRect(tile_rect, region);
+	if (visible.w == 0 || visible.h == 0)
+		return;
+
+	Rect src;
+	src.x = clip.x + visible.x - tile_rect.x;
+	src.y = clip.y + visible.y - tile_rect.y;
+	src.w = visible.w;
+	src.h = visible.h;
+
+	Rect dest = visible;
+	dest.x -= target_pos.x;
+	dest.y -= target_pos.y;
+
+	render_device->renderToImage(tile->getGraphics(), src, target, dest, target_is_transparent);
+}
+
+/**
+ * Collect the positions of animated tiles below the object layer which can
+ * reach into region (in map pixels). Tiles found before in that part of the
+ * map are replaced, so this can be called again for a part that changed.
+ */
+void MapRenderer::findAnimatedBackgroundTiles(const Rect& region) {
+	const Rect tiles = getTileRange(region);
+	if (tiles.w == 0 || tiles.h == 0)
+		return;
+
+	for (unsigned k = background_anim_tiles.size(); k > 0; --k) {
+		if (isWithin(tiles, background_anim_tiles[k-1])) {
+			background_anim_tiles[k-1] = background_anim_tiles.back();
+			background_anim_tiles.pop_back();
+		}
+	}
+
+	for (int i = tiles.x; i < tiles.x + tiles.w; ++i) {
+		for (int j = tiles.y; j < tiles.y + tiles.h; ++j) {
+			for (unsigned layer = 0; layer < index_objectlayer && layer < layers.size(); ++layer) {
+				const unsigned short id = layers[layer]->get(i, j);
+				if (id > 0 && id < tset.anim.size() && tset.anim[id].frames) {
+					background_anim_tiles.push_back(Point(i, j));
+					break;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Repaint a part of the background cache (in map pixels) on the next frame,
+ * after the tiles in it were changed
+ */
+void MapRenderer::invalidateBackground(const Rect& region) {
+	background_dirty = unionRect(background_dirty, region);
+}
+
+void MapRenderer::clearBackground() {
+	delete background;
+	delete background_scroll;
+	background = NULL;
+	background_scroll = NULL;
+	background_valid = false;
+}
+
+/**
+ * Set up the chunk grids of the current map and pre-render the chunks around
+ * the spawn point, as far as the memory budget allows. Chunks further away
+ * are baked when they first become visible.
+ */
+void MapRenderer::initChunks() {
+	clearChunks();
+
+	chunk_size = MAP_CHUNK_SIZE;
+	if (chunk_size == 0 || layers.empty() || w <= 0 || h <= 0)
+		return;
+	chunk_size = max(64, min(4096, chunk_size));
+	chunk_limit = (int)(((unsigned long)MAP_CHUNK_MEMORY * 1024 * 1024) / ((unsigned long)chunk_size * chunk_size * 4));
+	if (chunk_limit == 0)
+		return;
+
+	// the grid covers the whole map, including tiles reaching over its edges,
+	// so tiles changed by events always end up in a chunk
+	Rect map_area;
+	map_area.w = w;
+	map_area.h = h;
+	const Rect area = getAreaRect(map_area);
+
+	chunk_layers.resize(layers.size());
+	for (unsigned index = 0; index < layers.size(); ++index) {
+		Map_ChunkLayer &chunk_layer = chunk_layers[index];
+
+		// the object layer is drawn interleaved with entities, and animated
+		// layers would have to be baked again every time a frame changes
+		chunk_layer.enabled = (index != index_objectlayer);
+		for (int i = 0; i < w && chunk_layer.enabled; ++i) {
+			for (int j = 0; j < h; ++j) {
+				const unsigned short id = layers[index]->get(i, j);
+				if (id > 0 && id < tset.anim.size() && tset.anim[id].frames) {
+					chunk_layer.enabled = false;
+					break;
+				}
+			}
+		}
+		if (!chunk_layer.enabled)
+			continue;
+
+		chunk_layer.area = area;
+		chunk_layer.columns = (area.w + chunk_size - 1) / chunk_size;
+		chunk_layer.rows = (area.h + chunk_size - 1) / chunk_size;
+		chunk_layer.chunks.resize(chunk_layer.columns * chunk_layer.rows);
+	}
+
+	// bake the chunks closest to the spawn point first
+	const Point spawn_pixel = mapPixel(int(spawn.x), int(spawn.y));
+	std::vector<std::pair<long, std::pair<unsigned, unsigned> > > order;
+	for (unsigned index = 0; index < chunk_layers.size(); ++index) {
+		for (unsigned chunk = 0; chunk < chunk_layers[index].chunks.size(); ++chunk) {
+			const Rect r = getChunkRect(chunk_layers[index], chunk);
+			const long dx = r.x + r.w / 2 - spawn_pixel.x;
+			const long dy = r.y + r.h / 2 - spawn_pixel.y;
+			order.push_back(std::make_pair(dx * dx + dy * dy, std::make_pair(index, chunk)));
+		}
+	}
+	std::sort(order.begin(), order.end());
+
+	for (unsigned k = 0; k < order.size() && chunk_count < chunk_limit; ++k) {
+		bakeChunk(order[k].second.first, order[k].second.second);
+	}
+}
+
+void MapRenderer::clearChunks() {
+	for (unsigned index = 0; index < chunk_layers.size(); ++index) {
+		for (unsigned chunk = 0; chunk < chunk_layers[index].chunks.size(); ++chunk)
+			delete chunk_layers[index].chunks[chunk].sprite;
+	}
+	chunk_layers.clear();
+	chunk_count = 0;
+	chunk_limit = 0;
+}
+
+/**
+ * Forget all chunks of a layer which overlap region (in map pixels), so they are baked again
+ */
+void MapRenderer::dropChunks(unsigned index, const Rect& region) {
+	if (index >= chunk_layers.size() || !chunk_layers[index].enabled)
+		return;
+
+	Map_ChunkLayer &chunk_layer = chunk_layers[index];
+	int x0, y0, x1, y1;
+	getChunkRange(chunk_layer, region, x0, y0, x1, y1);
+
+	for (int y = y0; y <= y1; ++y) {
+		for (int x = x0; x <= x1; ++x) {
+			Map_Chunk &chunk = chunk_layer.chunks[y * chunk_layer.columns + x];
+			if (chunk.sprite) {
+				delete chunk.sprite;
+				chunk.sprite = NULL;
+				chunk_count--;
+			}
+			chunk.empty = false;
+		}
+	}
+}
+
+/**
+ * Make sure all chunks of a layer overlapping region (in map pixels) are baked.
+ * Returns false if the layer can't be drawn from chunks, e.g. because the
+ * memory budget is too small for the region.
+ */
+bool MapRenderer::prepareChunks(unsigned index, const Rect& region) {
+	if (index >= chunk_layers.size() || !chunk_layers[index].enabled)
+		return false;
+
+	Map_ChunkLayer &chunk_layer = chunk_layers[index];
+	int x0, y0, x1, y1;
+	getChunkRange(chunk_layer, region, x0, y0, x1, y1);
+
+	for (int y = y0; y <= y1; ++y) {
+		for (int x = x0; x <= x1; ++x) {
+			const unsigned chunk = y * chunk_layer.columns + x;
+			chunk_layer.chunks[chunk].last_used = chunk_frame;
+			if (!chunk_layer.chunks[chunk].sprite && !chunk_layer.chunks[chunk].empty && !bakeChunk(index, chunk))
+				return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Render all tiles of a layer inside a chunk into a new image
+ */
+bool MapRenderer::bakeChunk(unsigned index, unsigned chunk) {
+	Map_Chunk &target = chunk_layers[index].chunks[chunk];
+	if (chunk_count >= chunk_limit && !evictChunk())
+		return false;
+
+	Image *graphics = render_device->createImage(chunk_size, chunk_size);
+	if (!graphics)
+		return false;
+
+	const Rect region = getChunkRect(chunk_layers[index], chunk);
+	if (paintLayer(index, graphics, Point(region.x, region.y), region, true) == 0) {
+		graphics->unref();
+		target.empty = true;
+		return true;
+	}
+
+	target.sprite = graphics->createSprite();
+	graphics->unref();
+	chunk_count++;
+	return true;
+}
+
+/**
+ * Free the least recently used chunk, unless all chunks are needed for the current frame
+ */
+bool MapRenderer::evictChunk() {
+	Map_Chunk *oldest = NULL;
+
+	for (unsigned index = 0; index < chunk_layers.size(); ++index) {
+		for (unsigned chunk = 0; chunk < chunk_layers[index].chunks.size(); ++chunk) {
+			Map_Chunk &c = chunk_layers[index].chunks[chunk];
+			if (c.sprite && c.last_used != chunk_frame && (!oldest || c.last_used < oldest->last_used))
+				oldest = &c;
+		}
+	}
+
+	if (!oldest)
+		return false;
+
+	delete oldest->sprite;
+	oldest->sprite = NULL;
+	chunk_count--;
+	return true;
+}
+
+/**
+ * Draw the visible part of a layer from its chunks.
+ * Returns false if the layer has to be drawn tile by tile.
+ */
+bool MapRenderer::renderChunks(unsigned index) {
+	if (!prepareChunks(index, view_area))
+		return false;
+
+	const Map_ChunkLayer &chunk_layer = chunk_layers[index];
+	int x0, y0, x1, y1;
+	getChunkRange(chunk_layer, view_area, x0, y0, x1, y1);
+
+	for (int y = y0; y <= y1; ++y) {
+		for (int x = x0; x <= x1; ++x) {
+			const unsigned chunk = y * chunk_layer.columns + x;
+			Sprite *sprite = chunk_layer.chunks[chunk].sprite;
+			if (!sprite)
+				continue;
+
+			const Rect r = getChunkRect(chunk_layer, chunk);
+			const Rect part = intersectRect(r, view_area);
+			if (part.w == 0 || part.h == 0)
+				continue;
+
+			sprite->setClip(part.x - r.x, part.y - r.y, part.w, part.h);
+			sprite->setDest(part.x - view_area.x, part.y - view_area.y);
+			render_device->render(sprite);
+		}
+	}
+	return true;
+}
+
+/**
+ * Draw the part of a layer inside region (in map pixels) from its chunks into target.
+ * target_pos is the map pixel at the top left corner of target.
+ * Returns false if the layer has to be painted tile by tile.
+ */
+bool MapRenderer::blitChunks(unsigned index, Image *target, const Point& target_pos, const Rect& region) {
+	if (!prepareChunks(index, region))
+		return false;
+
+	const Map_ChunkLayer &chunk_layer = chunk_layers[index];
+	int x0, y0, x1, y1;
+	getChunkRange(chunk_layer, region, x0, y0, x1, y1);
+
+	for (int y = y0; y <= y1; ++y) {
+		for (int x = x0; x <= x1; ++x) {
+			const unsigned chunk = y * chunk_layer.columns + x;
+			Sprite *sprite = chunk_layer.chunks[chunk].sprite;
+			if (!sprite)
+				continue;
+
+			const Rect r = getChunkRect(chunk_layer, chunk);
+			const Rect part = intersectRect(r, region);
+			if (part.w == 0 || part.h == 0)
+				continue;
+
+			Rect src;
+			src.x = part.x - r.x;
+			src.y = part.y - r.y;
+			src.w = part.w;
+			src.h = part.h;
+			Rect dest = part;
+			dest.x -= target_pos.x;
+			dest.y -= target_pos.y;
+			render_device->renderToImage(sprite->getGraphics(), src, target, dest);
+		}
+	}
+	return true;
+}
+
+/**
+ * Find the columns x0..x1 and rows y0..y1 of the chunks overlapping region.
+ * The range is empty (x0 > x1) if region is outside of the grid.
+ */
+void MapRenderer::getChunkRange(const Map_ChunkLayer& chunk_layer, const Rect& region, int& x0, int& y0, int& x1, int& y1) {
+	x0 = max(0, floorDiv(region.x - chunk_layer.area.x, chunk_size));
+	y0 = max(0, floorDiv(region.y - chunk_layer.area.y, chunk_size));
+	x1 = min(chunk_layer.columns - 1, floorDiv(region.x + region.w - 1 - chunk_layer.area.x, chunk_size));
+	y1 = min(chunk_layer.rows - 1, floorDiv(region.y + region.h - 1 - chunk_layer.area.y, chunk_size));
+	if (region.w <= 0 || region.h <= 0)
+		x1 = x0 - 1;
+}
+
+/**
+ * Returns the area covered by a chunk, in map pixels
+ */
+Rect MapRenderer::getChunkRect(const Map_ChunkLayer& chunk_layer, unsigned chunk) {
+	Rect r;
+	r.x = chunk_layer.area.x + (chunk % chunk_layer.columns) * chunk_size;
+	r.y = chunk_layer.area.y + (chunk / chunk_layer.columns) * chunk_size;
+	r.w = chunk_size;
+	r.h = chunk_size;
+	return r;
+}
+
+/**
+ * Change a single tile and drop everything that was pre-rendered from it
+ */
+void MapRenderer::modifyTile(unsigned index, int x, int y, unsigned short tile_id) {
+	if (index >= layers.size() || x < 0 || x >= w || y < 0 || y >= h)
+		return;
+
+	if (tile_id >= tset.tiles.size() || (tile_id > 0 && tset.tiles[tile_id].tile == NULL)) {
+		fprintf(stderr, "Error: tile id %d is not defined in the tileset.\n", tile_id);
+		return;
+	}
+
+	// the region has to be loaded, or its tiles would replace the new one later
+	MapRegion *region = getRegionAt(x, y);
+	if (region) {
+		activateRegion(region);
+		region->modified = true;
+	}
+
+	const unsigned short old_id = layers[index]->get(x, y);
+	layers[index]->set(x, y, tile_id);
+
+	if (index < chunk_layers.size() && chunk_layers[index].enabled) {
+		if (tile_id > 0 && tile_id < tset.anim.size() && tset.anim[tile_id].frames) {
+			// the layer is animated now, so it can't be pre-rendered anymore
+			dropChunks(index, chunk_layers[index].area);
+			chunk_layers[index].enabled = false;
+		}
+		else {
+			if (old_id > 0)
+				dropChunks(index, getTileRect(old_id, x, y));
+			if (tile_id > 0)
+				dropChunks(index, getTileRect(tile_id, x, y));
+		}
+	}
+
+	// layers below the object layer are cached
+	if (index < index_objectlayer) {
+		Rect tile;
+		tile.x = x;
+		tile.y = y;
+		tile.w = tile.h = 1;
+		invalidateBackground(getAreaRect(tile));
+	}
+}
+
+void MapRenderer::modifyCollision(int x, int y, unsigned short value) {
+	MapRegion *region = getRegionAt(x, y);
+	if (region) {
+		activateRegion(region);
+		region->modified = true;
+	}
+
+	collider.colmap.set(x, y, value);
+	collider.invalidate_area(x, y, 1, 1);
+}
+
+void MapRenderer::clearRegions() {
+	region_loader.cancel();
+	for (unsigned i = 0; i < map_regions.size(); ++i)
+		delete map_regions[i];
+	map_regions.clear();
+}
+
+/**
+ * Merge parsed regions into the map as the camera approaches them, queue the
+ * ones coming into range for the loader, and unload those which are far away.
+ */
+void MapRenderer::streamRegions() {
+	if (map_regions.empty())
+		return;
+
+	std::vector<MapRegion*> parsed;
+	region_loader.collect(parsed);
+	for (unsigned i = 0; i < parsed.size(); ++i)
+		parsed[i]->state = MapRegion::PARSED;
+
+	// regions this close may be on screen before the loader is done with them
+	const int near_distance = (VIEW_W / TILE_W + VIEW_H / TILE_H) / 2 + 2;
+	const int load_distance = max(near_distance, (int)MAP_REGION_DISTANCE);
+
+	for (unsigned i = 0; i < map_regions.size(); ++i) {
+		MapRegion *region = map_regions[i];
+		const int distance = getRegionDistance(region, cam);
+
+		if (region->state == MapRegion::ACTIVE) {
+			if (distance > 2 * load_distance)
+				unloadRegion(region);
+		}
+		else if (distance <= near_distance) {
+			activateRegion(region);
+		}
+		else if (distance <= load_distance) {
+			if (region->state == MapRegion::UNLOADED) {
+				region->state = MapRegion::QUEUED;
+				region_loader.queue(region);
+			}
+			else if (region->state == MapRegion::PARSED) {
+				commitRegion(region);
+			}
+		}
+		else if (region->state == MapRegion::PARSED && !region->modified) {
+			// the camera turned away before the region was needed
+			region->release();
+			region->state = MapRegion::UNLOADED;
+		}
+	}
+}
+
+/**
+ * Load a region right away, waiting for the loader if it's already queued
+ */
+void MapRenderer::activateRegion(MapRegion *region) {
+	if (region->state == MapRegion::ACTIVE)
+		return;
+
+	if (region->state == MapRegion::UNLOADED)
+		region->parse();
+	else if (region->state == MapRegion::QUEUED)
+		region_loader.wait(region);
+
+	commitRegion(region);
+}
+
+/**
+ * Merge a parsed region into the map. Its enemies, NPCs and events are added
+ * the first time; they stay on the map when the region is unloaded again.
+ */
+void MapRenderer::commitRegion(MapRegion *region) {
+	const Rect &area = region->area;
+	const Rect pixel_area = getAreaRect(area);
+	int corrupted = 0;
+
+	collider.colmap.clearRect(area.x, area.y, area.w, area.h);
+	collider.invalidate_area(area.x, area.y, area.w, area.h);
+
+	for (unsigned k = 0; k < region->layers.size(); ++k) {
+		const Map_Layer &layer = *region->layers[k];
+		const int layer_w = min(area.w, layer.getWidth());
+		const int layer_h = min(area.h, layer.getHeight());
+
+		if (region->layernames[k] == "collision") {
+			for (int y = 0; y < layer_h; ++y)
+				for (int x = 0; x < layer_w; ++x)
+					collider.colmap.set(area.x + x, area.y + y, layer.get(x, y));
+			continue;
+		}
+
+		const unsigned index = distance(layernames.begin(), find(layernames.begin(), layernames.end(), region->layernames[k]));
+		if (index >= layers.size()) {
+			fprintf(stderr, "Map region %s: layer \"%s\" is not defined in %s, skipping.\n", region->file.c_str(), region->layernames[k].c_str(), filename.c_str());
+			continue;
+		}
+
+		bool animated = false;
+		for (int y = 0; y < layer_h; ++y) {
+			for (int x = 0; x < layer_w; ++x) {
+				unsigned short tile_id = layer.get(x, y);
+				if (tile_id > 0 && (tile_id >= tset.tiles.size() || tset.tiles[tile_id].tile == NULL)) {
+					corrupted++;
+					tile_id = 0;
+				}
+				else if (tile_id > 0 && tile_id < tset.anim.size() && tset.anim[tile_id].frames) {
+					animated = true;
+				}
+				layers[index]->set(area.x + x, area.y + y, tile_id);
+			}
+		}
+
+		if (index < chunk_layers.size() && chunk_layers[index].enabled) {
+			if (animated) {
+				dropChunks(index, chunk_layers[index].area);
+				chunk_layers[index].enabled = false;
+			}
+			else {
+				dropChunks(index, pixel_area);
+			}
+		}
+	}
+
+	if (corrupted > 0)
+		fprintf(stderr, "Map region %s: removed %d tiles which are not defined in the tileset.\n", region->file.c_str(), corrupted);
+
+	region->clearLayers();
+	region->state = MapRegion::ACTIVE;
+
+	if (!region->visited) {
+		region->visited = true;
+
+		while (!region->enemy_groups.empty()) {
+			pushEnemyGroup(region->enemy_groups.front());
+			region->enemy_groups.pop();
+		}
+		while (!region->npcs.empty()) {
+			npcs.push(region->npcs.front());
+			region->npcs.pop();
+		}
+
+		// Event doesn't copy its stats, so keep them out of the way while the
+		// vector grows. Only events which have run a power have stats.
+		std::vector<StatBlock*> event_stats(events.size());
+		for (unsigned i = 0; i < events.size(); ++i) {
+			event_stats[i] = events[i].stats;
+			events[i].stats = NULL;
+		}
+		const unsigned first_event = events.size();
+		events.insert(events.end(), region->events.begin(), region->events.end());
+		for (unsigned i = 0; i < first_event; ++i)
+			events[i].stats = event_stats[i];
+
+		// on_load events of the region trigger when it's loaded the first time
+		for (unsigned i = events.size(); i > first_event; --i) {
+			if (events[i-1].type == SID_ON_LOAD && EventManager::isActive(events[i-1]) && EventManager::executeEvent(events[i-1]))
+				events.erase(events.begin() + (i-1));
+		}
+	}
+	region->release();
+
+	invalidateBackground(pixel_area);
+	map_change = true;
+}
+
+/**
+ * Remove the tiles and collision of a region the camera has moved away from.
+ * Nothing can move into the region until it is loaded again.
+ */
+void MapRenderer::unloadRegion(MapRegion *region) {
+	const Rect &area = region->area;
+
+	// tiles changed by events would be lost by parsing the file again, so keep them
+	if (region->modified) {
+		for (unsigned index = 0; index < layers.size(); ++index) {
+			Map_Layer *layer = new Map_Layer(area.w, area.h);
+			for (int y = 0; y < area.h; ++y)
+				for (int x = 0; x < area.w; ++x)
+					layer->set(x, y, layers[index]->get(area.x + x, area.y + y));
+			region->layers.push_back(layer);
+			region->layernames.push_back(layernames[index]);
+		}
+
+		Map_Layer *layer = new Map_Layer(area.w, area.h);
+		for (int y = 0; y < area.h; ++y) {
+			for (int x = 0; x < area.w; ++x) {
+				const unsigned short value = collider.colmap.get(area.x + x, area.y + y);
+				if (value != BLOCKS_ENTITIES && value != BLOCKS_ENEMIES)
+					layer->set(x, y, value);
+			}
+		}
+		region->layers.push_back(layer);
+		region->layernames.push_back("collision");
+
+		region->state = MapRegion::PARSED;
+	}
+	else {
+		region->state = MapRegion::UNLOADED;
+	}
+
+	const Rect pixel_area = getAreaRect(area);
+	for (unsigned index = 0; index < layers.size(); ++index) {
+		layers[index]->clearRect(area.x, area.y, area.w, area.h);
+		dropChunks(index, pixel_area);
+	}
+
+	for (int y = area.y; y < area.y + area.h; ++y)
+		for (int x = area.x; x < area.x + area.w; ++x)
+			collider.colmap.set(x, y, BLOCKS_ALL);
+	collider.invalidate_area(area.x, area.y, area.w, area.h);
+
+	invalidateBackground(pixel_area);
+	map_change = true;
+}
+
+/**
+ * Returns the region which covers tile (x,y), or NULL
+ */
+MapRegion *MapRenderer::getRegionAt(int x, int y) {
+	for (unsigned i = 0; i < map_regions.size(); ++i) {
+		const Rect &area = map_regions[i]->area;
+		if (x >= area.x && y >= area.y && x < area.x + area.w && y < area.y + area.h)
+			return map_regions[i];
+	}
+	return NULL;
+}
+
+/**
+ * Returns the distance in tiles from pos to the nearest tile of a region
+ */
+int MapRenderer::getRegionDistance(const MapRegion *region, const FPoint& pos) {
+	const Rect &area = region->area;
+	const int x = int(pos.x);
+	const int y = int(pos.y);
+	const int dx = max(0, max(area.x - x, x - (area.x + area.w - 1)));
+	const int dy = max(0, max(area.y - y, y - (area.y + area.h - 1)));
+	return max(dx, dy);
+}
+
+/**
+ * Enemies of regions which weren't loaded yet don't exist, so the map can't be cleared before
+ */
+bool MapRenderer::allRegionsVisited() {
+	for (unsigned i = 0; i < map_regions.size(); ++i)
+		if (!map_regions[i]->visited)
+			return false;
+	return true;
+}
+
 void MapRenderer::executeOnLoadEvents() {
 	vector<Event>::iterator it;
 
@@ -579,7 +1744,7 @@ void MapRenderer::executeOnLoadEvents() {
 		// skip inactive events
 		if (!EventManager::isActive(*it)) continue;
 
-		if ((*it).type == "on_load") {
+		if ((*it).type == SID_ON_LOAD) {
 			if (EventManager::executeEvent(*it))
 				it = events.erase(it);
 		}
@@ -598,7 +1763,7 @@ void MapRenderer::executeOnMapExitEvents() {
 		// skip inactive events
 		if (!EventManager::isActive(*it)) continue;
 
-		if ((*it).type == "on_mapexit")
+		if ((*it).type == SID_ON_MAPEXIT)
 			EventManager::executeEvent(*it); // ignore repeat value
 	}
 }
@@ -616,7 +1781,7 @@ void MapRenderer::checkEvents(FPoint loc) {
 		// skip inactive events
 		if (!EventManager::isActive(*it)) continue;
 
-		if ((*it).type == "on_clear") {
+		if ((*it).type == SID_ON_CLEAR) {
 			if (enemies_cleared && EventManager::executeEvent(*it))
 				it = events.erase(it);
 			continue;
@@ -627,16 +1792,16 @@ void MapRenderer::checkEvents(FPoint loc) {
 					  maploc.x <= (*it).location.x + (*it).location.w-1 &&
 					  maploc.y <= (*it).location.y + (*it).location.h-1;
 
-		if ((*it).type == "on_leave") {
+		if ((*it).type == SID_ON_LEAVE) {
 			if (inside) {
-				if (!(*it).getComponent("wasInsideEventArea")) {
+				if (!(*it).getComponent(SID_WAS_INSIDE_EVENT_AREA)) {
 					(*it).components.push_back(Event_Component());
-					(*it).components.back().type = string("wasInsideEventArea");
+					(*it).components.back().type = SID_WAS_INSIDE_EVENT_AREA;
 				}
 			}
 			else {
-				if ((*it).getComponent("wasInsideEventArea")) {
-					(*it).deleteAllComponents("wasInsideEventArea");
+				if ((*it).getComponent(SID_WAS_INSIDE_EVENT_AREA)) {
+					(*it).deleteAllComponents(SID_WAS_INSIDE_EVENT_AREA);
 					if (EventManager::executeEvent(*it))
 						it = events.erase(it);
 				}
@@ -675,14 +1840,14 @@ void MapRenderer::checkHotspots() {
 			for (int y=it->hotspot.y; y < it->hotspot.y + it->hotspot.h; ++y) {
 				bool matched = false;
 				for (unsigned index = 0; index <= index_objectlayer; ++index) {
-					maprow *current_layer = layers[index];
+					const Map_Layer &current_layer = *layers[index];
 					Point p = map_to_screen(float(x),
 											float(y),
 											shakycam.x,
 											shakycam.y);
 					p = center_tile(p);
 
-					if (const short current_tile = current_layer[x][y]) {
+					if (const short current_tile = current_layer.get(x, y)) {
 						// first check if mouse pointer is in rectangle of that tile:
 						Rect dest;
 						dest.x = p.x - tset.tiles[current_tile].offset.x;
@@ -716,7 +1881,7 @@ void MapRenderer::checkHotspots() {
 					if ((*it).cooldown_ticks != 0) continue;
 
 					// new tooltip?
-					createTooltip((*it).getComponent("tooltip"));
+					createTooltip((*it).getComponent(SID_TOOLTIP));
 
 					if ((((*it).reachable_from.w == 0 && (*it).reachable_from.h == 0) || isWithin((*it).reachable_from, floor(cam)))
 							&& calcDist(cam, (*it).center) < INTERACT_RANGE) {
@@ -771,7 +1936,7 @@ void MapRenderer::checkNearestEvent() {
 	if (nearest != events.end()) {
 		if (NO_MOUSE) {
 			// new tooltip?
-			createTooltip((*nearest).getComponent("tooltip"));
+			createTooltip((*nearest).getComponent(SID_TOOLTIP));
 			tip_pos = map_to_screen((*nearest).center.x, (*nearest).center.y, shakycam.x, shakycam.y);
 			tip_pos.y -= TILE_H;
 		}
@@ -811,9 +1976,13 @@ MapRenderer::~MapRenderer() {
 	}
 
 	tip_buf.clear();
+	delete loading_collision;
+	clearRegions();
 	clearLayers();
 	clearEvents();
 	clearQueues();
+	clearBackground();
+	clearChunks();
 	delete tip;
 
 	/* unload sounds */
@@ -32,6 +32,8 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "GameStatePlay.h"
 #include "Map.h"
 #include "MapCollision.h"
+#include "MapRegion.h"
+#include "PathService.h"
 #include "Settings.h"
 #include "TileSet.h"
 #include "Utils.h"
@@ -41,6 +43,44 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 class FileParser;
 class WidgetTooltip;
 
+/**
+ * A pre-rendered square of one map layer.
+ * sprite is NULL until the chunk is baked; chunks without any tiles are only
+ * marked as empty, so they don't take up memory.
+ */
+class Map_Chunk {
+public:
+	Sprite *sprite;
+	bool empty;
+	unsigned last_used;
+
+	Map_Chunk()
+		: sprite(NULL)
+		, empty(false)
+		, last_used(0) {
+	}
+};
+
+/**
+ * The chunk grid of one map layer. Only layers without animated tiles can be
+ * pre-rendered. area is the part of the map covered by the grid, in map pixels.
+ */
+class Map_ChunkLayer {
+public:
+	bool enabled;
+	Rect area;
+	int columns;
+	int rows;
+	std::vector<Map_Chunk> chunks;
+
+	Map_ChunkLayer()
+		: enabled(false)
+		, area()
+		, columns(0)
+		, rows(0) {
+	}
+};
+
 class MapRenderer : public Map {
 private:
 
@@ -53,15 +93,17 @@ private:
 
 	bool enemyGroupPlaceEnemy(float x, float y, Map_Group &g);
 	void pushEnemyGroup(Map_Group &g);
+	void preloadAssets();
 
 	std::string played_music_filename;
 
 	void clearQueues();
 
-	// When the animated tiles are switched off, the background is
-	// not rendered all the time but everytime you have moved away too much.
-	// then the background is completely rendered, else it is just blit
-	// onto screen. units in tiles:
+	// The layers below the object layer are composited into a background
+	// cache, which reaches this far beyond each edge of the screen. Within
+	// that distance the camera can move without painting anything; beyond
+	// it the cache is scrolled and only the exposed edges are painted.
+	// units in tiles:
 	static const short movedistance_to_rerender = 4;
 
 
@@ -70,7 +112,7 @@ private:
 
 	void drawRenderable(std::vector<Renderable>::iterator r_cursor);
 
-	void renderIsoLayer(const unsigned short layerdata[][256]);
+	void renderIsoLayer(const Map_Layer &layerdata);
 
 	// renders only objects
 	void renderIsoBackObjects(std::vector<Renderable> &r);
@@ -79,18 +121,93 @@ private:
 	void renderIsoFrontObjects(std::vector<Renderable> &r);
 	void renderIso(std::vector<Renderable> &r, std::vector<Renderable> &r_dead);
 
-	void renderOrthoLayer(const unsigned short layerdata[][256]);
+	void renderOrthoLayer(const Map_Layer &layerdata);
 	void renderOrthoBackObjects(std::vector<Renderable> &r);
 	void renderOrthoFrontObjects(std::vector<Renderable> &r);
 	void renderOrtho(std::vector<Renderable> &r, std::vector<Renderable> &r_dead);
 
 	void clearLayers();
+	void renderLayer(unsigned index);
+	void updateViewArea();
+
+	// background cache
+	bool renderBackground();
+	void scrollBackground(const Rect& area);
+	void repaintAnimatedBackground();
+	void paintBackground(const Rect& region);
+	void invalidateBackground(const Rect& region);
+	void findAnimatedBackgroundTiles(const Rect& region);
+	void clearBackground();
+
+	// pre-rendered layer chunks
+	void initChunks();
+	void clearChunks();
+	void dropChunks(unsigned index, const Rect& region);
+	bool prepareChunks(unsigned index, const Rect& region);
+	bool bakeChunk(unsigned index, unsigned chunk);
+	bool evictChunk();
+	bool renderChunks(unsigned index);
+	bool blitChunks(unsigned index, Image *target, const Point& target_pos, const Rect& region);
+	void getChunkRange(const Map_ChunkLayer& chunk_layer, const Rect& region, int& x0, int& y0, int& x1, int& y1);
+	Rect getChunkRect(const Map_ChunkLayer& chunk_layer, unsigned chunk);
+
+	int paintLayer(unsigned index, Image *target, const Point& target_pos, const Rect& region, bool target_is_transparent);
+	void paintTile(unsigned short tile_id, int i, int j, Image *target, const Point& target_pos, const Rect& region, bool target_is_transparent);
+	Rect getTileRect(unsigned short tile_id, int i, int j);
+	Rect getAreaRect(const Rect& tiles);
+	Rect getTileRange(const Rect& region);
+	Point mapPixel(int i, int j);
+
+	// streamed map regions
+	void clearRegions();
+	void activateRegion(MapRegion *region);
+	void commitRegion(MapRegion *region);
+	void unloadRegion(MapRegion *region);
+	MapRegion *getRegionAt(int x, int y);
+	int getRegionDistance(const MapRegion *region, const FPoint& pos);
 
 	void createTooltip(Event_Component *ec);
 
 	FPoint shakycam;
+	FPoint shakycam_offset;
 	TileSet tset;
 
+	// cached background and a second buffer to scroll it into.
+	// background_area is the part of the map they cover, in pixels relative
+	// to the center of tile (0,0)
+	Sprite *background;
+	Sprite *background_scroll;
+	Rect background_area;
+	bool background_valid;
+
+	// the part of the map whose tiles changed since the cache was painted, in map pixels
+	Rect background_dirty;
+
+	// map positions of animated tiles below the object layer which reach into
+	// background_area, and the frame each animation was at when it was last
+	// painted into the cache
+	std::vector<Point> background_anim_tiles;
+	std::vector<unsigned short> background_anim_frames;
+
+	// the part of the map visible on screen this frame, in map pixels
+	Rect view_area;
+
+	// pre-rendered chunks of each layer. chunk_limit is the number of chunks
+	// which fit into the memory budget, chunk_count the number currently baked.
+	// chunk_frame counts rendered frames, to evict the least recently used chunk.
+	std::vector<Map_ChunkLayer> chunk_layers;
+	int chunk_size;
+	int chunk_limit;
+	int chunk_count;
+	unsigned chunk_frame;
+
+	// the regions of a streamed map, in the order of the map file
+	std::vector<MapRegion*> map_regions;
+	MapRegionLoader region_loader;
+
+	// the collision layer of the map file, from loadMapFile() until loadCollision()
+	Map_Layer *loading_collision;
+
 public:
 	// functions
 	MapRenderer();
@@ -100,6 +217,15 @@ public:
 
 	int load(std::string filename);
 	void logic();
+
+	// the steps of load(), in order. They can be run on separate frames,
+	// see GameStatePlay::updateLoading()
+	void loadMapFile(const std::string& filename);
+	void loadAssets();
+	void loadTileset();
+	void loadCollision();
+	void loadChunks();
+
 	void render(std::vector<Renderable> &r, std::vector<Renderable> &r_dead);
 
 	void checkEvents(FPoint loc);
@@ -119,6 +245,9 @@ public:
 
 	MapCollision collider;
 
+	// searches paths on a copy of the collider in the background
+	PathService path_service;
+
 	// event-created loot or items
 	std::vector<Event_Component> loot;
 
@@ -157,6 +286,14 @@ public:
 	// force a rendering of the background in the next render step.
 	bool repaint_background;
 
+	// change a tile of a visible layer, e.g. by a mapmod event
+	void modifyTile(unsigned index, int x, int y, unsigned short tile_id);
+	void modifyCollision(int x, int y, unsigned short value);
+
+	// load and unload the regions of a streamed map around the camera
+	void streamRegions();
+	bool allRegionsVisited();
+
 	/**
 	 * The index of the layer, which mixes with the objects on screen. Layers
 	 * before that are painted below objects; Layers after are painted on top.
@@ -0,0 +1,149 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+
+#include "MappedFile.h"
+
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+	: data(NULL)
+	, size(0)
+	, mapped(false)
+	, owned(false)
+#ifdef _WIN32
+	, file(INVALID_HANDLE_VALUE)
+	, mapping(NULL)
+#endif
+{
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+/**
+ * Map a file into memory. Empty files can't be mapped, they are opened
+ * without any data instead.
+ */
+bool MappedFile::open(const std::string &path) {
+	close();
+
+#ifdef _WIN32
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	const DWORD file_size = GetFileSize(file, NULL);
+	if (file_size == INVALID_FILE_SIZE) {
+		close();
+		return false;
+	}
+	if (file_size == 0) {
+		close();
+		return true;
+	}
+
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping)
+		data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!data) {
+		close();
+		return false;
+	}
+	size = file_size;
+	mapped = true;
+#else
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < 0) {
+		::close(fd);
+		return false;
+	}
+	if (st.st_size == 0) {
+		::close(fd);
+		return true;
+	}
+
+	void *mem = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// the mapping stays valid after the descriptor is closed
+	::close(fd);
+	if (mem == MAP_FAILED)
+		return false;
+
+	data = static_cast<const unsigned char*>(mem);
+	size = st.st_size;
+	mapped = true;
+#endif
+
+	return true;
+}
+
+/**
+ * Use data which is already in memory. Unless owned is set, it must stay
+ * valid until the file is closed.
+ */
+void MappedFile::openMemory(const unsigned char *_data, size_t _size, bool _owned) {
+	close();
+
+	data = _data;
+	size = _size;
+	owned = _owned;
+}
+
+void MappedFile::close() {
+	if (owned) {
+		free(const_cast<unsigned char*>(data));
+	}
+	else if (mapped) {
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+#else
+		munmap(const_cast<unsigned char*>(data), size);
+#endif
+	}
+#ifdef _WIN32
+	if (mapping) CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+	mapping = NULL;
+	file = INVALID_HANDLE_VALUE;
+#endif
+	data = NULL;
+	size = 0;
+	mapped = false;
+	owned = false;
+}
+
+const unsigned char *MappedFile::getData() const {
+	return data;
+}
+
+size_t MappedFile::getSize() const {
+	return size;
+}
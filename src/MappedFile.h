@@ -0,0 +1,61 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+
+/**
+ * class MappedFile
+ *
+ * Read-only view of a whole file. The file is memory mapped where the
+ * platform supports it, so its contents are paged in on demand and can be
+ * used in place instead of being copied into buffers first.
+ * It can also hold data that's already in memory, like a file unpacked from a
+ * mod archive.
+ */
+
+#pragma once
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include "CommonIncludes.h"
+
+class MappedFile {
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool open(const std::string &path);
+	void openMemory(const unsigned char *_data, size_t _size, bool _owned);
+	void close();
+
+	const unsigned char *getData() const;
+	size_t getSize() const;
+
+private:
+	MappedFile(const MappedFile &copy); // not implemented
+
+	const unsigned char *data;
+	size_t size;
+	bool mapped;
+	bool owned; // data was allocated with malloc and is freed on close
+
+#ifdef _WIN32
+	void *file;
+	void *mapping;
+#endif
+};
+
+#endif
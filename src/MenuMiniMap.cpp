@@ -35,13 +35,16 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 using namespace std;
 
+// the map surface is never smaller than this, so small maps don't need a new one
+const int MINIMAP_MIN_SIZE = 512;
+
 MenuMiniMap::MenuMiniMap()
 	: color_wall(0)
 	, color_obst(0)
 	, color_hero(0)
 	, map_surface(NULL) {
 
-	createMapSurface();
+	createMapSurface(MINIMAP_MIN_SIZE, MINIMAP_MIN_SIZE);
 	if (map_surface) {
 		color_wall = map_surface->getGraphics()->MapRGB(128,128,128);
 		color_obst = map_surface->getGraphics()->MapRGB(64,64,64);
@@ -78,14 +81,14 @@ void MenuMiniMap::getMapTitle(std::string map_title) {
 	label->set(window_area.x+text_pos.x, window_area.y+text_pos.y, text_pos.justify, text_pos.valign, map_title, font->getColor("menu_normal"), text_pos.font_style);
 }
 
-void MenuMiniMap::createMapSurface() {
+void MenuMiniMap::createMapSurface(int w, int h) {
 	if (map_surface) {
 		delete map_surface;
 		map_surface = NULL;
 	}
 
 	Image *graphics;
-	graphics = render_device->createImage(512, 512);
+	graphics = render_device->createImage(w, h);
 	if (graphics) {
 		map_surface = graphics->createSprite();
 		graphics->unref();
@@ -111,6 +114,20 @@ void MenuMiniMap::prerender(MapCollision *collider, int map_w, int map_h) {
 
 	map_size.x = map_w;
 	map_size.y = map_h;
+
+	// one pixel per tile; isometric maps take 2x1 pixels per tile and are rotated 45 degrees
+	int surface_w = map_w;
+	int surface_h = map_h;
+	if (TILESET_ORIENTATION == TILESET_ISOMETRIC)
+		surface_w = surface_h = 2 * std::max(map_w, map_h);
+	surface_w = std::max(surface_w, MINIMAP_MIN_SIZE);
+	surface_h = std::max(surface_h, MINIMAP_MIN_SIZE);
+
+	if (surface_w > map_surface->getGraphicsWidth() || surface_h > map_surface->getGraphicsHeight()) {
+		createMapSurface(surface_w, surface_h);
+		if (!map_surface) return;
+	}
+
 	map_surface->getGraphics()->fillWithColor(NULL, map_surface->getGraphics()->MapRGBA(0,0,0,0));
 
 	if (TILESET_ORIENTATION == TILESET_ISOMETRIC)
@@ -191,10 +208,10 @@ void MenuMiniMap::renderIso(FPoint hero_pos) {
 void MenuMiniMap::prerenderOrtho(MapCollision *collider) {
 	for (int i=0; i<std::min(map_surface->getGraphicsWidth(), map_size.x); i++) {
 		for (int j=0; j<std::min(map_surface->getGraphicsHeight(), map_size.y); j++) {
-			if (collider->colmap[i][j] == 1 || collider->colmap[i][j] == 5) {
+			if (collider->colmap.get(i, j) == 1 || collider->colmap.get(i, j) == 5) {
 				map_surface->getGraphics()->drawPixel(i, j, color_wall);
 			}
-			else if (collider->colmap[i][j] == 2 || collider->colmap[i][j] == 6) {
+			else if (collider->colmap.get(i, j) == 2 || collider->colmap.get(i, j) == 6) {
 				map_surface->getGraphics()->drawPixel(i, j, color_obst);
 			}
 		}
@@ -221,7 +238,7 @@ void MenuMiniMap::prerenderIso(MapCollision *collider) {
 			// if this tile is the max map size
 			if (tile_cursor.x >= 0 && tile_cursor.y >= 0 && tile_cursor.x < map_size.x && tile_cursor.y < map_size.y) {
 
-				tile_type = collider->colmap[tile_cursor.x][tile_cursor.y];
+				tile_type = collider->colmap.get(tile_cursor.x, tile_cursor.y);
 				bool draw_tile = true;
 
 				// walls and low obstacles show as different colors
@@ -44,7 +44,7 @@ private:
 	LabelInfo text_pos;
 	WidgetLabel *label;
 
-	void createMapSurface();
+	void createMapSurface(int w, int h);
 	void renderIso(FPoint hero_pos);
 	void renderOrtho(FPoint hero_pos);
 	void prerenderOrtho(MapCollision *collider);
@@ -136,7 +136,7 @@ void MenuTalker::logic() {
 
 	// determine active button
 	if (event_cursor < npc->dialog[dialog_node].size()-1) {
-		if (npc->dialog[dialog_node][event_cursor+1].type != "") {
+		if (npc->dialog[dialog_node][event_cursor+1].type != SID_NONE) {
 			advanceButton->enabled = true;
 			tablist.remove(closeButton);
 			tablist.add(advanceButton);
@@ -196,13 +196,13 @@ void MenuTalker::createBuffer() {
 	string line;
 
 	// speaker name
-	string etype = npc->dialog[dialog_node][event_cursor].type;
+	StringID etype = npc->dialog[dialog_node][event_cursor].type;
 	string who;
 
-	if (etype == "him" || etype == "her") {
+	if (etype == SID_HIM || etype == SID_HER) {
 		who = npc->name;
 	}
-	else if (etype == "you") {
+	else if (etype == SID_YOU) {
 		who = hero_name;
 	}
 
@@ -248,8 +248,8 @@ void MenuTalker::render() {
 	Menu::render();
 
 	// show active portrait
-	string etype = npc->dialog[dialog_node][event_cursor].type;
-	if (etype == "him" || etype == "her") {
+	StringID etype = npc->dialog[dialog_node][event_cursor].type;
+	if (etype == SID_HIM || etype == SID_HER) {
 		Sprite *r = npc->portrait;
 		if (r) {
 			src.w = dest.w = portrait_he.w;
@@ -262,7 +262,7 @@ void MenuTalker::render() {
 			render_device->render(r);
 		}
 	}
-	else if (etype == "you") {
+	else if (etype == SID_YOU) {
 		if (portrait) {
 			src.w = dest.w = portrait_you.w;
 			src.h = dest.h = portrait_you.h;
@@ -280,7 +280,7 @@ void MenuTalker::render() {
 
 	// show advance button if there are more event components, or close button if not
 	if (event_cursor < npc->dialog[dialog_node].size()-1) {
-		if (npc->dialog[dialog_node][event_cursor+1].type != "") {
+		if (npc->dialog[dialog_node][event_cursor+1].type != SID_NONE) {
 			advanceButton->render();
 		}
 		else {
@@ -33,31 +33,58 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 using namespace std;
 
 MessageEngine::MessageEngine() {
-	GetText infile;
+	load("languages/engine." + LANGUAGE + ".po");
+	load("languages/data." + LANGUAGE + ".po");
+}
 
-	vector<string> engineFiles = mods->list("languages/engine." + LANGUAGE + ".po");
-	if (engineFiles.size() == 0 && LANGUAGE != "en")
-		fprintf(stderr, "Unable to open basic translation files located in languages/engine.%s.po\n", LANGUAGE.c_str());
+/**
+ * Add the translations of all mods for one .po file. They are kept in the
+ * data cache, so they only have to be parsed again after a change.
+ */
+void MessageEngine::load(const string& filename) {
+	vector<string> files = mods->list(filename);
+	if (files.size() == 0) {
+		if (LANGUAGE != "en")
+			fprintf(stderr, "Unable to open basic translation files located in %s\n", filename.c_str());
+		return;
+	}
 
-	for (unsigned i = 0; i < engineFiles.size(); ++i) {
-		if (infile.open(engineFiles[i])) {
-			while (infile.next() && !infile.fuzzy)
-				messages.insert(pair<string,string>(infile.key, infile.val));
-			infile.close();
-		}
+	const vector<DataCacheEntry> *cached = data_cache ? data_cache->find(filename, files) : NULL;
+	if (cached) {
+		for (unsigned i = 0; i < cached->size(); ++i)
+			messages.insert(pair<string,string>((*cached)[i].key, (*cached)[i].val));
+		return;
 	}
 
-	vector<string> dataFiles = mods->list("languages/data." + LANGUAGE + ".po");
-	if (dataFiles.size() == 0 && LANGUAGE != "en")
-		fprintf(stderr, "Unable to open basic translation files located in languages/data.%s.po\n", LANGUAGE.c_str());
+	GetText infile;
+	vector<DataCacheEntry> entries;
 
-	for (unsigned i = 0; i < dataFiles.size(); ++i) {
-		if (infile.open(dataFiles[i])) {
-			while (infile.next() && !infile.fuzzy)
+	for (unsigned i = 0; i < files.size(); ++i) {
+		if (infile.open(files[i])) {
+			while (infile.next() && !infile.fuzzy) {
 				messages.insert(pair<string,string>(infile.key, infile.val));
+
+				entries.push_back(DataCacheEntry());
+				entries.back().file = i;
+				entries.back().key = infile.key;
+				entries.back().val = infile.val;
+			}
 			infile.close();
 		}
 	}
+
+	if (data_cache)
+		data_cache->store(filename, files, entries);
+}
+
+/**
+ * Find the translation of key, or an empty string.
+ * This doesn't modify the table, so maps can be parsed on a loader thread.
+ */
+string MessageEngine::lookup(const string& key) const {
+	map<string,string>::const_iterator it = messages.find(key);
+	if (it == messages.end()) return "";
+	return it->second;
 }
 
 /*
@@ -65,13 +92,13 @@ MessageEngine::MessageEngine() {
  * They differ only on which variables they replace in the string - strings replace %s, integers replace %d
  */
 string MessageEngine::get(const string& key) {
-	string message = messages[key];
+	string message = lookup(key);
 	if (message == "") message = key;
 	return unescape(message);
 }
 
 string MessageEngine::get(const string& key, int i) {
-	string message = messages[key];
+	string message = lookup(key);
 	if (message == "") message = key;
 	size_t index = message.find("%d");
 	if (index != string::npos) message = message.replace(index, 2, str(i));
@@ -79,7 +106,7 @@ string MessageEngine::get(const string& key, int i) {
 }
 
 string MessageEngine::get(const string& key, const string& s) {
-	string message = messages[key];
+	string message = lookup(key);
 	if (message == "") message = key;
 	size_t index = message.find("%s");
 	if (index != string::npos) message = message.replace(index, 2, s);
@@ -87,7 +114,7 @@ string MessageEngine::get(const string& key, const string& s) {
 }
 
 string MessageEngine::get(const string& key, int i, const string& s) {
-	string message = messages[key];
+	string message = lookup(key);
 	if (message == "") message = key;
 	size_t index = message.find("%d");
 	if (index != string::npos) message = message.replace(index, 2, str(i));
@@ -97,7 +124,7 @@ string MessageEngine::get(const string& key, int i, const string& s) {
 }
 
 string MessageEngine::get(const string& key, int i, int j) {
-	string message = messages[key];
+	string message = lookup(key);
 	if (message == "") message = key;
 	size_t index = message.find("%d");
 	if (index != string::npos) message = message.replace(index, 2, str(i));
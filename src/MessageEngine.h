@@ -36,6 +36,8 @@ class MessageEngine {
 
 private:
 	std::map<std::string,std::string> messages;
+	void load(const std::string& filename);
+	std::string lookup(const std::string& key) const;
 	std::string str(int i);
 	std::string unescape(std::string msg);
 public:
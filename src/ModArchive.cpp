@@ -0,0 +1,418 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ModArchive.h"
+#include "UtilsFileSystem.h"
+
+ModArchive::ModArchive()
+	: entry_count(0)
+	, entries(NULL)
+	, strings(NULL)
+	, strings_size(0)
+	, modified(0) {
+}
+
+static void writeUint32(std::vector<unsigned char> &buf, uint32_t value) {
+	buf.push_back(static_cast<unsigned char>(value & 0xff));
+	buf.push_back(static_cast<unsigned char>((value >> 8) & 0xff));
+	buf.push_back(static_cast<unsigned char>((value >> 16) & 0xff));
+	buf.push_back(static_cast<unsigned char>((value >> 24) & 0xff));
+}
+
+static void writeLZ4Length(std::vector<unsigned char> &buf, size_t length) {
+	while (length >= 255) {
+		buf.push_back(255);
+		length -= 255;
+	}
+	buf.push_back(static_cast<unsigned char>(length));
+}
+
+static void writeLZ4Sequence(std::vector<unsigned char> &buf, const unsigned char *literals, size_t literal_length, size_t offset, size_t match_length) {
+	const size_t match_code = match_length - 4;
+	buf.push_back(static_cast<unsigned char>(((literal_length < 15 ? literal_length : 15) << 4) | (match_code < 15 ? match_code : 15)));
+	if (literal_length >= 15)
+		writeLZ4Length(buf, literal_length - 15);
+	buf.insert(buf.end(), literals, literals + literal_length);
+
+	buf.push_back(static_cast<unsigned char>(offset & 0xff));
+	buf.push_back(static_cast<unsigned char>(offset >> 8));
+	if (match_code >= 15)
+		writeLZ4Length(buf, match_code - 15);
+}
+
+/**
+ * Compress data into a LZ4 block. This is a simple greedy compressor, which
+ * is good enough for the text files that make up most of a mod.
+ */
+static void compressLZ4(const unsigned char *src, size_t size, std::vector<unsigned char> &buf) {
+	// the format requires the last 5 bytes to be literals, and the last match to start 12 bytes before the end
+	const size_t MIN_MATCH = 4;
+	const size_t LAST_LITERALS = 5;
+	const size_t MATCH_START_LIMIT = 12;
+	const size_t MAX_OFFSET = 65535;
+	const size_t HASH_BITS = 16;
+
+	std::vector<size_t> table(1 << HASH_BITS, size);
+	size_t anchor = 0;
+	size_t pos = 0;
+
+	while (size >= MATCH_START_LIMIT && pos <= size - MATCH_START_LIMIT) {
+		uint32_t sequence;
+		memcpy(&sequence, src + pos, MIN_MATCH);
+		const uint32_t hash = (sequence * 2654435761u) >> (32 - HASH_BITS);
+
+		const size_t ref = table[hash];
+		table[hash] = pos;
+
+		if (ref == size || pos - ref > MAX_OFFSET || memcmp(src + ref, src + pos, MIN_MATCH) != 0) {
+			pos++;
+			continue;
+		}
+
+		size_t length = MIN_MATCH;
+		while (pos + length < size - LAST_LITERALS && src[ref + length] == src[pos + length])
+			length++;
+
+		writeLZ4Sequence(buf, src + anchor, pos - anchor, pos - ref, length);
+		pos += length;
+		anchor = pos;
+	}
+
+	// the last sequence only has literals
+	const size_t literal_length = size - anchor;
+	buf.push_back(static_cast<unsigned char>((literal_length < 15 ? literal_length : 15) << 4));
+	if (literal_length >= 15)
+		writeLZ4Length(buf, literal_length - 15);
+	buf.insert(buf.end(), src + anchor, src + size);
+}
+
+static bool readLZ4Length(const unsigned char *&src, const unsigned char *src_end, size_t &length) {
+	unsigned char byte;
+	do {
+		if (src >= src_end)
+			return false;
+		byte = *src++;
+		length += byte;
+	} while (byte == 255);
+	return true;
+}
+
+/**
+ * Decompress a LZ4 block into a buffer of exactly the original size.
+ * Damaged data is detected rather than read or written out of bounds.
+ */
+static bool decompressLZ4(const unsigned char *src, size_t src_size, unsigned char *dest, size_t dest_size) {
+	const unsigned char *src_end = src + src_size;
+	unsigned char *out = dest;
+	unsigned char *out_end = dest + dest_size;
+
+	while (src < src_end) {
+		const unsigned token = *src++;
+
+		size_t length = token >> 4;
+		if (length == 15 && !readLZ4Length(src, src_end, length))
+			return false;
+		if (length > static_cast<size_t>(src_end - src) || length > static_cast<size_t>(out_end - out))
+			return false;
+		memcpy(out, src, length);
+		out += length;
+		src += length;
+
+		// the last sequence has no match
+		if (src == src_end)
+			break;
+
+		if (src_end - src < 2)
+			return false;
+		const size_t offset = src[0] | (src[1] << 8);
+		src += 2;
+		if (offset == 0 || offset > static_cast<size_t>(out - dest))
+			return false;
+
+		length = token & 15;
+		if (length == 15 && !readLZ4Length(src, src_end, length))
+			return false;
+		length += 4;
+		if (length > static_cast<size_t>(out_end - out))
+			return false;
+
+		// the match may overlap the bytes it produces, so copy byte by byte
+		const unsigned char *match = out - offset;
+		for (size_t i = 0; i < length; ++i)
+			out[i] = match[i];
+		out += length;
+	}
+
+	return out == out_end;
+}
+
+/**
+ * Pack all files below mod_path into an archive at dest_path. With compress,
+ * files are stored LZ4 compressed where that makes them smaller.
+ */
+bool ModArchive::create(const std::string &mod_path, const std::string &dest_path, bool compress) {
+	std::vector<std::string> filenames;
+	getFileListRecursive(mod_path, filenames);
+	std::sort(filenames.begin(), filenames.end());
+
+	std::vector<unsigned char> data;
+	std::vector<unsigned char> entry_data;
+	std::vector<char> string_data;
+	std::vector<unsigned char> packed;
+	MappedFile infile;
+
+	for (unsigned i = 0; i < filenames.size(); ++i) {
+		if (!infile.open(mod_path + "/" + filenames[i])) {
+			fprintf(stderr, "Could not read %s/%s\n", mod_path.c_str(), filenames[i].c_str());
+			return false;
+		}
+
+		const unsigned char *contents = infile.getData();
+		const size_t size = infile.getSize();
+		uint32_t flags = 0;
+
+		packed.clear();
+		if (compress && size > 0) {
+			compressLZ4(contents, size, packed);
+			if (packed.size() < size) {
+				contents = &packed[0];
+				flags |= ENTRY_LZ4;
+			}
+		}
+		const size_t stored_size = (flags & ENTRY_LZ4) ? packed.size() : size;
+
+		if (data.size() + stored_size > 0xffffffffu - HEADER_SIZE) {
+			fprintf(stderr, "%s is too large for a mod archive\n", mod_path.c_str());
+			return false;
+		}
+
+		writeUint32(entry_data, static_cast<uint32_t>(string_data.size()));
+		writeUint32(entry_data, static_cast<uint32_t>(HEADER_SIZE + data.size()));
+		writeUint32(entry_data, static_cast<uint32_t>(stored_size));
+		writeUint32(entry_data, static_cast<uint32_t>(size));
+		writeUint32(entry_data, flags);
+
+		data.insert(data.end(), contents, contents + stored_size);
+		string_data.insert(string_data.end(), filenames[i].begin(), filenames[i].end());
+		string_data.push_back('\0');
+
+		infile.close();
+	}
+
+	if (string_data.empty())
+		string_data.push_back('\0');
+
+	const uint32_t entries_offset = static_cast<uint32_t>(HEADER_SIZE + data.size());
+	const uint32_t strings_offset = static_cast<uint32_t>(entries_offset + entry_data.size());
+
+	std::vector<unsigned char> buf;
+	buf.insert(buf.end(), "FLAREPAK", "FLAREPAK" + 8);
+	writeUint32(buf, VERSION);
+	writeUint32(buf, static_cast<uint32_t>(filenames.size()));
+	writeUint32(buf, entries_offset);
+	writeUint32(buf, strings_offset);
+	writeUint32(buf, static_cast<uint32_t>(string_data.size()));
+
+	std::ofstream outfile(dest_path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!outfile.is_open()) {
+		fprintf(stderr, "Could not write mod archive %s\n", dest_path.c_str());
+		return false;
+	}
+	outfile.write(reinterpret_cast<const char*>(&buf[0]), buf.size());
+	if (!data.empty())
+		outfile.write(reinterpret_cast<const char*>(&data[0]), data.size());
+	if (!entry_data.empty())
+		outfile.write(reinterpret_cast<const char*>(&entry_data[0]), entry_data.size());
+	outfile.write(&string_data[0], string_data.size());
+	outfile.close();
+	return !outfile.fail();
+}
+
+/**
+ * Map an archive and check that all tables and entries are inside the file
+ */
+bool ModArchive::open(const std::string &path) {
+	if (!file.open(path))
+		return false;
+
+	const unsigned char *data = file.getData();
+	const size_t size = file.getSize();
+
+	if (size < HEADER_SIZE || memcmp(data, "FLAREPAK", 8) != 0 || readUint32(data + 8) != VERSION) {
+		fprintf(stderr, "%s is not a mod archive of this version, ignoring it.\n", path.c_str());
+		file.close();
+		return false;
+	}
+
+	entry_count = readUint32(data + 12);
+	const uint32_t entries_offset = readUint32(data + 16);
+	const uint32_t strings_offset = readUint32(data + 20);
+	strings_size = readUint32(data + 24);
+
+	bool damaged = entries_offset > size || entry_count > (size - entries_offset) / ENTRY_SIZE ||
+			strings_offset > size || strings_size == 0 || strings_size > size - strings_offset ||
+			data[strings_offset + strings_size - 1] != '\0';
+
+	for (unsigned i = 0; i < entry_count && !damaged; ++i) {
+		const unsigned char *entry = data + entries_offset + i * ENTRY_SIZE;
+		const uint32_t offset = readUint32(entry + 4);
+		const uint32_t stored_size = readUint32(entry + 8);
+		const uint32_t flags = readUint32(entry + 16);
+
+		damaged = readUint32(entry) >= strings_size || offset > size || stored_size > size - offset ||
+				(!(flags & ENTRY_LZ4) && stored_size != readUint32(entry + 12));
+	}
+
+	if (damaged) {
+		fprintf(stderr, "Mod archive %s is damaged, ignoring it.\n", path.c_str());
+		file.close();
+		entry_count = 0;
+		return false;
+	}
+
+	entries = data + entries_offset;
+	strings = reinterpret_cast<const char*>(data + strings_offset);
+	modified = getFileModifiedTime(path);
+	return true;
+}
+
+unsigned ModArchive::getEntryCount() const {
+	return entry_count;
+}
+
+/**
+ * Find an entry by its filename, or return -1. This checks each entry in turn,
+ * lookups which happen often should go through the ModManager index.
+ */
+int ModArchive::find(const std::string &filename) const {
+	for (unsigned i = 0; i < entry_count; ++i) {
+		if (filename == getName(i))
+			return static_cast<int>(i);
+	}
+	return -1;
+}
+
+const char *ModArchive::getName(unsigned index) const {
+	return strings + readUint32(entries + index * ENTRY_SIZE);
+}
+
+/**
+ * The size of an entry once it's unpacked
+ */
+size_t ModArchive::getSize(unsigned index) const {
+	return readUint32(entries + index * ENTRY_SIZE + 12);
+}
+
+/**
+ * Entries don't have their own modified time, they all share the archive's
+ */
+time_t ModArchive::getModifiedTime() const {
+	return modified;
+}
+
+/**
+ * Copy or decompress an entry into dest, which must hold getSize() bytes
+ */
+bool ModArchive::unpack(unsigned index, unsigned char *dest) const {
+	const unsigned char *entry = entries + index * ENTRY_SIZE;
+	const unsigned char *src = file.getData() + readUint32(entry + 4);
+	const size_t stored_size = readUint32(entry + 8);
+
+	if (readUint32(entry + 16) & ENTRY_LZ4) {
+		if (!decompressLZ4(src, stored_size, dest, getSize(index))) {
+			fprintf(stderr, "Damaged entry in mod archive: %s\n", getName(index));
+			return false;
+		}
+	}
+	else if (stored_size > 0) {
+		memcpy(dest, src, stored_size);
+	}
+	return true;
+}
+
+/**
+ * Give out the contents of an entry. Stored entries are read straight from
+ * the archive, compressed ones are decompressed into a buffer out owns.
+ * This doesn't change the archive, so it's safe on any thread.
+ */
+bool ModArchive::read(unsigned index, MappedFile &out) const {
+	const unsigned char *entry = entries + index * ENTRY_SIZE;
+	const size_t size = getSize(index);
+
+	if (!(readUint32(entry + 16) & ENTRY_LZ4) || size == 0) {
+		out.openMemory(file.getData() + readUint32(entry + 4), size, false);
+		return true;
+	}
+
+	unsigned char *buffer = static_cast<unsigned char*>(malloc(size));
+	if (!buffer || !unpack(index, buffer)) {
+		free(buffer);
+		return false;
+	}
+	out.openMemory(buffer, size, true);
+	return true;
+}
+
+/**
+ * Memory streams don't free their memory, so streams over a buffer of their
+ * own get this as their close function.
+ */
+static int SDLCALL closeBufferRW(SDL_RWops *rw) {
+	if (rw) {
+		free(rw->hidden.mem.base);
+		SDL_FreeRW(rw);
+	}
+	return 0;
+}
+
+/**
+ * Open an entry as a stream for the SDL loaders. With copy, the stream reads
+ * from its own copy of the entry, so it stays valid after the archive is
+ * closed. That's needed by streams which are read for as long as the loaded
+ * object lives, like music and fonts.
+ */
+SDL_RWops *ModArchive::openRW(unsigned index, bool copy) const {
+	const unsigned char *entry = entries + index * ENTRY_SIZE;
+	const size_t size = getSize(index);
+
+	if (!copy && !(readUint32(entry + 16) & ENTRY_LZ4))
+		return SDL_RWFromConstMem(file.getData() + readUint32(entry + 4), static_cast<int>(size));
+
+	// malloc(0) may return NULL, so always ask for at least one byte
+	unsigned char *buffer = static_cast<unsigned char*>(malloc(size > 0 ? size : 1));
+	if (!buffer || !unpack(index, buffer)) {
+		free(buffer);
+		return NULL;
+	}
+
+	SDL_RWops *rw = SDL_RWFromConstMem(buffer, static_cast<int>(size));
+	if (!rw) {
+		free(buffer);
+		return NULL;
+	}
+	rw->close = closeBufferRW;
+	return rw;
+}
+
+uint32_t ModArchive::readUint32(const unsigned char *p) {
+	return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+		   (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
@@ -0,0 +1,82 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class ModArchive
+ *
+ * A mod packed into a single file by flare_mod_packer, so installing and
+ * loading it doesn't touch thousands of small files. ModManager mounts the
+ * archive next to the loose mod folder. The archive is memory mapped. Stored
+ * entries are read in place, and compressed ones (LZ4 block format) are
+ * decompressed into their own buffer when they are opened.
+ *
+ * Layout, all numbers are little endian unsigned 32 bit integers:
+ *   header:  "FLAREPAK", version, entry count, entry offset, string offset,
+ *            string size
+ *   entries: name (string offset), data offset, stored size, size, flags
+ *   strings: zero terminated filenames, relative to the mod folder
+ * Entries flagged as ENTRY_LZ4 are compressed.
+ */
+
+#pragma once
+#ifndef MOD_ARCHIVE_H
+#define MOD_ARCHIVE_H
+
+#include "CommonIncludes.h"
+#include "MappedFile.h"
+
+#include <time.h>
+
+// a mod folder "mods/NAME" can also be installed as "mods/NAME" + MOD_ARCHIVE_EXTENSION
+const std::string MOD_ARCHIVE_EXTENSION = ".pak";
+
+class ModArchive {
+public:
+	ModArchive();
+
+	static bool create(const std::string &mod_path, const std::string &dest_path, bool compress);
+
+	bool open(const std::string &path);
+
+	unsigned getEntryCount() const;
+	int find(const std::string &filename) const;
+	const char *getName(unsigned index) const;
+	size_t getSize(unsigned index) const;
+	time_t getModifiedTime() const;
+
+	bool read(unsigned index, MappedFile &out) const;
+	SDL_RWops *openRW(unsigned index, bool copy) const;
+
+private:
+	static const unsigned VERSION = 1;
+	static const unsigned HEADER_SIZE = 28;
+	static const unsigned ENTRY_SIZE = 20;
+
+	static const unsigned ENTRY_LZ4 = 1;
+
+	static uint32_t readUint32(const unsigned char *p);
+	bool unpack(unsigned index, unsigned char *dest) const;
+
+	MappedFile file;
+	unsigned entry_count;
+	const unsigned char *entries;
+	const char *strings;
+	uint32_t strings_size;
+	time_t modified;
+};
+
+#endif
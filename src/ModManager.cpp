@@ -57,8 +57,56 @@ bool Mod::operator!= (const Mod &mod) const {
 	return !(*this == mod);
 }
 
-ModManager::ModManager() {
-	loc_cache.clear();
+ModFile::ModFile(int _layer, const std::string& _path, ModArchive *_archive, unsigned _entry)
+	: layer(_layer)
+	, path(_path)
+	, archive(_archive)
+	, entry(_entry) {
+}
+
+/**
+ * Add the names of the mod archives in a folder to a list of mods
+ */
+static void getArchiveList(const string& dir, vector<string>& names) {
+	vector<string> files;
+	getFileList(dir, MOD_ARCHIVE_EXTENSION, files);
+
+	for (unsigned i=0; i<files.size(); ++i) {
+		const size_t start = dir.length() + 1;
+		names.push_back(files[i].substr(start, files[i].length() - start - MOD_ARCHIVE_EXTENSION.length()));
+	}
+}
+
+/**
+ * Strip the parts of a relative filename that wouldn't change which file it
+ * refers to (leading "./", doubled and trailing slashes), so it can be looked up
+ * in the file index.
+ */
+static string normalizePath(const string& filename) {
+	string path;
+	path.reserve(filename.length());
+
+	size_t i = 0;
+	while (filename.compare(i, 2, "./") == 0)
+		i += 2;
+
+	for (; i < filename.length(); ++i) {
+		if (filename[i] == '/' && (path.empty() || path[path.length()-1] == '/'))
+			continue;
+		path += filename[i];
+	}
+	if (!path.empty() && path[path.length()-1] == '/')
+		path.erase(path.length()-1);
+
+	return path;
+}
+
+ModManager::ModManager()
+	: index_mutex(SDL_CreateMutex())
+#ifdef WATCH_MODS
+	, next_watch_ticks(0)
+#endif
+{
 	mod_dirs.clear();
 	mod_list.clear();
 	setPaths();
@@ -66,6 +114,8 @@ ModManager::ModManager() {
 	vector<string> mod_dirs_other;
 	getDirList(PATH_DATA + "mods", mod_dirs_other);
 	getDirList(PATH_USER + "mods", mod_dirs_other);
+	getArchiveList(PATH_DATA + "mods", mod_dirs_other);
+	getArchiveList(PATH_USER + "mods", mod_dirs_other);
 
 	for (unsigned i=0; i<mod_dirs_other.size(); ++i) {
 		if (find(mod_dirs.begin(), mod_dirs.end(), mod_dirs_other[i]) == mod_dirs.end())
@@ -146,77 +196,246 @@ void ModManager::loadModList() {
 }
 
 /**
- * Find the location (mod file name) for this data file.
- * Use private loc_cache to prevent excessive disk I/O
+ * Index the files of all active mods. Mods are searched in the same order as
+ * list() returns files, so the last copy of each file is the one that wins.
+ * The old index stays in use by other threads until the new one is complete.
  */
-string ModManager::locate(const string& filename) {
-	// if we have this location already cached, return it
-	if (loc_cache.find(filename) != loc_cache.end()) {
-		return loc_cache[filename];
-	}
+void ModManager::buildIndex() {
+	map<string, vector<ModFile> > new_index;
+	map<string, const ModFile*> new_packed;
+#ifdef WATCH_MODS
+	watched_dirs.clear();
+	watched_times.clear();
+#endif
+
+	int layer = 0;
+	vector<string> files;
+	vector<string> dirs;
 
-	// search through mods for the first instance of this filename
-	string test_path;
+	for (unsigned int i = 0; i < mod_list.size(); ++i) {
+		for (unsigned int j = mod_paths.size(); j > 0; j--) {
+			string mod_path = mod_paths[j-1] + "mods/" + mod_list[i].name;
+
+			// a packed mod comes before the mod folder, so loose files can replace parts of it
+			ModArchive *archive = getArchive(mod_path + MOD_ARCHIVE_EXTENSION);
+			if (archive) {
+				for (unsigned int k = 0; k < archive->getEntryCount(); ++k) {
+					const string filename = archive->getName(k);
+					new_index[filename].push_back(ModFile(layer, mod_path + MOD_ARCHIVE_EXTENSION + "/" + filename, archive, k));
+				}
+				layer++;
+			}
 
-	for (unsigned int i = mod_list.size(); i > 0; i--) {
-		for (unsigned int j = 0; j < mod_paths.size(); j++) {
-			test_path = mod_paths[j] + "mods/" + mod_list[i-1].name + "/" + filename;
-			if (fileExists(test_path)) {
-				loc_cache[filename] = test_path;
-				return test_path;
+			files.clear();
+			getFileListRecursive(mod_path, files, &dirs);
+			for (unsigned int k = 0; k < files.size(); ++k) {
+				new_index[files[k]].push_back(ModFile(layer, mod_path + "/" + files[k]));
 			}
+			layer++;
 		}
 	}
 
-	// all else failing, simply return the filename
-	return PATH_DATA + filename;
+	for (map<string, vector<ModFile> >::const_iterator it = new_index.begin(); it != new_index.end(); ++it) {
+		for (unsigned int i = 0; i < it->second.size(); ++i) {
+			if (it->second[i].archive)
+				new_packed[it->second[i].path] = &it->second[i];
+		}
+	}
+
+	// swapping keeps the elements where they are, so new_packed still points into the index
+	SDL_LockMutex(index_mutex);
+	file_index.swap(new_index);
+	packed_files.swap(new_packed);
+	SDL_UnlockMutex(index_mutex);
+
+#ifdef WATCH_MODS
+	watched_dirs.swap(dirs);
+	for (unsigned int i = 0; i < watched_dirs.size(); ++i) {
+		watched_times.push_back(getFileModifiedTime(watched_dirs[i]));
+	}
+#endif
 }
 
-void amendPathToVector(const string &path, std::vector<std::string> &vec) {
-	if (pathExists(path)) {
-		if (isDirectory(path)) {
-			getFileList(path, "txt", vec);
+#ifdef WATCH_MODS
+void ModManager::checkForChanges() {
+	int now_ticks = SDL_GetTicks();
+	if (now_ticks < next_watch_ticks)
+		return;
+	next_watch_ticks = now_ticks + 1000;
+
+	// adding, removing or renaming a file changes the modified time of its folder
+	for (unsigned int i = 0; i < watched_dirs.size(); ++i) {
+		if (getFileModifiedTime(watched_dirs[i]) != watched_times[i]) {
+			printf("ModManager: \"%s\" changed, indexing mods again\n", watched_dirs[i].c_str());
+			buildIndex();
+			return;
 		}
-		else {
-			vec.push_back(path);
+	}
+}
+#endif
+
+/**
+ * Mount the archive at path, if there is one. Archives stay mounted until
+ * the ModManager is deleted.
+ */
+ModArchive *ModManager::getArchive(const string& path) {
+	map<string, ModArchive*>::iterator it = archives.find(path);
+	if (it != archives.end())
+		return it->second;
+
+	ModArchive *archive = NULL;
+	if (pathExists(path)) {
+		archive = new ModArchive();
+		if (!archive->open(path)) {
+			delete archive;
+			archive = NULL;
 		}
 	}
+	archives[path] = archive;
+	return archive;
+}
+
+/**
+ * Find the archive entry of a file returned by locate() or list(), if it is in a mod archive.
+ * Archives stay mounted, so they can be read after the index is unlocked.
+ */
+bool ModManager::findPacked(const string& path, ModArchive *&archive, unsigned &entry) {
+	bool found = false;
+
+	SDL_LockMutex(index_mutex);
+	map<string, const ModFile*>::const_iterator it = packed_files.find(path);
+	if (it != packed_files.end()) {
+		archive = it->second->archive;
+		entry = it->second->entry;
+		found = true;
+	}
+	SDL_UnlockMutex(index_mutex);
+
+	return found;
+}
+
+/**
+ * Find the location (mod file name) for this data file.
+ */
+string ModManager::locate(const string& filename) {
+	string path;
+
+	SDL_LockMutex(index_mutex);
+	map<string, vector<ModFile> >::const_iterator it = file_index.find(normalizePath(filename));
+	if (it != file_index.end())
+		path = it->second.back().path;
+	SDL_UnlockMutex(index_mutex);
+
+	if (!path.empty())
+		return path;
+
+	// all else failing, simply return the filename
+	return PATH_DATA + filename;
 }
 
 vector<string> ModManager::list(const string &path, bool full_paths) {
 	vector<string> ret;
-	string test_path;
+	string key = normalizePath(path);
 
-	for (unsigned int i = 0; i < mod_list.size(); ++i) {
-		for (unsigned int j = mod_paths.size(); j > 0; j--) {
-			test_path = mod_paths[j-1] + "mods/" + mod_list[i].name + "/" + path;
-			amendPathToVector(test_path, ret);
+	SDL_LockMutex(index_mutex);
+
+	// a single file
+	map<string, vector<ModFile> >::const_iterator it = file_index.find(key);
+	if (it != file_index.end()) {
+		if (!full_paths) {
+			ret.push_back(key);
+		}
+		else {
+			for (unsigned int i = 0; i < it->second.size(); ++i) {
+				ret.push_back(it->second[i].path);
+			}
 		}
+		SDL_UnlockMutex(index_mutex);
+		return ret;
 	}
 
-	// we don't need to check for duplicates if there are no paths
-	if (ret.empty()) return ret;
+	// the .txt files in a folder, from the mod with the lowest priority to the one with the highest.
+	// The index is sorted by filename, so the files of each mod are in alphabetical order.
+	vector<pair<int, string> > found;
+	string prefix = key + "/";
 
-	if (!full_paths) {
-		// reduce the each file path down to be relative to mods/
-		for (unsigned i=0; i<ret.size(); ++i) {
-			ret[i] = ret[i].substr(ret[i].rfind(path), ret[i].length());
-		}
+	for (it = file_index.lower_bound(prefix); it != file_index.end() && it->first.compare(0, prefix.length(), prefix) == 0; ++it) {
+		const string &filename = it->first;
 
-		// remove duplicates
-		for (unsigned i = 0; i < ret.size(); ++i) {
-			for (unsigned j = 0; j < i; ++j) {
-				if (ret[i] == ret[j]) {
-					ret.erase(ret.begin()+j);
-					break;
-				}
+		// skip files in subfolders
+		if (filename.find('/', prefix.length()) != string::npos)
+			continue;
+
+		if (filename.length() <= prefix.length() + 3 || filename.compare(filename.length() - 3, 3, "txt") != 0)
+			continue;
+
+		if (full_paths) {
+			for (unsigned int i = 0; i < it->second.size(); ++i) {
+				found.push_back(pair<int, string>(it->second[i].layer, it->second[i].path));
 			}
 		}
+		else {
+			// a file that's overridden is listed where its last copy is
+			found.push_back(pair<int, string>(it->second.back().layer, filename));
+		}
+	}
+
+	SDL_UnlockMutex(index_mutex);
+
+	sort(found.begin(), found.end());
+
+	ret.reserve(found.size());
+	for (unsigned int i = 0; i < found.size(); ++i) {
+		ret.push_back(found[i].second);
 	}
 
 	return ret;
 }
 
+bool ModManager::exists(const string& filename) {
+	SDL_LockMutex(index_mutex);
+	bool indexed = file_index.find(normalizePath(filename)) != file_index.end();
+	SDL_UnlockMutex(index_mutex);
+
+	return indexed || fileExists(PATH_DATA + filename);
+}
+
+bool ModManager::openFile(const string& path, MappedFile& file) {
+	ModArchive *archive;
+	unsigned entry;
+	if (findPacked(path, archive, entry))
+		return archive->read(entry, file);
+
+	return file.open(path);
+}
+
+SDL_RWops* ModManager::openRW(const string& path, bool copy) {
+	ModArchive *archive;
+	unsigned entry;
+	if (findPacked(path, archive, entry))
+		return archive->openRW(entry, copy);
+
+	return SDL_RWFromFile(path.c_str(), "rb");
+}
+
+time_t ModManager::getModifiedTime(const string& path) {
+	ModArchive *archive;
+	unsigned entry;
+	if (findPacked(path, archive, entry))
+		return archive->getModifiedTime();
+
+	return getFileModifiedTime(path);
+}
+
+size_t ModManager::getSize(const string& path) {
+	ModArchive *archive;
+	unsigned entry;
+	if (findPacked(path, archive, entry))
+		return archive->getSize(entry);
+
+	return getFileSize(path);
+}
+
 void ModManager::setPaths() {
 	// set some flags if directories are identical
 	bool uniq_path_data = PATH_USER != PATH_DATA;
@@ -236,8 +455,19 @@ Mod ModManager::loadMod(std::string name) {
 		std::string path = mod_paths[i] + "mods/" + name + "/settings.txt";
 		infile.open(path.c_str(), ios::in);
 
-		while (infile.good()) {
-			line = getLine(infile);
+		// a packed mod has its settings in the archive
+		std::istringstream packed;
+		if (!infile.is_open()) {
+			ModArchive *archive = getArchive(mod_paths[i] + "mods/" + name + MOD_ARCHIVE_EXTENSION);
+			int index = archive ? archive->find("settings.txt") : -1;
+			MappedFile settings;
+			if (index != -1 && archive->read(index, settings))
+				packed.str(std::string(reinterpret_cast<const char*>(settings.getData()), settings.getSize()));
+		}
+		std::istream &in = infile.is_open() ? static_cast<std::istream&>(infile) : packed;
+
+		while (in.good()) {
+			line = getLine(in);
 			key = "";
 			val = "";
 
@@ -368,6 +598,8 @@ void ModManager::applyDepends() {
 	// run recursivly until no more dependencies need to be met
 	if (!finished)
 		applyDepends();
+	else
+		buildIndex();
 }
 
 bool ModManager::haveFallbackMod() {
@@ -379,4 +611,8 @@ bool ModManager::haveFallbackMod() {
 }
 
 ModManager::~ModManager() {
+	for (map<string, ModArchive*>::iterator it = archives.begin(); it != archives.end(); ++it) {
+		delete it->second;
+	}
+	SDL_DestroyMutex(index_mutex);
 }
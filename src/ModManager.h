@@ -20,6 +20,14 @@ class ModManager
 
 ModManager maintains a list of active mods and provides functions for checking
 mods in priority order when loading data files.
+
+The files of all active mods are indexed once, when the mod list is set up, so
+finding a file doesn't need to touch the disk. With WATCH_MODS, the index is built
+again when the mods change; the new index is swapped in under a lock that every
+lookup takes, so locate(), list() and the open functions may be called from any thread.
+
+A mod can also be installed packed into a single ModArchive. Files located in an
+archive don't exist on disk, so they must be read through openFile() or openRW().
 */
 
 #pragma once
@@ -29,6 +37,10 @@ mods in priority order when loading data files.
 #define FALLBACK_MOD "default"
 
 #include "CommonIncludes.h"
+#include "MappedFile.h"
+#include "ModArchive.h"
+
+#include <time.h>
 
 class Mod {
 public:
@@ -48,14 +60,47 @@ public:
 	std::vector<std::string> depends;
 };
 
+/**
+ * One copy of a data file in a mod
+ */
+class ModFile {
+public:
+	ModFile(int _layer, const std::string& _path, ModArchive *_archive = NULL, unsigned _entry = 0);
+
+	int layer; // position of the mod folder in the search order, later layers override earlier ones
+	std::string path;
+
+	// for a file in a mod archive, the archive and the entry in it
+	ModArchive *archive;
+	unsigned entry;
+};
+
 class ModManager {
 private:
 	void loadModList();
 	void setPaths();
+	ModArchive *getArchive(const std::string& path);
+	bool findPacked(const std::string& path, ModArchive *&archive, unsigned &entry);
 
-	std::map<std::string,std::string> loc_cache;
+	// for each relative filename, the copies of it in the order list() returns them,
+	// so the last one is the file locate() returns
+	std::map<std::string, std::vector<ModFile> > file_index;
 	std::vector<std::string> mod_paths;
 
+	// mounted archives by path, NULL where there's none, and the files in them by full path
+	std::map<std::string, ModArchive*> archives;
+	std::map<std::string, const ModFile*> packed_files;
+
+	// held while file_index and packed_files are read or replaced
+	SDL_mutex *index_mutex;
+
+#ifdef WATCH_MODS
+	// the indexed folders and their modified times, see checkForChanges()
+	std::vector<std::string> watched_dirs;
+	std::vector<time_t> watched_times;
+	int next_watch_ticks;
+#endif
+
 public:
 	ModManager();
 	~ModManager();
@@ -63,6 +108,10 @@ public:
 	void applyDepends();
 	bool haveFallbackMod();
 
+	// Index the files of the mods in mod_list again, after mods were added
+	// to it or removed from it
+	void buildIndex();
+
 	// Returns the filename within the latest mod, in which the provided generic
 	// filename was found.
 	std::string locate(const std::string& filename);
@@ -76,6 +125,24 @@ public:
 	// that can be passed to locate() later
 	std::vector<std::string> list(const std::string& path, bool full_paths = true);
 
+	// Returns true if the generic filename is found in any mod
+	bool exists(const std::string& filename);
+
+	// Read a file returned by locate() or list(), whether it's on disk or in
+	// a mod archive. Set copy for streams that are kept open for as long as
+	// the loaded object lives (music, fonts), so they don't depend on the
+	// archive staying mounted.
+	bool openFile(const std::string& path, MappedFile& file);
+	SDL_RWops* openRW(const std::string& path, bool copy = false);
+	time_t getModifiedTime(const std::string& path);
+	size_t getSize(const std::string& path);
+
+#ifdef WATCH_MODS
+	// Rebuilds the file index if files were added to or removed from the mods
+	// since it was built. Only checks once a second.
+	void checkForChanges();
+#endif
+
 	std::vector<std::string> mod_dirs;
 	std::vector<Mod> mod_list;
 };
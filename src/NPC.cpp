@@ -80,7 +80,7 @@ void NPC::load(const string& npc_id, int hero_level) {
 					dialog.push_back(vector<Event_Component>());
 				}
 				Event_Component e;
-				e.type = infile.key;
+				e.type = internString(infile.key);
 				if (infile.key == "him" || infile.key == "her")
 					// @ATTR dialog.him, dialog.her|string|A line of dialog from the NPC.
 					e.s = msg->get(infile.val);
@@ -154,8 +154,9 @@ void NPC::load(const string& npc_id, int hero_level) {
 					// @ATTR status_stock|status (string), item (integer), ...|A list of items this vendor will have for sale if the required status is met.
 					if (camp->checkStatus(infile.nextValue())) {
 						stack.quantity = 1;
-						while (infile.val != "") {
-							stack.item = toInt(infile.nextValue());
+						std::string item;
+						while ((item = infile.nextValue()) != "") {
+							stack.item = toInt(item);
 							stock.add(stack);
 						}
 					}
@@ -173,6 +174,25 @@ void NPC::load(const string& npc_id, int hero_level) {
 	loadGraphics(filename_portrait);
 }
 
+/**
+ * Queue the graphics and voices of an NPC, see AssetLoader.
+ * Safe to call on a worker thread.
+ */
+void NPC::preload(AssetLoader &loader, const string& npc_id) {
+	FileParser infile;
+	if (!infile.open(npc_id, true, ""))
+		return;
+
+	while (infile.next()) {
+		if (infile.key == "gfx")
+			loader.addJob(AnimationSet::preload, infile.val);
+		else if (infile.key == "portrait")
+			loader.addImage(infile.val);
+		else if (infile.key == "vox_intro" || infile.key == "voice")
+			loader.addSound(infile.val);
+	}
+}
+
 void NPC::loadGraphics(const string& filename_portrait) {
 
 	if (gfx != "") {
@@ -258,43 +278,43 @@ void NPC::getDialogNodes(std::vector<int> &result) {
 		bool is_grouped = false;
 		for (unsigned int j=0; j<dialog[i].size(); j++) {
 
-			if (dialog[i][j].type == "requires_status") {
+			if (dialog[i][j].type == SID_REQUIRES_STATUS) {
 				if (camp->checkStatus(dialog[i][j].s))
 					continue;
 				is_available = false;
 				break;
 			}
-			else if (dialog[i][j].type == "requires_not_status") {
+			else if (dialog[i][j].type == SID_REQUIRES_NOT_STATUS) {
 				if (!camp->checkStatus(dialog[i][j].s))
 					continue;
 				is_available = false;
 				break;
 			}
-			else if (dialog[i][j].type == "requires_currency") {
+			else if (dialog[i][j].type == SID_REQUIRES_CURRENCY) {
 				if (camp->checkCurrency(dialog[i][j].x))
 					continue;
 				is_available = false;
 				break;
 			}
-			else if (dialog[i][j].type == "requires_item") {
+			else if (dialog[i][j].type == SID_REQUIRES_ITEM) {
 				if (camp->checkItem(dialog[i][j].x))
 					continue;
 				is_available = false;
 				break;
 			}
-			else if (dialog[i][j].type == "requires_level") {
+			else if (dialog[i][j].type == SID_REQUIRES_LEVEL) {
 				if (camp->hero->level >= dialog[i][j].x)
 					continue;
 				is_available = false;
 				break;
 			}
-			else if (dialog[i][j].type == "requires_not_level") {
+			else if (dialog[i][j].type == SID_REQUIRES_NOT_LEVEL) {
 				if (camp->hero->level < dialog[i][j].x)
 					continue;
 				is_available = false;
 				break;
 			}
-			else if (dialog[i][j].type == "group") {
+			else if (dialog[i][j].type == SID_GROUP) {
 				is_grouped = true;
 				group = dialog[i][j].s;
 			}
@@ -336,7 +356,7 @@ std::string NPC::getDialogTopic(unsigned int dialog_node) {
 		return "";
 
 	for (unsigned int j=0; j<dialog[dialog_node].size(); j++) {
-		if (dialog[dialog_node][j].type == "topic")
+		if (dialog[dialog_node][j].type == SID_TOPIC)
 			return dialog[dialog_node][j].s;
 	}
 
@@ -348,7 +368,7 @@ std::string NPC::getDialogTopic(unsigned int dialog_node) {
  */
 bool NPC::checkMovement(unsigned int dialog_node) {
 	for (unsigned int i=0; i<dialog[dialog_node].size(); i++) {
-		if (dialog[dialog_node][i].type == "allow_movement")
+		if (dialog[dialog_node][i].type == SID_ALLOW_MOVEMENT)
 			return toBool(dialog[dialog_node][i].s);
 	}
 	return true;
@@ -364,37 +384,37 @@ bool NPC::processDialog(unsigned int dialog_node, unsigned int &event_cursor) {
 	while (event_cursor < dialog[dialog_node].size()) {
 
 		// we've already determined requirements are met, so skip these
-		if (dialog[dialog_node][event_cursor].type == "requires_status") {
+		if (dialog[dialog_node][event_cursor].type == SID_REQUIRES_STATUS) {
 			// continue to next event component
 		}
-		else if (dialog[dialog_node][event_cursor].type == "requires_not_status") {
+		else if (dialog[dialog_node][event_cursor].type == SID_REQUIRES_NOT_STATUS) {
 			// continue to next event component
 		}
-		else if (dialog[dialog_node][event_cursor].type == "requires_level") {
+		else if (dialog[dialog_node][event_cursor].type == SID_REQUIRES_LEVEL) {
 			// continue to next event component
 		}
-		else if (dialog[dialog_node][event_cursor].type == "requires_not_level") {
+		else if (dialog[dialog_node][event_cursor].type == SID_REQUIRES_NOT_LEVEL) {
 			// continue to next event component
 		}
-		else if (dialog[dialog_node][event_cursor].type == "requires_currency") {
+		else if (dialog[dialog_node][event_cursor].type == SID_REQUIRES_CURRENCY) {
 			// continue to next event component
 		}
-		else if (dialog[dialog_node][event_cursor].type == "requires_item") {
+		else if (dialog[dialog_node][event_cursor].type == SID_REQUIRES_ITEM) {
 			// continue to next event component
 		}
-		else if (dialog[dialog_node][event_cursor].type == "him") {
+		else if (dialog[dialog_node][event_cursor].type == SID_HIM) {
 			return true;
 		}
-		else if (dialog[dialog_node][event_cursor].type == "her") {
+		else if (dialog[dialog_node][event_cursor].type == SID_HER) {
 			return true;
 		}
-		else if (dialog[dialog_node][event_cursor].type == "you") {
+		else if (dialog[dialog_node][event_cursor].type == SID_YOU) {
 			return true;
 		}
-		else if (dialog[dialog_node][event_cursor].type == "voice") {
+		else if (dialog[dialog_node][event_cursor].type == SID_VOICE) {
 			playSound(NPC_VOX_QUEST, dialog[dialog_node][event_cursor].x);
 		}
-		else if (dialog[dialog_node][event_cursor].type == "") {
+		else if (dialog[dialog_node][event_cursor].type == SID_NONE) {
 			// conversation ends
 			return false;
 		}
@@ -428,8 +448,8 @@ Renderable NPC::getRender() {
 	return r;
 }
 
-bool NPC::isDialogType(const std::string &type) {
-	return type == "him" || type == "her" || type == "you" || type == "voice";
+bool NPC::isDialogType(StringID type) {
+	return type == SID_HIM || type == SID_HER || type == SID_YOU || type == SID_VOICE;
 }
 
 NPC::~NPC() {
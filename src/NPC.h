@@ -29,6 +29,8 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "ItemStorage.h"
 #include "Utils.h"
 
+class AssetLoader;
+
 const int NPC_VENDOR_MAX_STOCK = 80;
 const int NPC_VOX_INTRO = 0;
 const int NPC_VOX_QUEST = 1;
@@ -36,11 +38,12 @@ const int NPC_NO_DIALOG_AVAIL = -1;
 
 class NPC : public Entity {
 private:
-	bool isDialogType(const std::string &type);
+	bool isDialogType(StringID type);
 public:
 	NPC();
 	~NPC();
 	void load(const std::string& npc_id, int hero_level);
+	static void preload(AssetLoader &loader, const std::string& npc_id);
 	void loadGraphics(const std::string& filename_portrait);
 	int loadSound(const std::string& fname, int type);
 	void logic();
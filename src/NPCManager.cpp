@@ -65,15 +65,22 @@ void NPCManager::addRenders(std::vector<Renderable> &r) {
 
 void NPCManager::handleNewMap() {
 
-	Map_NPC mn;
-	ItemStack item_roll;
-
 	// remove existing NPCs
 	for (unsigned i=0; i<npcs.size(); i++)
 		delete(npcs[i]);
 
 	npcs.clear();
 
+	addMapNPCs();
+}
+
+/**
+ * Create the NPCs the map has queued, e.g. when a region of a streamed map was loaded
+ */
+void NPCManager::addMapNPCs() {
+
+	Map_NPC mn;
+
 	// read the queued NPCs in the map file
 	while (!mapr->npcs.empty()) {
 		mn = mapr->npcs.front();
@@ -47,6 +47,7 @@ public:
 
 	std::vector<NPC*> npcs;
 	void handleNewMap();
+	void addMapNPCs();
 	void logic();
 	void addRenders(std::vector<Renderable> &r);
 	int getID(std::string npcName);
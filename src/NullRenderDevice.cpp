@@ -0,0 +1,230 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include <iostream>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SharedResources.h"
+#include "Settings.h"
+
+#include "NullRenderDevice.h"
+
+using namespace std;
+
+NullImage::NullImage(RenderDevice *_device, int _width, int _height)
+	: Image(_device)
+	, width(_width)
+	, height(_height) {
+}
+
+NullImage::~NullImage() {
+}
+
+int NullImage::getWidth() const {
+	return width;
+}
+
+int NullImage::getHeight() const {
+	return height;
+}
+
+void NullImage::fillWithColor(Rect *, Uint32) {
+}
+
+void NullImage::drawPixel(int, int, Uint32) {
+}
+
+Uint32 NullImage::MapRGB(Uint8 r, Uint8 g, Uint8 b) {
+	return MapRGBA(r, g, b, 255);
+}
+
+Uint32 NullImage::MapRGBA(Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+	// same layout as the ARGB8888 surfaces used by the SDL device
+	return ((Uint32)a << 24) | ((Uint32)r << 16) | ((Uint32)g << 8) | (Uint32)b;
+}
+
+/**
+ * Resizes an image
+ * Deletes the original image and returns a pointer to the resized version
+ */
+Image* NullImage::resize(int _width, int _height) {
+	if (_width <= 0 || _height <= 0)
+		return NULL;
+
+	NullImage *scaled = new NullImage(device, _width, _height);
+	this->unref();
+	return scaled;
+}
+
+/**
+ * There is no pixel data, so treat the whole image area as opaque.
+ * This keeps mouse-over checks on sprites working in a headless session.
+ */
+bool NullImage::checkPixel(Point px) {
+	return px.x >= 0 && px.y >= 0 && px.x < width && px.y < height;
+}
+
+Uint32 NullImage::readPixel(int, int) {
+	return 0;
+}
+
+
+NullRenderDevice::NullRenderDevice()
+	: context_size() {
+	cout << "Using Render Device: NullRenderDevice (headless)" << endl;
+}
+
+int NullRenderDevice::createContext(int width, int height) {
+	context_size.x = context_size.y = 0;
+	context_size.w = width;
+	context_size.h = height;
+	is_initialized = true;
+	return 0;
+}
+
+Rect NullRenderDevice::getContextSize() {
+	return context_size;
+}
+
+int NullRenderDevice::renderToImage(Image* src_image, Rect&, Image* dest_image, Rect&, bool) {
+	if (!src_image || !dest_image) return -1;
+	return 0;
+}
+
+Image* NullRenderDevice::renderTextToImage(TTF_Font* ttf_font, const std::string& text, Color, bool) {
+	int w = 0;
+	int h = 0;
+
+	// fonts are still loaded, so the text can be measured without rendering it
+	if (TTF_SizeUTF8(ttf_font, text.c_str(), &w, &h) != 0 || w <= 0 || h <= 0)
+		return NULL;
+
+	return new NullImage(this, w, h);
+}
+
+void NullRenderDevice::drawLine(int, int, int, int, Uint32) {
+}
+
+/**
+ * Commands are still recorded, batched and released, so their cost is
+ * measured. Only the drawing is left out.
+ */
+void NullRenderDevice::submit(std::vector<RenderCommand> &list) {
+	batchCommands(list);
+}
+
+void NullRenderDevice::presentFrame() {
+}
+
+void NullRenderDevice::destroyContext() {
+	discardCommands();
+	is_initialized = false;
+}
+
+Uint32 NullRenderDevice::MapRGB(Uint8 r, Uint8 g, Uint8 b) {
+	return MapRGBA(r, g, b, 255);
+}
+
+Uint32 NullRenderDevice::MapRGBA(Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+	return ((Uint32)a << 24) | ((Uint32)r << 16) | ((Uint32)g << 8) | (Uint32)b;
+}
+
+Image *NullRenderDevice::createImage(int width, int height) {
+	if (width <= 0 || height <= 0) {
+		fprintf(stderr, "CreateRGBSurface failed: invalid size %dx%d\n", width, height);
+		return NULL;
+	}
+	return new NullImage(this, width, height);
+}
+
+void NullRenderDevice::setGamma(float) {
+}
+
+void NullRenderDevice::listModes(std::vector<Rect> &modes) {
+	modes.push_back(context_size);
+}
+
+/**
+ * Get the dimensions of an image file
+ * PNG files are read from their header only. Anything else is decoded once.
+ */
+bool NullRenderDevice::readImageSize(const std::string& path, int *w, int *h) {
+	SDL_RWops *rw = mods->openRW(path);
+	if (!rw) return false;
+
+	unsigned char header[24];
+	size_t len = SDL_RWread(rw, header, 1, 24);
+
+	const unsigned char png_sig[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+	if (len == 24 && memcmp(header, png_sig, 8) == 0) {
+		// the IHDR chunk always comes first; width and height are big-endian
+		*w = (header[16] << 24) | (header[17] << 16) | (header[18] << 8) | header[19];
+		*h = (header[20] << 24) | (header[21] << 16) | (header[22] << 8) | header[23];
+		SDL_RWclose(rw);
+		return *w > 0 && *h > 0;
+	}
+
+	SDL_RWseek(rw, 0, RW_SEEK_SET);
+	SDL_Surface *surface = IMG_Load_RW(rw, 1);
+	if (!surface) return false;
+	*w = surface->w;
+	*h = surface->h;
+	SDL_FreeSurface(surface);
+	return true;
+}
+
+Image *NullRenderDevice::loadImage(std::string filename, std::string errormessage, bool IfNotFoundExit) {
+	// lookup image in cache
+	Image *img;
+	img = cacheLookup(filename);
+	if (img != NULL) return img;
+
+	NullImage *image = NULL;
+	int w = 0;
+	int h = 0;
+	if (!readImageSize(mods->locate(filename), &w, &h)) {
+		if (!errormessage.empty())
+			fprintf(stderr, "%s: %s\n", errormessage.c_str(), filename.c_str());
+		if (IfNotFoundExit) {
+			SDL_Quit();
+			exit(1);
+		}
+	}
+	else {
+		image = new NullImage(this, w, h);
+	}
+
+	// store image to cache
+	cacheStore(filename, image);
+	return image;
+}
+
+/**
+ * Only the size of an image is read, so decoding it ahead is wasted work
+ */
+bool NullRenderDevice::needsImage(const std::string &) {
+	return false;
+}
+
+void NullRenderDevice::freeImage(Image *image) {
+	if (!image) return;
+
+	cacheRemove(image);
+}
@@ -0,0 +1,93 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#pragma once
+#ifndef NULLRENDERDEVICE_H
+#define NULLRENDERDEVICE_H
+
+#include "RenderDevice.h"
+
+/** Provide a rendering device that draws nothing.
+ *
+ * The null device never opens a window or allocates pixel storage. Images
+ * only carry their dimensions, so game logic and menu layout behave the same
+ * as with a real backend. It is used for headless simulation, e.g. soak tests
+ * and benchmarks on machines without a display.
+ *
+ * @class NullRenderDevice
+ * @see RenderDevice
+ *
+ */
+
+/** Null Image */
+class NullImage : public Image {
+public:
+	NullImage(RenderDevice *device, int _width, int _height);
+	virtual ~NullImage();
+	int getWidth() const;
+	int getHeight() const;
+
+	void fillWithColor(Rect *dstrect, Uint32 color);
+	void drawPixel(int x, int y, Uint32 color);
+	Uint32 MapRGB(Uint8 r, Uint8 g, Uint8 b);
+	Uint32 MapRGBA(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+	Image* resize(int width, int height);
+	bool checkPixel(Point px);
+
+private:
+	Uint32 readPixel(int x, int y);
+
+	int width;
+	int height;
+};
+
+class NullRenderDevice : public RenderDevice {
+
+public:
+
+	NullRenderDevice();
+	int createContext(int width, int height);
+	Rect getContextSize();
+
+	virtual int renderToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest, bool dest_is_transparent = false);
+
+	Image* renderTextToImage(TTF_Font* ttf_font, const std::string& text, Color color, bool blended = true);
+	void destroyContext();
+	Uint32 MapRGB(Uint8 r, Uint8 g, Uint8 b);
+	Uint32 MapRGBA(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+	Image *createImage(int width, int height);
+	void setGamma(float g);
+	void listModes(std::vector<Rect> &modes);
+	void freeImage(Image *image);
+
+	Image* loadImage(std::string filename,
+					 std::string errormessage = "Couldn't load image",
+					 bool IfNotFoundExit = false);
+	bool needsImage(const std::string &filename);
+
+protected:
+	void submit(std::vector<RenderCommand> &list);
+	void presentFrame();
+
+private:
+	void drawLine(int x0, int y0, int x1, int y1, Uint32 color);
+	bool readImageSize(const std::string& path, int *w, int *h);
+
+	Rect context_size;
+};
+
+#endif // NULLRENDERDEVICE_H
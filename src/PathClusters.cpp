@@ -0,0 +1,437 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+
+#include "MapCollision.h"
+#include "PathClusters.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <functional>
+
+// runs of open border tiles which are longer than this get a portal at each end instead of one in the middle
+static const int MAX_PORTAL_RUN = 6;
+
+// step costs of the cluster-local searches; the ring of buckets must be longer than the biggest step
+static const int LOCAL_STEP = 5;
+static const int LOCAL_DIAGONAL_STEP = 7;
+
+// like the tile search (see AStarNode::getFinalCost()), the estimate is weighted to find a good path quickly rather than the best one
+static const float ESTIMATE_WEIGHT = 2.f;
+
+static const int NEIGHBOUR_OFFSETS[8][2] = {
+	{-1, -1}, {-1, 1}, {1, -1}, {1, 1},
+	{-1, 0}, {0, -1}, {1, 0}, {0, 1}
+};
+
+const int PathClusters::CLUSTER_SIZE;
+
+PathClusters::PathClusters(int _movement_type)
+	: movement_type(_movement_type)
+	, map_width(0)
+	, map_height(0)
+	, columns(0)
+	, rows(0)
+	, dirty(false)
+	, node_count(0)
+	, generation(0) {
+}
+
+PathClusters::~PathClusters() {
+}
+
+/**
+ * Cut a new map into clusters. The graph is built by the first update() or search().
+ */
+void PathClusters::setmap(int width, int height) {
+	map_width = width;
+	map_height = height;
+	columns = (width + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+	rows = (height + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+
+	clusters.assign(columns * rows, PathCluster());
+	for (int r = 0; r < rows; r++) {
+		for (int c = 0; c < columns; c++) {
+			Rect &area = clusters[r * columns + c].area;
+			area.x = c * CLUSTER_SIZE;
+			area.y = r * CLUSTER_SIZE;
+			area.w = std::min(CLUSTER_SIZE, width - area.x);
+			area.h = std::min(CLUSTER_SIZE, height - area.y);
+		}
+	}
+
+	dirty = true;
+}
+
+/**
+ * The terrain inside this area has changed. The affected clusters are rebuilt
+ * before the next search.
+ */
+void PathClusters::invalidate(int x, int y, int w, int h) {
+	if (clusters.empty() || w <= 0 || h <= 0)
+		return;
+
+	// tiles next to the area are included, since the portals along a border depend on both sides
+	const int c0 = std::max(0, x - 1) / CLUSTER_SIZE;
+	const int r0 = std::max(0, y - 1) / CLUSTER_SIZE;
+	const int c1 = std::min(map_width - 1, x + w) / CLUSTER_SIZE;
+	const int r1 = std::min(map_height - 1, y + h) / CLUSTER_SIZE;
+
+	for (int r = r0; r <= r1; r++) {
+		for (int c = c0; c <= c1; c++) {
+			clusters[r * columns + c].dirty = true;
+			dirty = true;
+		}
+	}
+}
+
+bool PathClusters::isSameCluster(const Point &a, const Point &b) const {
+	return a.x / CLUSTER_SIZE == b.x / CLUSTER_SIZE && a.y / CLUSTER_SIZE == b.y / CLUSTER_SIZE;
+}
+
+int PathClusters::getClusterIndex(int x, int y) const {
+	return (y / CLUSTER_SIZE) * columns + x / CLUSTER_SIZE;
+}
+
+/**
+ * Rebuild the clusters which are marked as dirty
+ */
+void PathClusters::update(const MapCollision &collider) {
+	if (!dirty)
+		return;
+
+	for (unsigned i = 0; i < clusters.size(); i++) {
+		if (clusters[i].dirty)
+			buildCluster(collider, i);
+	}
+
+	// nodes refer to the nodes of other clusters by position, so only the ids need to be updated
+	node_count = 0;
+	node_cluster.clear();
+	for (unsigned i = 0; i < clusters.size(); i++) {
+		clusters[i].first_id = node_count;
+		node_count += clusters[i].nodes.size();
+		node_cluster.resize(node_count, i);
+	}
+
+	for (unsigned i = 0; i < clusters.size(); i++) {
+		for (unsigned j = 0; j < clusters[i].nodes.size(); j++) {
+			PathClusterNode &node = clusters[i].nodes[j];
+			node.link_ids.resize(node.links.size());
+			for (unsigned k = 0; k < node.links.size(); k++) {
+				const int link_cluster = getClusterIndex(node.links[k].x, node.links[k].y);
+				const int link_node = findNode(link_cluster, node.links[k]);
+				node.link_ids[k] = (link_node == -1) ? -1 : static_cast<int>(clusters[link_cluster].first_id) + link_node;
+			}
+		}
+	}
+
+	// two extra ids for the start and the goal of a search
+	if (visited.size() != node_count + 2) {
+		cost.resize(node_count + 2);
+		parent.resize(node_count + 2);
+		visited.assign(node_count + 2, 0);
+		generation = 0;
+	}
+
+	dirty = false;
+}
+
+void PathClusters::buildCluster(const MapCollision &collider, int index) {
+	PathCluster &cluster = clusters[index];
+	const Rect &area = cluster.area;
+
+	cluster.nodes.clear();
+	cluster.dirty = false;
+
+	cluster.passable.resize(area.w * area.h);
+	for (int y = 0; y < area.h; y++)
+		for (int x = 0; x < area.w; x++)
+			cluster.passable[y * area.w + x] = collider.is_open_terrain(area.x + x, area.y + y, static_cast<MOVEMENTTYPE>(movement_type));
+
+	if (area.x > 0)
+		addPortals(collider, cluster, Point(area.x, area.y), Point(0, 1), Point(-1, 0), area.h);
+	if (area.x + area.w < map_width)
+		addPortals(collider, cluster, Point(area.x + area.w - 1, area.y), Point(0, 1), Point(1, 0), area.h);
+	if (area.y > 0)
+		addPortals(collider, cluster, Point(area.x, area.y), Point(1, 0), Point(0, -1), area.w);
+	if (area.y + area.h < map_height)
+		addPortals(collider, cluster, Point(area.x, area.y + area.h - 1), Point(1, 0), Point(0, 1), area.w);
+
+	// connect the portals which can reach each other inside the cluster
+	for (unsigned i = 0; i < cluster.nodes.size(); i++) {
+		computeLocalCosts(cluster, cluster.nodes[i].pos);
+		for (unsigned j = 0; j < cluster.nodes.size(); j++) {
+			const float c = getLocalCost(area, cluster.nodes[j].pos);
+			if (i != j && c < FLT_MAX)
+				cluster.nodes[i].edges.push_back(PathClusterEdge(j, c));
+		}
+	}
+}
+
+/**
+ * Walk along one border of a cluster and add portals for the runs of tiles
+ * which are open on both sides. Both clusters sharing the border find the same runs.
+ */
+void PathClusters::addPortals(const MapCollision &collider, PathCluster &cluster, const Point &from, const Point &step, const Point &across, int length) {
+	int run_start = -1;
+
+	for (int i = 0; i <= length; i++) {
+		bool is_open = false;
+		if (i < length) {
+			const int x = from.x + step.x * i;
+			const int y = from.y + step.y * i;
+			is_open = collider.is_open_terrain(x, y, static_cast<MOVEMENTTYPE>(movement_type)) &&
+					  collider.is_open_terrain(x + across.x, y + across.y, static_cast<MOVEMENTTYPE>(movement_type));
+		}
+
+		if (is_open) {
+			if (run_start == -1)
+				run_start = i;
+			continue;
+		}
+		if (run_start == -1)
+			continue;
+
+		const int run_end = i - 1;
+		if (run_end - run_start + 1 > MAX_PORTAL_RUN) {
+			addNode(cluster, Point(from.x + step.x * run_start, from.y + step.y * run_start), across);
+			addNode(cluster, Point(from.x + step.x * run_end, from.y + step.y * run_end), across);
+		}
+		else {
+			const int middle = (run_start + run_end) / 2;
+			addNode(cluster, Point(from.x + step.x * middle, from.y + step.y * middle), across);
+		}
+		run_start = -1;
+	}
+}
+
+/**
+ * Tiles in the corners of a cluster can be portals to two borders, those share one node
+ */
+void PathClusters::addNode(PathCluster &cluster, const Point &pos, const Point &across) {
+	const Point link(pos.x + across.x, pos.y + across.y);
+
+	for (unsigned i = 0; i < cluster.nodes.size(); i++) {
+		if (cluster.nodes[i].pos.x == pos.x && cluster.nodes[i].pos.y == pos.y) {
+			cluster.nodes[i].links.push_back(link);
+			return;
+		}
+	}
+
+	cluster.nodes.push_back(PathClusterNode());
+	cluster.nodes.back().pos = pos;
+	cluster.nodes.back().links.push_back(link);
+}
+
+int PathClusters::findNode(int cluster, const Point &pos) const {
+	const std::vector<PathClusterNode> &nodes = clusters[cluster].nodes;
+	for (unsigned i = 0; i < nodes.size(); i++) {
+		if (nodes[i].pos.x == pos.x && nodes[i].pos.y == pos.y)
+			return i;
+	}
+	return -1;
+}
+
+/**
+ * Dijkstra search from a tile to every tile of the cluster, without leaving the cluster.
+ * Costs are counted in fifths of a tile, so the queue can be a ring of buckets.
+ */
+void PathClusters::computeLocalCosts(const PathCluster &cluster, const Point &from) {
+	const Rect &area = cluster.area;
+
+	local_cost.assign(area.w * area.h, INT_MAX);
+
+	const int from_index = (from.y - area.y) * area.w + (from.x - area.x);
+	local_cost[from_index] = 0;
+	local_buckets[0].push_back(from_index);
+	int queued = 1;
+
+	for (int c = 0; queued > 0; c++) {
+		std::vector<int> &bucket = local_buckets[c % LOCAL_BUCKETS];
+
+		for (unsigned k = 0; k < bucket.size(); k++) {
+			const int index = bucket[k];
+			queued--;
+
+			// skip tiles which were reached cheaper after they were queued
+			if (local_cost[index] != c)
+				continue;
+
+			const int x = area.x + index % area.w;
+			const int y = area.y + index / area.w;
+
+			for (int i = 0; i < 8; i++) {
+				const int nx = x + NEIGHBOUR_OFFSETS[i][0];
+				const int ny = y + NEIGHBOUR_OFFSETS[i][1];
+				if (nx < area.x || ny < area.y || nx >= area.x + area.w || ny >= area.y + area.h)
+					continue;
+				const int next = (ny - area.y) * area.w + (nx - area.x);
+				if (!cluster.passable[next])
+					continue;
+
+				const int next_cost = c + (i < 4 ? LOCAL_DIAGONAL_STEP : LOCAL_STEP);
+				if (next_cost < local_cost[next]) {
+					local_cost[next] = next_cost;
+					local_buckets[next_cost % LOCAL_BUCKETS].push_back(next);
+					queued++;
+				}
+			}
+		}
+
+		bucket.clear();
+	}
+}
+
+float PathClusters::getLocalCost(const Rect &area, const Point &pos) const {
+	const int c = local_cost[(pos.y - area.y) * area.w + (pos.x - area.x)];
+	return (c == INT_MAX) ? FLT_MAX : static_cast<float>(c) / LOCAL_STEP;
+}
+
+bool PathClusters::search(const MapCollision &collider, const Point &start, const Point &end, std::vector<Point> &waypoints) {
+	waypoints.clear();
+
+	if (clusters.empty())
+		return false;
+	if (start.x < 0 || start.y < 0 || start.x >= map_width || start.y >= map_height)
+		return false;
+	if (end.x < 0 || end.y < 0 || end.x >= map_width || end.y >= map_height)
+		return false;
+
+	update(collider);
+
+	const int start_cluster = getClusterIndex(start.x, start.y);
+	const int end_cluster = getClusterIndex(end.x, end.y);
+	if (start_cluster == end_cluster)
+		return false;
+
+	const unsigned int start_id = node_count;
+	const unsigned int goal_id = node_count + 1;
+
+	// the cost from each portal of the goal cluster to the goal
+	const PathCluster &goal_cluster = clusters[end_cluster];
+	computeLocalCosts(goal_cluster, end);
+	goal_cost.resize(goal_cluster.nodes.size());
+	bool goal_reachable = false;
+	for (unsigned i = 0; i < goal_cluster.nodes.size(); i++) {
+		goal_cost[i] = getLocalCost(goal_cluster.area, goal_cluster.nodes[i].pos);
+		if (goal_cost[i] < FLT_MAX)
+			goal_reachable = true;
+	}
+	if (!goal_reachable)
+		return false;
+
+	generation++;
+	if (generation == 0) {
+		std::fill(visited.begin(), visited.end(), 0);
+		generation = 1;
+	}
+	open.clear();
+
+	// the portals of the start cluster are reached straight from the start
+	const PathCluster &start_cluster_ref = clusters[start_cluster];
+	computeLocalCosts(start_cluster_ref, start);
+	visited[start_id] = generation;
+	cost[start_id] = 0;
+
+	for (unsigned i = 0; i < start_cluster_ref.nodes.size(); i++) {
+		const float c = getLocalCost(start_cluster_ref.area, start_cluster_ref.nodes[i].pos);
+		if (c == FLT_MAX)
+			continue;
+
+		const unsigned int id = start_cluster_ref.first_id + i;
+		visited[id] = generation;
+		cost[id] = c;
+		parent[id] = start_id;
+		open.push_back(std::pair<float, int>(c + ESTIMATE_WEIGHT * calcDist(start_cluster_ref.nodes[i].pos, end), id));
+		std::push_heap(open.begin(), open.end(), std::greater<std::pair<float, int> >());
+	}
+
+	bool found = false;
+
+	while (!open.empty()) {
+		std::pop_heap(open.begin(), open.end(), std::greater<std::pair<float, int> >());
+		const float f = open.back().first;
+		const unsigned int id = open.back().second;
+		open.pop_back();
+
+		if (id == goal_id) {
+			found = true;
+			break;
+		}
+
+		const int cluster_index = node_cluster[id];
+		const PathCluster &cluster = clusters[cluster_index];
+		const PathClusterNode &node = cluster.nodes[id - cluster.first_id];
+
+		// skip queue entries which were replaced by a cheaper one
+		if (f > cost[id] + ESTIMATE_WEIGHT * calcDist(node.pos, end))
+			continue;
+
+		// collect the neighbours: the goal, the portals of the same cluster, and the portals across the borders
+		const unsigned int next_count = node.edges.size() + node.links.size() + 1;
+		for (unsigned i = 0; i < next_count; i++) {
+			unsigned int next;
+			float next_cost;
+			Point next_pos;
+
+			if (i < node.edges.size()) {
+				next = cluster.first_id + node.edges[i].node;
+				next_cost = cost[id] + node.edges[i].cost;
+				next_pos = cluster.nodes[node.edges[i].node].pos;
+			}
+			else if (i < node.edges.size() + node.links.size()) {
+				const int link_id = node.link_ids[i - node.edges.size()];
+				if (link_id == -1)
+					continue;
+				next = link_id;
+				next_cost = cost[id] + 1.f;
+				next_pos = node.links[i - node.edges.size()];
+			}
+			else {
+				if (cluster_index != end_cluster || goal_cost[id - cluster.first_id] == FLT_MAX)
+					continue;
+				next = goal_id;
+				next_cost = cost[id] + goal_cost[id - cluster.first_id];
+				next_pos = end;
+			}
+
+			if (visited[next] == generation && next_cost >= cost[next])
+				continue;
+
+			visited[next] = generation;
+			cost[next] = next_cost;
+			parent[next] = id;
+			open.push_back(std::pair<float, int>(next_cost + ESTIMATE_WEIGHT * calcDist(next_pos, end), next));
+			std::push_heap(open.begin(), open.end(), std::greater<std::pair<float, int> >());
+		}
+	}
+
+	if (!found)
+		return false;
+
+	// walk back from the goal
+	waypoints.push_back(end);
+	for (unsigned int id = parent[goal_id]; id != start_id; id = parent[id]) {
+		const PathCluster &cluster = clusters[node_cluster[id]];
+		waypoints.push_back(cluster.nodes[id - cluster.first_id].pos);
+	}
+	std::reverse(waypoints.begin(), waypoints.end());
+
+	return true;
+}
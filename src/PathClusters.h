@@ -0,0 +1,133 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+
+/**
+ * class PathClusters
+ *
+ * A coarse graph over the collision map for long distance pathfinding.
+ *
+ * The map is cut into square clusters. Wherever two neighbouring clusters
+ * share a run of open tiles along their border, a portal node is placed on
+ * each side of the run. Nodes of the same cluster are connected with the
+ * cost of the shortest path between them inside the cluster. A long path is
+ * first searched on this small graph and then filled in one cluster at a time
+ * by MapCollision.
+ *
+ * Only the terrain is considered; tiles occupied by entities count as open.
+ * When the terrain changes, the clusters around the change are marked and
+ * rebuilt before the next search.
+ */
+
+#pragma once
+#ifndef PATH_CLUSTERS_H
+#define PATH_CLUSTERS_H
+
+#include "Utils.h"
+
+#include <vector>
+
+class MapCollision;
+
+class PathClusterEdge {
+public:
+	int node; // index into the nodes of the same cluster
+	float cost;
+
+	PathClusterEdge(int _node = 0, float _cost = 0)
+		: node(_node)
+		, cost(_cost) {
+	}
+};
+
+class PathClusterNode {
+public:
+	Point pos;
+	std::vector<Point> links; // the portal tiles on the other side of the cluster borders
+	std::vector<int> link_ids; // the node ids of the links, or -1
+	std::vector<PathClusterEdge> edges;
+};
+
+class PathCluster {
+public:
+	Rect area;
+	bool dirty;
+	unsigned int first_id; // id of the first node in the whole graph
+	std::vector<PathClusterNode> nodes;
+	std::vector<unsigned char> passable; // the open tiles of the area, row by row
+
+	PathCluster()
+		: dirty(true)
+		, first_id(0) {
+	}
+};
+
+class PathClusters {
+public:
+	static const int CLUSTER_SIZE = 16;
+
+	PathClusters(int _movement_type);
+	~PathClusters();
+
+	void setmap(int width, int height);
+	void invalidate(int x, int y, int w, int h);
+	void update(const MapCollision &collider);
+
+	bool isSameCluster(const Point &a, const Point &b) const;
+
+	/**
+	 * Find the portals a path from start to end goes through.
+	 * waypoints is filled in walking order and ends with end.
+	 * Returns false if end can't be reached according to the graph.
+	 */
+	bool search(const MapCollision &collider, const Point &start, const Point &end, std::vector<Point> &waypoints);
+
+private:
+	void buildCluster(const MapCollision &collider, int index);
+	void addPortals(const MapCollision &collider, PathCluster &cluster, const Point &from, const Point &step, const Point &across, int length);
+	void addNode(PathCluster &cluster, const Point &pos, const Point &across);
+	int findNode(int cluster, const Point &pos) const;
+	int getClusterIndex(int x, int y) const;
+	void computeLocalCosts(const PathCluster &cluster, const Point &from);
+	float getLocalCost(const Rect &area, const Point &pos) const;
+
+	const int movement_type;
+	int map_width;
+	int map_height;
+	int columns;
+	int rows;
+	bool dirty;
+
+	std::vector<PathCluster> clusters;
+	std::vector<int> node_cluster; // node id -> cluster index
+	unsigned int node_count;
+
+	// scratch space for the cluster-local searches
+	static const int LOCAL_BUCKETS = 8;
+	std::vector<int> local_cost;
+	std::vector<int> local_buckets[LOCAL_BUCKETS];
+
+	// scratch space for the graph search, indexed by node id
+	std::vector<float> cost;
+	std::vector<int> parent;
+	std::vector<unsigned int> visited;
+	std::vector<float> goal_cost;
+	std::vector<std::pair<float, int> > open;
+	unsigned int generation;
+};
+
+#endif
@@ -0,0 +1,311 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+
+#include <stdio.h>
+
+#include "PathService.h"
+
+PathService::PathService()
+	: thread(NULL)
+	, mutex(SDL_CreateMutex())
+	, work_ready(SDL_CreateCond())
+	, work_done(SDL_CreateCond())
+	, generation(0)
+	, terrain_revision(0)
+	, terrain(BLOCKS_NONE)
+	, current(0)
+	, current_frame(0)
+	, current_cancelled(false)
+	, frame(0)
+	, next_ticket(0)
+	, quit(false) {
+}
+
+PathService::~PathService() {
+	if (thread) {
+		SDL_LockMutex(mutex);
+		quit = true;
+		pending.clear();
+		SDL_CondSignal(work_ready);
+		SDL_UnlockMutex(mutex);
+		SDL_WaitThread(thread, NULL);
+	}
+
+	if (work_done) SDL_DestroyCond(work_done);
+	if (work_ready) SDL_DestroyCond(work_ready);
+	if (mutex) SDL_DestroyMutex(mutex);
+}
+
+/**
+ * Called once per frame: counts the frames for collect(), and hands over the terrain
+ */
+void PathService::logic(const MapCollision &collider) {
+	frame++;
+	update(collider);
+}
+
+/**
+ * Hand the terrain of the map to the thread if it has changed since the last call.
+ * Called by logic(), and right after a new map is loaded.
+ * Paths which were requested before the change are still searched on the old terrain.
+ */
+void PathService::update(const MapCollision &collider) {
+	if (collider.terrain_revision == terrain_revision)
+		return;
+	terrain_revision = collider.terrain_revision;
+
+	// copied before locking, so the thread isn't held up
+	ChunkedGrid<unsigned short> colmap(collider.colmap);
+
+	if (thread) SDL_LockMutex(mutex);
+	generation++;
+
+	// a queued terrain which no request waits for is replaced
+	if (terrains.empty() || (!pending.empty() && pending.back().generation == terrains.back().generation))
+		terrains.push_back(PathTerrain());
+	terrains.back().generation = generation;
+	terrains.back().colmap.swap(colmap);
+
+	if (thread) {
+		SDL_CondSignal(work_ready);
+		SDL_UnlockMutex(mutex);
+	}
+}
+
+/**
+ * Queue a path search, see MapCollision::compute_path().
+ * The thread is only started for the first request.
+ * Without threads, the path is searched right away.
+ * @return the ticket to collect the path with; never 0
+ */
+unsigned int PathService::request(const FPoint &start, const FPoint &end, MOVEMENTTYPE movement_type, unsigned int limit) {
+	if (!thread && mutex && work_ready && work_done) {
+#if SDL_VERSION_ATLEAST(2,0,0)
+		thread = SDL_CreateThread(threadMain, "PathService", this);
+#else
+		thread = SDL_CreateThread(threadMain, this);
+#endif
+		if (!thread)
+			fprintf(stderr, "Could not create path service thread: %s\n", SDL_GetError());
+	}
+
+	PathRequest query;
+	query.ticket = ++next_ticket;
+	if (query.ticket == 0)
+		query.ticket = ++next_ticket;
+	query.frame = frame;
+	query.generation = generation;
+	query.start = start;
+	query.end = end;
+	query.movement_type = movement_type;
+	query.limit = limit;
+
+	if (!thread) {
+		while (!terrains.empty()) {
+			terrain.swap(terrains.front().colmap);
+			terrains.pop_front();
+			applyTerrain();
+		}
+		finished.push_back(PathResult());
+		search(query, finished.back());
+		return query.ticket;
+	}
+
+	SDL_LockMutex(mutex);
+	pending.push_back(query);
+	SDL_CondSignal(work_ready);
+	SDL_UnlockMutex(mutex);
+
+	return query.ticket;
+}
+
+/**
+ * Take the path of a request once RESULT_DELAY frames have passed since it was made.
+ * If the thread hasn't finished the search by then, this waits for it.
+ * Returns false before that, or if there is no such request; path and found are left alone then.
+ */
+bool PathService::collect(unsigned int ticket, std::vector<FPoint> &path, bool &found) {
+	bool done = false;
+
+	if (thread) SDL_LockMutex(mutex);
+	while (true) {
+		unsigned int requested = 0;
+		bool searched = false;
+		bool known = false;
+		unsigned int index = 0;
+
+		for (unsigned i = 0; i < finished.size() && !known; i++) {
+			if (finished[i].ticket == ticket) {
+				requested = finished[i].frame;
+				searched = known = true;
+				index = i;
+			}
+		}
+		for (unsigned i = 0; i < pending.size() && !known; i++) {
+			if (pending[i].ticket == ticket) {
+				requested = pending[i].frame;
+				known = true;
+			}
+		}
+		if (!known && current == ticket && !current_cancelled) {
+			requested = current_frame;
+			known = true;
+		}
+
+		if (!known || frame < requested + RESULT_DELAY)
+			break;
+
+		if (searched) {
+			path.swap(finished[index].path);
+			found = finished[index].found;
+			finished.erase(finished.begin() + index);
+			done = true;
+			break;
+		}
+
+		// only a thread can have unfinished requests
+		SDL_CondWait(work_done, mutex);
+	}
+	if (thread) SDL_UnlockMutex(mutex);
+
+	return done;
+}
+
+/**
+ * Forget a request, e.g. when the entity which asked for it is removed
+ */
+void PathService::cancel(unsigned int ticket) {
+	if (thread) SDL_LockMutex(mutex);
+
+	for (std::deque<PathRequest>::iterator it = pending.begin(); it != pending.end(); ++it) {
+		if (it->ticket == ticket) {
+			pending.erase(it);
+			break;
+		}
+	}
+	for (unsigned i = 0; i < finished.size(); i++) {
+		if (finished[i].ticket == ticket) {
+			finished.erase(finished.begin() + i);
+			break;
+		}
+	}
+	if (current == ticket)
+		current_cancelled = true;
+
+	if (thread) SDL_UnlockMutex(mutex);
+}
+
+/**
+ * Bring the copy of the map up to date with the terrain taken from the queue.
+ * Only the chunks which differ are replaced, so the pathfinding data of the
+ * rest of the map is kept.
+ */
+void PathService::applyTerrain() {
+	typedef ChunkedGrid<unsigned short> Grid;
+
+	// leave out the entities; they only stand on tiles which are empty otherwise
+	chunk_cells.resize(Grid::CHUNK_CELLS);
+	for (int cy = 0; cy < terrain.getRows(); cy++) {
+		for (int cx = 0; cx < terrain.getColumns(); cx++) {
+			const unsigned short *cells = terrain.getChunk(cx, cy);
+			if (!cells)
+				continue;
+			for (int i = 0; i < Grid::CHUNK_CELLS; i++)
+				chunk_cells[i] = (cells[i] == BLOCKS_ENTITIES || cells[i] == BLOCKS_ENEMIES) ? BLOCKS_NONE : cells[i];
+			terrain.setChunk(cx, cy, &chunk_cells[0]);
+		}
+	}
+
+	if (snapshot.map_size.x != terrain.getWidth() || snapshot.map_size.y != terrain.getHeight()) {
+		snapshot.setmap(terrain);
+		return;
+	}
+
+	for (int cy = 0; cy < terrain.getRows(); cy++) {
+		for (int cx = 0; cx < terrain.getColumns(); cx++) {
+			const unsigned short *cells = terrain.getChunk(cx, cy);
+			const unsigned short *old_cells = snapshot.colmap.getChunk(cx, cy);
+			if (cells == NULL && old_cells == NULL)
+				continue;
+			if (cells && old_cells && std::equal(cells, cells + Grid::CHUNK_CELLS, old_cells))
+				continue;
+
+			const int x = cx * Grid::CHUNK_SIZE;
+			const int y = cy * Grid::CHUNK_SIZE;
+			if (cells)
+				snapshot.colmap.setChunk(cx, cy, cells);
+			else
+				snapshot.colmap.clearRect(x, y, Grid::CHUNK_SIZE, Grid::CHUNK_SIZE);
+			snapshot.invalidate_area(x, y, Grid::CHUNK_SIZE, Grid::CHUNK_SIZE);
+		}
+	}
+}
+
+void PathService::search(PathRequest &query, PathResult &result) {
+	result.ticket = query.ticket;
+	result.frame = query.frame;
+	result.found = snapshot.compute_path(query.start, query.end, result.path, query.movement_type, query.limit);
+}
+
+int PathService::threadMain(void *arg) {
+	PathService *service = static_cast<PathService*>(arg);
+
+	SDL_LockMutex(service->mutex);
+	while (!service->quit) {
+		// a terrain is used once the requests made before it are done
+		if (!service->terrains.empty() && (service->pending.empty() || service->pending.front().generation >= service->terrains.front().generation)) {
+			service->terrain.swap(service->terrains.front().colmap);
+			service->terrains.pop_front();
+			SDL_UnlockMutex(service->mutex);
+
+			service->applyTerrain();
+
+			SDL_LockMutex(service->mutex);
+			continue;
+		}
+
+		if (service->pending.empty()) {
+			SDL_CondWait(service->work_ready, service->mutex);
+			continue;
+		}
+
+		PathRequest query = service->pending.front();
+		service->pending.pop_front();
+		service->current = query.ticket;
+		service->current_frame = query.frame;
+		service->current_cancelled = false;
+		SDL_UnlockMutex(service->mutex);
+
+		PathResult result;
+		service->search(query, result);
+
+		SDL_LockMutex(service->mutex);
+		if (!service->current_cancelled) {
+			service->finished.push_back(PathResult());
+			service->finished.back().ticket = result.ticket;
+			service->finished.back().frame = result.frame;
+			service->finished.back().found = result.found;
+			service->finished.back().path.swap(result.path);
+		}
+		service->current = 0;
+		SDL_CondBroadcast(service->work_done);
+	}
+	SDL_UnlockMutex(service->mutex);
+
+	return 0;
+}
@@ -0,0 +1,117 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+
+/**
+ * class PathService
+ *
+ * Finds paths on a background thread, so a burst of path searches in a big
+ * fight doesn't stall the frame. A path is requested with request(), and the
+ * answer is picked up with collect() RESULT_DELAY frames later. The delay is
+ * counted in frames rather than time, and collect() waits for a late answer,
+ * so recorded games replay the same no matter how the thread is scheduled.
+ *
+ * The thread searches on its own copy of the collision map. update() queues
+ * the terrain whenever the map has changed, and the thread only rebuilds the
+ * parts of its copy which are different. The thread takes the terrains and the
+ * requests in the order they were made, so every path is searched on the
+ * terrain of the frame it was requested on, without the main thread waiting.
+ * Entities are left out of the copy, since they will have moved by the time
+ * the answer is used anyway.
+ */
+
+#pragma once
+#ifndef PATH_SERVICE_H
+#define PATH_SERVICE_H
+
+#include "CommonIncludes.h"
+#include "MapCollision.h"
+
+class PathRequest {
+public:
+	unsigned int ticket;
+	unsigned int frame; // when the path was requested
+	unsigned int generation; // the terrain it was requested on
+	FPoint start;
+	FPoint end;
+	MOVEMENTTYPE movement_type;
+	unsigned int limit;
+};
+
+class PathResult {
+public:
+	unsigned int ticket;
+	unsigned int frame;
+	bool found;
+	std::vector<FPoint> path;
+};
+
+class PathTerrain {
+public:
+	PathTerrain() : generation(0), colmap(BLOCKS_NONE) {}
+
+	unsigned int generation;
+	ChunkedGrid<unsigned short> colmap;
+};
+
+class PathService {
+public:
+	static const unsigned int RESULT_DELAY = 2;
+
+	PathService();
+	~PathService();
+
+	void logic(const MapCollision &collider);
+	void update(const MapCollision &collider);
+
+	unsigned int request(const FPoint &start, const FPoint &end, MOVEMENTTYPE movement_type, unsigned int limit = 0);
+	bool collect(unsigned int ticket, std::vector<FPoint> &path, bool &found);
+	void cancel(unsigned int ticket);
+
+private:
+	PathService(const PathService &copy); // not implemented
+
+	static int threadMain(void *arg);
+	void applyTerrain();
+	void search(PathRequest &query, PathResult &result);
+
+	SDL_Thread *thread;
+	SDL_mutex *mutex;
+	SDL_cond *work_ready;
+	SDL_cond *work_done;
+
+	// terrains handed over by update(), waiting for the requests made before them
+	std::deque<PathTerrain> terrains;
+	unsigned int generation;
+	unsigned int terrain_revision;
+
+	// only used by the thread, or by request() when there is no thread
+	MapCollision snapshot;
+	ChunkedGrid<unsigned short> terrain;
+	std::vector<unsigned short> chunk_cells;
+
+	std::deque<PathRequest> pending;
+	std::vector<PathResult> finished;
+	unsigned int current;
+	unsigned int current_frame;
+	bool current_cancelled;
+	unsigned int frame;
+	unsigned int next_ticket;
+	bool quit;
+};
+
+#endif
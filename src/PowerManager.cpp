@@ -59,7 +59,7 @@ void PowerManager::loadEffects() {
 	FileParser infile;
 
 	// @CLASS Effects|Description of powers/effects.txt
-	if (!infile.open("powers/effects.txt"))
+	if (!infile.openCached("powers/effects.txt"))
 		return;
 
 	std::string input_name = "";
@@ -107,7 +107,7 @@ void PowerManager::loadPowers() {
 	FileParser infile;
 
 	// @CLASS Powers|Description of powers/powers.txt
-	if (!infile.open("powers/powers.txt"))
+	if (!infile.openCached("powers/powers.txt"))
 		return;
 
 	int input_id = 0;
@@ -153,7 +153,7 @@ void PowerManager::loadPowers() {
 			else if (infile.val == "instant") powers[input_id].new_state = POWSTATE_INSTANT;
 			else {
 				powers[input_id].new_state = POWSTATE_ATTACK;
-				powers[input_id].attack_anim = infile.val;
+				powers[input_id].attack_anim = internString(infile.val);
 			}
 		}
 		else if (infile.key == "face")
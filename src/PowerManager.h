@@ -132,7 +132,7 @@ public:
 	std::string description;
 	int icon; // just the number.  The caller menu will have access to the surface.
 	int new_state; // when using this power the user (avatar/enemy) starts a new state
-	std::string attack_anim; // name of the animation to play when using this power, if it is not block
+	StringID attack_anim; // name of the animation to play when using this power, if it is not block
 	bool face; // does the user turn to face the mouse cursor when using this power?
 	int source_type; //hero, neutral, or enemy
 	bool beacon; //true if it's just an ememy calling its allies
@@ -238,7 +238,7 @@ public:
 		, description("")
 		, icon(-1)
 		, new_state(-1)
-		, attack_anim("")
+		, attack_anim(SID_NONE)
 		, face(false)
 		, source_type(-1)
 		, beacon(false)
@@ -0,0 +1,254 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class Profiler
+ *
+ * Measures how much time each engine subsystem takes per frame.
+ */
+
+#include <cstdio>
+
+#include "Profiler.h"
+#include "Settings.h"
+#include "SharedResources.h"
+#include "WidgetLabel.h"
+
+using namespace std;
+
+Profiler::Profiler()
+	: frame_start(0)
+	, frequency(1000)
+	, history_pos(0)
+	, history_size(0)
+	, frame_count(0)
+	, show_overlay(false)
+	, overlay_ticks(0) {
+
+	section_name[PROF_FRAME] = "frame";
+	section_name[PROF_LOGIC] = "logic";
+	section_name[PROF_INPUT] = "input";
+	section_name[PROF_MENU_LOGIC] = "menu_logic";
+	section_name[PROF_AVATAR] = "avatar";
+	section_name[PROF_ENEMIES] = "enemies";
+	section_name[PROF_HAZARDS] = "hazards";
+	section_name[PROF_LOOT] = "loot";
+	section_name[PROF_NPCS] = "npcs";
+	section_name[PROF_MAP_LOGIC] = "map_logic";
+	section_name[PROF_RENDER] = "render";
+	section_name[PROF_RENDER_ADD] = "render_add";
+	section_name[PROF_MAP_RENDER] = "map_render";
+	section_name[PROF_MINIMAP_RENDER] = "minimap_render";
+	section_name[PROF_MENU_RENDER] = "menu_render";
+	section_name[PROF_COMMIT] = "commit";
+	section_name[PROF_LOADING] = "loading";
+	section_name[PROF_LOAD_MAP] = "load_map";
+	section_name[PROF_LOAD_ASSETS] = "load_assets";
+	section_name[PROF_LOAD_TILESET] = "load_tileset";
+	section_name[PROF_LOAD_COLLISION] = "load_collision";
+	section_name[PROF_LOAD_CHUNKS] = "load_chunks";
+	section_name[PROF_LOAD_ENEMIES] = "load_enemies";
+	section_name[PROF_LOAD_NPCS] = "load_npcs";
+	section_name[PROF_LOAD_MINIMAP] = "load_minimap";
+
+	for (int i=0; i<section_count; i++) {
+		start[i] = 0;
+		current[i] = 0;
+		total[i] = 0;
+		peak[i] = 0;
+		labels[i] = NULL;
+		overlay_avg[i] = 0;
+		for (int j=0; j<PROFILER_FRAMES; j++) {
+			history[j][i] = 0;
+		}
+	}
+
+#if SDL_VERSION_ATLEAST(2,0,0)
+	frequency = SDL_GetPerformanceFrequency();
+#endif
+	frame_start = now();
+}
+
+/**
+ * Returns a timestamp in units of 1/frequency seconds
+ */
+Uint64 Profiler::now() {
+#if SDL_VERSION_ATLEAST(2,0,0)
+	return SDL_GetPerformanceCounter();
+#else
+	return SDL_GetTicks();
+#endif
+}
+
+void Profiler::begin(int section) {
+	start[section] = now();
+}
+
+void Profiler::end(int section) {
+	current[section] += now() - start[section];
+}
+
+/**
+ * Store the timings of the current frame in the ring buffer, and start a new frame
+ */
+void Profiler::endFrame() {
+	Uint64 frame_end = now();
+	current[PROF_FRAME] = frame_end - frame_start;
+	frame_start = frame_end;
+
+	for (int i=0; i<section_count; i++) {
+		Uint32 us = (Uint32)(current[i] * 1000000 / frequency);
+		history[history_pos][i] = us;
+		total[i] += us;
+		if (us > peak[i]) peak[i] = us;
+		current[i] = 0;
+	}
+
+	history_pos = (history_pos + 1) % PROFILER_FRAMES;
+	if (history_size < PROFILER_FRAMES) history_size++;
+	frame_count++;
+
+	if (overlay_ticks > 0) overlay_ticks--;
+}
+
+/**
+ * Average time in milliseconds over the frames in the ring buffer
+ */
+float Profiler::getAverage(int section) {
+	if (history_size == 0) return 0;
+
+	Uint64 sum = 0;
+	for (int i=0; i<history_size; i++) {
+		sum += history[i][section];
+	}
+	return (float)sum / history_size / 1000.f;
+}
+
+/**
+ * Longest time in milliseconds over the frames in the ring buffer
+ */
+float Profiler::getMax(int section) {
+	Uint32 max = 0;
+	for (int i=0; i<history_size; i++) {
+		if (history[i][section] > max) max = history[i][section];
+	}
+	return max / 1000.f;
+}
+
+void Profiler::toggleOverlay() {
+	show_overlay = !show_overlay;
+	overlay_ticks = 0;
+}
+
+void Profiler::renderOverlay() {
+	if (!show_overlay) return;
+
+	font->setFont("font_regular");
+	int line_height = font->getLineHeight();
+	int bar_x = VIEW_W / 2;
+
+	// the text labels are only refreshed a few times per second, to keep the cost of the overlay low
+	if (overlay_ticks == 0) {
+		overlay_ticks = MAX_FRAMES_PER_SEC / 4;
+
+		for (int i=0; i<section_count; i++) {
+			overlay_avg[i] = getAverage(i);
+
+			stringstream ss;
+			ss.setf(ios::fixed);
+			ss.precision(2);
+			ss << section_name[i] << ": " << overlay_avg[i] << " ms (max " << getMax(i) << ")";
+
+			if (!labels[i]) labels[i] = new WidgetLabel();
+			labels[i]->set(8, line_height * (i+1), JUSTIFY_LEFT, VALIGN_TOP, ss.str(), FONT_WHITE);
+		}
+	}
+
+	for (int i=0; i<section_count; i++) {
+		if (labels[i]) labels[i]->render();
+
+		// one pixel per 0.1 ms, so the frame budget is easy to compare at a glance
+		int y = line_height * (i+1);
+		int bar_w = (int)(overlay_avg[i] * 10);
+		if (bar_w > 0) {
+			render_device->drawRectangle(Point(bar_x, y + 2), Point(bar_x + bar_w, y + line_height - 2), render_device->MapRGB(255, 255, 0));
+		}
+	}
+}
+
+/**
+ * Write the ring buffer and totals to a file
+ * Files ending in ".json" are written as JSON, anything else as CSV.
+ */
+bool Profiler::dump(const std::string& filename) {
+	FILE *f = fopen(filename.c_str(), "w");
+	if (!f) {
+		fprintf(stderr, "Unable to write profiler data to %s\n", filename.c_str());
+		return false;
+	}
+
+	// oldest frame first
+	int first = (history_size < PROFILER_FRAMES) ? 0 : history_pos;
+
+	bool json = filename.length() > 5 && filename.compare(filename.length()-5, 5, ".json") == 0;
+	if (json) {
+		fprintf(f, "{\n\t\"frames\": %u,\n\t\"sections\": [\n", frame_count);
+		for (int i=0; i<section_count; i++) {
+			float avg_total = frame_count ? (float)total[i] / frame_count / 1000.f : 0;
+			fprintf(f, "\t\t{\"name\": \"%s\", \"avg_ms\": %.3f, \"max_ms\": %.3f, \"history_ms\": [",
+					section_name[i].c_str(), avg_total, peak[i] / 1000.f);
+			for (int j=0; j<history_size; j++) {
+				fprintf(f, "%s%.3f", (j ? ", " : ""), history[(first + j) % PROFILER_FRAMES][i] / 1000.f);
+			}
+			fprintf(f, "]}%s\n", (i < section_count-1 ? "," : ""));
+		}
+		fprintf(f, "\t]\n}\n");
+	}
+	else {
+		fprintf(f, "frame");
+		for (int i=0; i<section_count; i++) {
+			fprintf(f, ",%s_ms", section_name[i].c_str());
+		}
+		fprintf(f, "\n");
+
+		for (int j=0; j<history_size; j++) {
+			fprintf(f, "%u", frame_count - history_size + j);
+			for (int i=0; i<section_count; i++) {
+				fprintf(f, ",%.3f", history[(first + j) % PROFILER_FRAMES][i] / 1000.f);
+			}
+			fprintf(f, "\n");
+		}
+	}
+
+	fclose(f);
+	return true;
+}
+
+Profiler::~Profiler() {
+	for (int i=0; i<section_count; i++) {
+		delete labels[i];
+	}
+}
+
+ProfileScope::ProfileScope(int _section)
+	: section(_section) {
+	if (prof) prof->begin(section);
+}
+
+ProfileScope::~ProfileScope() {
+	if (prof) prof->end(section);
+}
@@ -0,0 +1,120 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class Profiler
+ *
+ * Measures how much time each engine subsystem takes per frame.
+ * Timings of the last PROFILER_FRAMES frames are kept in a ring buffer,
+ * which can be shown as an overlay and written to a CSV or JSON file.
+ */
+
+#pragma once
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "CommonIncludes.h"
+#include "Utils.h"
+
+class WidgetLabel;
+
+// Profiler sections
+const int PROF_FRAME = 0;
+const int PROF_LOGIC = 1;
+const int PROF_INPUT = 2;
+const int PROF_MENU_LOGIC = 3;
+const int PROF_AVATAR = 4;
+const int PROF_ENEMIES = 5;
+const int PROF_HAZARDS = 6;
+const int PROF_LOOT = 7;
+const int PROF_NPCS = 8;
+const int PROF_MAP_LOGIC = 9;
+const int PROF_RENDER = 10;
+const int PROF_RENDER_ADD = 11;
+const int PROF_MAP_RENDER = 12;
+const int PROF_MINIMAP_RENDER = 13;
+const int PROF_MENU_RENDER = 14;
+const int PROF_COMMIT = 15;
+const int PROF_LOADING = 16;
+// stages of loading a map, see GameStatePlay::updateLoading()
+const int PROF_LOAD_MAP = 17;
+const int PROF_LOAD_ASSETS = 18;
+const int PROF_LOAD_TILESET = 19;
+const int PROF_LOAD_COLLISION = 20;
+const int PROF_LOAD_CHUNKS = 21;
+const int PROF_LOAD_ENEMIES = 22;
+const int PROF_LOAD_NPCS = 23;
+const int PROF_LOAD_MINIMAP = 24;
+
+const int PROFILER_FRAMES = 300;
+
+class Profiler {
+public:
+	static const int section_count = 25;
+
+	Profiler();
+	~Profiler();
+
+	void begin(int section);
+	void end(int section);
+	void endFrame();
+
+	void toggleOverlay();
+	void renderOverlay();
+	bool dump(const std::string& filename);
+
+	float getAverage(int section);
+	float getMax(int section);
+
+private:
+	Uint64 now();
+
+	std::string section_name[section_count];
+
+	Uint64 start[section_count];
+	Uint64 current[section_count];
+	Uint64 frame_start;
+	Uint64 frequency;
+
+	// ring buffer of per-frame timings, in microseconds
+	Uint32 history[PROFILER_FRAMES][section_count];
+	int history_pos;
+	int history_size;
+
+	// totals since startup, in microseconds
+	Uint64 total[section_count];
+	Uint32 peak[section_count];
+	Uint32 frame_count;
+
+	bool show_overlay;
+	int overlay_ticks;
+	WidgetLabel *labels[section_count];
+	float overlay_avg[section_count];
+};
+
+/**
+ * Times the enclosing scope under the given profiler section
+ */
+class ProfileScope {
+public:
+	ProfileScope(int _section);
+	~ProfileScope();
+private:
+	int section;
+};
+
+#endif
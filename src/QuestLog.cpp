@@ -79,7 +79,7 @@ void QuestLog::load(const std::string& filename) {
 		// @ATTR quest.quest_text|string|Text that gets displayed in the Quest log when this quest is active.
 		if (!quests.empty()) {
 			Event_Component ev;
-			ev.type = infile.key;
+			ev.type = internString(infile.key);
 			ev.s = msg->get(infile.val);
 			quests.back().push_back(ev);
 		}
@@ -108,18 +108,18 @@ void QuestLog::createQuestList() {
 			// break (skip to next dialog node) if any requirement fails
 			// if we reach an event that is not a requirement, succeed
 
-			if (quests[i][j].type == "requires_status") {
+			if (quests[i][j].type == SID_REQUIRES_STATUS) {
 				if (!camp->checkStatus(quests[i][j].s)) break;
 			}
-			else if (quests[i][j].type == "requires_not_status") {
+			else if (quests[i][j].type == SID_REQUIRES_NOT_STATUS) {
 				if (camp->checkStatus(quests[i][j].s)) break;
 			}
-			else if (quests[i][j].type == "quest_text") {
+			else if (quests[i][j].type == SID_QUEST_TEXT) {
 				log->add(quests[i][j].s, LOG_TYPE_QUESTS);
 				newQuestNotification = true;
 				break;
 			}
-			else if (quests[i][j].type == "") {
+			else if (quests[i][j].type == SID_NONE) {
 				break;
 			}
 		}
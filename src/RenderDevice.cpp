@@ -17,7 +17,9 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include <assert.h>
 #include <stdio.h>
+#include <algorithm>
 #include "RenderDevice.h"
+#include "Settings.h"
 
 
 /*
@@ -25,12 +27,17 @@ FLARE.  If not, see http://www.gnu.org/licenses/
  */
 Image::Image(RenderDevice *_device)
 	: device(_device)
-	, ref_counter(1) {
+	, ref_counter(1)
+	, pending_commands(0)
+	, atlas_page(NULL)
+	, atlas_offset() {
 }
 
 Image::~Image() {
 	/* free resource allocated by renderdevice */
 	device->freeImage(this);
+	if (atlas_page)
+		atlas_page->unref();
 }
 
 void Image::ref() {
@@ -55,6 +62,15 @@ int Image::getHeight() const {
 	return 0;
 }
 
+/**
+ * Recorded screen commands must see the image as it was when they were
+ * recorded, so they are drawn before the image is changed
+ */
+void Image::flushPendingCommands() {
+	if (pending_commands > 0 || (atlas_page && atlas_page->pending_commands > 0))
+		device->flush();
+}
+
 Sprite *Image::createSprite(bool clipToSize) {
 	Sprite *sprite;
 	sprite = new Sprite(this);
@@ -169,12 +185,256 @@ Image * Sprite::getGraphics() {
  * RenderDevice
  */
 RenderDevice::RenderDevice()
-	: is_initialized(false) {
+	: is_initialized(false)
+	, atlas()
+	, commands()
+	, submitted() {
 }
 
 RenderDevice::~RenderDevice() {
 }
 
+int RenderDevice::render(Sprite *r) {
+	if (r == NULL) {
+		return -1;
+	}
+
+	if ( !localToGlobal(r) ) {
+		return -1;
+	}
+
+	RenderCommand cmd;
+	cmd.image = r->getGraphics();
+	cmd.src = m_clip;
+	cmd.dest = m_dest;
+	addCommand(cmd);
+	return 0;
+}
+
+int RenderDevice::render(Renderable& r, Rect dest) {
+	if (!r.image) return -1;
+
+	RenderCommand cmd;
+	cmd.image = r.image;
+	cmd.src = r.src;
+	cmd.dest = dest;
+	addCommand(cmd);
+	return 0;
+}
+
+int RenderDevice::renderImage(Image* image, Rect& src) {
+	if (!image) return -1;
+
+	RenderCommand cmd;
+	cmd.image = image;
+	cmd.src = src;
+	addCommand(cmd);
+	return 0;
+}
+
+int RenderDevice::renderText(TTF_Font *ttf_font, const std::string& text, Color color, Rect& dest) {
+	if (!ttf_font || text.empty()) return -1;
+
+	RenderCommand cmd;
+	cmd.type = RenderCommand::TEXT;
+	cmd.font = ttf_font;
+	cmd.text = text;
+	cmd.text_color = color;
+	cmd.dest.x = dest.x;
+	cmd.dest.y = dest.y;
+	addCommand(cmd);
+	return 0;
+}
+
+void RenderDevice::drawPixel(int x, int y, Uint32 color) {
+	RenderCommand cmd;
+	cmd.type = RenderCommand::PIXEL;
+	cmd.dest.x = x;
+	cmd.dest.y = y;
+	cmd.dest.w = cmd.dest.h = 1;
+	cmd.color = color;
+	addCommand(cmd);
+}
+
+void RenderDevice::drawRectangle(const Point& p0, const Point& p1, Uint32 color) {
+	RenderCommand cmd;
+	cmd.type = RenderCommand::RECTANGLE;
+	cmd.dest.x = p0.x;
+	cmd.dest.y = p0.y;
+	cmd.p1 = p1;
+	cmd.color = color;
+	addCommand(cmd);
+}
+
+void RenderDevice::blankScreen() {
+	// everything recorded so far would be painted over
+	discardCommands();
+
+	RenderCommand cmd;
+	cmd.type = RenderCommand::FILL;
+	cmd.dest = getContextSize();
+	cmd.color = 0;
+	addCommand(cmd);
+}
+
+void RenderDevice::commitFrame() {
+	flush();
+	presentFrame();
+}
+
+void RenderDevice::flush() {
+	if (commands.empty())
+		return;
+
+	// swap the lists, so that anything the backend does while drawing can't
+	// change the list it is working on. Both keep their capacity.
+	commands.swap(submitted);
+	submit(submitted);
+	releaseCommands(submitted);
+}
+
+void RenderDevice::discardCommands() {
+	releaseCommands(commands);
+}
+
+void RenderDevice::addCommand(const RenderCommand &cmd) {
+	commands.push_back(cmd);
+	RenderCommand &added = commands.back();
+
+	if (added.type == RenderCommand::BLIT) {
+		// blits draw the whole source area, no matter what size dest had
+		added.dest.w = added.src.w;
+		added.dest.h = added.src.h;
+
+		if (added.image && added.image->atlas_page && !mapToAtlas(added)) {
+			commands.pop_back();
+			return;
+		}
+	}
+
+	// drop what can't be seen, text is only measured when it is rendered
+	if (added.type != RenderCommand::TEXT && added.type != RenderCommand::RECTANGLE) {
+		if (added.dest.w <= 0 || added.dest.h <= 0 ||
+				added.dest.x >= VIEW_W || added.dest.y >= VIEW_H ||
+				added.dest.x + added.dest.w <= 0 || added.dest.y + added.dest.h <= 0) {
+			commands.pop_back();
+			return;
+		}
+	}
+
+	if (added.image) {
+		added.image->ref();
+		added.image->pending_commands++;
+	}
+}
+
+void RenderDevice::releaseCommands(std::vector<RenderCommand> &list) {
+	for (size_t i = 0; i < list.size(); ++i) {
+		if (list[i].image) {
+			list[i].image->pending_commands--;
+			list[i].image->unref();
+		}
+	}
+	list.clear();
+}
+
+/**
+ * Redirect a blit of a packed image to its atlas page. The page doesn't end
+ * where the image does, so the source area is clipped to the image first, the
+ * same way SDL_BlitSurface clips to the source surface.
+ * Returns false if nothing is left to draw.
+ */
+bool RenderDevice::mapToAtlas(RenderCommand &cmd) {
+	Rect &src = cmd.src;
+	Rect &dest = cmd.dest;
+
+	if (src.x < 0) {
+		src.w += src.x;
+		dest.x -= src.x;
+		src.x = 0;
+	}
+	if (src.y < 0) {
+		src.h += src.y;
+		dest.y -= src.y;
+		src.y = 0;
+	}
+	src.w = std::min(src.w, cmd.image->getWidth() - src.x);
+	src.h = std::min(src.h, cmd.image->getHeight() - src.y);
+	if (src.w <= 0 || src.h <= 0)
+		return false;
+
+	dest.w = src.w;
+	dest.h = src.h;
+	src.x += cmd.image->atlas_offset.x;
+	src.y += cmd.image->atlas_offset.y;
+	cmd.image = cmd.image->atlas_page;
+	return true;
+}
+
+void RenderDevice::setAtlasRegion(Image *image, Image *page, const Point& offset) {
+	if (image->atlas_page)
+		image->atlas_page->unref();
+	image->atlas_page = page;
+	image->atlas_offset = offset;
+}
+
+static bool overlaps(const Rect& a, const Rect& b) {
+	return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+/**
+ * Moving a blit in front of blits it doesn't overlap doesn't change the
+ * result. Each blit is moved back to the last blit of the same image, if there
+ * is one within a short distance and nothing in between is in the way.
+ * Commands other than blits are never passed.
+ */
+void RenderDevice::batchCommands(std::vector<RenderCommand> &list) {
+	const size_t search_distance = 32;
+
+	for (size_t i = 1; i < list.size(); ++i) {
+		if (list[i].type != RenderCommand::BLIT)
+			continue;
+
+		const size_t first = (i > search_distance) ? i - search_distance : 0;
+		size_t target = i;
+
+		for (size_t j = i; j > first; --j) {
+			const RenderCommand &prev = list[j-1];
+			if (prev.type != RenderCommand::BLIT)
+				break;
+			if (prev.image == list[i].image) {
+				target = j;
+				break;
+			}
+			if (overlaps(prev.dest, list[i].dest))
+				break;
+		}
+
+		if (target < i)
+			std::rotate(list.begin() + target, list.begin() + i, list.begin() + i + 1);
+	}
+}
+
+/**
+ * Render the text of a TEXT command and turn it into a BLIT, which holds the
+ * only reference to the rendered text. Returns false if there is nothing to draw.
+ */
+bool RenderDevice::renderTextCommand(RenderCommand &cmd) {
+	if (cmd.type != RenderCommand::TEXT)
+		return true;
+
+	cmd.type = RenderCommand::BLIT;
+	cmd.image = renderTextToImage(cmd.font, cmd.text, cmd.text_color, true);
+	if (!cmd.image)
+		return false;
+
+	cmd.image->pending_commands++;
+	cmd.src.x = cmd.src.y = 0;
+	cmd.src.w = cmd.dest.w = cmd.image->getWidth();
+	cmd.src.h = cmd.dest.h = cmd.image->getHeight();
+	return true;
+}
+
 void RenderDevice::destroyContext() {
 	if (!cache.empty()) {
 		IMAGE_CACHE_CONTAINER_ITER it;
@@ -188,6 +448,10 @@ void RenderDevice::destroyContext() {
 	assert(cache.size() == 0);
 }
 
+bool RenderDevice::needsImage(const std::string &filename) {
+	return cache.find(filename) == cache.end();
+}
+
 Image * RenderDevice::cacheLookup(std::string &filename) {
 	IMAGE_CACHE_CONTAINER_ITER it;
 	it = cache.find(filename);
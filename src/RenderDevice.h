@@ -24,6 +24,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include <vector>
 #include <map>
 #include <SDL_ttf.h>
+#include "ImageAtlas.h"
 #include "Utils.h"
 
 class Image;
@@ -102,6 +103,10 @@ protected:
  * Creating a Sprite of a Image increases the reference counter, destructor of a
  * Sprite will release the reference to the image.
  *
+ * A small image may be packed into an atlas page shared with other images. It
+ * still behaves like a separate image; only screen operations are redirected
+ * to the page, and the image holds a reference to it.
+ *
  * @class Image
  * @author Henrik Andersson
  * @date 2014-01-30
@@ -124,15 +129,24 @@ public:
 
 	class Sprite *createSprite(bool clipToSize = true);
 
+	// draw the recorded screen commands which still read from this image,
+	// backends call this before changing the image's pixels
+	void flushPendingCommands();
+
 private:
 	Image(RenderDevice *device);
 	virtual ~Image();
 	virtual Uint32 readPixel(int x, int y) = 0;
 	friend class SDLSoftwareImage;
+	friend class NullImage;
+	friend class RenderDevice;
 
 private:
 	RenderDevice *device;
 	uint32_t ref_counter;
+	uint32_t pending_commands;
+	Image *atlas_page;
+	Point atlas_offset;
 };
 
 struct Renderable {
@@ -154,6 +168,51 @@ public:
 
 
 
+/** A recorded screen operation
+ *
+ * The screen operations of a RenderDevice are not drawn when they are called.
+ * They are recorded in a command list, which is handed to the backend once per
+ * frame. The backend is free to sort, batch, cull or reorder the commands, as
+ * long as the end result is the same as drawing them in order.
+ *
+ * A command holds a reference to its image until it has been drawn.
+ *
+ * @class RenderCommand
+ * @see RenderDevice
+ */
+class RenderCommand {
+public:
+	enum Type {
+		BLIT = 0,  // image area src at dest
+		TEXT = 1,  // text at dest
+		FILL = 2,  // dest filled with color
+		PIXEL = 3, // a single pixel at dest, filled with color
+		RECTANGLE = 4 // outline from (dest.x, dest.y) to p1
+	};
+
+	Type type;
+	Image *image;
+	Rect src;
+	Rect dest; // w and h are the size of the drawn area, if it is known
+	Point p1;
+	Uint32 color;
+	TTF_Font *font;
+	std::string text;
+	Color text_color;
+
+	RenderCommand()
+		: type(BLIT)
+		, image(NULL)
+		, src()
+		, dest()
+		, p1()
+		, color(0)
+		, font(NULL)
+		, text("")
+		, text_color() {
+	}
+};
+
 /** Provide abstract interface for FLARE engine rendering devices.
  *
  * Provide an abstract interface for renderning a Renderable to the screen.
@@ -165,6 +224,10 @@ public:
  * As this is for the FLARE engine, implementations use the the engine's global
  * settings context.
  *
+ * Screen operations are recorded as RenderCommands. flush() hands the list to
+ * the backend's submit(); commitFrame() flushes and then presents the frame.
+ * Operations on images, such as renderToImage(), are done right away.
+ *
  * @class RenderDevice
  * @author Kurt Rinnert
  * @author Henrik Andersson
@@ -191,22 +254,49 @@ public:
 	virtual Image *createImage(int width, int height) = 0;
 	virtual void freeImage(Image *image) = 0;
 
-	/** Screen operations */
-	virtual int render(Sprite* r) = 0;
-	virtual int render(Renderable& r, Rect dest) = 0;
-	virtual int renderImage(Image* image, Rect& src) = 0;
+	/** Check if loadImage() would decode the file, so it's worth preloading */
+	virtual bool needsImage(const std::string &filename);
+
+	/** Screen operations, recorded until the next flush() */
+	int render(Sprite* r);
+	int render(Renderable& r, Rect dest);
+	int renderImage(Image* image, Rect& src);
+	int renderText(TTF_Font *ttf_font, const std::string& text, Color color, Rect& dest);
+	void blankScreen();
+	void commitFrame();
+	void drawPixel(int x, int y, Uint32 color);
+	void drawRectangle(const Point& p0, const Point& p1, Uint32 color);
+
+	/** Draw all recorded screen operations */
+	void flush();
+
+	/** Image operations */
 	virtual int renderToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest,
 							  bool dest_is_transparent = false) = 0;
-	virtual int renderText(TTF_Font *ttf_font, const std::string& text, Color color, Rect& dest) = 0;
 	virtual Image* renderTextToImage(TTF_Font* ttf_font, const std::string& text, Color color, bool blended = true) = 0;
-	virtual void blankScreen() = 0;
-	virtual void commitFrame() = 0;
-	virtual void drawPixel(int x, int y, Uint32 color) = 0;
-	virtual void drawRectangle(const Point& p0, const Point& p1, Uint32 color) = 0;
 	virtual Uint32 MapRGB(Uint8 r, Uint8 g, Uint8 b) = 0;
 	virtual Uint32 MapRGBA(Uint8 r, Uint8 g, Uint8 b, Uint8 a) = 0;
 
 protected:
+	/** Backend operations
+	 * submit() draws a list of commands on the screen and may reorder it.
+	 * presentFrame() shows the finished screen.
+	 */
+	virtual void submit(std::vector<RenderCommand> &list) = 0;
+	virtual void presentFrame() = 0;
+
+	/* Release the recorded commands without drawing them. */
+	void discardCommands();
+
+	/* Move blits of the same image next to each other, where that doesn't change the result. */
+	static void batchCommands(std::vector<RenderCommand> &list);
+
+	/* Turn a TEXT command into a BLIT of the rendered text. */
+	bool renderTextCommand(RenderCommand &cmd);
+
+	/* Mark image as packed into page at offset. image takes over a reference to page. */
+	void setAtlasRegion(Image *image, Image *page, const Point& offset);
+
 	/* Compute clipping and global position from local frame. */
 	bool localToGlobal(Sprite *r);
 
@@ -220,12 +310,22 @@ protected:
 	Rect m_clip;
 	Rect m_dest;
 
+	ImageAtlas atlas;
+
 private:
 	typedef std::map<std::string, Image *> IMAGE_CACHE_CONTAINER;
 	typedef IMAGE_CACHE_CONTAINER::iterator IMAGE_CACHE_CONTAINER_ITER;
 
 	IMAGE_CACHE_CONTAINER cache;
 
+	void addCommand(const RenderCommand &cmd);
+	bool mapToAtlas(RenderCommand &cmd);
+	void releaseCommands(std::vector<RenderCommand> &list);
+
+	// commands recorded for the next flush, and the list being drawn
+	std::vector<RenderCommand> commands;
+	std::vector<RenderCommand> submitted;
+
 	virtual void drawLine(int x0, int y0, int x1, int y1, Uint32 color) = 0;
 };
 
@@ -21,11 +21,13 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "RenderDeviceList.h"
 
 #include "SDLSoftwareRenderDevice.h"
+#include "NullRenderDevice.h"
 
 RenderDevice* getRenderDevice(std::string name) {
 	// "sdl" is the default
 	if (name != "") {
 		if (name == "sdl") return new SDLSoftwareRenderDevice();
+		else if (name == "null") return new NullRenderDevice();
 		else {
 			fprintf(stderr, "Render device '%s' not found. Falling back to the default.\n", name.c_str());
 			return new SDLSoftwareRenderDevice();
@@ -0,0 +1,624 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include <string.h>
+
+#include "SDL_gfxBlitFunc.h"
+#include "SDLBlitKernels.h"
+
+// The vector kernels are compiled with per-function target attributes, so the
+// rest of the engine doesn't need to be built for a newer instruction set.
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define BLIT_SIMD
+#define BLIT_TARGET_SSE2 __attribute__((target("sse2")))
+#define BLIT_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && _MSC_VER >= 1800 && (defined(_M_X64) || defined(_M_IX86))
+#define BLIT_SIMD
+#define BLIT_TARGET_SSE2
+#define BLIT_TARGET_AVX2
+#endif
+
+#ifdef BLIT_SIMD
+#include <immintrin.h>
+// SDL can only detect AVX2 since 2.0.4
+#if SDL_VERSION_ATLEAST(2,0,4)
+#define BLIT_AVX2
+#endif
+#endif
+
+typedef void (*BlendRowFunc)(Uint32 *dest, const Uint32 *src, int count, bool keep_dest_alpha);
+typedef void (*BlendAdjustedRowFunc)(Uint32 *dest, const Uint32 *src, int count);
+typedef void (*FillRowFunc)(Uint32 *dest, Uint32 color, int count);
+
+static BlendRowFunc blend_row = NULL;
+static BlendAdjustedRowFunc blend_adjusted_row = NULL;
+static FillRowFunc fill_row = NULL;
+static const char *kernel_name = "scalar";
+
+/**
+ * Blend a source pixel over a destination pixel, like SDL does for
+ * SDL_BLENDMODE_BLEND. The alpha is scaled to 0..256, so fully opaque pixels
+ * are copied exactly. With keep_dest_alpha, the destination alpha is left
+ * untouched (SDL 1.2 behaviour).
+ */
+static inline Uint32 blendPixel(Uint32 s, Uint32 d, bool keep_dest_alpha) {
+	const Uint32 sa = s >> 24;
+	const Uint32 a = sa + (sa >> 7);
+	const Uint32 na = 256 - a;
+	const Uint32 rb = (((s & 0xff00ff) * a + (d & 0xff00ff) * na) >> 8) & 0xff00ff;
+	const Uint32 g = (((s & 0xff00) * a + (d & 0xff00) * na) >> 8) & 0xff00;
+	const Uint32 da = d >> 24;
+	const Uint32 oa = keep_dest_alpha ? da : sa + ((da * na) >> 8);
+	return (oa << 24) | rb | g;
+}
+
+/**
+ * x / 255, exact for 0 <= x <= 255*255
+ */
+static inline Uint32 div255(Uint32 x) {
+	return (x + 1 + (x >> 8)) >> 8;
+}
+
+/**
+ * Blend a source pixel onto a possibly transparent destination pixel, with
+ * the alpha transfer function of SDL_gfxBlitRGBA
+ */
+static inline Uint32 blendPixelAdjusted(Uint32 s, Uint32 d) {
+	const Uint32 a = GFX_ALPHA_ADJUST_ARRAY[s >> 24];
+	const Uint32 na = 255 - a;
+	const Uint32 r = div255(((s >> 16) & 0xff) * a + ((d >> 16) & 0xff) * na);
+	const Uint32 g = div255(((s >> 8) & 0xff) * a + ((d >> 8) & 0xff) * na);
+	const Uint32 b = div255((s & 0xff) * a + (d & 0xff) * na);
+	const Uint32 oa = (d >> 24) | a;
+	return (oa << 24) | (r << 16) | (g << 8) | b;
+}
+
+static void blendRowScalar(Uint32 *dest, const Uint32 *src, int count, bool keep_dest_alpha) {
+	for (int i = 0; i < count; ++i) {
+		const Uint32 s = src[i];
+		if ((s >> 24) == 0)
+			continue;
+		else if ((s >> 24) == 255 && !keep_dest_alpha)
+			dest[i] = s;
+		else
+			dest[i] = blendPixel(s, dest[i], keep_dest_alpha);
+	}
+}
+
+static void blendAdjustedRowScalar(Uint32 *dest, const Uint32 *src, int count) {
+	for (int i = 0; i < count; ++i) {
+		if ((src[i] >> 24) != 0)
+			dest[i] = blendPixelAdjusted(src[i], dest[i]);
+	}
+}
+
+static void fillRowScalar(Uint32 *dest, Uint32 color, int count) {
+	for (int i = 0; i < count; ++i)
+		dest[i] = color;
+}
+
+#ifdef BLIT_SIMD
+
+/**
+ * SSE2 kernels, 4 pixels at a time.
+ * Channels are widened to 16 bits, so the products fit without overflow.
+ */
+BLIT_TARGET_SSE2
+static void blendRowSSE2(Uint32 *dest, const Uint32 *src, int count, bool keep_dest_alpha) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i opaque = _mm_set1_epi32(255);
+	const __m128i alpha_mask = _mm_set1_epi32((int)0xff000000);
+	const __m128i c256 = _mm_set1_epi32(256);
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+		const __m128i sa = _mm_srli_epi32(s, 24);
+
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(sa, zero)) == 0xffff)
+			continue;
+		if (!keep_dest_alpha && _mm_movemask_epi8(_mm_cmpeq_epi32(sa, opaque)) == 0xffff) {
+			_mm_storeu_si128((__m128i*)(dest + i), s);
+			continue;
+		}
+
+		const __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+
+		// a = sa + (sa >> 7), repeated for each channel of each pixel
+		const __m128i a = _mm_add_epi32(sa, _mm_srli_epi32(sa, 7));
+		const __m128i na = _mm_sub_epi32(c256, a);
+		const __m128i a16 = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+		const __m128i na16 = _mm_or_si128(na, _mm_slli_epi32(na, 16));
+
+		__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi32(a16, a16)),
+								   _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi32(na16, na16)));
+		__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi32(a16, a16)),
+								   _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi32(na16, na16)));
+		const __m128i color = _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+
+		__m128i oa;
+		if (keep_dest_alpha) {
+			oa = _mm_and_si128(d, alpha_mask);
+		}
+		else {
+			const __m128i da = _mm_srli_epi32(d, 24);
+			oa = _mm_slli_epi32(_mm_add_epi32(sa, _mm_srli_epi32(_mm_mullo_epi16(da, na), 8)), 24);
+		}
+
+		_mm_storeu_si128((__m128i*)(dest + i), _mm_or_si128(_mm_andnot_si128(alpha_mask, color), oa));
+	}
+
+	blendRowScalar(dest + i, src + i, count - i, keep_dest_alpha);
+}
+
+BLIT_TARGET_SSE2
+static void blendAdjustedRowSSE2(Uint32 *dest, const Uint32 *src, int count) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi16(1);
+	const __m128i c255 = _mm_set1_epi32(255);
+	const __m128i alpha_mask = _mm_set1_epi32((int)0xff000000);
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_srli_epi32(s, 24), zero)) == 0xffff)
+			continue;
+
+		const __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+
+		// SSE2 has no gather, so the table is read per pixel
+		const __m128i a = _mm_setr_epi32(GFX_ALPHA_ADJUST_ARRAY[src[i] >> 24], GFX_ALPHA_ADJUST_ARRAY[src[i+1] >> 24],
+										 GFX_ALPHA_ADJUST_ARRAY[src[i+2] >> 24], GFX_ALPHA_ADJUST_ARRAY[src[i+3] >> 24]);
+		const __m128i na = _mm_sub_epi32(c255, a);
+		const __m128i a16 = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+		const __m128i na16 = _mm_or_si128(na, _mm_slli_epi32(na, 16));
+
+		__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi32(a16, a16)),
+								   _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi32(na16, na16)));
+		__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi32(a16, a16)),
+								   _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi32(na16, na16)));
+
+		// divide by 255
+		lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, one), _mm_srli_epi16(lo, 8)), 8);
+		hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, one), _mm_srli_epi16(hi, 8)), 8);
+		const __m128i color = _mm_packus_epi16(lo, hi);
+
+		const __m128i oa = _mm_or_si128(_mm_and_si128(d, alpha_mask), _mm_slli_epi32(a, 24));
+		_mm_storeu_si128((__m128i*)(dest + i), _mm_or_si128(_mm_andnot_si128(alpha_mask, color), oa));
+	}
+
+	blendAdjustedRowScalar(dest + i, src + i, count - i);
+}
+
+BLIT_TARGET_SSE2
+static void fillRowSSE2(Uint32 *dest, Uint32 color, int count) {
+	const __m128i c = _mm_set1_epi32((int)color);
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_si128((__m128i*)(dest + i), c);
+
+	fillRowScalar(dest + i, color, count - i);
+}
+
+#ifdef BLIT_AVX2
+
+/**
+ * AVX2 kernels, 8 pixels at a time.
+ * Unpacking and packing work within 128 bit lanes, so pixel order is kept.
+ */
+BLIT_TARGET_AVX2
+static void blendRowAVX2(Uint32 *dest, const Uint32 *src, int count, bool keep_dest_alpha) {
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i opaque = _mm256_set1_epi32(255);
+	const __m256i alpha_mask = _mm256_set1_epi32((int)0xff000000);
+	const __m256i c256 = _mm256_set1_epi32(256);
+
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+		const __m256i sa = _mm256_srli_epi32(s, 24);
+
+		if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(sa, zero)) == -1)
+			continue;
+		if (!keep_dest_alpha && _mm256_movemask_epi8(_mm256_cmpeq_epi32(sa, opaque)) == -1) {
+			_mm256_storeu_si256((__m256i*)(dest + i), s);
+			continue;
+		}
+
+		const __m256i d = _mm256_loadu_si256((const __m256i*)(dest + i));
+
+		const __m256i a = _mm256_add_epi32(sa, _mm256_srli_epi32(sa, 7));
+		const __m256i na = _mm256_sub_epi32(c256, a);
+		const __m256i a16 = _mm256_or_si256(a, _mm256_slli_epi32(a, 16));
+		const __m256i na16 = _mm256_or_si256(na, _mm256_slli_epi32(na, 16));
+
+		__m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi32(a16, a16)),
+									  _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), _mm256_unpacklo_epi32(na16, na16)));
+		__m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi32(a16, a16)),
+									  _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), _mm256_unpackhi_epi32(na16, na16)));
+		const __m256i color = _mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8));
+
+		__m256i oa;
+		if (keep_dest_alpha) {
+			oa = _mm256_and_si256(d, alpha_mask);
+		}
+		else {
+			const __m256i da = _mm256_srli_epi32(d, 24);
+			oa = _mm256_slli_epi32(_mm256_add_epi32(sa, _mm256_srli_epi32(_mm256_mullo_epi16(da, na), 8)), 24);
+		}
+
+		_mm256_storeu_si256((__m256i*)(dest + i), _mm256_or_si256(_mm256_andnot_si256(alpha_mask, color), oa));
+	}
+
+	blendRowScalar(dest + i, src + i, count - i, keep_dest_alpha);
+}
+
+BLIT_TARGET_AVX2
+static void blendAdjustedRowAVX2(Uint32 *dest, const Uint32 *src, int count) {
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i one = _mm256_set1_epi16(1);
+	const __m256i c255 = _mm256_set1_epi32(255);
+	const __m256i alpha_mask = _mm256_set1_epi32((int)0xff000000);
+
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+		const __m256i sa = _mm256_srli_epi32(s, 24);
+		if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(sa, zero)) == -1)
+			continue;
+
+		const __m256i d = _mm256_loadu_si256((const __m256i*)(dest + i));
+
+		const __m256i a = _mm256_i32gather_epi32((const int*)GFX_ALPHA_ADJUST_ARRAY, sa, 4);
+		const __m256i na = _mm256_sub_epi32(c255, a);
+		const __m256i a16 = _mm256_or_si256(a, _mm256_slli_epi32(a, 16));
+		const __m256i na16 = _mm256_or_si256(na, _mm256_slli_epi32(na, 16));
+
+		__m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi32(a16, a16)),
+									  _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), _mm256_unpacklo_epi32(na16, na16)));
+		__m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi32(a16, a16)),
+									  _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), _mm256_unpackhi_epi32(na16, na16)));
+
+		lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(lo, one), _mm256_srli_epi16(lo, 8)), 8);
+		hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(hi, one), _mm256_srli_epi16(hi, 8)), 8);
+		const __m256i color = _mm256_packus_epi16(lo, hi);
+
+		const __m256i oa = _mm256_or_si256(_mm256_and_si256(d, alpha_mask), _mm256_slli_epi32(a, 24));
+		_mm256_storeu_si256((__m256i*)(dest + i), _mm256_or_si256(_mm256_andnot_si256(alpha_mask, color), oa));
+	}
+
+	blendAdjustedRowScalar(dest + i, src + i, count - i);
+}
+
+BLIT_TARGET_AVX2
+static void fillRowAVX2(Uint32 *dest, Uint32 color, int count) {
+	const __m256i c = _mm256_set1_epi32((int)color);
+
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_si256((__m256i*)(dest + i), c);
+
+	fillRowScalar(dest + i, color, count - i);
+}
+
+#endif // BLIT_AVX2
+#endif // BLIT_SIMD
+
+/**
+ * Pick the fastest kernels the CPU supports
+ */
+void initBlitKernels() {
+	blend_row = blendRowScalar;
+	blend_adjusted_row = blendAdjustedRowScalar;
+	fill_row = fillRowScalar;
+	kernel_name = "scalar";
+
+#ifdef BLIT_SIMD
+	if (SDL_HasSSE2()) {
+		blend_row = blendRowSSE2;
+		blend_adjusted_row = blendAdjustedRowSSE2;
+		fill_row = fillRowSSE2;
+		kernel_name = "SSE2";
+	}
+#ifdef BLIT_AVX2
+	if (SDL_HasAVX2()) {
+		blend_row = blendRowAVX2;
+		blend_adjusted_row = blendAdjustedRowAVX2;
+		fill_row = fillRowAVX2;
+		kernel_name = "AVX2";
+	}
+#endif
+#endif
+}
+
+const char* getBlitKernelName() {
+	if (!blend_row) initBlitKernels();
+	return kernel_name;
+}
+
+static bool isARGB8888(const SDL_PixelFormat *fmt, bool need_alpha) {
+	return fmt->BytesPerPixel == 4
+		   && fmt->Rmask == 0x00ff0000 && fmt->Gmask == 0x0000ff00 && fmt->Bmask == 0x000000ff
+		   && (fmt->Amask == 0xff000000 || (!need_alpha && fmt->Amask == 0));
+}
+
+static Uint32* getPixels(SDL_Surface *surface, int x, int y) {
+#if SDL_VERSION_ATLEAST(2,0,0)
+	Uint8 *pixels = (Uint8 *)surface->pixels;
+#else
+	Uint8 *pixels = (Uint8 *)surface->pixels + surface->offset;
+#endif
+	return (Uint32 *)(pixels + y * surface->pitch) + x;
+}
+
+static bool lockSurfaces(SDL_Surface *src, SDL_Surface *dst) {
+	if (SDL_MUSTLOCK(src) && SDL_LockSurface(src) != 0)
+		return false;
+	if (SDL_MUSTLOCK(dst) && SDL_LockSurface(dst) != 0) {
+		if (SDL_MUSTLOCK(src)) SDL_UnlockSurface(src);
+		return false;
+	}
+	return true;
+}
+
+static void unlockSurfaces(SDL_Surface *src, SDL_Surface *dst) {
+	if (SDL_MUSTLOCK(dst)) SDL_UnlockSurface(dst);
+	if (SDL_MUSTLOCK(src)) SDL_UnlockSurface(src);
+}
+
+/**
+ * Clip a blit to the source surface and a clip rectangle on the destination,
+ * the same way SDL does. Returns false if nothing is left to draw.
+ */
+static bool clipBlit(SDL_Surface *src, SDL_Rect *srcrect, SDL_Rect *dstrect, const SDL_Rect &clip, SDL_Rect &sr, SDL_Rect &dr) {
+	int srcx, srcy, w, h;
+	int dx = dstrect ? dstrect->x : 0;
+	int dy = dstrect ? dstrect->y : 0;
+
+	if (srcrect) {
+		srcx = srcrect->x;
+		w = srcrect->w;
+		if (srcx < 0) {
+			w += srcx;
+			dx -= srcx;
+			srcx = 0;
+		}
+		if (src->w - srcx < w)
+			w = src->w - srcx;
+
+		srcy = srcrect->y;
+		h = srcrect->h;
+		if (srcy < 0) {
+			h += srcy;
+			dy -= srcy;
+			srcy = 0;
+		}
+		if (src->h - srcy < h)
+			h = src->h - srcy;
+	}
+	else {
+		srcx = srcy = 0;
+		w = src->w;
+		h = src->h;
+	}
+
+	if (clip.x > dx) {
+		w -= clip.x - dx;
+		srcx += clip.x - dx;
+		dx = clip.x;
+	}
+	if (dx + w > clip.x + clip.w)
+		w = clip.x + clip.w - dx;
+	if (clip.y > dy) {
+		h -= clip.y - dy;
+		srcy += clip.y - dy;
+		dy = clip.y;
+	}
+	if (dy + h > clip.y + clip.h)
+		h = clip.y + clip.h - dy;
+
+	if (w <= 0 || h <= 0)
+		return false;
+
+	sr.x = srcx;
+	sr.y = srcy;
+	sr.w = dr.w = w;
+	sr.h = dr.h = h;
+	dr.x = dx;
+	dr.y = dy;
+	return true;
+}
+
+enum BlitMode {
+	BLIT_SDL,
+	BLIT_COPY,
+	BLIT_BLEND
+};
+
+/**
+ * Find out how SDL would blit src: copied, alpha blended, or with some
+ * effect (color key, modulation, RLE) the kernels don't handle
+ */
+static BlitMode getBlitMode(SDL_Surface *src) {
+#if SDL_VERSION_ATLEAST(2,0,0)
+	if (src->flags & SDL_RLEACCEL)
+		return BLIT_SDL;
+
+	Uint32 key;
+	if (SDL_GetColorKey(src, &key) == 0)
+		return BLIT_SDL;
+
+	Uint8 alpha = 0;
+	Uint8 r = 0, g = 0, b = 0;
+	if (SDL_GetSurfaceAlphaMod(src, &alpha) != 0 || alpha != 255)
+		return BLIT_SDL;
+	if (SDL_GetSurfaceColorMod(src, &r, &g, &b) != 0 || r != 255 || g != 255 || b != 255)
+		return BLIT_SDL;
+
+	SDL_BlendMode mode;
+	if (SDL_GetSurfaceBlendMode(src, &mode) != 0)
+		return BLIT_SDL;
+	if (mode == SDL_BLENDMODE_BLEND)
+		return BLIT_BLEND;
+	if (mode == SDL_BLENDMODE_NONE)
+		return BLIT_COPY;
+	return BLIT_SDL;
+#else
+	if (src->flags & (SDL_SRCCOLORKEY | SDL_RLEACCEL))
+		return BLIT_SDL;
+	return (src->flags & SDL_SRCALPHA) ? BLIT_BLEND : BLIT_COPY;
+#endif
+}
+
+/**
+ * Draw the already clipped rectangle sr of src at dr on dst
+ */
+static void blitRows(SDL_Surface *src, const SDL_Rect &sr, SDL_Surface *dst, const SDL_Rect &dr, BlitMode mode) {
+#if SDL_VERSION_ATLEAST(2,0,0)
+	const bool keep_dest_alpha = (dst->format->Amask == 0);
+#else
+	const bool keep_dest_alpha = true;
+#endif
+
+	for (int y = 0; y < sr.h; ++y) {
+		Uint32 *d = getPixels(dst, dr.x, dr.y + y);
+		const Uint32 *s = getPixels(src, sr.x, sr.y + y);
+		if (mode == BLIT_BLEND)
+			blend_row(d, s, sr.w, keep_dest_alpha);
+		else
+			memcpy(d, s, sr.w * sizeof(Uint32));
+	}
+}
+
+int blitARGB(SDL_Surface *src, SDL_Rect *srcrect, SDL_Surface *dst, SDL_Rect *dstrect) {
+	if (!src || !dst || src->locked || dst->locked || !isARGB8888(src->format, true) || !isARGB8888(dst->format, false))
+		return SDL_BlitSurface(src, srcrect, dst, dstrect);
+
+	const BlitMode mode = getBlitMode(src);
+	if (mode == BLIT_SDL)
+		return SDL_BlitSurface(src, srcrect, dst, dstrect);
+
+	if (!blend_row) initBlitKernels();
+
+	SDL_Rect sr, dr;
+	if (!clipBlit(src, srcrect, dstrect, dst->clip_rect, sr, dr)) {
+		if (dstrect) dstrect->w = dstrect->h = 0;
+		return 0;
+	}
+	if (dstrect) *dstrect = dr;
+
+	if (!lockSurfaces(src, dst))
+		return SDL_BlitSurface(src, &sr, dst, &dr);
+
+	blitRows(src, sr, dst, dr, mode);
+
+	unlockSurfaces(src, dst);
+	return 0;
+}
+
+/**
+ * Check if blitARGB can draw src onto dst without calling SDL or locking,
+ * which also makes it safe to use from several threads at once
+ */
+bool canBlitARGB(SDL_Surface *src, SDL_Surface *dst) {
+	return src && canBlitARGBOnto(dst) && isARGB8888(src->format, true) && !SDL_MUSTLOCK(src) && getBlitMode(src) != BLIT_SDL;
+}
+
+/**
+ * Check if dst is a surface the thread-safe variants can draw onto
+ */
+bool canBlitARGBOnto(SDL_Surface *dst) {
+	return dst && isARGB8888(dst->format, false) && !SDL_MUSTLOCK(dst);
+}
+
+/**
+ * Same as blitARGB, but limited to clip instead of the clip rectangle of dst.
+ * canBlitARGB must be true for src and dst.
+ */
+void blitARGBClipped(SDL_Surface *src, const SDL_Rect &srcrect, SDL_Surface *dst, const SDL_Rect &dstrect, const SDL_Rect &clip) {
+	if (!blend_row) initBlitKernels();
+
+	SDL_Rect src_in = srcrect;
+	SDL_Rect dest_in = dstrect;
+	SDL_Rect sr, dr;
+	if (clipBlit(src, &src_in, &dest_in, clip, sr, dr))
+		blitRows(src, sr, dst, dr, getBlitMode(src));
+}
+
+/**
+ * Same as fillARGB, but limited to clip instead of the clip rectangle of dst.
+ * dst must be a 32 bit surface which doesn't need locking.
+ */
+void fillARGBClipped(SDL_Surface *dst, const SDL_Rect &dstrect, Uint32 color, const SDL_Rect &clip) {
+	if (!fill_row) initBlitKernels();
+
+	const int x0 = std::max((int)clip.x, (int)dstrect.x);
+	const int y0 = std::max((int)clip.y, (int)dstrect.y);
+	const int x1 = std::min(clip.x + clip.w, dstrect.x + dstrect.w);
+	const int y1 = std::min(clip.y + clip.h, dstrect.y + dstrect.h);
+
+	for (int y = y0; y < y1 && x0 < x1; ++y)
+		fill_row(getPixels(dst, x0, y), color, x1 - x0);
+}
+
+int blitARGBAdjusted(SDL_Surface *src, SDL_Rect *srcrect, SDL_Surface *dst, SDL_Rect *dstrect) {
+	if (!src || !dst || src->locked || dst->locked || !isARGB8888(src->format, true) || !isARGB8888(dst->format, true)
+			|| (src->flags & SDL_RLEACCEL) || (dst->flags & SDL_RLEACCEL))
+		return SDL_gfxBlitRGBA(src, srcrect, dst, dstrect);
+
+	if (!blend_row) initBlitKernels();
+
+	SDL_Rect sr, dr;
+	if (!clipBlit(src, srcrect, dstrect, dst->clip_rect, sr, dr))
+		return 0;
+
+	for (int y = 0; y < sr.h; ++y)
+		blend_adjusted_row(getPixels(dst, dr.x, dr.y + y), getPixels(src, sr.x, sr.y + y), sr.w);
+
+	return 1;
+}
+
+int fillARGB(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color) {
+	if (!dst || dst->format->BytesPerPixel != 4 || (dst->flags & SDL_RLEACCEL))
+		return SDL_FillRect(dst, dstrect, color);
+
+	if (!fill_row) initBlitKernels();
+
+	const SDL_Rect &clip = dst->clip_rect;
+	int x0 = clip.x;
+	int y0 = clip.y;
+	int x1 = clip.x + clip.w;
+	int y1 = clip.y + clip.h;
+	if (dstrect) {
+		x0 = std::max(x0, (int)dstrect->x);
+		y0 = std::max(y0, (int)dstrect->y);
+		x1 = std::min(x1, dstrect->x + dstrect->w);
+		y1 = std::min(y1, dstrect->y + dstrect->h);
+	}
+	if (x1 <= x0 || y1 <= y0)
+		return 0;
+
+	if (SDL_MUSTLOCK(dst) && SDL_LockSurface(dst) != 0)
+		return SDL_FillRect(dst, dstrect, color);
+
+	for (int y = y0; y < y1; ++y)
+		fill_row(getPixels(dst, x0, y), color, x1 - x0);
+
+	if (SDL_MUSTLOCK(dst)) SDL_UnlockSurface(dst);
+	return 0;
+}
@@ -0,0 +1,51 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * SDLBlitKernels
+ *
+ * Blit and fill functions for the ARGB8888 surfaces of the software renderer.
+ * The inner loops come in scalar, SSE2 and AVX2 versions; the fastest one the
+ * CPU supports is picked at startup. Surfaces in any other format, or with
+ * color keys and modulation, are passed on to SDL.
+ */
+
+#pragma once
+#ifndef SDL_BLIT_KERNELS_H
+#define SDL_BLIT_KERNELS_H
+
+#include "CommonIncludes.h"
+
+void initBlitKernels();
+const char* getBlitKernelName();
+
+// same as SDL_BlitSurface
+int blitARGB(SDL_Surface *src, SDL_Rect *srcrect, SDL_Surface *dst, SDL_Rect *dstrect);
+
+// same as SDL_gfxBlitRGBA, for blitting onto transparent surfaces
+int blitARGBAdjusted(SDL_Surface *src, SDL_Rect *srcrect, SDL_Surface *dst, SDL_Rect *dstrect);
+
+// same as SDL_FillRect
+int fillARGB(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color);
+
+// thread-safe variants with an explicit clip rectangle, see canBlitARGB
+bool canBlitARGB(SDL_Surface *src, SDL_Surface *dst);
+bool canBlitARGBOnto(SDL_Surface *dst);
+void blitARGBClipped(SDL_Surface *src, const SDL_Rect &srcrect, SDL_Surface *dst, const SDL_Rect &dstrect, const SDL_Rect &clip);
+void fillARGBClipped(SDL_Surface *dst, const SDL_Rect &dstrect, Uint32 color, const SDL_Rect &clip);
+
+#endif
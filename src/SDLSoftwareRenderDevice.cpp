@@ -21,12 +21,14 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include <stdio.h>
 #include <stdlib.h>
-#include "SDL_gfxBlitFunc.h"
+#include <string.h>
+#include "SDLBlitKernels.h"
 
 #include "SharedResources.h"
 #include "Settings.h"
 
 #include "SDLSoftwareRenderDevice.h"
+#include "WorkerPool.h"
 
 using namespace std;
 
@@ -48,13 +50,14 @@ int SDLSoftwareImage::getHeight() const {
 
 void SDLSoftwareImage::fillWithColor(Rect *dstrect, Uint32 color) {
 	if (!surface) return;
+	flushPendingCommands();
 
 	if (dstrect) {
 		SDL_Rect dest = *dstrect;
-		SDL_FillRect(surface, &dest, color);
+		fillARGB(surface, &dest, color);
 	}
 	else {
-		SDL_FillRect(surface, NULL, color);
+		fillARGB(surface, NULL, color);
 	}
 }
 
@@ -67,6 +70,7 @@ void SDLSoftwareImage::fillWithColor(Rect *dstrect, Uint32 color) {
  */
 void SDLSoftwareImage::drawPixel(int x, int y, Uint32 pixel) {
 	if (!surface) return;
+	flushPendingCommands();
 
 	int bpp = surface->format->BytesPerPixel;
 	/* Here p is the address to the pixel we want to set */
@@ -261,12 +265,20 @@ SDLSoftwareRenderDevice::SDLSoftwareRenderDevice()
 	, texture(NULL)
 #endif
 	, titlebar_icon(NULL)
-	, title(NULL) {
+	, title(NULL)
+	, workers(NULL)
+	, banded(false)
+	, band_count(1)
+	, band_list(NULL)
+	, band_begin(0)
+	, band_end(0) {
 #if SDL_VERSION_ATLEAST(2,0,0)
 	cout << "Using Render Device: SDLSoftwareRenderDevice (software, SDL 2)" << endl;
 #else
 	cout << "Using Render Device: SDLSoftwareRenderDevice (software, SDL 1.2)" << endl;
 #endif
+	initBlitKernels();
+	cout << "Using blit kernels: " << getBlitKernelName() << endl;
 }
 
 int SDLSoftwareRenderDevice::createContext(int width, int height) {
@@ -278,7 +290,7 @@ int SDLSoftwareRenderDevice::createContext(int width, int height) {
 
 	// window title and icon
 	title = strdup(msg->get(WINDOW_TITLE).c_str());
-	titlebar_icon = IMG_Load(mods->locate("images/logo/icon.png").c_str());
+	titlebar_icon = IMG_Load_RW(mods->openRW(mods->locate("images/logo/icon.png")), 1);
 
 #if SDL_VERSION_ATLEAST(2,0,0)
 	Uint32 w_flags = 0;
@@ -331,6 +343,18 @@ int SDLSoftwareRenderDevice::createContext(int width, int height) {
 		is_initialized = true;
 	}
 
+	atlas.init(this, ATLAS_PAGE_SIZE);
+
+	// draw in bands only if the kernels can draw into bands of the screen
+	if (window_created) {
+		if (!workers)
+			workers = new WorkerPool(RENDER_THREADS);
+		banded = workers->getThreadCount() > 1 && canBlitARGBOnto(screen);
+		band_count = workers->getThreadCount() * 2;
+		if (banded)
+			cout << "Software rendering with " << workers->getThreadCount() << " threads" << endl;
+	}
+
 	if (is_initialized) {
 #if SDL_VERSION_ATLEAST(2,0,0)
 		// title was already set when creating the window
@@ -352,66 +376,20 @@ Rect SDLSoftwareRenderDevice::getContextSize() {
 	return size;
 }
 
-int SDLSoftwareRenderDevice::render(Renderable& r, Rect dest) {
-	SDL_Rect src = r.src;
-	SDL_Rect _dest = dest;
-	return SDL_BlitSurface(static_cast<SDLSoftwareImage *>(r.image)->surface, &src, screen, &_dest);
-}
-
-int SDLSoftwareRenderDevice::render(Sprite *r) {
-	if (r == NULL) {
-		return -1;
-	}
-
-	if ( !localToGlobal(r) ) {
-		return -1;
-	}
-
-	SDL_Rect src = m_clip;
-	SDL_Rect dest = m_dest;
-	return SDL_BlitSurface(static_cast<SDLSoftwareImage *>(r->getGraphics())->surface, &src, screen, &dest);
-}
-
-int SDLSoftwareRenderDevice::renderImage(Image* image, Rect& src) {
-	if (!image) return -1;
-	SDL_Rect _src = src;
-	return SDL_BlitSurface(static_cast<SDLSoftwareImage *>(image)->surface, &_src, screen , 0);
-}
-
 int SDLSoftwareRenderDevice::renderToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest, bool dest_is_transparent) {
 	if (!src_image || !dest_image) return -1;
 
 	SDL_Rect _src = src;
 	SDL_Rect _dest = dest;
 
+	dest_image->flushPendingCommands();
+
 	if (dest_is_transparent)
-		return SDL_gfxBlitRGBA(static_cast<SDLSoftwareImage *>(src_image)->surface, &_src,
-							   static_cast<SDLSoftwareImage *>(dest_image)->surface, &_dest);
+		return blitARGBAdjusted(static_cast<SDLSoftwareImage *>(src_image)->surface, &_src,
+								static_cast<SDLSoftwareImage *>(dest_image)->surface, &_dest);
 	else
-		return SDL_BlitSurface(static_cast<SDLSoftwareImage *>(src_image)->surface, &_src,
-							   static_cast<SDLSoftwareImage *>(dest_image)->surface, &_dest);
-}
-
-int SDLSoftwareRenderDevice::renderText(
-	TTF_Font *ttf_font,
-	const std::string& text,
-	Color color,
-	Rect& dest
-) {
-	int ret = 0;
-	SDL_Color _color = color;
-
-	SDL_Surface *surface = TTF_RenderUTF8_Blended(ttf_font, text.c_str(), _color);
-
-	if (surface == NULL)
-		return -1;
-
-	SDL_Rect _dest = dest;
-	ret = SDL_BlitSurface(surface, NULL, screen, &_dest);
-
-	SDL_FreeSurface(surface);
-
-	return ret;
+		return blitARGB(static_cast<SDLSoftwareImage *>(src_image)->surface, &_src,
+						static_cast<SDLSoftwareImage *>(dest_image)->surface, &_dest);
 }
 
 Image* SDLSoftwareRenderDevice::renderTextToImage(TTF_Font* ttf_font, const std::string& text, Color color, bool blended) {
@@ -432,7 +410,10 @@ Image* SDLSoftwareRenderDevice::renderTextToImage(TTF_Font* ttf_font, const std:
 	return NULL;
 }
 
-void SDLSoftwareRenderDevice::drawPixel(
+/**
+ * Set a pixel of the screen, for drawing lines
+ */
+void SDLSoftwareRenderDevice::drawScreenPixel(
 	int x,
 	int y,
 	Uint32 color
@@ -441,9 +422,6 @@ void SDLSoftwareRenderDevice::drawPixel(
 	/* Here p is the address to the pixel we want to set */
 	Uint8 *p = (Uint8 *)screen->pixels + y * screen->pitch + x * bpp;
 
-	if (SDL_MUSTLOCK(screen)) {
-		SDL_LockSurface(screen);
-	}
 	switch(bpp) {
 		case 1:
 			*p = color;
@@ -469,11 +447,6 @@ void SDLSoftwareRenderDevice::drawPixel(
 			*(Uint32 *)p = color;
 			break;
 	}
-	if (SDL_MUSTLOCK(screen)) {
-		SDL_UnlockSurface(screen);
-	}
-
-	return;
 }
 
 void SDLSoftwareRenderDevice::drawLine(
@@ -492,7 +465,7 @@ void SDLSoftwareRenderDevice::drawLine(
 	do {
 		//skip draw if outside screen
 		if (x0 > 0 && y0 > 0 && x0 < VIEW_W && y0 < VIEW_H) {
-			this->drawPixel(x0,y0,color);
+			drawScreenPixel(x0,y0,color);
 		}
 
 		int e2 = 2*err;
@@ -508,29 +481,126 @@ void SDLSoftwareRenderDevice::drawLine(
 	while(x0 != x1 || y0 != y1);
 }
 
-void SDLSoftwareRenderDevice::drawRectangle(
-	const Point& p0,
-	const Point& p1,
-	Uint32 color
-) {
-	if (SDL_MUSTLOCK(screen)) {
-		SDL_LockSurface(screen);
+bool SDLSoftwareRenderDevice::isParallel(const RenderCommand& cmd) {
+	switch (cmd.type) {
+		case RenderCommand::BLIT:
+			return cmd.image && canBlitARGB(static_cast<SDLSoftwareImage *>(cmd.image)->surface, screen);
+		case RenderCommand::FILL:
+		case RenderCommand::PIXEL:
+			return true;
+		default:
+			return false;
 	}
-	this->drawLine(p0.x, p0.y, p1.x, p0.y, color);
-	this->drawLine(p1.x, p0.y, p1.x, p1.y, color);
-	this->drawLine(p0.x, p0.y, p0.x, p1.y, color);
-	this->drawLine(p0.x, p1.y, p1.x, p1.y, color);
-	if (SDL_MUSTLOCK(screen)) {
-		SDL_UnlockSurface(screen);
+}
+
+/**
+ * Draw the commands in order. Text is rendered first, on this thread. Blits
+ * are then batched by source image. With more than one thread, runs of
+ * commands the kernels can handle are drawn band by band in parallel, and
+ * anything else is drawn in between.
+ */
+void SDLSoftwareRenderDevice::submit(std::vector<RenderCommand> &list) {
+	for (size_t i = 0; i < list.size(); ++i)
+		renderTextCommand(list[i]);
+
+	batchCommands(list);
+
+	if (!banded) {
+		for (size_t i = 0; i < list.size(); ++i)
+			drawCommand(list[i], NULL);
+		return;
+	}
+
+	size_t i = 0;
+	while (i < list.size()) {
+		size_t end = i;
+		while (end < list.size() && isParallel(list[end]))
+			++end;
+
+		if (end > i) {
+			band_list = &list;
+			band_begin = i;
+			band_end = end;
+			workers->run(drawBand, this, band_count);
+			band_list = NULL;
+			i = end;
+		}
+		else {
+			drawCommand(list[i], NULL);
+			++i;
+		}
 	}
 }
 
-void SDLSoftwareRenderDevice::blankScreen() {
-	SDL_FillRect(screen, NULL, 0);
-	return;
+/**
+ * Draw one command. If clip is given, the command is drawn by the kernels and
+ * only inside clip, which is safe to do from a worker thread.
+ */
+void SDLSoftwareRenderDevice::drawCommand(const RenderCommand& cmd, const SDL_Rect *clip) {
+	Rect _src = cmd.src;
+	Rect _dest = cmd.dest;
+	SDL_Rect src = _src;
+	SDL_Rect dest = _dest;
+
+	switch (cmd.type) {
+		case RenderCommand::BLIT:
+			if (!cmd.image) break;
+			if (clip)
+				blitARGBClipped(static_cast<SDLSoftwareImage *>(cmd.image)->surface, src, screen, dest, *clip);
+			else
+				blitARGB(static_cast<SDLSoftwareImage *>(cmd.image)->surface, &src, screen, &dest);
+			break;
+
+		case RenderCommand::FILL:
+		case RenderCommand::PIXEL:
+			if (clip)
+				fillARGBClipped(screen, dest, cmd.color, *clip);
+			else
+				fillARGB(screen, &dest, cmd.color);
+			break;
+
+		case RenderCommand::RECTANGLE:
+			if (SDL_MUSTLOCK(screen)) {
+				SDL_LockSurface(screen);
+			}
+			drawLine(cmd.dest.x, cmd.dest.y, cmd.p1.x, cmd.dest.y, cmd.color);
+			drawLine(cmd.p1.x, cmd.dest.y, cmd.p1.x, cmd.p1.y, cmd.color);
+			drawLine(cmd.dest.x, cmd.dest.y, cmd.dest.x, cmd.p1.y, cmd.color);
+			drawLine(cmd.dest.x, cmd.p1.y, cmd.p1.x, cmd.p1.y, cmd.color);
+			if (SDL_MUSTLOCK(screen)) {
+				SDL_UnlockSurface(screen);
+			}
+			break;
+
+		default:
+			break;
+	}
 }
 
-void SDLSoftwareRenderDevice::commitFrame() {
+/**
+ * Worker job: replay the current range of commands, clipped to one band of the screen
+ */
+void SDLSoftwareRenderDevice::drawBand(void *data, int band) {
+	SDLSoftwareRenderDevice *device = static_cast<SDLSoftwareRenderDevice *>(data);
+	SDL_Surface *screen = device->screen;
+
+	const int top = screen->h * band / device->band_count;
+	const int bottom = screen->h * (band + 1) / device->band_count;
+
+	SDL_Rect clip = screen->clip_rect;
+	const int clip_top = std::max((int)clip.y, top);
+	const int clip_bottom = std::min(clip.y + clip.h, bottom);
+	if (clip_bottom <= clip_top)
+		return;
+	clip.y = clip_top;
+	clip.h = clip_bottom - clip_top;
+
+	const std::vector<RenderCommand> &list = *device->band_list;
+	for (size_t i = device->band_begin; i < device->band_end; ++i)
+		device->drawCommand(list[i], &clip);
+}
+
+void SDLSoftwareRenderDevice::presentFrame() {
 #if SDL_VERSION_ATLEAST(2,0,0)
 	SDL_UpdateTexture(texture, NULL, screen->pixels, screen->pitch);
 	SDL_RenderClear(renderer);
@@ -543,6 +613,11 @@ void SDLSoftwareRenderDevice::commitFrame() {
 }
 
 void SDLSoftwareRenderDevice::destroyContext() {
+	discardCommands();
+	delete workers;
+	workers = NULL;
+	banded = false;
+
 	if (titlebar_icon) {
 		SDL_FreeSurface(titlebar_icon);
 		titlebar_icon = NULL;
@@ -701,7 +776,10 @@ Image *SDLSoftwareRenderDevice::loadImage(std::string filename, std::string erro
 	// load image
 	SDLSoftwareImage *image;
 	image = NULL;
-	SDL_Surface *cleanup = IMG_Load(mods->locate(filename).c_str());
+	// the image may have been decoded on a worker thread already
+	SDL_Surface *cleanup = assets ? assets->takeImage(filename) : NULL;
+	if (!cleanup)
+		cleanup = IMG_Load_RW(mods->openRW(mods->locate(filename)), 1);
 	if(!cleanup) {
 		if (!errormessage.empty())
 			fprintf(stderr, "%s: %s\n", errormessage.c_str(), IMG_GetError());
@@ -718,6 +796,9 @@ Image *SDLSoftwareRenderDevice::loadImage(std::string filename, std::string erro
 		image->surface = SDL_DisplayFormatAlpha(cleanup);
 #endif
 		SDL_FreeSurface(cleanup);
+
+		if (image->surface)
+			packImage(image);
 	}
 
 	// store image to cache
@@ -729,6 +810,7 @@ void SDLSoftwareRenderDevice::freeImage(Image *image) {
 	if (!image) return;
 
 	cacheRemove(image);
+	atlas.removePage(image);
 
 	if (static_cast<SDLSoftwareImage *>(image)->surface)
 		SDL_FreeSurface(static_cast<SDLSoftwareImage *>(image)->surface);
@@ -748,3 +830,50 @@ void SDLSoftwareRenderDevice::setSDL_RGBA(Uint32 *rmask, Uint32 *gmask, Uint32 *
 #endif
 }
 
+/**
+ * Copy a small image into an atlas page. The image keeps a surface of its own,
+ * which uses the pixels in the page, so everything but screen blits works the
+ * same as before.
+ */
+bool SDLSoftwareRenderDevice::packImage(SDLSoftwareImage *image) {
+	SDL_Surface *surface = image->surface;
+	if (!atlas.fits(surface->w, surface->h))
+		return false;
+	if (surface->format->BytesPerPixel != 4 || SDL_MUSTLOCK(surface))
+		return false;
+
+	Point pos;
+	SDLSoftwareImage *page = static_cast<SDLSoftwareImage *>(atlas.insert(surface->w, surface->h, pos));
+	if (!page)
+		return false;
+
+	SDL_Surface *page_surface = page->surface;
+	if (SDL_MUSTLOCK(page_surface) || page_surface->format->BytesPerPixel != 4 ||
+			page_surface->format->Amask != surface->format->Amask ||
+			page_surface->format->Rmask != surface->format->Rmask) {
+		// the space stays unused, which only costs memory
+		page->unref();
+		return false;
+	}
+
+	Uint8 *pixels = static_cast<Uint8 *>(page_surface->pixels) + pos.y * page_surface->pitch + pos.x * 4;
+	for (int y = 0; y < surface->h; ++y)
+		memcpy(pixels + y * page_surface->pitch, static_cast<Uint8 *>(surface->pixels) + y * surface->pitch, surface->w * 4);
+
+	SDL_Surface *view = SDL_CreateRGBSurfaceFrom(pixels, surface->w, surface->h, 32, page_surface->pitch,
+						surface->format->Rmask, surface->format->Gmask,
+						surface->format->Bmask, surface->format->Amask);
+	if (!view) {
+		page->unref();
+		return false;
+	}
+
+#if !SDL_VERSION_ATLEAST(2,0,0)
+	SDL_SetAlpha(view, surface->flags & SDL_SRCALPHA, surface->format->alpha);
+#endif
+
+	SDL_FreeSurface(surface);
+	image->surface = view;
+	setAtlasRegion(image, page, pos);
+	return true;
+}
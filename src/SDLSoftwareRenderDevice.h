@@ -23,6 +23,8 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include "RenderDevice.h"
 
+class WorkerPool;
+
 /** Provide rendering device using SDL_BlitSurface backend.
  *
  * Provide an SDL_BlitSurface implementation for renderning a Renderable to
@@ -31,6 +33,10 @@ FLARE.  If not, see http://www.gnu.org/licenses/
  * As this is for the FLARE engine, the implementation uses the engine's
  * global settings context, which is included by the interface.
  *
+ * When more than one render thread is available, the screen is split into
+ * horizontal bands, and the submitted commands are replayed on each band by a
+ * worker pool.
+ *
  * @class SDLSoftwareRenderDevice
  * @see RenderDevice
  * @author Kurt Rinnert
@@ -68,17 +74,9 @@ public:
 	int createContext(int width, int height);
 	Rect getContextSize();
 
-	virtual int render(Renderable& r, Rect dest);
-	virtual int render(Sprite* r);
-	virtual int renderImage(Image* image, Rect& src);
 	virtual int renderToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest, bool dest_is_transparent = false);
 
-	int renderText(TTF_Font *ttf_font, const std::string& text, Color color, Rect& dest);
 	Image* renderTextToImage(TTF_Font* ttf_font, const std::string& text, Color color, bool blended = true);
-	void drawPixel(int x, int y, Uint32 color);
-	void drawRectangle(const Point& p0, const Point& p1, Uint32 color);
-	void blankScreen();
-	void commitFrame();
 	void destroyContext();
 	Uint32 MapRGB(Uint8 r, Uint8 g, Uint8 b);
 	Uint32 MapRGBA(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
@@ -90,9 +88,20 @@ public:
 	Image* loadImage(std::string filename,
 					 std::string errormessage = "Couldn't load image",
 					 bool IfNotFoundExit = false);
+
+protected:
+	void submit(std::vector<RenderCommand> &list);
+	void presentFrame();
+
 private:
 	void drawLine(int x0, int y0, int x1, int y1, Uint32 color);
+	void drawScreenPixel(int x, int y, Uint32 color);
 	void setSDL_RGBA(Uint32 *rmask, Uint32 *gmask, Uint32 *bmask, Uint32 *amask);
+	bool packImage(SDLSoftwareImage *image);
+
+	bool isParallel(const RenderCommand& cmd);
+	void drawCommand(const RenderCommand& cmd, const SDL_Rect *clip);
+	static void drawBand(void *data, int band);
 
 	SDL_Surface* screen;
 #if SDL_VERSION_ATLEAST(2,0,0)
@@ -102,6 +111,15 @@ private:
 #endif
 	SDL_Surface* titlebar_icon;
 	char* title;
+
+	WorkerPool *workers;
+	bool banded;
+	int band_count;
+
+	// the range of commands drawBand replays
+	std::vector<RenderCommand> *band_list;
+	size_t band_begin;
+	size_t band_end;
 };
 
 #endif // SDLSOFTWARERENDERDEVICE_H
@@ -25,6 +25,9 @@ freely, subject to the following restrictions:
 
 Andreas Schiffler -- aschiffler at ferzkopp dot net
 
+Altered for FLARE: the alpha adjustment table is exported, so the vectorized
+blitters in SDLBlitKernels.cpp apply the same transfer function.
+
 */
 
 #include "SDL_gfxBlitFunc.h"
@@ -36,7 +39,7 @@ The table provides values for a modified, non-linear
 transfer function which maintain brightness.
 
 */
-static unsigned int GFX_ALPHA_ADJUST_ARRAY[256] = {
+unsigned int GFX_ALPHA_ADJUST_ARRAY[256] = {
 	0,  /* 0 */
 	15,  /* 1 */
 	22,  /* 2 */
@@ -60,6 +60,9 @@ extern    "C" {
 
 SDL_GFXBLITFUNC_SCOPE int SDL_gfxBlitRGBA(SDL_Surface * src, SDL_Rect * srcrect, SDL_Surface * dst, SDL_Rect * dstrect);
 
+/* Alpha adjustment table used by SDL_gfxBlitRGBA */
+extern unsigned int GFX_ALPHA_ADJUST_ARRAY[256];
+
 /* -------- Macros */
 
 /* Define SDL macros locally as a substitute for an #include "SDL_blit.h", */
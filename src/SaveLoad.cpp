@@ -253,7 +253,7 @@ void GameStatePlay::loadGame() {
 			}
 			else if (infile.key == "spawn") {
 				mapr->teleport_mapname = infile.nextValue();
-				if (fileExists(mods->locate(mapr->teleport_mapname))) {
+				if (mods->exists(mapr->teleport_mapname)) {
 					mapr->teleport_destination.x = toInt(infile.nextValue()) + 0.5f;
 					mapr->teleport_destination.y = toInt(infile.nextValue()) + 0.5f;
 					mapr->teleportation = true;
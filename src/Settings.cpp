@@ -59,6 +59,7 @@ ConfigEntry config[] = {
 	{ "mouse_move",       &typeid(MOUSE_MOVE),      "0",   &MOUSE_MOVE,      "use mouse to move (experimental). 1 enable, 0 disable."},
 	{ "hwsurface",        &typeid(HWSURFACE),       "1",   &HWSURFACE,       "hardware surfaces, double buffering. Try disabling for performance. 1 enable, 0 disable."},
 	{ "doublebuf",        &typeid(DOUBLEBUF),       "1",   &DOUBLEBUF,       NULL},
+	{ "render_threads",   &typeid(RENDER_THREADS),  "0",   &RENDER_THREADS,  "number of threads for software rendering. 0 = one per CPU core, 1 = render on the main thread only."},
 	{ "enable_joystick",  &typeid(ENABLE_JOYSTICK), "0",   &ENABLE_JOYSTICK, "joystick settings."},
 	{ "joystick_device",  &typeid(JOYSTICK_DEVICE), "0",   &JOYSTICK_DEVICE, NULL},
 	{ "joystick_deadzone",&typeid(JOY_DEADZONE),    "100", &JOY_DEADZONE,    NULL},
@@ -70,7 +71,11 @@ ConfigEntry config[] = {
 	{ "show_fps",         &typeid(SHOW_FPS),        "0",   &SHOW_FPS,        "show frames per second. 1 enable, 0 disable."},
 	{ "show_hotkeys",     &typeid(SHOW_HOTKEYS),    "1",   &SHOW_HOTKEYS,    "show hotkeys names on power bar. 1 enable, 0 disable."},
 	{ "colorblind",       &typeid(COLORBLIND),      "0",   &COLORBLIND,      "enable colorblind tooltips. 1 enable, 0 disable"},
-	{ "hardware_cursor",  &typeid(HARDWARE_CURSOR), "0",   &HARDWARE_CURSOR, "use the system mouse cursor. 1 enable, 0 disable"}
+	{ "hardware_cursor",  &typeid(HARDWARE_CURSOR), "0",   &HARDWARE_CURSOR, "use the system mouse cursor. 1 enable, 0 disable"},
+	{ "map_chunk_size",   &typeid(MAP_CHUNK_SIZE),  "512", &MAP_CHUNK_SIZE,  "size in pixels of the pre-rendered parts of map layers. 0 disables pre-rendering."},
+	{ "map_chunk_memory", &typeid(MAP_CHUNK_MEMORY),"64",  &MAP_CHUNK_MEMORY,"memory budget for pre-rendered map layers, in megabytes."},
+	{ "atlas_page_size",  &typeid(ATLAS_PAGE_SIZE), "1024",&ATLAS_PAGE_SIZE, "size in pixels of the shared images small images are packed into. 0 disables packing."},
+	{ "map_region_distance", &typeid(MAP_REGION_DISTANCE), "24", &MAP_REGION_DISTANCE, "distance in tiles from the camera at which map regions are loaded in the background. They are unloaded at twice that distance."}
 };
 const int config_size = sizeof(config) / sizeof(ConfigEntry);
 
@@ -80,6 +85,9 @@ string PATH_USER = "";
 string PATH_DATA = "";
 string CUSTOM_PATH_DATA = "";
 
+// Command-line options
+int LOAD_SLOT = 0;
+
 // Filenames
 string FILE_SETTINGS	= "settings.txt";
 string FILE_KEYBINDINGS = "keybindings.txt";
@@ -113,8 +121,13 @@ short MIN_VIEW_W = -1;
 short MIN_VIEW_H = -1;
 bool DOUBLEBUF;
 bool HWSURFACE;
+unsigned short RENDER_THREADS;
 bool CHANGE_GAMMA;
 float GAMMA;
+unsigned short MAP_CHUNK_SIZE;
+unsigned short MAP_CHUNK_MEMORY;
+unsigned short ATLAS_PAGE_SIZE;
+unsigned short MAP_REGION_DISTANCE;
 
 // Audio Settings
 bool AUDIO;
@@ -185,6 +198,7 @@ int SOUND_FALLOFF;
 int PARTY_EXP_PERCENTAGE;
 bool ENABLE_ALLY_COLLISION_AI;
 bool ENABLE_ALLY_COLLISION;
+bool JUMP_POINT_SEARCH;
 int CURRENCY_ID;
 float INTERACT_RANGE;
 bool HARDWARE_CURSOR = false;
@@ -453,6 +467,7 @@ void loadMiscSettings() {
 	PARTY_EXP_PERCENTAGE = 100;
 	ENABLE_ALLY_COLLISION_AI = true;
 	ENABLE_ALLY_COLLISION = true;
+	JUMP_POINT_SEARCH = false;
 	CURRENCY_ID = 1;
 	INTERACT_RANGE = 3;
 
@@ -490,6 +505,9 @@ void loadMiscSettings() {
 			// @ATTR enable_ally_collision_ai|boolean|Allows allies to block the path of other AI creatures.
 			else if (infile.key == "enable_ally_collision_ai")
 				ENABLE_ALLY_COLLISION_AI = toBool(infile.val);
+			// @ATTR jump_point_search|boolean|Find paths with jump point search instead of A*. Usually faster on open maps.
+			else if (infile.key == "jump_point_search")
+				JUMP_POINT_SEARCH = toBool(infile.val);
 			else if (infile.key == "currency_id") {
 				// @ATTR currency_id|integer|An item id that will be used as currency.
 				CURRENCY_ID = toInt(infile.val);
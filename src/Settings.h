@@ -73,6 +73,9 @@ extern std::string PATH_USER; // important per-user data (saves)
 extern std::string PATH_DATA; // common game data
 extern std::string CUSTOM_PATH_DATA; // user-defined replacement for PATH_DATA
 
+// Command-line options
+extern int LOAD_SLOT; // save slot to load on startup, skipping the title screen (0 = disabled)
+
 // Filenames
 extern std::string FILE_SETTINGS;     // Name of the settings file (e.g. "settings.txt").
 extern std::string FILE_KEYBINDINGS;  // Name of the key bindings file (e.g. "keybindings.txt").
@@ -98,8 +101,13 @@ extern short MIN_VIEW_W;
 extern short MIN_VIEW_H;
 extern bool DOUBLEBUF;
 extern bool HWSURFACE;
+extern unsigned short RENDER_THREADS;
 extern bool CHANGE_GAMMA;
 extern float GAMMA;
+extern unsigned short MAP_CHUNK_SIZE;
+extern unsigned short MAP_CHUNK_MEMORY;
+extern unsigned short ATLAS_PAGE_SIZE;
+extern unsigned short MAP_REGION_DISTANCE;
 
 // Input Settings
 extern bool MOUSE_MOVE;
@@ -128,6 +136,7 @@ extern int SOUND_FALLOFF;
 extern int PARTY_EXP_PERCENTAGE;
 extern bool ENABLE_ALLY_COLLISION_AI;
 extern bool ENABLE_ALLY_COLLISION;
+extern bool JUMP_POINT_SEARCH;
 extern int CURRENCY_ID;
 extern float INTERACT_RANGE;
 extern bool HARDWARE_CURSOR;
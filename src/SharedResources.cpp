@@ -29,12 +29,15 @@ Created and destroyed by main.cpp
 #include "SharedResources.h"
 
 AnimationManager *anim;
+AssetLoader *assets;
 CombatText *comb;
 CursorManager *curs;
+DataCache *data_cache;
 FontEngine *font;
 InputState *inpt;
 MessageEngine *msg;
 ModManager *mods;
+Profiler *prof;
 RenderDevice *render_device;
 SDL_Joystick *joy;
 SoundManager *snd;
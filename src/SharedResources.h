@@ -32,24 +32,30 @@ Created and destroyed by main.cpp
 
 #include "CommonIncludes.h"
 #include "AnimationManager.h"
+#include "AssetLoader.h"
 #include "CombatText.h"
 #include "CursorManager.h"
+#include "DataCache.h"
 #include "FontEngine.h"
 #include "InputState.h"
 #include "MessageEngine.h"
 #include "ModManager.h"
+#include "Profiler.h"
 #include "SoundManager.h"
 #include "RenderDevice.h"
 
 extern SDL_Joystick *joy;
 
 extern AnimationManager *anim;
+extern AssetLoader *assets;
 extern CombatText *comb;
 extern CursorManager *curs;
+extern DataCache *data_cache;
 extern FontEngine *font;
 extern InputState *inpt;
 extern MessageEngine *msg;
 extern ModManager *mods;
+extern Profiler *prof;
 extern SoundManager *snd;
 extern Sprite *icons;
 extern RenderDevice *render_device;
@@ -160,24 +160,24 @@ SoundManager::SoundID SoundManager::load(const std::string& filename, const std:
 	Sound lsnd;
 	SoundID sid = 0;
 	SoundMapIterator it;
-	std::locale loc;
 
 	if (!AUDIO || !SOUND_VOLUME)
 		return 0;
 
-	const collate<char>& coll = use_facet<collate<char> >(loc);
 	const string realfilename = mods->locate(filename);
 
 	/* create sid hash and check if already loaded */
-	sid = coll.hash(realfilename.data(), realfilename.data()+realfilename.length());
+	sid = getSoundID(realfilename);
 	it = sounds.find(sid);
 	if (it != sounds.end()) {
 		it->second->refCnt++;
 		return sid;
 	}
 
-	/* load non existing sound */
-	lsnd.chunk = Mix_LoadWAV(realfilename.c_str());
+	/* load non existing sound, it may have been decoded on a worker thread already */
+	lsnd.chunk = assets ? assets->takeSound(filename) : NULL;
+	if (!lsnd.chunk)
+		lsnd.chunk = Mix_LoadWAV_RW(mods->openRW(realfilename), 1);
 	lsnd.refCnt = 1;
 	if (!lsnd.chunk) {
 		fprintf(stderr, "%s: Loading sound %s (%s) failed: %s \n", errormessage.c_str(),
@@ -193,6 +193,16 @@ SoundManager::SoundID SoundManager::load(const std::string& filename, const std:
 	return sid;
 }
 
+bool SoundManager::isLoaded(const std::string& filename) {
+	return sounds.find(getSoundID(mods->locate(filename))) != sounds.end();
+}
+
+SoundManager::SoundID SoundManager::getSoundID(const std::string& realfilename) {
+	std::locale loc;
+	const collate<char>& coll = use_facet<collate<char> >(loc);
+	return coll.hash(realfilename.data(), realfilename.data()+realfilename.length());
+}
+
 void SoundManager::unload(SoundManager::SoundID sid) {
 
 	SoundMapIterator it;
@@ -39,6 +39,7 @@ public:
 
 	SoundManager::SoundID load(const std::string& filename, const std::string& errormessage);
 	void unload(SoundManager::SoundID);
+	bool isLoaded(const std::string& filename);
 	void play(SoundManager::SoundID, std::string channel = GLOBAL_VIRTUAL_CHANNEL, FPoint pos = FPoint(0,0), bool loop = false);
 
 	void logic(FPoint center);
@@ -54,6 +55,7 @@ private:
 	typedef std::map<int, class Playback> PlaybackMap;
 	typedef PlaybackMap::iterator PlaybackMapIterator;
 
+	static SoundID getSoundID(const std::string& realfilename);
 	static void channel_finished(int channel);
 	void on_channel_finished(int channel);
 
@@ -256,13 +256,32 @@ bool StatBlock::loadSfxStat(FileParser *infile) {
 	return true;
 }
 
+/**
+ * Queue the animations and sounds of an enemy definition, see AssetLoader.
+ * Safe to call on a worker thread.
+ */
+void StatBlock::preload(AssetLoader &loader, const string& filename) {
+	FileParser infile;
+	if (!infile.open(filename, true, ""))
+		return;
+
+	while (infile.next()) {
+		if (infile.key == "animations")
+			loader.addJob(AnimationSet::preload, infile.val);
+		else if (infile.key == "sfx_phys" || infile.key == "sfx_ment" || infile.key == "sfx_hit" ||
+				 infile.key == "sfx_die" || infile.key == "sfx_critdie" || infile.key == "sfx_block" ||
+				 infile.key == "sfx_levelup")
+			loader.addSound(infile.val);
+	}
+}
+
 /**
  * load a statblock, typically for an enemy definition
  */
 void StatBlock::load(const string& filename) {
 	// @CLASS StatBlock: Enemies|Description of enemies in enemies/
 	FileParser infile;
-	if (!infile.open(filename))
+	if (!infile.openCached(filename))
 		return;
 
 	string loot_token;
@@ -35,6 +35,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 class Power;
 class FileParser;
+class AssetLoader;
 
 const int POWERSLOT_COUNT = 10;
 const int MELEE_PHYS = 0;
@@ -95,6 +96,7 @@ public:
 	~StatBlock();
 
 	void load(const std::string& filename);
+	static void preload(AssetLoader &loader, const std::string& filename);
 	void takeDamage(int dmg);
 	void recalc();
 	void applyEffects();
@@ -0,0 +1,177 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "CommonIncludes.h"
+#include "StringID.h"
+
+// must be in the same order as the SID_ constants
+static const char *const BUILTIN_NAMES[SID_COUNT] = {
+	"",
+
+	// animations
+	"stance",
+	"run",
+	"block",
+	"hit",
+	"die",
+	"critdie",
+	"spawn",
+	"swing",
+	"shoot",
+	"cast",
+
+	// effects
+	"damage",
+	"hpot",
+	"mpot",
+	"speed",
+	"immunity",
+	"stun",
+	"forced_move",
+	"revive",
+	"convert",
+	"fear",
+	"offense",
+	"defense",
+	"physical",
+	"mental",
+	"death_sentence",
+	"shield",
+	"heal",
+
+	// event types
+	"on_trigger",
+	"on_mapexit",
+	"on_leave",
+	"on_load",
+	"on_clear",
+
+	// event components
+	"tooltip",
+	"power_path",
+	"power_damage",
+	"intermap",
+	"intramap",
+	"mapmod",
+	"soundfx",
+	"loot",
+	"msg",
+	"shakycam",
+	"requires_status",
+	"requires_not_status",
+	"requires_level",
+	"requires_not_level",
+	"requires_currency",
+	"requires_item",
+	"set_status",
+	"unset_status",
+	"remove_currency",
+	"remove_item",
+	"reward_xp",
+	"reward_currency",
+	"reward_item",
+	"restore",
+	"power",
+	"stash",
+	"npc",
+	"music",
+	"cutscene",
+	"repeat",
+	"wasInsideEventArea",
+
+	// quests and dialogs
+	"quest_text",
+	"group",
+	"topic",
+	"allow_movement",
+	"him",
+	"her",
+	"you",
+	"voice",
+};
+
+/**
+ * The interned strings. Ids index into names, which point at the keys of ids,
+ * so each string is only stored once.
+ */
+class StringTable {
+public:
+	StringTable();
+	~StringTable();
+
+	StringID intern(const std::string &s);
+
+	std::map<std::string, StringID> ids;
+	std::vector<const std::string*> names;
+	SDL_mutex *mutex;
+};
+
+StringTable::StringTable()
+	: mutex(SDL_CreateMutex()) {
+	for (unsigned i = 0; i < SID_COUNT; ++i)
+		intern(BUILTIN_NAMES[i]);
+}
+
+StringTable::~StringTable() {
+	SDL_DestroyMutex(mutex);
+}
+
+StringID StringTable::intern(const std::string &s) {
+	std::map<std::string, StringID>::iterator it = ids.find(s);
+	if (it != ids.end())
+		return it->second;
+
+	const StringID id = static_cast<StringID>(names.size());
+	it = ids.insert(std::pair<std::string, StringID>(s, id)).first;
+	names.push_back(&it->first);
+	return id;
+}
+
+/**
+ * The table is created on first use, so ids can be used by static objects as well
+ */
+static StringTable &getStringTable() {
+	static StringTable table;
+	return table;
+}
+
+/**
+ * Get the id of a string, adding it to the table if it's new.
+ * This takes a lock, so it's meant for loading, not for every frame.
+ */
+StringID internString(const std::string &s) {
+	StringTable &table = getStringTable();
+
+	SDL_LockMutex(table.mutex);
+	const StringID id = table.intern(s);
+	SDL_UnlockMutex(table.mutex);
+
+	return id;
+}
+
+/**
+ * Get the string an id was made from, or the empty string for unknown ids
+ */
+const std::string &getInternedString(StringID id) {
+	StringTable &table = getStringTable();
+
+	SDL_LockMutex(table.mutex);
+	const std::string *name = (id < table.names.size()) ? table.names[id] : table.names[SID_NONE];
+	SDL_UnlockMutex(table.mutex);
+
+	return *name;
+}
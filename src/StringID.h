@@ -0,0 +1,126 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * String ids
+ *
+ * Names which are compared every frame (animations, effect types, event
+ * components) are interned into integer ids when they are loaded, so the
+ * comparisons are integer compares. The same string always gets the same id.
+ * The names the engine itself looks for are interned first, so their ids are
+ * the SID_ constants below.
+ */
+
+#pragma once
+#ifndef STRING_ID_H
+#define STRING_ID_H
+
+#include <string>
+
+typedef unsigned int StringID;
+
+enum {
+	SID_NONE = 0, // the empty string
+
+	// animations
+	SID_STANCE,
+	SID_RUN,
+	SID_BLOCK,
+	SID_HIT,
+	SID_DIE,
+	SID_CRITDIE,
+	SID_SPAWN,
+	SID_SWING,
+	SID_SHOOT,
+	SID_CAST,
+
+	// effects
+	SID_DAMAGE,
+	SID_HPOT,
+	SID_MPOT,
+	SID_SPEED,
+	SID_IMMUNITY,
+	SID_STUN,
+	SID_FORCED_MOVE,
+	SID_REVIVE,
+	SID_CONVERT,
+	SID_FEAR,
+	SID_OFFENSE,
+	SID_DEFENSE,
+	SID_PHYSICAL,
+	SID_MENTAL,
+	SID_DEATH_SENTENCE,
+	SID_SHIELD,
+	SID_HEAL,
+
+	// event types
+	SID_ON_TRIGGER,
+	SID_ON_MAPEXIT,
+	SID_ON_LEAVE,
+	SID_ON_LOAD,
+	SID_ON_CLEAR,
+
+	// event components
+	SID_TOOLTIP,
+	SID_POWER_PATH,
+	SID_POWER_DAMAGE,
+	SID_INTERMAP,
+	SID_INTRAMAP,
+	SID_MAPMOD,
+	SID_SOUNDFX,
+	SID_LOOT,
+	SID_MSG,
+	SID_SHAKYCAM,
+	SID_REQUIRES_STATUS,
+	SID_REQUIRES_NOT_STATUS,
+	SID_REQUIRES_LEVEL,
+	SID_REQUIRES_NOT_LEVEL,
+	SID_REQUIRES_CURRENCY,
+	SID_REQUIRES_ITEM,
+	SID_SET_STATUS,
+	SID_UNSET_STATUS,
+	SID_REMOVE_CURRENCY,
+	SID_REMOVE_ITEM,
+	SID_REWARD_XP,
+	SID_REWARD_CURRENCY,
+	SID_REWARD_ITEM,
+	SID_RESTORE,
+	SID_POWER,
+	SID_STASH,
+	SID_NPC,
+	SID_MUSIC,
+	SID_CUTSCENE,
+	SID_REPEAT,
+	SID_WAS_INSIDE_EVENT_AREA,
+
+	// quests and dialogs
+	SID_QUEST_TEXT,
+	SID_GROUP,
+	SID_TOPIC,
+	SID_ALLOW_MOVEMENT,
+	SID_HIM,
+	SID_HER,
+	SID_YOU,
+	SID_VOICE,
+
+	SID_COUNT
+};
+
+StringID internString(const std::string &s);
+const std::string &getInternedString(StringID id);
+
+#endif
@@ -81,6 +81,21 @@ void TileSet::loadGraphics(const std::string& filename) {
 	}
 }
 
+/**
+ * Queue the tile sheets of a tileset, see AssetLoader.
+ * Safe to call on a worker thread.
+ */
+void TileSet::preload(AssetLoader &loader, const std::string& filename) {
+	FileParser infile;
+	if (!infile.open(filename, true, ""))
+		return;
+
+	while (infile.next()) {
+		if (infile.key == "img")
+			loader.addImage(infile.val);
+	}
+}
+
 void TileSet::load(const std::string& filename) {
 	if (current_map == filename) return;
 
@@ -31,6 +31,8 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "CommonIncludes.h"
 #include "Utils.h"
 
+class AssetLoader;
+
 /**
  * Describes a tile by its location \a src in the tileset sprite and
  * by the \a offset to be applied when rendering it on screen.
@@ -78,6 +80,7 @@ public:
 	TileSet();
 	~TileSet();
 	void load(const std::string& filename);
+	static void preload(AssetLoader &loader, const std::string& filename);
 	void logic();
 
 	std::vector<Tile_Def> tiles;
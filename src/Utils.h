@@ -32,6 +32,8 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include <stdint.h>
 #include <string>
 
+#include "StringID.h"
+
 class Point {
 public:
 	int x, y;
@@ -85,7 +87,7 @@ public:
 
 class Event_Component {
 public:
-	std::string type;
+	StringID type;
 	std::string s;
 	int x;
 	int y;
@@ -94,7 +96,7 @@ public:
 	int b;
 
 	Event_Component()
-		: type("")
+		: type(SID_NONE)
 		, s("")
 		, x(0)
 		, y(0)
@@ -91,6 +91,26 @@ bool fileExists(std::string filename) {
 	return exists;
 }
 
+/**
+ * Returns the time a file was last changed, or 0 if it doesn't exist
+ */
+time_t getFileModifiedTime(const std::string &path) {
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0)
+		return 0;
+	return st.st_mtime;
+}
+
+/**
+ * Returns the size of a file in bytes, or 0 if it doesn't exist
+ */
+size_t getFileSize(const std::string &path) {
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0)
+		return 0;
+	return static_cast<size_t>(st.st_size);
+}
+
 /**
  * Returns a vector containing all filenames in a given folder with the given extension
  */
@@ -141,3 +161,40 @@ int getDirList(std::string dir, std::vector<std::string> &dirs) {
 	closedir(dp);
 	return 0;
 }
+
+static void listFilesRecursive(const std::string &dir, const std::string &prefix, std::vector<std::string> &files, std::vector<std::string> *dirs) {
+
+	DIR *dp;
+	struct dirent *dirp;
+	struct stat st;
+
+	if ((dp = opendir(dir.c_str())) == NULL)
+		return;
+
+	if (dirs) dirs->push_back(dir);
+
+	while ((dirp = readdir(dp)) != NULL) {
+		std::string name = std::string(dirp->d_name);
+		if (name == "." || name == "..")
+			continue;
+
+		std::string path = dir + "/" + name;
+		if (stat(path.c_str(), &st) == -1)
+			continue;
+
+		if (S_ISDIR(st.st_mode))
+			listFilesRecursive(path, prefix + name + "/", files, dirs);
+		else
+			files.push_back(prefix + name);
+	}
+	closedir(dp);
+}
+
+/**
+ * Returns a vector containing the paths of all files below a given folder,
+ * relative to that folder. If dirs isn't NULL, the full paths of the folders
+ * that were searched are added to it.
+ */
+void getFileListRecursive(const std::string &dir, std::vector<std::string> &files, std::vector<std::string> *dirs) {
+	listFilesRecursive(dir, "", files, dirs);
+}
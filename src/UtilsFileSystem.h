@@ -28,12 +28,17 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include "CommonIncludes.h"
 
+#include <time.h>
+
 bool dirExists(const std::string &path);
 bool pathExists(const std::string &path);
 void createDir(std::string path);
 bool fileExists(std::string filename);
+time_t getFileModifiedTime(const std::string &path);
+size_t getFileSize(const std::string &path);
 int getFileList(std::string dir, std::string ext, std::vector<std::string> &files);
 int getDirList(std::string dir, std::vector<std::string> &dirs);
+void getFileListRecursive(const std::string &dir, std::vector<std::string> &files, std::vector<std::string> *dirs = NULL);
 
 
 bool isDirectory(const std::string &path);
@@ -20,7 +20,10 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "CommonIncludes.h"
 #include "UtilsParsing.h"
 #include "Settings.h"
+#include <cctype>
+#include <climits>
 #include <cstdlib>
+#include <cstring>
 #include <typeinfo>
 #include <math.h>
 
@@ -104,6 +107,22 @@ int popFirstInt(string &s, char separator) {
 	return num;
 }
 
+/**
+ * Same as above, for text which is read in place, e.g. from a mapped file.
+ * The int is parsed from [cursor, end), and cursor is moved past the separator.
+ */
+int popFirstInt(const char *&cursor, const char *end, char separator) {
+	const char *seppos = static_cast<const char*>(memchr(cursor, separator, end - cursor));
+	if (!seppos) {
+		const int num = toInt(cursor, end);
+		cursor = end;
+		return num;
+	}
+	const int num = toInt(cursor, seppos);
+	cursor = seppos + 1;
+	return num;
+}
+
 string popFirstString(string &s, char separator) {
 	string outs = "";
 	size_t seppos = s.find_first_of(separator);
@@ -140,7 +159,7 @@ string stripCarriageReturn(const string& line) {
 	return line;
 }
 
-string getLine(ifstream &infile) {
+string getLine(istream &infile) {
 	string line;
 	// This is the standard way to check whether a read failed.
 	if (!getline(infile, line))
@@ -232,9 +251,41 @@ std::string toString(const type_info & type, void * value) {
 }
 
 int toInt(const string& s, int default_value) {
-	int result;
-	if (!(stringstream(s) >> result))
-		result = default_value;
+	return toInt(s.data(), s.data() + s.length(), default_value);
+}
+
+/**
+ * Parse a decimal int from a range that doesn't need to be null-terminated.
+ * Like reading it from a stream, leading whitespace and trailing text are
+ * ignored, and default_value is returned if there is no number or it overflows.
+ */
+int toInt(const char *begin, const char *end, int default_value) {
+	while (begin < end && isspace(static_cast<unsigned char>(*begin)))
+		++begin;
+
+	bool negative = false;
+	if (begin < end && (*begin == '-' || *begin == '+')) {
+		negative = (*begin == '-');
+		++begin;
+	}
+
+	if (begin == end || !isdigit(static_cast<unsigned char>(*begin)))
+		return default_value;
+
+	// accumulate negatively, so INT_MIN can be represented
+	int result = 0;
+	for (; begin < end && isdigit(static_cast<unsigned char>(*begin)); ++begin) {
+		const int digit = *begin - '0';
+		if (result < (INT_MIN + digit) / 10)
+			return default_value;
+		result = result * 10 - digit;
+	}
+
+	if (!negative) {
+		if (result == INT_MIN)
+			return default_value;
+		result = -result;
+	}
 	return result;
 }
 
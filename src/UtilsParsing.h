@@ -32,14 +32,16 @@ int parse_duration(const std::string& s);
 std::string parse_section_title(const std::string& s);
 void parse_key_pair(const std::string& s, std::string& key, std::string& val);
 int popFirstInt(std::string& s, char separator = ',');
+int popFirstInt(const char *&cursor, const char *end, char separator = ',');
 std::string popFirstString(std::string& s, char separator = ',');
 std::string getNextToken(const std::string& s, size_t& cursor, char separator);
 std::string stripCarriageReturn(const std::string& line);
-std::string getLine(std::ifstream& infile);
+std::string getLine(std::istream& infile);
 bool tryParseValue(const std::type_info & type, const char * value, void * output);
 bool tryParseValue(const std::type_info & type, const std::string & value, void * output);
 std::string toString(const std::type_info & type, void * value);
 int toInt(const std::string& s, int default_value = 0);
+int toInt(const char *begin, const char *end, int default_value = 0);
 float toFloat(const std::string &s, float default_value = 0.0);
 unsigned long toUnsignedLong(const std::string& s, unsigned long default_value = 0);
 bool toBool(std::string value);
@@ -0,0 +1,158 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include <stdio.h>
+
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(int thread_count)
+	: mutex(SDL_CreateMutex())
+	, work_ready(SDL_CreateCond())
+	, work_done(SDL_CreateCond())
+	, job(NULL)
+	, job_data(NULL)
+	, part_count(0)
+	, next_part(0)
+	, parts_left(0)
+	, quit(false) {
+
+	if (thread_count <= 0)
+		thread_count = getCPUCount();
+
+	if (!mutex || !work_ready || !work_done)
+		return;
+
+	for (int i = 1; i < thread_count; ++i) {
+#if SDL_VERSION_ATLEAST(2,0,0)
+		SDL_Thread *thread = SDL_CreateThread(threadMain, "WorkerPool", this);
+#else
+		SDL_Thread *thread = SDL_CreateThread(threadMain, this);
+#endif
+		if (!thread) {
+			fprintf(stderr, "Could not create worker thread: %s\n", SDL_GetError());
+			break;
+		}
+		threads.push_back(thread);
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	if (mutex) {
+		SDL_LockMutex(mutex);
+		quit = true;
+		SDL_CondBroadcast(work_ready);
+		SDL_UnlockMutex(mutex);
+	}
+
+	for (unsigned i = 0; i < threads.size(); ++i)
+		SDL_WaitThread(threads[i], NULL);
+
+	if (work_done) SDL_DestroyCond(work_done);
+	if (work_ready) SDL_DestroyCond(work_ready);
+	if (mutex) SDL_DestroyMutex(mutex);
+}
+
+int WorkerPool::getThreadCount() {
+	return (int)threads.size() + 1;
+}
+
+int WorkerPool::getCPUCount() {
+#if SDL_VERSION_ATLEAST(2,0,0)
+	return std::max(1, SDL_GetCPUCount());
+#else
+	return 1;
+#endif
+}
+
+/**
+ * Run job(data, part) for each part in [0, part_count).
+ * Parts may run in any order and at the same time, so they must not depend
+ * on each other.
+ */
+void WorkerPool::run(Job _job, void *data, int _part_count) {
+	if (threads.empty() || _part_count <= 1) {
+		for (int part = 0; part < _part_count; ++part)
+			_job(data, part);
+		return;
+	}
+
+	SDL_LockMutex(mutex);
+	job = _job;
+	job_data = data;
+	part_count = _part_count;
+	next_part = 0;
+	parts_left = _part_count;
+	SDL_CondBroadcast(work_ready);
+	SDL_UnlockMutex(mutex);
+
+	// the calling thread helps instead of waiting idle
+	int part;
+	while (nextPart(part)) {
+		_job(data, part);
+		finishPart();
+	}
+
+	SDL_LockMutex(mutex);
+	while (parts_left > 0)
+		SDL_CondWait(work_done, mutex);
+	job = NULL;
+	job_data = NULL;
+	part_count = 0;
+	SDL_UnlockMutex(mutex);
+}
+
+bool WorkerPool::nextPart(int &part) {
+	SDL_LockMutex(mutex);
+	const bool found = (next_part < part_count);
+	if (found)
+		part = next_part++;
+	SDL_UnlockMutex(mutex);
+	return found;
+}
+
+void WorkerPool::finishPart() {
+	SDL_LockMutex(mutex);
+	if (--parts_left == 0)
+		SDL_CondSignal(work_done);
+	SDL_UnlockMutex(mutex);
+}
+
+int WorkerPool::threadMain(void *arg) {
+	WorkerPool *pool = static_cast<WorkerPool*>(arg);
+
+	SDL_LockMutex(pool->mutex);
+	while (!pool->quit) {
+		if (pool->next_part >= pool->part_count) {
+			SDL_CondWait(pool->work_ready, pool->mutex);
+			continue;
+		}
+
+		const int part = pool->next_part++;
+		Job current_job = pool->job;
+		void *data = pool->job_data;
+		SDL_UnlockMutex(pool->mutex);
+
+		current_job(data, part);
+
+		SDL_LockMutex(pool->mutex);
+		if (--pool->parts_left == 0)
+			SDL_CondSignal(pool->work_done);
+	}
+	SDL_UnlockMutex(pool->mutex);
+
+	return 0;
+}
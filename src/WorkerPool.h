@@ -0,0 +1,65 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class WorkerPool
+ *
+ * A fixed set of SDL threads for splitting a job into independent parts.
+ * run() hands out the parts to the workers and the calling thread, and
+ * returns when all of them are done.
+ */
+
+#pragma once
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include "CommonIncludes.h"
+
+class WorkerPool {
+public:
+	typedef void (*Job)(void *data, int part);
+
+	// thread_count includes the calling thread. 0 uses one thread per CPU core.
+	WorkerPool(int thread_count);
+	~WorkerPool();
+
+	int getThreadCount();
+	void run(Job job, void *data, int part_count);
+
+	static int getCPUCount();
+
+private:
+	WorkerPool(const WorkerPool &copy); // not implemented
+
+	static int threadMain(void *arg);
+	bool nextPart(int &part);
+	void finishPart();
+
+	std::vector<SDL_Thread*> threads;
+	SDL_mutex *mutex;
+	SDL_cond *work_ready;
+	SDL_cond *work_done;
+
+	Job job;
+	void *job_data;
+	int part_count;
+	int next_part;
+	int parts_left;
+	bool quit;
+};
+
+#endif
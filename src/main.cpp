@@ -34,20 +34,34 @@ using namespace std;
 
 GameSwitcher *gswitch;
 
+// reproducible runs: a fixed random seed, and input recording / replay
+static bool fixed_seed = false;
+static unsigned int rand_seed = 0;
+static std::string record_filename = "";
+static std::string replay_filename = "";
+
+// per-subsystem timings are written here on exit
+static std::string profile_filename = "";
+
 /**
  * Game initialization.
  */
 void init(const std::string render_device_name) {
-	srand((unsigned int)time(NULL));
+	if (!fixed_seed) rand_seed = (unsigned int)time(NULL);
 	setPaths();
 	setStatNames();
 
 	// SDL Inits
-	if ( SDL_Init (SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_JOYSTICK) < 0 ) {
+	// the null render device doesn't need a video subsystem, so it can run without a display
+	Uint32 sdl_flags = SDL_INIT_AUDIO | SDL_INIT_JOYSTICK;
+	if (render_device_name != "null") sdl_flags |= SDL_INIT_VIDEO;
+	if ( SDL_Init (sdl_flags) < 0 ) {
 		fprintf(stderr, "Could not initialize SDL: %s\n", SDL_GetError());
 		exit(1);
 	}
 
+	prof = new Profiler();
+
 	// Shared Resources set-up
 
 	mods = new ModManager();
@@ -68,11 +82,31 @@ void init(const std::string render_device_name) {
 		exit(1);
 	}
 
+	// parsed data files are kept between launches
+	createDir(PATH_USER + "cache/");
+	data_cache = new DataCache(PATH_USER + "cache/data.bin");
+	data_cache->load();
+
 	msg = new MessageEngine();
 	font = new FontEngine();
 	anim = new AnimationManager();
 	comb = new CombatText();
 	inpt = new InputState();
+
+	// A replay must use the seed it was recorded with, so we seed the random
+	// number generator only after the replay file has been read.
+	if (!replay_filename.empty()) {
+		if (!inpt->startReplay(replay_filename, &rand_seed)) {
+			SDL_Quit();
+			exit(1);
+		}
+		printf("Replaying input from %s (seed %u)\n", replay_filename.c_str(), rand_seed);
+	}
+	else if (!record_filename.empty()) {
+		if (inpt->startRecording(record_filename, rand_seed))
+			printf("Recording input to %s (seed %u)\n", record_filename.c_str(), rand_seed);
+	}
+	srand(rand_seed);
 	icons = NULL;
 
 	// Load tileset options (must be after ModManager is initialized)
@@ -105,6 +139,7 @@ void init(const std::string render_device_name) {
 	}
 
 	snd = new SoundManager();
+	assets = new AssetLoader();
 
 	// initialize Joysticks
 	if(SDL_NumJoysticks() == 1) {
@@ -134,6 +169,25 @@ void init(const std::string render_device_name) {
 	curs = new CursorManager();
 }
 
+/**
+ * Run a single tick of game logic
+ */
+void logic_tick(bool debug_event) {
+	ProfileScope scope(PROF_LOGIC);
+
+	prof->begin(PROF_INPUT);
+	SDL_PumpEvents();
+	inpt->handle(debug_event);
+	prof->end(PROF_INPUT);
+
+	gswitch->logic();
+	inpt->resetScroll();
+
+#ifdef WATCH_MODS
+	mods->checkForChanges();
+#endif
+}
+
 int simulate(int logic_ticks, bool debug_event, int delay) {
 	int now_ticks = SDL_GetTicks();
 	int loops = 0;
@@ -147,10 +201,7 @@ int simulate(int logic_ticks, bool debug_event, int delay) {
 			break;
 		}
 
-		SDL_PumpEvents();
-		inpt->handle(debug_event);
-		gswitch->logic();
-		inpt->resetScroll();
+		logic_tick(debug_event);
 
 		logic_ticks += delay;
 		loops++;
@@ -159,8 +210,10 @@ int simulate(int logic_ticks, bool debug_event, int delay) {
 }
 
 void render(int prev_ticks, int delay) {
+	prof->begin(PROF_RENDER);
 	render_device->blankScreen();
 	gswitch->render();
+	prof->end(PROF_RENDER);
 
 	// display the FPS counter
 	// if the frame completed quickly, we estimate the delay here
@@ -172,8 +225,13 @@ void render(int prev_ticks, int delay) {
 	if (now_ticks+delay_ticks - prev_ticks != 0) {
 		gswitch->showFPS(1000 / (now_ticks+delay_ticks - prev_ticks));
 	}
+	prof->renderOverlay();
 
+	prof->begin(PROF_COMMIT);
 	render_device->commitFrame();
+	prof->end(PROF_COMMIT);
+
+	prof->endFrame();
 }
 
 void delay_loop(int prev_ticks, int delay) {
@@ -210,10 +268,49 @@ void mainLoop (bool debug_event) {
 	}
 }
 
+/**
+ * Run game logic as fast as possible, without rendering or frame delays
+ * Stops after max_ticks logic ticks (0 means no limit) and reports the tick rate.
+ */
+void headlessLoop(bool debug_event, int max_ticks) {
+	int start_ticks = SDL_GetTicks();
+	int report_ticks = start_ticks;
+	int ticks = 0;
+	int report_count = 0;
+
+	while (!done() && (max_ticks <= 0 || ticks < max_ticks)) {
+		// loading frames are skipped here as well, so they don't count as logic ticks
+		if (gswitch->isLoadingFrame())
+			continue;
+
+		logic_tick(debug_event);
+		prof->endFrame();
+		ticks++;
+		report_count++;
+
+		int now_ticks = SDL_GetTicks();
+		if (now_ticks - report_ticks >= 5000) {
+			printf("Headless: %.1f ticks/sec\n", report_count * 1000.f / (now_ticks - report_ticks));
+			report_ticks = now_ticks;
+			report_count = 0;
+		}
+	}
+
+	int elapsed = SDL_GetTicks() - start_ticks;
+	if (elapsed <= 0) elapsed = 1;
+	printf("Headless: %d ticks in %d ms (%.1f ticks/sec)\n", ticks, elapsed, ticks * 1000.f / elapsed);
+}
+
 void cleanup() {
+	if (!profile_filename.empty() && prof->dump(profile_filename))
+		printf("Profiler data written to %s\n", profile_filename.c_str());
+
 	delete gswitch;
 
+	data_cache->save();
+
 	delete anim;
+	delete assets;
 	delete comb;
 	delete font;
 	delete inpt;
@@ -221,6 +318,8 @@ void cleanup() {
 	delete msg;
 	delete snd;
 	delete curs;
+	delete data_cache;
+	delete prof;
 
 	Mix_CloseAudio();
 
@@ -262,6 +361,8 @@ std::string parseArgValue(const std::string &arg) {
 int main(int argc, char *argv[]) {
 	bool debug_event = false;
 	bool done = false;
+	bool headless = false;
+	int max_ticks = 0;
 	std::string render_device_name = "";
 
 	for (int i = 1 ; i < argc; i++) {
@@ -281,20 +382,56 @@ int main(int argc, char *argv[]) {
 		else if (parseArg(arg) == "renderer") {
 			render_device_name = parseArgValue(arg);
 		}
+		else if (parseArg(arg) == "headless") {
+			headless = true;
+		}
+		else if (parseArg(arg) == "ticks") {
+			max_ticks = atoi(parseArgValue(arg).c_str());
+		}
+		else if (parseArg(arg) == "seed") {
+			rand_seed = (unsigned int)strtoul(parseArgValue(arg).c_str(), NULL, 10);
+			fixed_seed = true;
+		}
+		else if (parseArg(arg) == "record") {
+			record_filename = parseArgValue(arg);
+		}
+		else if (parseArg(arg) == "replay") {
+			replay_filename = parseArgValue(arg);
+		}
+		else if (parseArg(arg) == "profile") {
+			profile_filename = parseArgValue(arg);
+		}
+		else if (parseArg(arg) == "load-slot") {
+			LOAD_SLOT = atoi(parseArgValue(arg).c_str());
+		}
 		else if (parseArg(arg) == "help") {
 			printf("\
 --help           Prints this message.\n\n\
 --version        Prints the release version.\n\n\
 --data-path      Specifies an exact path to look for mod data.\n\n\
 --debug-event    Prints verbose hardware input information.\n\n\
---renderer       Specifies the rendering backend to use. The default is 'sdl'.\n");
+--renderer       Specifies the rendering backend to use. The default is 'sdl'. Use 'null' to render nothing.\n\n\
+--headless       Runs game logic as fast as possible with the 'null' renderer and reports ticks/second.\n\n\
+--ticks          Stops a headless run after this many logic ticks.\n\n\
+--load-slot      Skips the title screen and loads the given save slot.\n\n\
+--seed           Uses a fixed seed for random numbers.\n\n\
+--record         Records all input to the given file.\n\n\
+--replay         Plays back input from a recorded file, using its random seed. Exits when the file ends.\n\n\
+--profile        Writes per-subsystem frame timings to the given file on exit (.csv or .json). Press F3 in game for an overlay.\n");
 			done = true;
 		}
 	}
 
 	if (!done) {
-		init(render_device_name);
-		mainLoop(debug_event);
+		if (headless) {
+			render_device_name = "null";
+			init(render_device_name);
+			headlessLoop(debug_event, max_ticks);
+		}
+		else {
+			init(render_device_name);
+			mainLoop(debug_event);
+		}
 		cleanup();
 	}
 
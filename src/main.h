@@ -32,9 +32,11 @@ using namespace std;
 
 void init(const std::string render_device_name);
 void mainLoop (bool debug_event);
+void headlessLoop(bool debug_event, int max_ticks);
 void cleanup();
 bool done();
 int game_ticks();
+void logic_tick(bool debug_event);
 int simulate(int logic_ticks, bool debug_event, int delay);
 void render(int prev_ticks, int delay);
 void delay_loop(int prev_ticks, int delay);
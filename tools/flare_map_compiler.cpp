@@ -0,0 +1,76 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+
+/**
+ * flare_map_compiler
+ *
+ * Converts text maps into compiled maps (see CompiledMap). Each map is
+ * written next to the text file, with ".bin" appended to its name, where
+ * Map::load picks it up as long as it isn't older than the text file.
+ * Directories are searched for .txt files, e.g. mods/default/maps.
+ */
+
+#include "CommonIncludes.h"
+#include "CompiledMap.h"
+#include "UtilsFileSystem.h"
+
+#include <cstdio>
+
+using namespace std;
+
+int main(int argc, char *argv[]) {
+	std::vector<std::string> files;
+
+	for (int i = 1 ; i < argc; i++) {
+		std::string arg = std::string(argv[i]);
+		if (arg == "--help") {
+			printf("\
+Usage: flare_map_compiler MAP_OR_DIRECTORY...\n\n\
+Writes a compiled copy of each map next to it, e.g. maps/cave.txt.bin.\n\
+The text map stays the source, compile again after changing it.\n");
+			return 0;
+		}
+		else if (isDirectory(arg)) {
+			getFileList(arg, ".txt", files);
+		}
+		else {
+			files.push_back(arg);
+		}
+	}
+
+	if (files.empty()) {
+		fprintf(stderr, "No maps given, see --help\n");
+		return 1;
+	}
+
+	std::sort(files.begin(), files.end());
+
+	int failed = 0;
+	for (unsigned i = 0; i < files.size(); ++i) {
+		const std::string dest = files[i] + COMPILED_MAP_EXTENSION;
+		if (CompiledMap::compile(files[i], dest)) {
+			printf("%s\n", dest.c_str());
+		}
+		else {
+			fprintf(stderr, "Could not compile %s\n", files[i].c_str());
+			failed++;
+		}
+	}
+
+	return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,77 @@
+/*
+Copyright © 2014 FLARE contributors
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * flare_mod_packer
+ *
+ * Packs mod folders into mod archives (see ModArchive). The archive of
+ * mods/NAME is written to mods/NAME.pak, which the game loads in place of
+ * the folder. Files left in the folder still override the archive.
+ */
+
+#include "CommonIncludes.h"
+#include "ModArchive.h"
+#include "UtilsFileSystem.h"
+
+#include <cstdio>
+
+using namespace std;
+
+int main(int argc, char *argv[]) {
+	std::vector<std::string> dirs;
+	bool compress = true;
+
+	for (int i = 1 ; i < argc; i++) {
+		std::string arg = std::string(argv[i]);
+		if (arg == "--help") {
+			printf("\
+Usage: flare_mod_packer [--store] MOD_DIRECTORY...\n\n\
+Packs each mod folder into an archive next to it, e.g. mods/default.pak.\n\
+Files are compressed where that makes them smaller, unless --store is given.\n\
+Remove or rename the folder afterwards, or it overrides the archive.\n");
+			return 0;
+		}
+		else if (arg == "--store") {
+			compress = false;
+		}
+		else {
+			// trailing slashes would end up in the archive name
+			while (arg.length() > 1 && arg[arg.length()-1] == '/')
+				arg.erase(arg.length()-1);
+			dirs.push_back(arg);
+		}
+	}
+
+	if (dirs.empty()) {
+		fprintf(stderr, "No mod folders given, see --help\n");
+		return 1;
+	}
+
+	int failed = 0;
+	for (unsigned i = 0; i < dirs.size(); ++i) {
+		const std::string dest = dirs[i] + MOD_ARCHIVE_EXTENSION;
+		if (isDirectory(dirs[i]) && ModArchive::create(dirs[i], dest, compress)) {
+			printf("%s\n", dest.c_str());
+		}
+		else {
+			fprintf(stderr, "Could not pack %s\n", dirs[i].c_str());
+			failed++;
+		}
+	}
+
+	return failed > 0 ? 1 : 0;
+}